@@ -0,0 +1,615 @@
+/** @file BenchmarkMain.cpp
+ *
+ *  Throughput benchmarks for the configuration file lexer, parser,
+ *  value processor and ApplicationConfiguration.
+ *
+ *  Run with "make bench CONFIGURATION=RELEASE".  Timings from a DEBUG
+ *  build are not meaningful.
+ */
+
+#include <pistis/config_parser/ApplicationConfiguration.hpp>
+#include <pistis/config_parser/ConfigFileParser.hpp>
+#include <pistis/config_parser/ConfigurationSnapshot.hpp>
+#include <pistis/config_parser/FlatConfigurationPropertyMap.hpp>
+#include <pistis/config_parser/IncludeFileCache.hpp>
+#include <pistis/config_parser/SourceGraph.hpp>
+#include <pistis/config_parser/detail/ConfigFileLexer.hpp>
+#include <pistis/config_parser/detail/ValueProcessor.hpp>
+#include <pistis/config_parser/bench/BenchmarkRunner.hpp>
+#include <pistis/config_parser/bench/Corpus.hpp>
+#include <pistis/config_parser/bench/SyntheticConfig.hpp>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser;
+using namespace pistis::config_parser::bench;
+using namespace pistis::config_parser::detail;
+
+namespace {
+
+  struct Options {
+    bool quick;
+    double minSeconds;
+    std::string filter;
+    std::string corpus;
+  };
+
+  /** @brief Exposes load_() so it can be timed separately from parsing */
+  class BenchConfiguration : public ApplicationConfiguration {
+  public:
+    BenchConfiguration():
+	ApplicationConfiguration(false, false), values_() {
+      registerPropertyPrefix_("section", false, false, values_);
+    }
+
+    size_t numValues() const { return values_.size(); }
+
+    void apply(const std::string& sourceName,
+	       const ConfigurationPropertyMap& properties) {
+      values_.clear();
+      load_(sourceName, properties);
+    }
+
+  private:
+    std::vector<std::string> values_;
+  };
+
+  void check(bool condition, const std::string& what) {
+    if (!condition) {
+      throw std::runtime_error("Benchmark sanity check failed: " + what);
+    }
+  }
+
+  std::string sizeName(size_t n) {
+    if (n >= 1000000) {
+      return std::to_string(n / 1000000) + "M";
+    } else if (n >= 1000) {
+      return std::to_string(n / 1000) + "K";
+    }
+    return std::to_string(n);
+  }
+
+  /** @brief Tokenize [begin, end) the way the parser does, returning the
+   *         number of assignments seen.
+   */
+  size_t lexAll(const char* begin, const char* end) {
+    ConfigFileLexer lexer(begin, end);
+    size_t assignments= 0;
+    while (true) {
+      Token t= lexer.next();
+      if (t.type() == TokenType::END_OF_FILE) {
+	break;
+      } else if ((t.type() == TokenType::PUNCTUATION) &&
+		 (t.value() == "=")) {
+	lexer.parseNextAsValue();
+	++assignments;
+      }
+    }
+    return assignments;
+  }
+
+  void benchFlat(const BenchmarkRunner& runner, size_t numProperties) {
+    const std::string suffix= sizeName(numProperties);
+    if (!runner.selected("lexer.flat." + suffix) &&
+	!runner.selected("parse.flat." + suffix) &&
+	!runner.selected("parse.flat.stream." + suffix) &&
+	!runner.selected("load.flat." + suffix)) {
+      return;
+    }
+
+    const std::string text= flatConfig(numProperties);
+    const char* begin= text.data();
+    const char* end= begin + text.size();
+
+    check(lexAll(begin, end) == numProperties, "lexer.flat." + suffix);
+    runner.run("lexer.flat." + suffix, text.size(), numProperties,
+	       [begin, end]() { lexAll(begin, end); });
+
+    runner.run("parse.flat." + suffix, text.size(), numProperties,
+	       [begin, end]() {
+      ConfigFileParser parser;
+      parser.parseBuffer("flat.conf", begin, end);
+    });
+
+    runner.run("parse.flat.stream." + suffix, text.size(), numProperties,
+	       [&text]() {
+      ConfigFileParser parser;
+      std::istringstream input(text);
+      parser.parse("flat.conf", input);
+    });
+
+    ConfigFileParser parser;
+    const ConfigurationPropertyMap properties=
+	parser.parseBuffer("flat.conf", begin, end);
+    check(properties.size() == numProperties, "parse.flat." + suffix);
+
+    BenchConfiguration config;
+    config.apply("flat.conf", properties);
+    check(config.numValues() == numProperties, "load.flat." + suffix);
+    runner.run("load.flat." + suffix, 0, numProperties,
+	       [&config, &properties]() {
+      config.apply("flat.conf", properties);
+    });
+  }
+
+  /** @brief Look up every property by name, then scan every section by
+   *         prefix
+   */
+  template <typename MapT>
+  void lookupAll(const MapT& map, const std::vector<std::string>& keys,
+		 const std::vector<std::string>& prefixes) {
+    size_t found= 0;
+    for (auto i= keys.begin(); i != keys.end(); ++i) {
+      found += map.hasKey(*i);
+    }
+    for (auto i= prefixes.begin(); i != prefixes.end(); ++i) {
+      map.getPropertiesWithPrefix(*i, [&found](const ConfigurationProperty&) {
+	++found;
+      });
+    }
+    check(found == 2 * keys.size(), "lookup");
+  }
+
+  /** @brief Sum the value lengths in every section, copying each
+   *         section's properties into a vector first
+   */
+  size_t scanCopy(const ConfigurationPropertyMap& map,
+		  const std::vector<std::string>& prefixes) {
+    size_t total= 0;
+    for (auto i= prefixes.begin(); i != prefixes.end(); ++i) {
+      const std::vector<ConfigurationProperty> section=
+	  map.getPropertiesWithPrefix(*i);
+      for (auto j= section.begin(); j != section.end(); ++j) {
+	total += j->value().size();
+      }
+    }
+    return total;
+  }
+
+  /** @brief Sum the value lengths in every section through a view */
+  size_t scanView(const ConfigurationPropertyMap& map,
+		  const std::vector<std::string>& prefixes) {
+    size_t total= 0;
+    for (auto i= prefixes.begin(); i != prefixes.end(); ++i) {
+      for (const ConfigurationProperty& p : map.propertiesWithPrefix(*i)) {
+	total += p.value().size();
+      }
+    }
+    return total;
+  }
+
+  void benchLookup(const BenchmarkRunner& runner, size_t numProperties) {
+    const std::string suffix= sizeName(numProperties);
+    if (!runner.selected("lookup.map." + suffix) &&
+	!runner.selected("lookup.flat." + suffix) &&
+	!runner.selected("build.map." + suffix) &&
+	!runner.selected("build.flat." + suffix) &&
+	!runner.selected("scan.copy." + suffix) &&
+	!runner.selected("scan.view." + suffix)) {
+      return;
+    }
+
+    const std::string text= flatConfig(numProperties);
+    ConfigFileParser parser;
+    const ConfigurationPropertyMap properties=
+	parser.parseBuffer("flat.conf", text.data(),
+			   text.data() + text.size());
+    const FlatConfigurationPropertyMap flat(properties);
+
+    // Look keys up in a scrambled order so successive searches do not
+    // share a path through the map
+    std::vector<std::string> keys(properties.beginNames(),
+				  properties.endNames());
+    for (size_t i= 0; i < keys.size(); ++i) {
+      std::swap(keys[i], keys[(i * 7919) % keys.size()]);
+    }
+    std::vector<std::string> prefixes;
+    for (size_t i= 0; i < (numProperties + 9) / 10; ++i) {
+      prefixes.push_back("section" + std::to_string(i) + ".");
+    }
+
+    // The bytes each build allocates are the memory the map holds
+    runner.run("build.map." + suffix, 0, numProperties, [&properties]() {
+      const ConfigurationPropertyMap copy(properties);
+    });
+    runner.run("build.flat." + suffix, 0, numProperties, [&properties]() {
+      const FlatConfigurationPropertyMap copy(properties);
+    });
+
+    runner.run("lookup.map." + suffix, 0, numProperties,
+	       [&properties, &keys, &prefixes]() {
+      lookupAll(properties, keys, prefixes);
+    });
+    runner.run("lookup.flat." + suffix, 0, numProperties,
+	       [&flat, &keys, &prefixes]() {
+      lookupAll(flat, keys, prefixes);
+    });
+
+    const size_t total= scanCopy(properties, prefixes);
+    check(scanView(properties, prefixes) == total, "scan.view." + suffix);
+    runner.run("scan.copy." + suffix, 0, numProperties,
+	       [&properties, &prefixes, total]() {
+      check(scanCopy(properties, prefixes) == total, "scan.copy");
+    });
+    runner.run("scan.view." + suffix, 0, numProperties,
+	       [&properties, &prefixes, total]() {
+      check(scanView(properties, prefixes) == total, "scan.view");
+    });
+  }
+
+  /** @brief Validate property names with the automaton and with the
+   *         regular expression it replaced
+   */
+  void benchNames(const BenchmarkRunner& runner, size_t numProperties) {
+    const std::string suffix= sizeName(numProperties);
+    if (!runner.selected("name.regex." + suffix) &&
+	!runner.selected("name.dfa." + suffix)) {
+      return;
+    }
+
+    std::vector<std::string> names;
+    names.reserve(numProperties);
+    for (size_t i= 0; i < numProperties; ++i) {
+      names.push_back("section" + std::to_string(i / 10) + ".property_" +
+		      std::to_string(i % 10));
+    }
+
+    const std::regex LEGAL_NAME_REX(
+	"[A-Za-z][A-Za-z0-9_]*(?:\\.[A-Za-z0-9_]+)*$"
+    );
+    runner.run("name.regex." + suffix, 0, numProperties,
+	       [&names, &LEGAL_NAME_REX]() {
+      size_t legal= 0;
+      for (auto i= names.begin(); i != names.end(); ++i) {
+	legal += std::regex_match(i->begin(), i->end(), LEGAL_NAME_REX);
+      }
+      check(legal == names.size(), "name.regex");
+    });
+    runner.run("name.dfa." + suffix, 0, numProperties, [&names]() {
+      size_t legal= 0;
+      for (auto i= names.begin(); i != names.end(); ++i) {
+	legal += ConfigurationProperty::isLegalName(*i);
+      }
+      check(legal == names.size(), "name.dfa");
+    });
+  }
+
+  void benchFile(const BenchmarkRunner& runner, size_t numProperties) {
+    const std::string suffix= sizeName(numProperties);
+    if (!runner.selected("parse.file.mmap." + suffix) &&
+	!runner.selected("parse.file.read." + suffix)) {
+      return;
+    }
+
+    TemporaryDirectory dir;
+    const std::string text= flatConfig(numProperties);
+    const std::string filename= dir.writeFile("flat.conf", text);
+
+    for (bool useMemoryMap : { true, false }) {
+      const std::string name=
+	  std::string(useMemoryMap ? "parse.file.mmap." : "parse.file.read.")
+	  + suffix;
+      runner.run(name, text.size(), numProperties,
+		 [&filename, useMemoryMap]() {
+	ConfigFileParser parser;
+	parser.setUsesMemoryMappedInput(useMemoryMap);
+	parser.parse(filename);
+      });
+    }
+  }
+
+  /** @brief Compare parsing a file with reading its snapshot */
+  void benchSnapshot(const BenchmarkRunner& runner, size_t numProperties) {
+    const std::string suffix= sizeName(numProperties);
+    if (!runner.selected("snapshot.open." + suffix) &&
+	!runner.selected("parse.file.snapshot." + suffix)) {
+      return;
+    }
+
+    TemporaryDirectory dir;
+    const std::string text= flatConfig(numProperties);
+    const std::string filename= dir.writeFile("flat.conf", text);
+    ConfigFileParser writer(false);
+    writer.setSnapshotDirectory(dir.path());
+    const std::string snapshotFile= writer.snapshotFile(filename);
+    check(writer.parse(filename).size() == numProperties, "snapshot");
+    check(ConfigurationSnapshot(snapshotFile).size() == numProperties,
+	  "snapshot");
+
+    // Opening the snapshot and reading one property is independent of
+    // the number of properties
+    const std::string name=
+	"section" + std::to_string(numProperties / 20) + ".key5";
+    runner.run("snapshot.open." + suffix, 0, 1, [&snapshotFile, &name]() {
+      ConfigurationSnapshot snapshot(snapshotFile);
+      check(snapshot.find(name).has_value(), "snapshot.open");
+    });
+    runner.run("parse.file.snapshot." + suffix, text.size(), numProperties,
+	       [&dir, &filename]() {
+      ConfigFileParser parser(false);
+      parser.setSnapshotDirectory(dir.path());
+      parser.parse(filename);
+    });
+    ::unlink(snapshotFile.c_str());
+  }
+
+  /** @brief Read every property as an integer and as a list of
+   *         integers, as a service reading its settings per request would
+   */
+  void benchTypedValues(const BenchmarkRunner& runner) {
+    const size_t PROPERTIES= 1000;
+    ConfigurationPropertyMap properties;
+    for (size_t i= 0; i < PROPERTIES; ++i) {
+      const std::string n= std::to_string(i);
+      properties.add(ConfigurationProperty("int" + n, n, "typed.conf", i));
+      properties.add(ConfigurationProperty("list" + n, n + ", 2, 3, 4",
+					   "typed.conf", i));
+    }
+
+    auto readInts= [&properties]() {
+      size_t total= 0;
+      for (auto i= properties.begin(); i != properties.end(); ++i) {
+	if (i->name()[0] == 'i') {
+	  total += i->valueAsInt();
+	}
+      }
+      check(total == PROPERTIES * (PROPERTIES - 1) / 2, "value.asInt");
+    };
+    auto readLists= [&properties]() {
+      size_t total= 0;
+      for (auto i= properties.begin(); i != properties.end(); ++i) {
+	if (i->name()[0] == 'l') {
+	  total += i->valueAsListOfInt(",").size();
+	}
+      }
+      check(total == PROPERTIES * 4, "value.asListOfInt");
+    };
+
+    // Read each value once first, so the timings and allocation counts
+    // reflect repeated reads
+    readInts();
+    readLists();
+    runner.run("value.asInt", 0, PROPERTIES, readInts);
+    runner.run("value.asListOfInt", 0, PROPERTIES, readLists);
+  }
+
+  void benchNested(const BenchmarkRunner& runner) {
+    const size_t TREES= 100;
+    const size_t DEPTH= 64;
+    const size_t PROPERTIES_PER_BLOCK= 4;
+    const size_t numProperties= TREES * DEPTH * PROPERTIES_PER_BLOCK;
+    const std::string text= nestedConfig(TREES, DEPTH, PROPERTIES_PER_BLOCK);
+
+    runner.run("parse.nested.depth64", text.size(), numProperties,
+	       [&text]() {
+      ConfigFileParser parser;
+      parser.parseBuffer("nested.conf", text.data(),
+			 text.data() + text.size());
+    });
+  }
+
+  void benchSubstitution(const BenchmarkRunner& runner) {
+    const size_t BASE= 1000;
+    const size_t DERIVED= 20000;
+    const size_t REFERENCES= 8;
+    const std::string text= substitutionConfig(BASE, DERIVED, REFERENCES);
+
+    runner.run("parse.substitution", text.size(), BASE + DERIVED,
+	       [&text]() {
+      ConfigFileParser parser;
+      parser.parseBuffer("subst.conf", text.data(),
+			 text.data() + text.size());
+    });
+
+    ConfigFileParser parser;
+    const ConfigurationPropertyMap properties=
+	parser.parseBuffer("subst.conf", text.data(),
+			   text.data() + text.size());
+    check(properties.size() == BASE + DERIVED, "parse.substitution");
+
+    const std::string value= substitutionValue(BASE, REFERENCES);
+    ValueProcessor processor(properties, false);
+    runner.run("value.processValue", value.size(), 1,
+	       [&processor, &value]() { processor.processValue(value); });
+
+    // Re-evaluating a value after its variables change, as a replay does
+    const ValueTemplate compiled= processor.compile(value);
+    runner.run("value.evaluate", value.size(), 1,
+	       [&processor, &compiled]() { processor.evaluate(compiled); });
+
+    // Most values have no escapes or references
+    const std::string plain=
+	"a value with neither escape sequences nor variable references";
+    runner.run("value.plain", plain.size(), 1,
+	       [&processor, &plain]() { processor.processValue(plain); });
+  }
+
+  void benchEnvironment(const BenchmarkRunner& runner) {
+    const size_t PROPERTIES= 10000;
+    std::ostringstream config;
+    for (size_t i= 0; i < PROPERTIES; ++i) {
+      config << "p" << i << "= ${BENCH_HOME}/p" << i << "\n";
+    }
+    const std::string text= config.str();
+    setenv("BENCH_HOME", "/home/bench", 0);
+
+    // Every value refers to the same environment variable
+    ConfigFileParser parser;
+    check(parser.parseText("env.conf", text).size() == PROPERTIES,
+	  "parse.environment");
+    runner.run("parse.environment", text.size(), PROPERTIES, [&text]() {
+      ConfigFileParser parser;
+      parser.parseBuffer("env.conf", text.data(), text.data() + text.size());
+    });
+  }
+
+  void benchContinuation(const BenchmarkRunner& runner) {
+    const size_t PROPERTIES= 10000;
+    const size_t LINES_PER_VALUE= 20;
+    const std::string text= continuationConfig(PROPERTIES, LINES_PER_VALUE);
+
+    runner.run("parse.continuation", text.size(), PROPERTIES, [&text]() {
+      ConfigFileParser parser;
+      parser.parseBuffer("continued.conf", text.data(),
+			 text.data() + text.size());
+    });
+  }
+
+  void benchIncludes(const BenchmarkRunner& runner) {
+    if (!runner.selected("parse.includes.4x4") &&
+	!runner.selected("parse.includes.4x4.threads4") &&
+	!runner.selected("parse.includes.4x4.cached") &&
+	!runner.selected("parse.includes.4x4.graph")) {
+      return;
+    }
+
+    const size_t FAN_OUT= 4;
+    const size_t DEPTH= 4;
+    const size_t PROPERTIES_PER_FILE= 50;
+    TemporaryDirectory dir;
+    const IncludeTree tree= writeIncludeTree(dir, FAN_OUT, DEPTH,
+					     PROPERTIES_PER_FILE);
+
+    ConfigFileParser parser;
+    check(parser.parse(tree.rootFile).size() == tree.numProperties,
+	  "parse.includes");
+    runner.run("parse.includes.4x4", tree.numBytes, tree.numProperties,
+	       [&tree]() {
+      ConfigFileParser parser;
+      parser.parse(tree.rootFile);
+    });
+    runner.run("parse.includes.4x4.threads4", tree.numBytes,
+	       tree.numProperties, [&tree]() {
+      ConfigFileParser parser;
+      parser.setIncludeThreads(4);
+      parser.parse(tree.rootFile);
+    });
+
+    // Reloading an unchanged tree only stats the included files
+    std::shared_ptr<IncludeFileCache> cache=
+	std::make_shared<IncludeFileCache>();
+    runner.run("parse.includes.4x4.cached", tree.numBytes,
+	       tree.numProperties, [&tree, &cache]() {
+      ConfigFileParser parser;
+      parser.setIncludeFileCache(cache);
+      parser.parse(tree.rootFile);
+    });
+
+    // With a source graph, the root file is not parsed again either
+    std::shared_ptr<SourceGraph> graph= std::make_shared<SourceGraph>();
+    runner.run("parse.includes.4x4.graph", tree.numBytes,
+	       tree.numProperties, [&tree, &graph]() {
+      ConfigFileParser parser;
+      parser.setSourceGraph(graph);
+      parser.parse(tree.rootFile);
+    });
+  }
+
+  /** @brief Check that the parser reproduces a generated corpus, then
+   *         time parsing it
+   */
+  void benchCorpus(const BenchmarkRunner& runner,
+		   const std::string& directory) {
+    Corpus corpus(directory);
+    corpus.readManifest();
+
+    ConfigFileParser parser;
+    std::vector<std::string> errors=
+	corpus.verify(parser.parse(corpus.rootPath()));
+    if (!errors.empty()) {
+      throw std::runtime_error("Corpus " + directory + " does not parse "
+			       "correctly: " + errors.front());
+    }
+
+    const std::string rootPath= corpus.rootPath();
+    runner.run("parse.corpus", corpus.numBytes(),
+	       corpus.properties().size(), [&rootPath]() {
+      ConfigFileParser parser;
+      parser.parse(rootPath);
+    });
+  }
+
+  void usage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [options]\n"
+	<< "Options:\n"
+	<< "  --quick            Skip the largest inputs and run each case "
+	<< "for less time\n"
+	<< "  --min-time=SECS    Run each case for at least SECS seconds "
+	<< "(default 1)\n"
+	<< "  --filter=TEXT      Only run cases whose names contain TEXT\n"
+	<< "  --corpus=DIR       Verify and time the corpus in DIR, "
+	<< "written by\n"
+	<< "                     config_parser_corpus, instead of the "
+	<< "built-in cases\n"
+	<< "  --help             Print this message" << std::endl;
+  }
+
+  bool parseOptions(int argc, char** argv, Options& options) {
+    options.quick= false;
+    options.minSeconds= -1.0;
+    for (int i= 1; i < argc; ++i) {
+      if (!::strcmp(argv[i], "--quick")) {
+	options.quick= true;
+      } else if (!::strncmp(argv[i], "--min-time=", 11)) {
+	options.minSeconds= ::atof(argv[i] + 11);
+      } else if (!::strncmp(argv[i], "--filter=", 9)) {
+	options.filter= argv[i] + 9;
+      } else if (!::strncmp(argv[i], "--corpus=", 9)) {
+	options.corpus= argv[i] + 9;
+      } else {
+	usage(::strcmp(argv[i], "--help") ? std::cerr : std::cout, argv[0]);
+	return false;
+      }
+    }
+    if (options.minSeconds < 0.0) {
+      options.minSeconds= options.quick ? 0.2 : 1.0;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    return 2;
+  }
+
+  try {
+    BenchmarkRunner runner(std::cout, options.minSeconds, options.filter);
+    runner.printHeader();
+
+    if (!options.corpus.empty()) {
+      benchCorpus(runner, options.corpus);
+      return 0;
+    }
+
+    std::vector<size_t> sizes{ 1000, 100000 };
+    if (!options.quick) {
+      sizes.push_back(1000000);
+    }
+    for (size_t n : sizes) {
+      benchFlat(runner, n);
+      benchLookup(runner, n);
+      benchNames(runner, n);
+    }
+    benchFile(runner, 100000);
+    benchSnapshot(runner, 100000);
+    benchTypedValues(runner);
+    benchNested(runner);
+    benchSubstitution(runner);
+    benchEnvironment(runner);
+    benchContinuation(runner);
+    benchIncludes(runner);
+  } catch(const std::exception& e) {
+    std::cerr << "Benchmark failed: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,138 @@
+/** @file CorpusGeneratorMain.cpp
+ *
+ *  Generates synthetic configuration file corpora for load testing, and
+ *  checks that the parser produces the properties listed in a corpus'
+ *  manifest.
+ */
+
+#include <pistis/config_parser/ConfigFileParser.hpp>
+#include <pistis/config_parser/bench/Corpus.hpp>
+#include <pistis/config_parser/bench/CorpusGenerator.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+using namespace pistis::config_parser;
+using namespace pistis::config_parser::bench;
+
+namespace {
+
+  void usage(std::ostream& out, const char* program) {
+    const CorpusOptions defaults;
+    out << "Usage: " << program << " generate [options] DIRECTORY\n"
+	<< "       " << program << " verify DIRECTORY\n"
+	<< "Options for generate:\n"
+	<< "  --properties=N       Total properties (default "
+	<< defaults.numProperties << ")\n"
+	<< "  --block-depth=N      Maximum block nesting depth (default "
+	<< defaults.maxBlockDepth << ")\n"
+	<< "  --references=R       Average ${name} references per value "
+	<< "(default " << defaults.referencesPerValue << ")\n"
+	<< "  --escapes=R          Average escape sequences per value "
+	<< "(default " << defaults.escapesPerValue << ")\n"
+	<< "  --continuations=P    Fraction of values continued across "
+	<< "lines (default " << defaults.continuationRate << ")\n"
+	<< "  --fan-out=N          Files included by each non-leaf file "
+	<< "(default " << defaults.includeFanOut << ")\n"
+	<< "  --include-depth=N    Levels of includes below the root file "
+	<< "(default " << defaults.includeDepth << ")\n"
+	<< "  --seed=N             Random number seed (default "
+	<< defaults.seed << ")" << std::endl;
+  }
+
+  bool optionValue(const char* arg, const char* name, const char*& value) {
+    const size_t n= ::strlen(name);
+    if (::strncmp(arg, name, n) || (arg[n] != '=')) {
+      return false;
+    }
+    value= arg + n + 1;
+    return true;
+  }
+
+  bool parseOptions(int argc, char** argv, CorpusOptions& options,
+		    std::string& directory) {
+    const char* value;
+    for (int i= 2; i < argc; ++i) {
+      if (optionValue(argv[i], "--properties", value)) {
+	options.numProperties= ::strtoull(value, nullptr, 10);
+      } else if (optionValue(argv[i], "--block-depth", value)) {
+	options.maxBlockDepth= ::strtoull(value, nullptr, 10);
+      } else if (optionValue(argv[i], "--references", value)) {
+	options.referencesPerValue= ::atof(value);
+      } else if (optionValue(argv[i], "--escapes", value)) {
+	options.escapesPerValue= ::atof(value);
+      } else if (optionValue(argv[i], "--continuations", value)) {
+	options.continuationRate= ::atof(value);
+      } else if (optionValue(argv[i], "--fan-out", value)) {
+	options.includeFanOut= ::strtoull(value, nullptr, 10);
+      } else if (optionValue(argv[i], "--include-depth", value)) {
+	options.includeDepth= ::strtoull(value, nullptr, 10);
+      } else if (optionValue(argv[i], "--seed", value)) {
+	options.seed= ::strtoull(value, nullptr, 10);
+      } else if ((argv[i][0] == '-') || !directory.empty()) {
+	return false;
+      } else {
+	directory= argv[i];
+      }
+    }
+    return !directory.empty();
+  }
+
+  int generate(const CorpusOptions& options, const std::string& directory) {
+    if ((::mkdir(directory.c_str(), 0755) < 0) && (errno != EEXIST)) {
+      std::cerr << "Cannot create " << directory << ": " << ::strerror(errno)
+		<< std::endl;
+      return 1;
+    }
+
+    CorpusGenerator generator(options);
+    Corpus corpus= generator.generate(directory);
+    std::cout << "Wrote " << corpus.properties().size() << " properties in "
+	      << corpus.files().size() << " files (" << corpus.numBytes()
+	      << " bytes) to " << directory << std::endl;
+    return 0;
+  }
+
+  int verify(const std::string& directory) {
+    Corpus corpus(directory);
+    corpus.readManifest();
+
+    ConfigFileParser parser;
+    std::vector<std::string> errors=
+	corpus.verify(parser.parse(corpus.rootPath()));
+    for (auto i= errors.begin(); i != errors.end(); ++i) {
+      std::cout << *i << "\n";
+    }
+    std::cout << corpus.properties().size() << " properties checked, "
+	      << errors.size() << " errors" << std::endl;
+    return errors.empty() ? 0 : 1;
+  }
+}
+
+int main(int argc, char** argv) {
+  const std::string command= (argc > 1) ? argv[1] : "";
+  CorpusOptions options;
+  std::string directory;
+
+  if ((command == "--help") || (command == "-h")) {
+    usage(std::cout, argv[0]);
+    return 0;
+  } else if (((command != "generate") && (command != "verify")) ||
+	     !parseOptions(argc, argv, options, directory) ||
+	     ((command == "verify") && (argc != 3))) {
+    usage(std::cerr, argv[0]);
+    return 2;
+  }
+
+  try {
+    return (command == "generate") ? generate(options, directory)
+				   : verify(directory);
+  } catch(const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,36 @@
+#include "AllocationCounter.hpp"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+using namespace pistis::config_parser::bench;
+
+namespace {
+  std::atomic<uint64_t> numAllocations(0);
+  std::atomic<uint64_t> numBytes(0);
+
+  void* allocate(size_t size) {
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    numBytes.fetch_add(size, std::memory_order_relaxed);
+    void* p= ::malloc(size ? size : 1);
+    if (!p) {
+      throw std::bad_alloc();
+    }
+    return p;
+  }
+}
+
+uint64_t AllocationCounter::allocations() {
+  return numAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::bytesAllocated() {
+  return numBytes.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* p) noexcept { ::free(p); }
+void operator delete[](void* p) noexcept { ::free(p); }
+void operator delete(void* p, size_t) noexcept { ::free(p); }
+void operator delete[](void* p, size_t) noexcept { ::free(p); }
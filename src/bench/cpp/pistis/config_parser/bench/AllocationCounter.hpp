@@ -0,0 +1,29 @@
+#ifndef __PISTIS__CONFIG_PARSER__BENCH__ALLOCATIONCOUNTER_HPP__
+#define __PISTIS__CONFIG_PARSER__BENCH__ALLOCATIONCOUNTER_HPP__
+
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace bench {
+
+      /** @brief Counts calls to the global operator new
+       *
+       *  AllocationCounter.cpp replaces the global allocation functions
+       *  for the whole program that links it, so every allocation made by
+       *  the library (std::string, std::map nodes, etc.) is counted.  The
+       *  benchmarks and config_parser_tool both link it.
+       */
+      class AllocationCounter {
+      public:
+	/** @brief Number of allocations since the program started */
+	static uint64_t allocations();
+
+	/** @brief Number of bytes requested since the program started */
+	static uint64_t bytesAllocated();
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,72 @@
+#include "BenchmarkRunner.hpp"
+#include "AllocationCounter.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace pistis::config_parser::bench;
+
+BenchmarkRunner::BenchmarkRunner(std::ostream& out, double minSeconds,
+				 const std::string& filter):
+    out_(out), minSeconds_(minSeconds), filter_(filter) {
+  // Intentionally left blank
+}
+
+bool BenchmarkRunner::selected(const std::string& name) const {
+  return filter_.empty() || (name.find(filter_) != std::string::npos);
+}
+
+void BenchmarkRunner::printHeader() const {
+  out_ << std::left << std::setw(32) << "benchmark" << std::right
+       << std::setw(8) << "iters" << std::setw(12) << "ms/iter"
+       << std::setw(12) << "MB/s" << std::setw(14) << "props/s"
+       << std::setw(14) << "allocs/prop" << std::setw(12) << "bytes/prop"
+       << std::endl;
+}
+
+void BenchmarkRunner::run(const std::string& name, size_t bytes,
+			  size_t properties,
+			  const std::function<void ()>& body) const {
+  typedef std::chrono::steady_clock Clock;
+
+  if (!selected(name)) {
+    return;
+  }
+
+  // Warm up caches and the page cache for file-based cases, and
+  // count the allocations made by a single call
+  const uint64_t allocationsBefore= AllocationCounter::allocations();
+  const uint64_t bytesBefore= AllocationCounter::bytesAllocated();
+  body();
+  const uint64_t allocations=
+      AllocationCounter::allocations() - allocationsBefore;
+  const uint64_t allocatedBytes=
+      AllocationCounter::bytesAllocated() - bytesBefore;
+
+  size_t iterations= 0;
+  const Clock::time_point start= Clock::now();
+  double elapsed= 0.0;
+  do {
+    body();
+    ++iterations;
+    elapsed= std::chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < minSeconds_);
+
+  const double perIteration= elapsed / iterations;
+  out_ << std::left << std::setw(32) << name << std::right << std::fixed
+       << std::setw(8) << iterations
+       << std::setw(12) << std::setprecision(3) << (perIteration * 1000.0)
+       << std::setw(12) << std::setprecision(1);
+  if (bytes) {
+    out_ << (bytes / perIteration / (1024.0 * 1024.0));
+  } else {
+    // Case does not process configuration text
+    out_ << "-";
+  }
+  out_ << std::setw(14) << std::setprecision(0)
+       << (properties / perIteration)
+       << std::setw(14) << std::setprecision(2)
+       << (properties ? (double)allocations / properties : 0.0)
+       << std::setw(12) << std::setprecision(1)
+       << (properties ? (double)allocatedBytes / properties : 0.0)
+       << std::endl;
+}
@@ -0,0 +1,55 @@
+#ifndef __PISTIS__CONFIG_PARSER__BENCH__BENCHMARKRUNNER_HPP__
+#define __PISTIS__CONFIG_PARSER__BENCH__BENCHMARKRUNNER_HPP__
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace bench {
+
+      /** @brief Times benchmark cases and prints one row per case
+       *
+       *  Each case is run once to warm up, then repeatedly until at least
+       *  minSeconds() have elapsed.  The report gives throughput in MB/s
+       *  of configuration text, properties per second, and the heap
+       *  allocations and bytes allocated per property.
+       */
+      class BenchmarkRunner {
+      public:
+	BenchmarkRunner(std::ostream& out, double minSeconds= 1.0,
+			const std::string& filter= std::string());
+
+	double minSeconds() const { return minSeconds_; }
+	const std::string& filter() const { return filter_; }
+
+	/** @brief True if a case named @c name passes the filter */
+	bool selected(const std::string& name) const;
+
+	/** @brief Print the column headings */
+	void printHeader() const;
+
+	/** @brief Time @c body and print its results
+	 *
+	 *  @param name        Name of the benchmark case
+	 *  @param bytes       Bytes of configuration text @c body
+	 *                       processes per call
+	 *  @param properties  Properties @c body produces per call
+	 *  @param body        Code to time
+	 */
+	void run(const std::string& name, size_t bytes, size_t properties,
+		 const std::function<void ()>& body) const;
+
+      private:
+	std::ostream& out_;
+	double minSeconds_;
+	std::string filter_;
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,183 @@
+#include "Corpus.hpp"
+#include <pistis/filesystem/Path.hpp>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <stdlib.h>
+
+using namespace pistis::config_parser;
+using namespace pistis::config_parser::bench;
+namespace path = pistis::filesystem::path;
+
+namespace {
+  const std::string MAGIC("pistis-config-corpus 1");
+
+  std::string encode(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (char ch : text) {
+      switch (ch) {
+	case '\\': result += "\\\\"; break;
+	case '\t': result += "\\t"; break;
+	case '\n': result += "\\n"; break;
+	case '\r': result += "\\r"; break;
+	default:   result.push_back(ch); break;
+      }
+    }
+    return result;
+  }
+
+  std::string decode(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (auto i= text.begin(); i != text.end(); ++i) {
+      if ((*i != '\\') || ((i + 1) == text.end())) {
+	result.push_back(*i);
+      } else {
+	switch (*++i) {
+	  case 't': result.push_back('\t'); break;
+	  case 'n': result.push_back('\n'); break;
+	  case 'r': result.push_back('\r'); break;
+	  default:  result.push_back(*i); break;
+	}
+      }
+    }
+    return result;
+  }
+
+  std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start= 0;
+    while (true) {
+      size_t tab= line.find('\t', start);
+      fields.push_back(line.substr(start, tab - start));
+      if (tab == std::string::npos) {
+	return fields;
+      }
+      start= tab + 1;
+    }
+  }
+
+  std::runtime_error manifestError(int line, const std::string& msg) {
+    std::ostringstream text;
+    text << Corpus::MANIFEST_NAME << ":" << line << ": " << msg;
+    return std::runtime_error(text.str());
+  }
+}
+
+const std::string Corpus::MANIFEST_NAME("MANIFEST");
+
+Corpus::Corpus():
+    directory_(), rootFile_(), files_(), numBytes_(0), properties_() {
+  // Intentionally left blank
+}
+
+Corpus::Corpus(const std::string& directory):
+    directory_(directory), rootFile_(), files_(), numBytes_(0),
+    properties_() {
+  // Intentionally left blank
+}
+
+std::string Corpus::rootPath() const {
+  return path::join(directory_, rootFile_);
+}
+
+void Corpus::addFile(const std::string& name, size_t numBytes) {
+  files_.push_back(CorpusFile{ name, numBytes });
+  numBytes_ += numBytes;
+}
+
+void Corpus::readManifest() {
+  const std::string filename= path::join(directory_, MANIFEST_NAME);
+  std::ifstream input(filename);
+  if (!input) {
+    throw std::runtime_error("Cannot open " + filename);
+  }
+  readManifest(input);
+}
+
+void Corpus::writeManifest() const {
+  const std::string filename= path::join(directory_, MANIFEST_NAME);
+  std::ofstream output(filename);
+  writeManifest(output);
+  output.close();
+  if (!output) {
+    throw std::runtime_error("Cannot write " + filename);
+  }
+}
+
+void Corpus::readManifest(std::istream& input) {
+  std::string line;
+  int lineNumber= 1;
+
+  if (!std::getline(input, line) || (line != MAGIC)) {
+    throw manifestError(lineNumber, "Not a corpus manifest");
+  }
+
+  rootFile_.clear();
+  files_.clear();
+  numBytes_= 0;
+  properties_.clear();
+  while (std::getline(input, line)) {
+    ++lineNumber;
+    std::vector<std::string> fields= splitFields(line);
+    if ((fields[0] == "root") && (fields.size() == 2)) {
+      rootFile_= fields[1];
+    } else if ((fields[0] == "file") && (fields.size() == 3)) {
+      addFile(fields[1], ::strtoull(fields[2].c_str(), nullptr, 10));
+    } else if ((fields[0] == "property") && (fields.size() == 5)) {
+      addProperty(ExpectedProperty{ fields[1], decode(fields[4]), fields[2],
+				    ::atoi(fields[3].c_str()) });
+    } else if (!line.empty()) {
+      throw manifestError(lineNumber, "Malformed entry");
+    }
+  }
+  if (rootFile_.empty()) {
+    throw manifestError(lineNumber, "No root file");
+  }
+}
+
+void Corpus::writeManifest(std::ostream& output) const {
+  output << MAGIC << "\n" << "root\t" << rootFile_ << "\n";
+  for (auto i= files_.begin(); i != files_.end(); ++i) {
+    output << "file\t" << i->name << "\t" << i->numBytes << "\n";
+  }
+  for (auto i= properties_.begin(); i != properties_.end(); ++i) {
+    output << "property\t" << i->name << "\t" << i->source << "\t"
+	   << i->line << "\t" << encode(i->value) << "\n";
+  }
+}
+
+std::vector<std::string> Corpus::verify(
+    const ConfigurationPropertyMap& properties
+) const {
+  std::vector<std::string> errors;
+
+  for (auto i= properties_.begin(); i != properties_.end(); ++i) {
+    if (!properties.hasKey(i->name)) {
+      errors.push_back("Property \"" + i->name + "\" is missing");
+      continue;
+    }
+
+    const ConfigurationProperty& p= properties[i->name];
+    const std::string source= path::join(directory_, i->source);
+    if (p.value() != i->value) {
+      errors.push_back("Property \"" + i->name + "\" has value \"" +
+		       encode(p.value()) + "\" instead of \"" +
+		       encode(i->value) + "\"");
+    }
+    if ((p.source() != source) || (p.line() != i->line)) {
+      std::ostringstream msg;
+      msg << "Property \"" << i->name << "\" is defined at " << p.source()
+	  << ":" << p.line() << " instead of " << source << ":" << i->line;
+      errors.push_back(msg.str());
+    }
+  }
+  if (properties.size() > properties_.size()) {
+    std::ostringstream msg;
+    msg << "Parser produced " << properties.size() << " properties; "
+	<< properties_.size() << " were expected";
+    errors.push_back(msg.str());
+  }
+  return errors;
+}
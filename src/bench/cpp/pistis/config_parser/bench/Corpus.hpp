@@ -0,0 +1,110 @@
+#ifndef __PISTIS__CONFIG_PARSER__BENCH__CORPUS_HPP__
+#define __PISTIS__CONFIG_PARSER__BENCH__CORPUS_HPP__
+
+#include <pistis/config_parser/ConfigurationPropertyMap.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace bench {
+
+      /** @brief A property the parser should produce from a corpus */
+      struct ExpectedProperty {
+	std::string name;    ///< Full name, including block prefixes
+	std::string value;   ///< Value after escapes and substitutions
+	std::string source;  ///< File that defines it, relative to the
+			     ///<   corpus directory
+	int line;            ///< Line of the property's name
+      };
+
+      /** @brief A configuration file in a corpus */
+      struct CorpusFile {
+	std::string name;  ///< Relative to the corpus directory
+	size_t numBytes;
+      };
+
+      /** @brief A set of configuration files and the properties parsing
+       *         them should produce.
+       *
+       *  A corpus lives in a directory that contains the configuration
+       *  files and a manifest named MANIFEST.  The manifest is a text file
+       *  whose first line is "pistis-config-corpus 1".  Each following
+       *  line holds tab-separated fields:
+       *  <code>
+       *    root      FILE
+       *    file      FILE  BYTES
+       *    property  NAME  SOURCE  LINE  VALUE
+       *  </code>
+       *  VALUE escapes backslash, tab, newline and carriage return as
+       *  "\\", "\t", "\n" and "\r".
+       */
+      class Corpus {
+      public:
+	static const std::string MANIFEST_NAME;
+
+      public:
+	Corpus();
+	Corpus(const std::string& directory);
+
+	/** @brief Directory containing the corpus' files */
+	const std::string& directory() const { return directory_; }
+	void setDirectory(const std::string& directory) {
+	  directory_= directory;
+	}
+
+	/** @brief Name of the file to parse, relative to directory() */
+	const std::string& rootFile() const { return rootFile_; }
+	void setRootFile(const std::string& name) { rootFile_= name; }
+
+	/** @brief Full path of the file to parse */
+	std::string rootPath() const;
+
+	const std::vector<CorpusFile>& files() const { return files_; }
+	size_t numBytes() const { return numBytes_; }
+	void addFile(const std::string& name, size_t numBytes);
+
+	const std::vector<ExpectedProperty>& properties() const {
+	  return properties_;
+	}
+	void addProperty(ExpectedProperty&& p) {
+	  properties_.push_back(std::move(p));
+	}
+
+	/** @brief Read directory()/MANIFEST
+	 *
+	 *  @throws std::runtime_error if the manifest cannot be read or
+	 *          is malformed.
+	 */
+	void readManifest();
+
+	/** @brief Write directory()/MANIFEST */
+	void writeManifest() const;
+
+	void readManifest(std::istream& input);
+	void writeManifest(std::ostream& output) const;
+
+	/** @brief Compare @c properties, the result of parsing
+	 *         rootPath(), with the expected properties
+	 *
+	 *  @returns One message per discrepancy; empty if the parse
+	 *           result matches the manifest exactly
+	 */
+	std::vector<std::string> verify(
+	    const ConfigurationPropertyMap& properties
+	) const;
+
+      private:
+	std::string directory_;
+	std::string rootFile_;
+	std::vector<CorpusFile> files_;
+	size_t numBytes_;
+	std::vector<ExpectedProperty> properties_;
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,262 @@
+#include "CorpusGenerator.hpp"
+#include <pistis/filesystem/Path.hpp>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace pistis::config_parser::bench;
+namespace path = pistis::filesystem::path;
+
+namespace {
+  const char* const WORDS[]= {
+    "server", "client", "cache", "log", "database", "pool", "retry",
+    "timeout", "path", "limit", "user", "queue", "host", "port", "level",
+    "buffer"
+  };
+  const size_t NUM_WORDS= sizeof(WORDS) / sizeof(WORDS[0]);
+
+  // Escape sequences as written in a value and what they become
+  const std::pair<const char*, const char*> ESCAPES[]= {
+    { "\\n", "\n" }, { "\\t", "\t" }, { "\\\\", "\\" }, { "\\$", "$" },
+    { "\\u{263a}", "\xe2\x98\xba" }, { "\\u{e9}", "\xc3\xa9" },
+    { "\\u00e9", "\xc3\xa9" }
+  };
+  const size_t NUM_ESCAPES= sizeof(ESCAPES) / sizeof(ESCAPES[0]);
+
+  // How often the generator opens or closes a block before an assignment
+  const double BLOCK_RATE= 0.1;
+
+  // How often the generator writes a comment or blank line
+  const double COMMENT_RATE= 0.05;
+
+  // Part of a value, as written in the file and as the parser returns it
+  struct ValuePiece {
+    std::string text;
+    std::string expected;
+  };
+}
+
+/** @brief Accumulates the text of one file of the corpus */
+class CorpusGenerator::FileWriter {
+public:
+  FileWriter(const std::string& name):
+      name_(name), text_(), line_(1), blocks_(), prefix_(), defined_() {
+    // Intentionally left blank
+  }
+
+  const std::string& text() const { return text_; }
+  size_t blockDepth() const { return blocks_.size(); }
+
+  const ExpectedProperty* defined(size_t i) const {
+    return &defined_[i];
+  }
+  size_t numDefined() const { return defined_.size(); }
+
+  void writeLine(const std::string& line) {
+    text_.append(blocks_.size() * 2, ' ').append(line).push_back('\n');
+    ++line_;
+  }
+
+  void beginBlock(const std::string& name) {
+    writeLine(name + " {");
+    blocks_.push_back(prefix_.size());
+    prefix_.append(name).push_back('.');
+  }
+
+  void endBlock() {
+    prefix_.erase(blocks_.back());
+    blocks_.pop_back();
+    writeLine("}");
+  }
+
+  void endAllBlocks() {
+    while (!blocks_.empty()) {
+      endBlock();
+    }
+  }
+
+  /** @brief Write an assignment whose value is @c pieces separated by
+   *         spaces, continuing onto a new line after each piece whose
+   *         index is in @c breaks
+   */
+  ExpectedProperty assign(const std::string& name,
+			  const std::vector<ValuePiece>& pieces,
+			  const std::vector<size_t>& breaks) {
+    const std::string indent(blocks_.size() * 2, ' ');
+    ExpectedProperty p{ prefix_ + name, std::string(), name_, line_ };
+
+    text_.append(indent).append(name).append(" = ");
+    for (size_t i= 0; i < pieces.size(); ++i) {
+      text_ += pieces[i].text;
+      p.value += pieces[i].expected;
+      if ((i + 1) == pieces.size()) {
+	text_.push_back('\n');
+	++line_;
+      } else if (std::find(breaks.begin(), breaks.end(), i) != breaks.end()) {
+	// The lexer keeps everything before the backslash and all of the
+	// next line, joining them with a newline
+	text_.append(" \\\n").append(indent).append("  ");
+	p.value.append(" \n").append(indent).append("  ");
+	++line_;
+      } else {
+	text_.push_back(' ');
+	p.value.push_back(' ');
+      }
+    }
+    defined_.push_back(p);
+    return p;
+  }
+
+private:
+  std::string name_;
+  std::string text_;
+  int line_;
+  std::vector<size_t> blocks_;  ///< Length of prefix_ before each block
+  std::string prefix_;
+  std::vector<ExpectedProperty> defined_;
+};
+
+CorpusGenerator::CorpusGenerator(const CorpusOptions& options):
+    options_(options), random_(options.seed), propertiesPerFile_(0),
+    extraProperties_(0), nameCounter_(0) {
+  // Intentionally left blank
+}
+
+Corpus CorpusGenerator::generate(const std::string& directory) {
+  Corpus corpus(directory);
+  size_t nextFile= 0;
+
+  random_.seed(options_.seed);
+  nameCounter_= 0;
+  propertiesPerFile_= options_.numProperties / numFiles_();
+  extraProperties_= options_.numProperties % numFiles_();
+
+  writeFile_(corpus, 0, nextFile);
+  corpus.writeManifest();
+  return corpus;
+}
+
+size_t CorpusGenerator::numFiles_() const {
+  size_t total= 1;
+  size_t level= 1;
+  for (size_t d= 0; d < options_.includeDepth; ++d) {
+    level *= options_.includeFanOut;
+    total += level;
+  }
+  return total;
+}
+
+void CorpusGenerator::writeFile_(Corpus& corpus, size_t depth,
+				 size_t& nextFile) {
+  const size_t fileIndex= nextFile++;
+  const std::string name=
+      fileIndex ? "include_" + std::to_string(fileIndex) + ".conf"
+		: std::string("root.conf");
+  const size_t numIncludes=
+      (depth < options_.includeDepth) ? options_.includeFanOut : 0;
+  const size_t numProperties=
+      propertiesPerFile_ + (fileIndex ? 0 : extraProperties_);
+  FileWriter file(name);
+
+  if (!fileIndex) {
+    corpus.setRootFile(name);
+  }
+  file.writeLine("# Generated configuration file " + name);
+
+  // Spread the includes evenly between runs of assignments.  Includes
+  // are not allowed inside blocks, so close them first.
+  for (size_t chunk= 0; chunk <= numIncludes; ++chunk) {
+    if (chunk) {
+      const std::string child= "include_" + std::to_string(nextFile) +
+			       ".conf";
+      writeFile_(corpus, depth + 1, nextFile);
+      file.writeLine("include \"" + child + "\"");
+    }
+
+    const size_t begin= numProperties * chunk / (numIncludes + 1);
+    const size_t end= numProperties * (chunk + 1) / (numIncludes + 1);
+    for (size_t i= begin; i < end; ++i) {
+      if (chance_(COMMENT_RATE)) {
+	file.writeLine(chance_(0.5) ? std::string()
+				    : "# Comment before property " +
+					  std::to_string(i));
+      }
+      if (file.blockDepth() && chance_(BLOCK_RATE)) {
+	file.endBlock();
+      } else if ((file.blockDepth() < options_.maxBlockDepth) &&
+		 chance_(BLOCK_RATE)) {
+	file.beginBlock(nextName_());
+      }
+
+      std::vector<ValuePiece> pieces;
+      const size_t numWords= 2 + pick_(4);
+      for (size_t w= 0; w < numWords; ++w) {
+	std::string word= WORDS[pick_(NUM_WORDS)];
+	if (chance_(0.3)) {
+	  word += std::to_string(pick_(100000));
+	}
+	pieces.push_back(ValuePiece{ word, word });
+      }
+
+      // References and escapes go anywhere except the ends, so values
+      // never begin or end with whitespace produced by an escape
+      const size_t numReferences=
+	  file.numDefined() ? count_(options_.referencesPerValue) : 0;
+      for (size_t r= 0; r < numReferences; ++r) {
+	const ExpectedProperty* target=
+	    file.defined(pick_(file.numDefined()));
+	pieces.insert(pieces.begin() + 1 + pick_(pieces.size() - 1),
+		      ValuePiece{ "${" + target->name + "}",
+				  target->value });
+      }
+      const size_t numEscapes= count_(options_.escapesPerValue);
+      for (size_t e= 0; e < numEscapes; ++e) {
+	const auto& escape= ESCAPES[pick_(NUM_ESCAPES)];
+	pieces.insert(pieces.begin() + 1 + pick_(pieces.size() - 1),
+		      ValuePiece{ escape.first, escape.second });
+      }
+
+      std::vector<size_t> breaks;
+      if (chance_(options_.continuationRate)) {
+	const size_t numBreaks= 1 + pick_(std::min(pieces.size() - 1,
+						   (size_t)3));
+	for (size_t b= 0; b < numBreaks; ++b) {
+	  breaks.push_back(pick_(pieces.size() - 1));
+	}
+      }
+
+      corpus.addProperty(file.assign(nextName_(), pieces, breaks));
+    }
+    file.endAllBlocks();
+  }
+
+  const std::string filename= path::join(corpus.directory(), name);
+  std::ofstream output(filename);
+  output << file.text();
+  output.close();
+  if (!output) {
+    throw std::runtime_error("Cannot write " + filename);
+  }
+  corpus.addFile(name, file.text().size());
+}
+
+size_t CorpusGenerator::count_(double average) {
+  const size_t whole= (size_t)average;
+  return whole + (chance_(average - whole) ? 1 : 0);
+}
+
+bool CorpusGenerator::chance_(double probability) {
+  return std::uniform_real_distribution<double>(0.0, 1.0)(random_) <
+	 probability;
+}
+
+size_t CorpusGenerator::pick_(size_t n) {
+  return std::uniform_int_distribution<size_t>(0, n - 1)(random_);
+}
+
+std::string CorpusGenerator::nextName_() {
+  return std::string(WORDS[pick_(NUM_WORDS)]) + "_" +
+	 std::to_string(nameCounter_++);
+}
@@ -0,0 +1,90 @@
+#ifndef __PISTIS__CONFIG_PARSER__BENCH__CORPUSGENERATOR_HPP__
+#define __PISTIS__CONFIG_PARSER__BENCH__CORPUSGENERATOR_HPP__
+
+#include <pistis/config_parser/bench/Corpus.hpp>
+#include <random>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace bench {
+
+      /** @brief Controls the size and shape of a generated corpus */
+      struct CorpusOptions {
+	/** @brief Total properties across all files */
+	size_t numProperties= 10000;
+
+	/** @brief Maximum nesting depth of blocks.  Zero disables
+	 *         blocks.
+	 */
+	size_t maxBlockDepth= 3;
+
+	/** @brief Average number of "${name}" references per value */
+	double referencesPerValue= 0.2;
+
+	/** @brief Average number of escape sequences per value */
+	double escapesPerValue= 0.1;
+
+	/** @brief Fraction of values continued across multiple lines
+	 *         with backslashes
+	 */
+	double continuationRate= 0.05;
+
+	/** @brief Number of files each non-leaf file includes */
+	size_t includeFanOut= 0;
+
+	/** @brief Number of levels of includes below the root file */
+	size_t includeDepth= 0;
+
+	/** @brief Seed for the random number generator.  The same seed
+	 *         and options always produce the same corpus.
+	 */
+	uint64_t seed= 1;
+      };
+
+      /** @brief Writes a corpus of configuration files with the shape
+       *         given by a CorpusOptions and computes the properties the
+       *         parser should produce from it.
+       *
+       *  Property names are unique across the corpus, and "${name}"
+       *  references only name properties defined earlier in the same
+       *  file, so the expected value of every property is independent
+       *  of the parser's duplicate property settings.
+       */
+      class CorpusGenerator {
+      public:
+	CorpusGenerator(const CorpusOptions& options);
+	CorpusGenerator(const CorpusGenerator&) = delete;
+
+	const CorpusOptions& options() const { return options_; }
+
+	/** @brief Write the corpus and its manifest into @c directory,
+	 *         which must already exist.
+	 */
+	Corpus generate(const std::string& directory);
+
+	CorpusGenerator& operator=(const CorpusGenerator&) = delete;
+
+      private:
+	class FileWriter;
+
+	size_t numFiles_() const;
+	void writeFile_(Corpus& corpus, size_t depth, size_t& nextFile);
+	size_t count_(double average);
+	bool chance_(double probability);
+	size_t pick_(size_t n);
+	std::string nextName_();
+
+	CorpusOptions options_;
+	std::mt19937_64 random_;
+	size_t propertiesPerFile_;
+	size_t extraProperties_;
+	size_t nameCounter_;
+      };
+
+    }
+  }
+}
+#endif
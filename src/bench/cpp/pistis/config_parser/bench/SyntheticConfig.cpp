@@ -0,0 +1,164 @@
+#include "SyntheticConfig.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser::bench;
+
+namespace {
+  void writeFileProperties(std::ostream& out, size_t file,
+			   size_t numProperties) {
+    for (size_t i= 0; i < numProperties; ++i) {
+      out << "file" << file << ".key" << i << " = value " << i
+	  << " from file " << file << "\n";
+    }
+  }
+
+  size_t writeIncludeFile(TemporaryDirectory& dir, size_t fanOut,
+			  size_t depth, size_t propertiesPerFile,
+			  size_t& nextFile, IncludeTree& tree) {
+    const size_t file= nextFile++;
+    std::ostringstream text;
+
+    text << "# Include tree file " << file << "\n";
+    if (depth) {
+      for (size_t i= 0; i < fanOut; ++i) {
+	const size_t child= writeIncludeFile(dir, fanOut, depth - 1,
+					     propertiesPerFile, nextFile,
+					     tree);
+	text << "include \"file" << child << ".conf\"\n";
+      }
+    }
+    writeFileProperties(text, file, propertiesPerFile);
+
+    const std::string contents= text.str();
+    const std::string filename= dir.writeFile(
+	"file" + std::to_string(file) + ".conf", contents
+    );
+    if (!file) {
+      tree.rootFile= filename;
+    }
+    ++tree.numFiles;
+    tree.numBytes += contents.size();
+    tree.numProperties += propertiesPerFile;
+    return file;
+  }
+}
+
+std::string pistis::config_parser::bench::flatConfig(size_t numProperties) {
+  std::ostringstream text;
+  text << "# Flat configuration with " << numProperties << " properties\n";
+  for (size_t i= 0; i < numProperties; ++i) {
+    text << "section" << (i / 10) << ".key" << (i % 10) << " = value "
+	 << i << "\n";
+  }
+  return text.str();
+}
+
+std::string pistis::config_parser::bench::nestedConfig(
+    size_t numTrees, size_t depth, size_t propertiesPerBlock
+) {
+  std::ostringstream text;
+  for (size_t t= 0; t < numTrees; ++t) {
+    for (size_t d= 0; d < depth; ++d) {
+      text << std::string(d * 2, ' ') << "block" << t << "_" << d
+	   << " {\n";
+      for (size_t i= 0; i < propertiesPerBlock; ++i) {
+	text << std::string(d * 2 + 2, ' ') << "key" << i << " = value "
+	     << i << "\n";
+      }
+    }
+    for (size_t d= depth; d > 0; --d) {
+      text << std::string((d - 1) * 2, ' ') << "}\n";
+    }
+  }
+  return text.str();
+}
+
+std::string pistis::config_parser::bench::substitutionValue(
+    size_t numBase, size_t referencesPerValue
+) {
+  std::ostringstream text;
+  for (size_t r= 0; r < referencesPerValue; ++r) {
+    text << "${base.key" << ((r * 7919) % numBase) << "}/\\t";
+  }
+  text << "\\u{263a}";
+  return text.str();
+}
+
+std::string pistis::config_parser::bench::substitutionConfig(
+    size_t numBase, size_t numProperties, size_t referencesPerValue
+) {
+  std::ostringstream text;
+  for (size_t i= 0; i < numBase; ++i) {
+    text << "base.key" << i << " = base value " << i << "\n";
+  }
+  for (size_t i= 0; i < numProperties; ++i) {
+    text << "derived.key" << i << " = ";
+    for (size_t r= 0; r < referencesPerValue; ++r) {
+      text << "${base.key" << ((i + r * 7919) % numBase) << "}/";
+    }
+    text << "\\tend\n";
+  }
+  return text.str();
+}
+
+std::string pistis::config_parser::bench::continuationConfig(
+    size_t numProperties, size_t linesPerValue
+) {
+  std::ostringstream text;
+  for (size_t i= 0; i < numProperties; ++i) {
+    text << "long.key" << i << " = ";
+    for (size_t l= 1; l < linesPerValue; ++l) {
+      text << "segment " << l << " of a long value that is continued \\\n"
+	   << "    ";
+    }
+    text << "last segment\n";
+  }
+  return text.str();
+}
+
+TemporaryDirectory::TemporaryDirectory(): path_(), files_() {
+  const char* tmpdir= ::getenv("TMPDIR");
+  std::string pattern= std::string(tmpdir ? tmpdir : "/tmp") +
+		       "/config_parser_bench_XXXXXX";
+  if (!::mkdtemp(&pattern[0])) {
+    throw std::runtime_error("Cannot create temporary directory " +
+			     pattern + ": " + ::strerror(errno));
+  }
+  path_= pattern;
+}
+
+TemporaryDirectory::~TemporaryDirectory() {
+  for (auto i= files_.begin(); i != files_.end(); ++i) {
+    ::unlink(i->c_str());
+  }
+  ::rmdir(path_.c_str());
+}
+
+std::string TemporaryDirectory::writeFile(const std::string& name,
+					  const std::string& text) {
+  const std::string filename= path_ + "/" + name;
+  std::ofstream out(filename);
+  out << text;
+  out.close();
+  if (!out) {
+    throw std::runtime_error("Cannot write " + filename);
+  }
+  files_.push_back(filename);
+  return filename;
+}
+
+IncludeTree pistis::config_parser::bench::writeIncludeTree(
+    TemporaryDirectory& dir, size_t fanOut, size_t depth,
+    size_t propertiesPerFile
+) {
+  IncludeTree tree{ std::string(), 0, 0, 0 };
+  size_t nextFile= 0;
+  writeIncludeFile(dir, fanOut, depth, propertiesPerFile, nextFile, tree);
+  return tree;
+}
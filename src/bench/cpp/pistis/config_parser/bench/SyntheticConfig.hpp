@@ -0,0 +1,101 @@
+#ifndef __PISTIS__CONFIG_PARSER__BENCH__SYNTHETICCONFIG_HPP__
+#define __PISTIS__CONFIG_PARSER__BENCH__SYNTHETICCONFIG_HPP__
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace bench {
+
+      /** @brief Generators for the configuration text used by the
+       *         benchmarks.
+       *
+       *  Every generator is deterministic and produces text that parses
+       *  without errors.  Property names are unique, so the number of
+       *  properties in the parsed result is always known in advance.
+       */
+
+      /** @brief @c numProperties assignments, grouped ten to a section
+       *         using dotted names.
+       */
+      std::string flatConfig(size_t numProperties);
+
+      /** @brief Blocks nested @c depth deep with @c propertiesPerBlock
+       *         assignments at each level, repeated @c numTrees times.
+       *
+       *  Produces numTrees * depth * propertiesPerBlock properties.
+       */
+      std::string nestedConfig(size_t numTrees, size_t depth,
+			       size_t propertiesPerBlock);
+
+      /** @brief @c numBase plain properties followed by @c numProperties
+       *         properties whose values each contain
+       *         @c referencesPerValue "${...}" substitutions of earlier
+       *         properties.
+       */
+      std::string substitutionConfig(size_t numBase, size_t numProperties,
+				     size_t referencesPerValue);
+
+      /** @brief Text of a single value that contains
+       *         @c referencesPerValue substitutions of the properties
+       *         written by substitutionConfig(), plus escape sequences.
+       */
+      std::string substitutionValue(size_t numBase,
+				    size_t referencesPerValue);
+
+      /** @brief @c numProperties values, each continued with backslashes
+       *         across @c linesPerValue lines
+       */
+      std::string continuationConfig(size_t numProperties,
+				     size_t linesPerValue);
+
+      /** @brief A directory that is removed along with the files written
+       *         to it when the TemporaryDirectory is destroyed.
+       */
+      class TemporaryDirectory {
+      public:
+	TemporaryDirectory();
+	TemporaryDirectory(const TemporaryDirectory&) = delete;
+	~TemporaryDirectory();
+
+	const std::string& path() const { return path_; }
+
+	/** @brief Write @c text to the file @c name in this directory
+	 *
+	 *  @returns The full path to the file
+	 */
+	std::string writeFile(const std::string& name,
+			      const std::string& text);
+
+	TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+      private:
+	std::string path_;
+	std::vector<std::string> files_;
+      };
+
+      /** @brief Shape and size of an include tree written by
+       *         writeIncludeTree()
+       */
+      struct IncludeTree {
+	std::string rootFile;   ///< File to pass to the parser
+	size_t numFiles;        ///< Files in the tree, including the root
+	size_t numBytes;        ///< Total size of all files in the tree
+	size_t numProperties;   ///< Properties defined by all files
+      };
+
+      /** @brief Write a tree of files into @c dir where each file that is
+       *         not a leaf includes @c fanOut other files, down to
+       *         @c depth levels below the root.
+       *
+       *  Each file defines @c propertiesPerFile properties of its own.
+       */
+      IncludeTree writeIncludeTree(TemporaryDirectory& dir, size_t fanOut,
+				   size_t depth, size_t propertiesPerFile);
+
+    }
+  }
+}
+#endif
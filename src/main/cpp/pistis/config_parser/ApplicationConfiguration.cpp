@@ -9,6 +9,23 @@
 using namespace pistis::util;
 using namespace pistis::config_parser;
 
+/** @brief Passes the properties of a streaming load to their handlers */
+class ApplicationConfiguration::Dispatcher : public ConfigurationHandler {
+public:
+  Dispatcher(ApplicationConfiguration& configuration):
+      configuration_(configuration) {
+    // Intentionally left blank
+  }
+
+  virtual void onProperty(const std::string& name, const std::string& value,
+			  const std::string& source, int line) override {
+    configuration_.dispatch_(ConfigurationProperty(name, value, source, line));
+  }
+
+private:
+  ApplicationConfiguration& configuration_;
+};
+
 ApplicationConfiguration::ApplicationConfiguration(
     bool ignoreUnknownProperties, bool useEnvironmentVars,
     ConfigFileParser::DuplicatePropertyMode duplicatePropertyAction,
@@ -17,7 +34,10 @@ ApplicationConfiguration::ApplicationConfiguration(
     ignoreUnknownProperties_(ignoreUnknownProperties),
     useEnvironmentVars_(useEnvironmentVars),
     duplicatePropertyAction_(duplicatePropertyAction),
-    includedPropertyAction_(includedPropertyAction) {
+    includedPropertyAction_(includedPropertyAction), includeThreads_(0),
+    referenceResolution_(ConfigFileParser::RESOLVE_IN_ORDER),
+    environmentProvider_(EnvironmentProvider::process()), includeFileCache_(),
+    sourceGraph_(), snapshotDirectory_(), inputFiles_() {
   // Intentionally left blank
 }
 
@@ -26,17 +46,17 @@ ApplicationConfiguration::~ApplicationConfiguration() {
 }
 
 void ApplicationConfiguration::load(const std::string& filename) {
-  ConfigFileParser parser(useEnvironmentVars_, duplicatePropertyAction_,
-			  includedPropertyAction_);
+  ConfigFileParser parser= makeParser_();
   ConfigurationPropertyMap properties = parser.parse(filename);
   load_(filename, properties);
+  inputFiles_.insert(inputFiles_.end(), parser.inputFiles().begin(),
+		     parser.inputFiles().end());
 }
 
 void ApplicationConfiguration::load(const std::string& sourceName,
 				    std::istream& input, int initialLine,
 				    int initialColumn) {
-  ConfigFileParser parser(useEnvironmentVars_, duplicatePropertyAction_,
-			  includedPropertyAction_);
+  ConfigFileParser parser= makeParser_();
   ConfigurationPropertyMap properties =
       parser.parse(sourceName, input, initialLine, initialColumn);
   load_(sourceName, properties);
@@ -44,16 +64,171 @@ void ApplicationConfiguration::load(const std::string& sourceName,
 
 void ApplicationConfiguration::loadFromText(const std::string& sourceName,
 					    const std::string& text) {
-  ConfigFileParser parser(useEnvironmentVars_, duplicatePropertyAction_,
-			  includedPropertyAction_);
+  ConfigFileParser parser= makeParser_();
   ConfigurationPropertyMap properties = parser.parseText(sourceName, text);
   load_(sourceName, properties);
 }
 
+void ApplicationConfiguration::load(
+    const std::string& filename, ApplicationConfigurationErrorList& errors
+) {
+  ConfigFileParser parser= makeParser_();
+  ConfigurationPropertyMap properties= parser.parse(filename, errors);
+  loadProperties_(filename, properties, &errors);
+  inputFiles_.insert(inputFiles_.end(), parser.inputFiles().begin(),
+		     parser.inputFiles().end());
+}
+
+void ApplicationConfiguration::load(
+    const std::string& sourceName, std::istream& input,
+    ApplicationConfigurationErrorList& errors, int initialLine,
+    int initialColumn
+) {
+  ConfigFileParser parser= makeParser_();
+  ConfigurationPropertyMap properties=
+      parser.parse(sourceName, input, errors, initialLine, initialColumn);
+  loadProperties_(sourceName, properties, &errors);
+}
+
+void ApplicationConfiguration::loadFromText(
+    const std::string& sourceName, const std::string& text,
+    ApplicationConfigurationErrorList& errors
+) {
+  ConfigFileParser parser= makeParser_();
+  ConfigurationPropertyMap properties=
+      parser.parseText(sourceName, text, errors);
+  loadProperties_(sourceName, properties, &errors);
+}
+
+void ApplicationConfiguration::loadStreaming(const std::string& filename) {
+  loadStreaming_(filename,
+		 [&filename](ConfigFileParser& parser,
+			     ConfigurationHandler& handler) {
+    parser.parse(filename, handler);
+  });
+}
+
+void ApplicationConfiguration::loadStreaming(const std::string& sourceName,
+					     std::istream& input,
+					     int initialLine,
+					     int initialColumn) {
+  loadStreaming_(sourceName,
+		 [&](ConfigFileParser& parser, ConfigurationHandler& handler) {
+    parser.parse(sourceName, input, handler, initialLine, initialColumn);
+  });
+}
+
+void ApplicationConfiguration::loadStreamingFromText(
+    const std::string& sourceName, const std::string& text
+) {
+  loadStreaming_(sourceName,
+		 [&](ConfigFileParser& parser, ConfigurationHandler& handler) {
+    parser.parseText(sourceName, text, handler);
+  });
+}
+
+void ApplicationConfiguration::loadStreaming_(
+    const std::string& sourceName,
+    const std::function<void (ConfigFileParser&, ConfigurationHandler&)>&
+	parse
+) {
+  ConfigFileParser parser= makeParser_();
+  Dispatcher dispatcher(*this);
+  for (auto i= handlers_.begin(); i != handlers_.end(); ++i) {
+    i->second.setFound(false);
+  }
+
+  parse(parser, dispatcher);
+
+  for (auto i= handlers_.begin(); i != handlers_.end(); ++i) {
+    if (i->second.required() && !i->second.found()) {
+      throw RequiredPropertyMissingError(sourceName, i->first);
+    }
+  }
+}
+
+void ApplicationConfiguration::dispatch_(
+    const ConfigurationProperty& property
+) {
+  auto i= handlers_.find(property.name());
+  if (i == handlers_.end()) {
+    const size_t prefixLength=
+	prefixHandlers_.shortestPrefixOf(property.name());
+    if (prefixLength != detail::SegmentTrie::NONE) {
+      i= handlers_.find(property.name().substr(0, prefixLength));
+    }
+  }
+
+  if (i != handlers_.end()) {
+    applyHandler_(i->second, property);
+    i->second.setFound(true);
+  } else if (!ignoreUnknownProperties_) {
+    throw UnknownPropertyError(property.source(), property.line(),
+			       property.name());
+  }
+}
+
+bool ApplicationConfiguration::isRegistered_(const std::string& name) const {
+  return handlers_.count(name) ||
+         (prefixHandlers_.shortestPrefixOf(name) != detail::SegmentTrie::NONE);
+}
+
+ConfigFileParser ApplicationConfiguration::makeParser_() const {
+  ConfigFileParser parser(useEnvironmentVars_, duplicatePropertyAction_,
+			  includedPropertyAction_);
+  parser.setIncludeThreads(includeThreads_);
+  parser.setIncludeFileCache(includeFileCache_);
+  parser.setSourceGraph(sourceGraph_);
+  parser.setSnapshotDirectory(snapshotDirectory_);
+  configureReferences_(parser);
+  return parser;
+}
+
+void ApplicationConfiguration::configureReferences_(
+    ConfigFileParser& parser
+) const {
+  parser.setReferenceResolution(referenceResolution_);
+  parser.setEnvironmentProvider(environmentProvider_);
+  // Unless unknown properties are ignored, each one is read to report it
+  if (ignoreUnknownProperties_) {
+    parser.setWantedProperties([this](const std::string& name) {
+      return isRegistered_(name);
+    });
+  }
+}
+
 void ApplicationConfiguration::load_(
     const std::string& sourceName,
     const ConfigurationPropertyMap& properties
 ) {
+  loadProperties_(sourceName, properties, nullptr);
+}
+
+namespace {
+  /** @brief Add @c error to @c errors, or throw it if there is no list */
+  template <typename Error>
+  void reportError(ApplicationConfigurationErrorList* errors,
+		   const Error& error) {
+    if (!errors) {
+      throw error;
+    }
+    errors->push_back(std::make_shared<Error>(error));
+  }
+}
+
+void ApplicationConfiguration::loadProperties_(
+    const std::string& sourceName,
+    const ConfigurationPropertyMap& properties,
+    ApplicationConfigurationErrorList* errors
+) {
+  auto apply= [this, errors](const PropertyInfo& info,
+			     const ConfigurationProperty& property) {
+    try {
+      applyHandler_(info, property);
+    } catch(const InvalidPropertyValueError& e) {
+      reportError(errors, e);
+    }
+  };
   auto i= properties.begin();
   auto j= handlers_.begin();
 
@@ -65,36 +240,42 @@ void ApplicationConfiguration::load_(
   j= handlers_.begin();
   while ((i != properties.end()) && (j != handlers_.end())) {
     if (i->name() == j->first) {
-      applyHandler_(j->second, *i);
+      apply(j->second, *i);
       j->second.setFound(true);
       ++i;
       if (!j->second.isPrefixHandler()) {
 	++j;
       }
     } else if (j->second.isPrefixHandler() && startsWith(i->name(), j->first)) {
-      applyHandler_(j->second, *i);
+      apply(j->second, *i);
       j->second.setFound(true);
       ++i;
     } else if (j->first < i->name()) {
       if (j->second.required()) {
-	throw RequiredPropertyMissingError(sourceName, j->first);
+	reportError(errors,
+		    RequiredPropertyMissingError(sourceName, j->first));
       }
       ++j;
-    } else if (!ignoreUnknownProperties_) {
-      throw UnknownPropertyError(i->source(), i->line(), i->name());
     } else {
+      if (!ignoreUnknownProperties_) {
+	reportError(errors,
+		    UnknownPropertyError(i->source(), i->line(), i->name()));
+      }
       ++i;
     }
   }
 
   while (j != handlers_.end()) {
     if (j->second.required()) {
-      throw RequiredPropertyMissingError(sourceName, j->first);
+      reportError(errors, RequiredPropertyMissingError(sourceName, j->first));
     }
     ++j;
   }
-  if (!ignoreUnknownProperties_ && (i != properties.end())) {
-    throw UnknownPropertyError(i->source(), i->line(), i->name());
+  if (!ignoreUnknownProperties_) {
+    for (; i != properties.end(); ++i) {
+      reportError(errors,
+		  UnknownPropertyError(i->source(), i->line(), i->name()));
+    }
   }
 }
 
@@ -121,9 +302,9 @@ void ApplicationConfiguration::applyHandler_(
   }
 }
 
-static bool isLegalPropertyName(const std::string& name, int nameLen) {
+static bool isLegalPropertyName(std::string_view name, int nameLen) {
   if (name[nameLen - 1] == '.') {
-    return ConfigurationProperty::isLegalName(name.substr(0, nameLen - 1));
+    name.remove_suffix(1);
   }
   return ConfigurationProperty::isLegalName(name);
 }
@@ -157,37 +338,32 @@ void ApplicationConfiguration::registerProperty_(PropertyInfo&& info) {
     throw ApplicationConfigurationError(msg.str());
   }
 
-  if (info.isPrefixHandler()) {
-    // Check that no previously-registered property handler begins with
-    // this prefix
-    char firstChar = info.name()[0];
-    auto k = i;
-    while ((k != handlers_.end()) && (k->first[0] == firstChar)) {
-      if (startsWith(k->first, info.name())) {
-	std::ostringstream msg;
-	msg << "Cannot register handler for prefix \"" << info.name()
-	    << "\" because a previously-registered property (\""
-	    << k->first << "\") begins with that prefix";
-	throw ApplicationConfigurationError(msg.str());  
-      }
-      ++k;
-    }
+  if (info.isPrefixHandler() && (i != handlers_.end()) &&
+      startsWith(i->first, info.name())) {
+    // Names that begin with this prefix sort immediately after it, so
+    // if any previously-registered handler begins with the prefix, the
+    // one at i does
+    std::ostringstream msg;
+    msg << "Cannot register handler for prefix \"" << info.name()
+	<< "\" because a previously-registered property (\""
+	<< i->first << "\") begins with that prefix";
+    throw ApplicationConfigurationError(msg.str());  
   }
 
   // Check that a property prefix handler hasn't been registered for any
   // prefix of this property
-  auto j= handlers_.lower_bound(info.name().substr(0,1));
-  if ((j != handlers_.end()) && (j->first[0] == info.name()[0])) {
-    while (j != i) {
-      if (j->second.isPrefixHandler() && startsWith(info.name(), j->first)) {
-	std::ostringstream msg;
-	msg << "Cannot register handler for property \"" << info.name()
-	    << "\" because a handler for properties with prefix \""
-	    << j->second.name() << "\" has already been registered";
-	throw ApplicationConfigurationError(msg.str());
-      }
-      ++j;
-    }
+  const size_t prefixLength= prefixHandlers_.shortestPrefixOf(info.name());
+  if (prefixLength != detail::SegmentTrie::NONE) {
+    std::ostringstream msg;
+    msg << "Cannot register handler for property \"" << info.name()
+	<< "\" because a handler for properties with prefix \""
+	<< info.name().substr(0, prefixLength)
+	<< "\" has already been registered";
+    throw ApplicationConfigurationError(msg.str());
+  }
+
+  if (info.isPrefixHandler()) {
+    prefixHandlers_.insert(info.name(), prefixHandlers_.size());
   }
   handlers_.insert(std::make_pair(info.name(), std::move(info)));
 }
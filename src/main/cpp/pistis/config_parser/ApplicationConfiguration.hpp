@@ -9,6 +9,8 @@
 #include <pistis/config_parser/ConfigFileParser.hpp>
 #include <pistis/config_parser/ConfigurationProperty.hpp>
 #include <pistis/config_parser/PropertyFormatError.hpp>
+#include <pistis/config_parser/detail/SegmentTrie.hpp>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -23,12 +25,149 @@ namespace pistis {
     class ApplicationConfiguration {
     public:
       virtual ~ApplicationConfiguration();
+
+      /** @brief Parse @c filename and set the registered properties
+       *
+       *  Sets fields of this object in place, so it must not be called
+       *  while other threads read them.  To reload a configuration other
+       *  threads are using, see ReloadableConfiguration.
+       */
       virtual void load(const std::string& filename);
       virtual void load(const std::string& sourceName,
 			std::istream& input, int initialLine=1,
 			int initialColumn=1);
       virtual void loadFromText(const std::string& sourceName,
 				const std::string& text);
+
+      /** @brief Parse @c filename and set the registered properties,
+       *         adding every error found to @c errors instead of
+       *         throwing the first
+       *
+       *  Syntax errors, duplicate properties and files that cannot be
+       *  included are reported as ConfigFileParser::parse(filename,
+       *  errors) reports them.  Every unknown property, invalid value
+       *  and missing required property among the properties that
+       *  could be parsed is then reported as well.  The properties
+       *  with valid values are set, so @c errors is empty if and only
+       *  if load() would have succeeded.
+       */
+      virtual void load(const std::string& filename,
+			ApplicationConfigurationErrorList& errors);
+      virtual void load(const std::string& sourceName, std::istream& input,
+			ApplicationConfigurationErrorList& errors,
+			int initialLine=1, int initialColumn=1);
+      virtual void loadFromText(const std::string& sourceName,
+				const std::string& text,
+				ApplicationConfigurationErrorList& errors);
+
+      /** @brief Parse @c filename and set the registered properties as
+       *         they are parsed
+       *
+       *  Each property goes to its handler as soon as the parser settles
+       *  it, through ConfigFileParser::parse(filename, handler), instead
+       *  of after the whole file has been parsed into a map.  The
+       *  include file cache, source graph, snapshots and include threads
+       *  are not used.
+       *
+       *  A property defined more than once with DUP_OVERWRITE goes to
+       *  its handler once for each definition, so the last one wins as
+       *  it does with load().  Properties that match a prefix arrive in
+       *  the order they are parsed rather than in order of their names.
+       *  An unknown property is reported as soon as it is parsed, and a
+       *  missing required property once the file has been parsed.
+       */
+      virtual void loadStreaming(const std::string& filename);
+      virtual void loadStreaming(const std::string& sourceName,
+				 std::istream& input, int initialLine=1,
+				 int initialColumn=1);
+      virtual void loadStreamingFromText(const std::string& sourceName,
+					 const std::string& text);
+
+      /** @brief Number of threads used to parse included files
+       *
+       *  See ConfigFileParser::setIncludeThreads().  Zero, the default,
+       *  parses included files serially.
+       */
+      size_t includeThreads() const { return includeThreads_; }
+      void setIncludeThreads(size_t n) { includeThreads_= n; }
+
+      /** @brief When the variables referenced in property values are
+       *         resolved
+       *
+       *  See ConfigFileParser::setReferenceResolution().  The default
+       *  is ConfigFileParser::RESOLVE_IN_ORDER.  With
+       *  ConfigFileParser::RESOLVE_LAZY, a configuration that ignores
+       *  unknown properties resolves only the registered properties and
+       *  those they refer to.  loadStreaming() always resolves in order.
+       */
+      ConfigFileParser::ReferenceResolution referenceResolution() const {
+	return referenceResolution_;
+      }
+      void setReferenceResolution(ConfigFileParser::ReferenceResolution r) {
+	referenceResolution_= r;
+      }
+
+      /** @brief Where environment variables come from
+       *
+       *  See ConfigFileParser::setEnvironmentProvider().  The default
+       *  provider snapshots the environment of the process once per
+       *  load.
+       */
+      const std::shared_ptr<EnvironmentProvider>& environmentProvider() const {
+	return environmentProvider_;
+      }
+      void setEnvironmentProvider(
+	  const std::shared_ptr<EnvironmentProvider>& p
+      ) {
+	environmentProvider_= p ? p : EnvironmentProvider::process();
+      }
+
+      /** @brief Cache of parsed include files
+       *
+       *  See ConfigFileParser::setIncludeFileCache().  Null, the default,
+       *  parses included files every time they are included.
+       */
+      const std::shared_ptr<IncludeFileCache>& includeFileCache() const {
+	return includeFileCache_;
+      }
+      void setIncludeFileCache(const std::shared_ptr<IncludeFileCache>& c) {
+	includeFileCache_= c;
+      }
+
+      /** @brief Record of the files loaded, for reparsing only what
+       *         has changed on the next load
+       *
+       *  See ConfigFileParser::setSourceGraph().  Null, the default,
+       *  parses every file in full.
+       */
+      const std::shared_ptr<SourceGraph>& sourceGraph() const {
+	return sourceGraph_;
+      }
+      void setSourceGraph(const std::shared_ptr<SourceGraph>& g) {
+	sourceGraph_= g;
+      }
+
+      /** @brief Files read by load(filename) and load(filename, errors),
+       *         in the order they were read
+       *
+       *  Each file loaded is followed by the files it included.  See
+       *  ConfigFileParser::inputFiles().
+       */
+      const std::vector<std::string>& inputFiles() const {
+	return inputFiles_;
+      }
+
+      /** @brief Directory for compiled snapshots of configuration files
+       *
+       *  See ConfigFileParser::setSnapshotDirectory().  Empty, the
+       *  default, always parses the files.
+       */
+      const std::string& snapshotDirectory() const {
+	return snapshotDirectory_;
+      }
+      void setSnapshotDirectory(const std::string& d) {
+	snapshotDirectory_= d;
+      }
 	
     protected:
       template <typename Value>
@@ -138,9 +277,44 @@ namespace pistis {
 
       typedef std::map<std::string, PropertyInfo> PropertyInfoMap;
 
+      class Dispatcher;
+
       void applyHandler_(const PropertyInfo& handler,
 			 const ConfigurationProperty& property);
 
+      /** @brief Set the registered properties from @c properties
+       *
+       *  Errors are added to @c errors, or thrown if it is null.
+       */
+      void loadProperties_(const std::string& sourceName,
+			   const ConfigurationPropertyMap& properties,
+			   ApplicationConfigurationErrorList* errors);
+
+      /** @brief Pass @c property to its handler, for loadStreaming() */
+      void dispatch_(const ConfigurationProperty& property);
+
+      /** @brief True if a handler is registered for property @c name */
+      bool isRegistered_(const std::string& name) const;
+
+      /** @brief Parser for load() and loadStreaming(), set up with this
+       *         configuration's settings
+       */
+      ConfigFileParser makeParser_() const;
+
+      /** @brief Set how @c parser resolves the variables referenced in
+       *         property values, and where it finds environment variables
+       */
+      void configureReferences_(ConfigFileParser& parser) const;
+
+      /** @brief Parse with @c parse, passing each property to its
+       *         handler as it arrives
+       */
+      void loadStreaming_(
+	  const std::string& sourceName,
+	  const std::function<void (ConfigFileParser&, ConfigurationHandler&)>&
+	      parse
+      );
+
     protected:
       ApplicationConfiguration(
 	  bool ignoreUnknownProperties, bool useEnvironmentVars= true,
@@ -549,10 +723,22 @@ namespace pistis {
 
     private:
       PropertyInfoMap handlers_;
+
+      /** @brief Names of the registered prefix handlers, for finding
+       *         the handler whose prefix a property name begins with
+       */
+      detail::SegmentTrie prefixHandlers_;
       bool ignoreUnknownProperties_;
       bool useEnvironmentVars_;
       ConfigFileParser::DuplicatePropertyMode duplicatePropertyAction_;
       ConfigFileParser::DuplicatePropertyMode includedPropertyAction_;
+      size_t includeThreads_;
+      ConfigFileParser::ReferenceResolution referenceResolution_;
+      std::shared_ptr<EnvironmentProvider> environmentProvider_;
+      std::shared_ptr<IncludeFileCache> includeFileCache_;
+      std::shared_ptr<SourceGraph> sourceGraph_;
+      std::string snapshotDirectory_;
+      std::vector<std::string> inputFiles_;
     };
 
     template<>
@@ -2,6 +2,8 @@
 #define __PISTIS__CONFIG_PARSER__APPLICATIONCONFIGURATIONERROR_HPP__
 
 #include <pistis/exceptions/PistisException.hpp>
+#include <memory>
+#include <vector>
 
 namespace pistis {
   namespace config_parser {
@@ -20,6 +22,15 @@ namespace pistis {
 					const std::string& details);
     };
 
+    /** @brief Errors collected by a parse or load that continues past
+     *         them, in the order they were found
+     *
+     *  Each error has its original type, such as ConfigFileParseError
+     *  or UnknownPropertyError.
+     */
+    typedef std::vector< std::shared_ptr<const ApplicationConfigurationError> >
+        ApplicationConfigurationErrorList;
+
   }
 }
 #endif
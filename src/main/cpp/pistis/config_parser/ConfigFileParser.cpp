@@ -1,12 +1,24 @@
 #include "ConfigFileParser.hpp"
 #include "ConfigFileParseError.hpp"
+#include "ConfigurationSnapshot.hpp"
+#include "ConfigurationSnapshotError.hpp"
 #include "PropertyFormatError.hpp"
 #include "detail/ConfigFileLexer.hpp"
+#include "detail/LazyEnvironment.hpp"
+#include "detail/MemoryMappedFile.hpp"
+#include "detail/TaskPool.hpp"
 #include "detail/ValueProcessor.hpp"
 #include <pistis/filesystem/Path.hpp>
 #include <pistis/util/StringUtil.hpp>
+#include <algorithm>
+#include <exception>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 
 using namespace pistis::exceptions;
 using namespace pistis::util;
@@ -15,15 +27,315 @@ using namespace pistis::config_parser::detail;
 
 namespace path = pistis::filesystem::path;
 
+struct ConfigFileParser::PrefetchedInclude {
+  std::shared_ptr<TaskPool::Task> task;
+  std::shared_ptr<const IncludeFileCache::Entry> result;
+  std::exception_ptr error;
+};
+
+/** @brief A value compiled while parsing, to be resolved once the file
+ *         has been parsed
+ */
+struct ConfigFileParser::DeferredValue {
+  std::string name;
+  std::shared_ptr<const ValueTemplate> compiled;
+  int line;
+  int column;
+};
+
+/** @brief Gives a parser an environment for the life of the object, if
+ *         it is not parsing already
+ */
+class ConfigFileParser::EnvironmentScope {
+public:
+  EnvironmentScope(ConfigFileParser& parser): parser_(parser), owner_(false) {
+    if (!parser.environment_ && parser.usesEnvironmentVars()) {
+      parser.environment_=
+	  std::make_shared<LazyEnvironment>(parser.environmentProvider());
+      owner_= true;
+    }
+  }
+  EnvironmentScope(const EnvironmentScope&) = delete;
+  ~EnvironmentScope() {
+    if (owner_) {
+      parser_.environment_.reset();
+    }
+  }
+
+  EnvironmentScope& operator=(const EnvironmentScope&) = delete;
+
+private:
+  ConfigFileParser& parser_;
+  bool owner_;
+};
+
+/** @brief Merges the properties of an included file into its includer
+ *         as they are parsed, and passes on those that survive
+ */
+class ConfigFileParser::IncludeForwarder : public ConfigurationHandler {
+public:
+  IncludeForwarder(ConfigFileParser& parser,
+		   ConfigurationPropertyMap& properties):
+      parser_(parser), properties_(properties), names_() {
+    // Intentionally left blank
+  }
+
+  virtual void onProperty(const std::string& name, const std::string& value,
+			  const std::string& source, int line) override {
+    // A name this file has already added was settled by the parser for
+    // the included file, so the later definition replaces it
+    ConfigurationProperty property(name, value, source, line);
+    if (names_.count(name)) {
+      properties_.add(std::move(property));
+    } else if (parser_.mergeIncludedProperty_(property, properties_)) {
+      names_.insert(name);
+    } else {
+      return;
+    }
+    parser_.handler_->onProperty(name, value, source, line);
+  }
+
+  virtual void onBlockBegin(const std::string& name,
+			    const std::string& source, int line) override {
+    parser_.handler_->onBlockBegin(name, source, line);
+  }
+
+  virtual void onBlockEnd(const std::string& name,
+			  const std::string& source, int line) override {
+    parser_.handler_->onBlockEnd(name, source, line);
+  }
+
+  virtual void onInclude(const std::string& filename,
+			 const std::string& source, int line) override {
+    parser_.handler_->onInclude(filename, source, line);
+  }
+
+  virtual void onIncludeEnd(const std::string& filename,
+			    const std::string& source, int line) override {
+    parser_.handler_->onIncludeEnd(filename, source, line);
+  }
+
+private:
+  ConfigFileParser& parser_;
+  ConfigurationPropertyMap& properties_;
+
+  /** @brief Names of the properties the included file has added */
+  std::unordered_set<std::string> names_;
+};
+
+namespace {
+  /** @brief Sets a parser's handler or error list for the life of the
+   *         object
+   */
+  template <typename T>
+  class PointerScope {
+  public:
+    PointerScope(T*& slot, T& value): slot_(slot), outer_(slot) {
+      slot_= &value;
+    }
+    PointerScope(const PointerScope&) = delete;
+    ~PointerScope() { slot_= outer_; }
+
+    PointerScope& operator=(const PointerScope&) = delete;
+
+  private:
+    T*& slot_;
+    T* const outer_;
+  };
+
+  bool opensBlock(const std::string& text) {
+    auto p= text.find_last_not_of(" \t\r");
+    return (p != std::string::npos) && (text[p] == '{');
+  }
+
+  std::string resolveIncludePath(const std::string& sourceName,
+				 const std::string& includeFilePath) {
+    if (path::isAbsolute(includeFilePath)) {
+      return includeFilePath;
+    }
+    std::string pathToSource = std::get<0>(path::splitFile(sourceName));
+    return path::join(pathToSource, includeFilePath);
+  }
+
+  bool isSpaceOrTab(char c) { return (c == ' ') || (c == '\t'); }
+
+  /** @brief Returns the file names in lines of [begin, end) of the form
+   *         include "file name"
+   */
+  std::vector<std::string> findIncludes(const char* begin, const char* end) {
+    static const char INCLUDE[]= "include";
+    static const size_t INCLUDE_LEN= sizeof(INCLUDE) - 1;
+    std::vector<std::string> includes;
+    const char* p= begin;
+
+    while (p != end) {
+      const char* eol= static_cast<const char*>(::memchr(p, '\n', end - p));
+      if (!eol) {
+	eol= end;
+      }
+      while ((p != eol) && isSpaceOrTab(*p)) {
+	++p;
+      }
+      if (((size_t)(eol - p) > INCLUDE_LEN) &&
+	  !::memcmp(p, INCLUDE, INCLUDE_LEN)) {
+	p += INCLUDE_LEN;
+	while ((p != eol) && isSpaceOrTab(*p)) {
+	  ++p;
+	}
+	if ((p != eol) && (*p == '"')) {
+	  const char* start= ++p;
+	  const char* quote=
+	      static_cast<const char*>(::memchr(start, '"', eol - start));
+	  if (quote && (quote != start)) {
+	    includes.emplace_back(start, quote);
+	  }
+	}
+      }
+      p= (eol == end) ? end : eol + 1;
+    }
+    return includes;
+  }
+
+  /** @brief True if each of @c references would resolve to the value it
+   *         had before, given @c properties
+   */
+  bool referencesUnchanged(const std::vector<VariableReference>& references,
+			   const ConfigurationPropertyMap& properties,
+			   LazyEnvironment* environment) {
+    for (auto i= references.begin(); i != references.end(); ++i) {
+      const ConfigurationProperty* p= properties.find(i->name);
+      if (p) {
+	if (i->fromEnvironment || (p->value() != i->value)) {
+	  return false;
+	}
+      } else {
+	const std::string* envValue=
+	    environment ? environment->find(i->name) : nullptr;
+	if (!i->fromEnvironment || !envValue || (i->value != *envValue)) {
+	  return false;
+	}
+      }
+    }
+    return true;
+  }
+
+  /** @brief Names and values of environment variables */
+  typedef std::vector< std::pair<std::string, std::string> >
+      EnvironmentValues;
+
+  /** @brief True if the environment variables among @c references have
+   *         the values they had before
+   */
+  bool environmentUnchanged(
+      const std::vector<VariableReference>& references,
+      LazyEnvironment* environment
+  ) {
+    for (auto i= references.begin(); i != references.end(); ++i) {
+      if (i->fromEnvironment) {
+	const std::string* envValue=
+	    environment ? environment->find(i->name) : nullptr;
+	if (!envValue || (i->value != *envValue)) {
+	  return false;
+	}
+      }
+    }
+    return true;
+  }
+
+  /** @brief True if each of @c variables has the value it had before */
+  bool environmentUnchanged(const EnvironmentValues& variables,
+			    LazyEnvironment* environment) {
+    for (auto i= variables.begin(); i != variables.end(); ++i) {
+      const std::string* envValue=
+	  environment ? environment->find(i->first) : nullptr;
+      if (!envValue || (i->second != *envValue)) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  /** @brief Add variable @c name to @c environment, unless it already
+   *         has it
+   */
+  void addEnvironmentVariable(const std::string& name,
+			      const std::string& value,
+			      EnvironmentValues& environment) {
+    if (std::none_of(environment.begin(), environment.end(),
+		     [&name](const std::pair<std::string, std::string>& v) {
+		       return v.first == name;
+		     })) {
+      environment.emplace_back(name, value);
+    }
+  }
+
+  /** @brief Add the environment variables among @c references to
+   *         @c environment, unless it already has them
+   */
+  void addEnvironmentReferences(
+      const std::vector<VariableReference>& references,
+      EnvironmentValues& environment
+  ) {
+    for (auto i= references.begin(); i != references.end(); ++i) {
+      if (i->fromEnvironment) {
+	addEnvironmentVariable(i->name, i->value, environment);
+      }
+    }
+  }
+
+  /** @brief Add @c variables to @c environment, except those it already
+   *         has
+   */
+  void addEnvironmentReferences(const EnvironmentValues& variables,
+				EnvironmentValues& environment) {
+    for (auto i= variables.begin(); i != variables.end(); ++i) {
+      addEnvironmentVariable(i->first, i->second, environment);
+    }
+  }
+
+  std::shared_ptr<const IncludeFileCache::Entry> makeEntry(
+      const SourceGraph::Node& node, ConfigurationPropertyMap&& properties
+  ) {
+    std::shared_ptr<IncludeFileCache::Entry> entry=
+	std::make_shared<IncludeFileCache::Entry>();
+    bool complete= true;
+    entry->files.emplace_back(node.filename, node.stamp);
+    for (auto i= node.statements.begin(); i != node.statements.end(); ++i) {
+      addEnvironmentReferences(i->references, entry->environment);
+    }
+    for (auto i= node.includes.begin(); i != node.includes.end(); ++i) {
+      const IncludeFileCache::Entry& included= **i;
+      complete= complete && !included.files.empty();
+      entry->files.insert(entry->files.end(), included.files.begin(),
+			  included.files.end());
+      entry->depth= std::max(entry->depth, included.depth + 1);
+      addEnvironmentReferences(included.environment, entry->environment);
+    }
+    if (!complete) {
+      entry->files.clear();
+    }
+    entry->properties= std::move(properties);
+    return entry;
+  }
+}
+
 ConfigFileParser::ConfigFileParser(
     bool useEnvironmentVars,
     DuplicatePropertyMode duplicatePropertyAction,
     DuplicatePropertyMode includedPropertyAction
 ):
     useEnvVars_(useEnvironmentVars),
+    environmentProvider_(EnvironmentProvider::process()), environment_(),
     duplicatePropertyAction_(duplicatePropertyAction),
-    includedPropertyAction_(includedPropertyAction),
-    context_(), contextPrefix_(), includedFrom_() {
+    includedPropertyAction_(includedPropertyAction), useMemoryMap_(false),
+    referenceResolution_(RESOLVE_IN_ORDER), wantedProperties_(),
+    deferred_(nullptr), includeThreads_(0), ownedIncludePool_(),
+    includePool_(nullptr), includeFileCache_(), sourceGraph_(), statistics_(),
+    snapshotDirectory_(), recordIncludedFiles_(false), includedFiles_(),
+    recording_(nullptr), environmentUsed_(nullptr), inputFiles_(),
+    handler_(nullptr), errors_(nullptr),
+    prefetched_(), context_(), contextPrefix_(),
+    includedFrom_() {
   // Intentionally left blank
 }
 
@@ -35,17 +347,145 @@ ConfigFileParser::ConfigFileParser(
     const std::string& includedFrom
 ):
     useEnvVars_(useEnvironmentVars),
+    environmentProvider_(EnvironmentProvider::process()), environment_(),
     duplicatePropertyAction_(duplicatePropertyAction),
-    includedPropertyAction_(includedPropertyAction),
-    context_(), contextPrefix_(), includedFrom_(includedFiles) {
+    includedPropertyAction_(includedPropertyAction), useMemoryMap_(false),
+    referenceResolution_(RESOLVE_IN_ORDER), wantedProperties_(),
+    deferred_(nullptr), includeThreads_(0), ownedIncludePool_(),
+    includePool_(nullptr), includeFileCache_(), sourceGraph_(), statistics_(),
+    snapshotDirectory_(), recordIncludedFiles_(false), includedFiles_(),
+    recording_(nullptr), environmentUsed_(nullptr), inputFiles_(),
+    handler_(nullptr), errors_(nullptr),
+    prefetched_(), context_(), contextPrefix_(),
+    includedFrom_(includedFiles) {
   includedFrom_.push_back(includedFrom);
 }
 
 ConfigFileParser::~ConfigFileParser() {
-  // Intentionally left blank
+  discardPrefetchedIncludes_();
+}
+
+void ConfigFileParser::setIncludeThreads(size_t n) {
+  if (n != includeThreads_) {
+    ownedIncludePool_.reset(n ? new TaskPool(n) : nullptr);
+    includePool_= ownedIncludePool_.get();
+    includeThreads_= n;
+  }
+}
+
+std::string ConfigFileParser::snapshotFile(const std::string& filename) const {
+  std::string key;
+  if (!snapshotKey_(filename, key)) {
+    return std::string();
+  }
+  return path::join(snapshotDirectory_,
+		    ConfigurationSnapshot::fileNameFor(key));
 }
 
 ConfigurationPropertyMap ConfigFileParser::parse(const std::string& filename) {
+  // Parsers for included files report their files to their includer
+  if (!getIncludedFrom_().empty()) {
+    return parseFile_(filename);
+  }
+
+  std::string key;
+  const bool useSnapshot= snapshotKey_(filename, key);
+  const std::string snapshotPath= useSnapshot
+      ? path::join(snapshotDirectory_, ConfigurationSnapshot::fileNameFor(key))
+      : std::string();
+  inputFiles_.clear();
+
+  // The snapshot is checked against the environment the parse would use
+  EnvironmentScope environmentScope(*this);
+  if (useSnapshot) {
+    try {
+      ConfigurationSnapshot snapshot(snapshotPath);
+      if ((snapshot.key() == key) &&
+	  ((environment_ && snapshot.numEnvironmentVariables())
+	       ? snapshot.isFresh(environment_->snapshot())
+	       : snapshot.isFresh())) {
+	ConfigurationPropertyMap properties= snapshot.toPropertyMap();
+	for (size_t i= 0; i < snapshot.numInputFiles(); ++i) {
+	  inputFiles_.emplace_back(snapshot.inputFile(i).path);
+	}
+	return properties;
+      }
+    } catch(const ConfigurationSnapshotError&) {
+      // Missing or unreadable, so parse the file and replace it
+    }
+  }
+
+  // Stamp the file before reading it, so a change made while it is
+  // being parsed keeps the snapshot from being written
+  FileStamp stamp;
+  const bool stamped= FileStamp::read(filename, stamp);
+
+  ConfigurationPropertyMap properties;
+  EnvironmentValues environment;
+  includedFiles_.clear();
+  recordIncludedFiles_= true;
+  try {
+    PointerScope<EnvironmentValues> environmentUsed(
+	environmentUsed_, environment
+    );
+    properties= parseFile_(filename);
+  } catch(...) {
+    recordIncludedFiles_= false;
+    includedFiles_.clear();
+    throw;
+  }
+  recordIncludedFiles_= false;
+
+  std::vector< std::pair<std::string, FileStamp> > files;
+  bool complete= stamped;
+  files.emplace_back(filename, stamp);
+  for (auto i= includedFiles_.begin(); i != includedFiles_.end(); ++i) {
+    complete= complete && !(*i)->files.empty();
+    files.insert(files.end(), (*i)->files.begin(), (*i)->files.end());
+    addEnvironmentReferences((*i)->environment, environment);
+  }
+  includedFiles_.clear();
+  for (auto i= files.begin(); i != files.end(); ++i) {
+    inputFiles_.push_back(i->first);
+  }
+
+  if (useSnapshot && complete) {
+    try {
+      ConfigurationSnapshot::write(snapshotPath, key, properties, files,
+				   environment);
+    } catch(const ConfigurationSnapshotError&) {
+      // The properties are still good, and the snapshot will be written
+      // the next time the file is parsed
+    }
+  }
+  return properties;
+}
+
+ConfigurationPropertyMap ConfigFileParser::parseFile_(
+    const std::string& filename
+) {
+  EnvironmentScope environment(*this);
+  if (sourceGraph_ && (referenceResolution() == RESOLVE_IN_ORDER)) {
+    return parseWithGraph_(filename)->properties;
+  }
+  return readFile_(filename);
+}
+
+ConfigurationPropertyMap ConfigFileParser::readFile_(
+    const std::string& filename
+) {
+  if (usesMemoryMappedInput()) {
+    MemoryMappedFile file(filename);
+    if (file.error()) {
+      std::ostringstream msg;
+      msg << "Cannot open file (" << strerror(file.error()) << ")";
+      throw ConfigFileParseError(filename, 0, 0, msg.str());
+    } else if (file.isMapped()) {
+      return parseBuffer(filename, file.begin(), file.end());
+    }
+    // Not a regular file, so read it as a stream
+  }
+
   std::ifstream input(filename.c_str());
   if (input) {
     return parse(filename, input);
@@ -56,55 +496,348 @@ ConfigurationPropertyMap ConfigFileParser::parse(const std::string& filename) {
   }
 }
 
+std::shared_ptr<const IncludeFileCache::Entry>
+    ConfigFileParser::parseWithGraph_(const std::string& filename) {
+  // Stamp the file before reading it, so a change made while it is
+  // being parsed is seen the next time
+  std::string key;
+  FileStamp stamp;
+  if (!fileKey_(filename, key) || !FileStamp::read(filename, stamp)) {
+    std::shared_ptr<IncludeFileCache::Entry> entry=
+	std::make_shared<IncludeFileCache::Entry>();
+    entry->properties= readFile_(filename);
+    return entry;
+  }
+
+  // Property sources are spelled as the file was named when it was
+  // parsed, so a file named differently is parsed again
+  std::shared_ptr<const SourceGraph::Node> node= sourceGraph_->find(key);
+  if (node && (node->stamp == stamp) && (node->filename == filename)) {
+    std::shared_ptr<const SourceGraph::Node> replayed=
+	replay_(filename, node);
+    if (replayed != node) {
+      sourceGraph_->insert(key, replayed);
+    }
+    node= std::move(replayed);
+  } else {
+    std::shared_ptr<SourceGraph::Node> parsed=
+	std::make_shared<SourceGraph::Node>();
+    parsed->filename= filename;
+    parsed->stamp= stamp;
+
+    SourceGraph::Node* const outerRecording= recording_;
+    ConfigurationPropertyMap properties;
+    recording_= parsed.get();
+    try {
+      properties= readFile_(filename);
+    } catch(...) {
+      recording_= outerRecording;
+      throw;
+    }
+    recording_= outerRecording;
+
+    parsed->result= makeEntry(*parsed, std::move(properties));
+    sourceGraph_->count(1, 0, 0, 0);
+    sourceGraph_->insert(key, parsed);
+    node= std::move(parsed);
+  }
+
+  // Only a top-level parse knows every file its includes still reach
+  if (getIncludedFrom_().empty()) {
+    sourceGraph_->prune(key);
+    if (environmentUsed_) {
+      // A reused file substitutes nothing, so take what it did before
+      addEnvironmentReferences(node->result->environment, *environmentUsed_);
+    }
+  }
+  return node->result;
+}
+
+std::shared_ptr<const SourceGraph::Node> ConfigFileParser::replay_(
+    const std::string& sourceName,
+    const std::shared_ptr<const SourceGraph::Node>& previous
+) {
+  const SourceGraph::Node& old= *previous;
+
+  // Nothing is built until an included file or an environment variable
+  // differs from last time, since until then the statements would do
+  // just what they did before.  From there on every statement is
+  // replayed in order, so errors are reported as a full parse would.
+  std::shared_ptr<SourceGraph::Node> node;
+  ConfigurationPropertyMap properties;
+  std::unique_ptr<ValueProcessor> valueProcessor;
+  std::vector< std::shared_ptr<const IncludeFileCache::Entry> > includes;
+  size_t nextInclude= 0;
+  uint64_t reprocessed= 0;
+
+  auto replayStatement= [&](const SourceGraph::Statement& s) {
+    if (s.kind == SourceGraph::Statement::INCLUDE) {
+      const std::shared_ptr<const IncludeFileCache::Entry>& included=
+	  includes[nextInclude++];
+      node->statements.push_back(s);
+      node->includes.push_back(included);
+      mergeIncluded_(included->properties, properties);
+    } else if (referencesUnchanged(s.references, properties,
+				   environment_.get())) {
+      addProperty_(sourceName, s.name, s.value, s.line, s.nameColumn,
+		   properties);
+      node->statements.push_back(s);
+    } else {
+      std::vector<VariableReference> references;
+      std::shared_ptr<const ValueTemplate> compiled= s.compiled;
+      std::string value= processValue_(sourceName, *valueProcessor, s.text,
+				       s.line, s.valueColumn, &references,
+				       &compiled);
+      ++reprocessed;
+      addProperty_(sourceName, s.name, value, s.line, s.nameColumn,
+		   properties);
+      node->statements.push_back(
+	  SourceGraph::Statement{ s.kind, s.name, s.text, std::move(value),
+				  s.line, s.nameColumn, s.valueColumn,
+				  std::move(references), std::move(compiled) }
+      );
+    }
+  };
+
+  includes.reserve(old.includes.size());
+  for (auto i= old.statements.begin(); i != old.statements.end(); ++i) {
+    bool changed;
+    if (i->kind == SourceGraph::Statement::INCLUDE) {
+      checkInclude_(sourceName, i->name, i->line, i->valueColumn);
+      includes.push_back(parseIncludedFile_(sourceName, i->name));
+      if (recordIncludedFiles_) {
+	includedFiles_.push_back(includes.back());
+      }
+      changed= (includes.back() != old.includes[includes.size() - 1]);
+    } else {
+      changed= !environmentUnchanged(i->references, environment_.get());
+    }
+
+    if (!node && changed) {
+      node= std::make_shared<SourceGraph::Node>();
+      node->filename= old.filename;
+      node->stamp= old.stamp;
+      node->statements.reserve(old.statements.size());
+      valueProcessor.reset(
+	  createValueProcessor_(properties, usesEnvironmentVars())
+      );
+      valueProcessor->setEnvironment(environment_.get());
+      for (auto j= old.statements.begin(); j != i; ++j) {
+	replayStatement(*j);
+      }
+    }
+    if (node) {
+      replayStatement(*i);
+    }
+  }
+
+  if (!node) {
+    sourceGraph_->count(0, 0, 1, 0);
+    return previous;
+  }
+
+  node->result= makeEntry(*node, std::move(properties));
+  sourceGraph_->count(0, 1, 0, reprocessed);
+  return node;
+}
+
 ConfigurationPropertyMap ConfigFileParser::parse(const std::string& sourceName,
 						 std::istream& input,
 						 int initialLine,
 						 int initialColumn) {
+  EnvironmentScope environment(*this);
   ConfigFileLexer lexer(input, initialLine, initialColumn);
+  return parse_(sourceName, lexer);
+}
+
+ConfigurationPropertyMap ConfigFileParser::parseText(
+    const std::string& sourceName, const std::string& text,
+    int initialLine, int initialColumn
+) {
+  return parseBuffer(sourceName, text.data(), text.data() + text.size(),
+		     initialLine, initialColumn);
+}
+
+void ConfigFileParser::parse(const std::string& filename,
+			     ConfigurationHandler& handler) {
+  PointerScope<ConfigurationHandler> scope(handler_, handler);
+  readFile_(filename);
+}
+
+void ConfigFileParser::parse(const std::string& sourceName,
+			     std::istream& input,
+			     ConfigurationHandler& handler,
+			     int initialLine, int initialColumn) {
+  PointerScope<ConfigurationHandler> scope(handler_, handler);
+  parse(sourceName, input, initialLine, initialColumn);
+}
+
+void ConfigFileParser::parseText(const std::string& sourceName,
+				 const std::string& text,
+				 ConfigurationHandler& handler,
+				 int initialLine, int initialColumn) {
+  PointerScope<ConfigurationHandler> scope(handler_, handler);
+  parseText(sourceName, text, initialLine, initialColumn);
+}
+
+ConfigurationPropertyMap ConfigFileParser::parse(
+    const std::string& filename, ApplicationConfigurationErrorList& errors
+) {
+  PointerScope<ApplicationConfigurationErrorList> scope(errors_, errors);
+  inputFiles_.assign(1, filename);
+  recordIncludedFiles_= true;
+  try {
+    ConfigurationPropertyMap properties= readFile_(filename);
+    recordIncludedFiles_= false;
+    return properties;
+  } catch(const ConfigFileParseError& e) {
+    // The file could not be read
+    recordIncludedFiles_= false;
+    inputFiles_.clear();
+    errors.push_back(std::make_shared<ConfigFileParseError>(e));
+    return ConfigurationPropertyMap();
+  } catch(...) {
+    recordIncludedFiles_= false;
+    inputFiles_.clear();
+    throw;
+  }
+}
+
+ConfigurationPropertyMap ConfigFileParser::parse(
+    const std::string& sourceName, std::istream& input,
+    ApplicationConfigurationErrorList& errors, int initialLine,
+    int initialColumn
+) {
+  PointerScope<ApplicationConfigurationErrorList> scope(errors_, errors);
+  return parse(sourceName, input, initialLine, initialColumn);
+}
+
+ConfigurationPropertyMap ConfigFileParser::parseText(
+    const std::string& sourceName, const std::string& text,
+    ApplicationConfigurationErrorList& errors, int initialLine,
+    int initialColumn
+) {
+  PointerScope<ApplicationConfigurationErrorList> scope(errors_, errors);
+  return parseText(sourceName, text, initialLine, initialColumn);
+}
+
+ConfigurationPropertyMap ConfigFileParser::parseBuffer(
+    const std::string& sourceName, const char* begin, const char* end,
+    int initialLine, int initialColumn
+) {
+  EnvironmentScope environment(*this);
+  ConfigFileLexer lexer(begin, end, initialLine, initialColumn);
+  if (!includePool_ || handler_ || errors_) {
+    return parse_(sourceName, lexer);
+  }
+
+  prefetchIncludes_(sourceName, begin, end);
+  try {
+    ConfigurationPropertyMap properties= parse_(sourceName, lexer);
+    discardPrefetchedIncludes_();
+    return properties;
+  } catch(...) {
+    discardPrefetchedIncludes_();
+    throw;
+  }
+}
+
+ConfigurationPropertyMap ConfigFileParser::parse_(
+    const std::string& sourceName, ConfigFileLexer& lexer
+) {
   ConfigurationPropertyMap properties;
   std::unique_ptr<ValueProcessor> valueProcessor(
       createValueProcessor_(properties, usesEnvironmentVars())
   );
+  valueProcessor->setEnvironment(environment_.get());
+  std::vector<DeferredValue> deferred;
+  PointerScope< std::vector<DeferredValue> > deferredScope(deferred_,
+							   deferred);
+
+  // A parse that failed inside a block leaves it open
+  context_.clear();
+  contextPrefix_.clear();
 
   while (true) {
-    Token t= lexer.next();
-    if (t.type() == TokenType::END_OF_FILE) {
-      if (!getContext_().empty()) {
+    Token t= nextToken_(lexer);
+    try {
+      if (t.type() == TokenType::END_OF_FILE) {
+	if (!getContext_().empty()) {
+	  throw ConfigFileParseError(sourceName, t.line(), t.column(),
+				     "'}' expected");
+	}
+	break;
+      } else if (t.type() == TokenType::COMMENT) {
+	// Skip comments
+      } else if ((t.type() == TokenType::PUNCTUATION) && (t.value() == "}")) {
+	if (getContext_().empty()) {
+	  throw ConfigFileParseError(sourceName, t.line(), t.column(),
+				     "Syntax error ('}' unexpected)");
+	}
+	if (handler_) {
+	  handler_->onBlockEnd(
+	      contextPrefix_.substr(0, contextPrefix_.size() - 1),
+	      sourceName, t.line()
+	  );
+	}
+	endBlock_();
+      } else if (t.type() != TokenType::NAME) {
 	throw ConfigFileParseError(sourceName, t.line(), t.column(),
-				   "'}' expected");
-      }
-      break;
-    } else if (t.type() == TokenType::COMMENT) {
-      // Skip comments
-    } else if ((t.type() == TokenType::PUNCTUATION) && (t.value() == "}")) {
-      if (getContext_().empty()) {
+				   "Syntax error (property name expected)");
+      } else if (t.value() == "include") {
+	parseIncludeDirective_(sourceName, lexer, properties);
+      } else if (ConfigurationProperty::isLegalName(t.value())) {
+	parseAssignmentOrBlock_(sourceName, t, lexer, *valueProcessor,
+				properties);
+      } else {
+	std::ostringstream msg;
+	msg << "\"" << t.value() << "\" is not a legal property name";
 	throw ConfigFileParseError(sourceName, t.line(), t.column(),
-				   "Syntax error ('}' unexpected)");
+				   msg.str());
       }
-      endBlock_();
-    } else if (t.type() != TokenType::NAME) {
-      throw ConfigFileParseError(sourceName, t.line(), t.column(),
-				 "Syntax error (property name expected)");
-    } else if (t.value() == "include") {
-      parseIncludeDirective_(sourceName, lexer, properties);
-    } else if (ConfigurationProperty::isLegalName(t.value())) {
-      parseAssignmentOrBlock_(sourceName, t, lexer, *valueProcessor,
-			      properties);
-    } else {
-      std::ostringstream msg;
-      msg << "\"" << t.value() << "\" is not a legal property name";
-      throw ConfigFileParseError(sourceName, t.line(), t.column(), msg.str());
+    } catch(const ConfigFileParseError& e) {
+      if (!errors_) {
+	throw;
+      }
+      errors_->push_back(std::make_shared<ConfigFileParseError>(e));
+      if (t.type() == TokenType::END_OF_FILE) {
+	break;
+      }
+      recover_(lexer);
     }
   }
+
+  if (!deferred.empty()) {
+    resolveDeferred_(sourceName, deferred, *valueProcessor, properties);
+  }
   return properties;
 }
 
-ConfigurationPropertyMap ConfigFileParser::parseText(
-    const std::string& sourceName, const std::string& text,
-    int initialLine, int initialColumn
-) {
-  std::istringstream input(text);
-  return parse(sourceName, input, initialLine, initialColumn);
+void ConfigFileParser::recover_(ConfigFileLexer& lexer) {
+  if (!opensBlock(lexer.skipLine())) {
+    return;
+  }
+
+  // Skip the block's contents, reading values and quoted strings as
+  // such so braces within them are not counted
+  int depth= 1;
+  while (depth) {
+    Token t= nextToken_(lexer);
+    if (t.type() == TokenType::END_OF_FILE) {
+      break;
+    } else if (t.type() != TokenType::PUNCTUATION) {
+      continue;
+    } else if (t.value() == "{") {
+      ++depth;
+    } else if (t.value() == "}") {
+      --depth;
+    } else if (t.value() == "=") {
+      lexer.parseNextAsValue();
+    } else if (t.value() == "\"") {
+      lexer.parseNextAsQuotedString();
+      nextToken_(lexer);
+    }
+  }
 }
 
 void ConfigFileParser::parseIncludeDirective_(
@@ -113,7 +846,7 @@ void ConfigFileParser::parseIncludeDirective_(
 ) {
   int line = lexer.currentLine();
   int col = lexer.currentColumn();
-  Token t = lexer.next();
+  Token t = nextToken_(lexer);
   std::string includeFilePath;
 
   if ((t.type() != TokenType::PUNCTUATION) || (t.value() != "\"") ||
@@ -122,19 +855,15 @@ void ConfigFileParser::parseIncludeDirective_(
   }
 
   lexer.parseNextAsQuotedString();
-  t= lexer.next();
+  t= nextToken_(lexer);
   if ((t.type() != TokenType::VALUE) || t.value().empty()) {
     throw ConfigFileParseError(sourceName, line, t.column(),
 			       "File name missing");
   }
 
-  includeFilePath = t.value();
-  if (!path::isAbsolute(includeFilePath)) {
-    std::string pathToSource = std::get<0>(path::splitFile(sourceName));
-    includeFilePath = path::join(pathToSource, includeFilePath);
-  }
+  includeFilePath = resolveIncludePath(sourceName, std::string(t.value()));
   col= lexer.currentColumn();
-  t= lexer.next();
+  t= nextToken_(lexer);
   if ((t.type() != TokenType::PUNCTUATION) || (t.value() != "\"") ||
       (t.line() != line)) {
     throw ConfigFileParseError(sourceName, line, col, "'\"' expected");
@@ -144,45 +873,366 @@ void ConfigFileParser::parseIncludeDirective_(
     throw ConfigFileParseError(sourceName, t.line(), t.column(),
 			       "Cannot include a file from within a block");
   }
+  checkInclude_(sourceName, includeFilePath, t.line(), col);
+  if (recording_) {
+    recording_->statements.push_back(
+	SourceGraph::Statement{ SourceGraph::Statement::INCLUDE,
+				includeFilePath, std::string(),
+				std::string(), t.line(), col, col,
+				std::vector<VariableReference>(), nullptr }
+    );
+  }
+
+  if (handler_) {
+    parseIncludeEvents_(sourceName, includeFilePath, t.line(), properties);
+    return;
+  } else if (errors_) {
+    // The included file adds its errors to the same list
+    ConfigFileParser parser= createIncludeParser_(sourceName);
+    parser.includePool_= nullptr;
+    parser.includeFileCache_.reset();
+    parser.sourceGraph_.reset();
+    parser.recordIncludedFiles_= recordIncludedFiles_;
+    parser.errors_= errors_;
+    mergeIncluded_(parser.readFile_(includeFilePath), properties);
+    if (recordIncludedFiles_) {
+      // The included file comes before the files it included
+      inputFiles_.push_back(includeFilePath);
+      inputFiles_.insert(inputFiles_.end(), parser.inputFiles_.begin(),
+			 parser.inputFiles_.end());
+    }
+    return;
+  }
+
+  // Read the included properties and merge them
+  std::shared_ptr<const IncludeFileCache::Entry> included =
+      parseIncludedFile_(sourceName, includeFilePath);
+  if (recordIncludedFiles_) {
+    includedFiles_.push_back(included);
+  }
+  if (recording_) {
+    recording_->includes.push_back(included);
+  }
+  mergeIncluded_(included->properties, properties);
+}
+
+void ConfigFileParser::checkInclude_(const std::string& sourceName,
+				     const std::string& includeFilePath,
+				     int line, int column) {
   if (isIncludedFrom_(includeFilePath)) {
     std::ostringstream msg;
     msg << "Including \"" << includeFilePath
 	<< "\" would produce an include file loop.  The include file list is:"
 	<< join(getIncludedFrom_().begin(), getIncludedFrom_().end(), "\n  ")
 	<< "\n  " << sourceName;
-    throw ConfigFileParseError(sourceName, t.line(), col, msg.str());
+    throw ConfigFileParseError(sourceName, line, column, msg.str());
   }
   if (getIncludedFrom_().size() > MAX_INCLUDE_DEPTH_) {
     std::ostringstream msg;
     msg << "Maximum inclusion depth exceeded.  The include file list is:"
 	<< join(getIncludedFrom_().begin(), getIncludedFrom_().end(), "\n  ")
 	<< "\n  " << sourceName;
-    throw ConfigFileParseError(sourceName, t.line(), col, msg.str());
+    throw ConfigFileParseError(sourceName, line, column, msg.str());
   }
-  
-  // Read the included properties and merge them
-  ConfigFileParser includeFileParser(usesEnvironmentVars(),
-				     duplicatePropertyAction(),
-				     includedPropertyAction(),
-				     getIncludedFrom_(),
-				     sourceName);
-  ConfigurationPropertyMap includedProperties =
-      includeFileParser.parse(includeFilePath);
-  for (auto i = includedProperties.begin();
-       i != includedProperties.end();
-       ++i) {
-    if (!properties.hasKey(i->name()) ||
-	(includedPropertyAction() == DUP_OVERWRITE)) {
-      properties.add(*i);
-    } else if (includedPropertyAction() == DUP_ERROR) {
-      ConfigurationProperty original= properties[i->name()];
-      std::ostringstream msg;
-      msg << "Duplicate property \"" << i->name()
-	  << "\" (Originally defined at " << original.source() << ":"
-	  << original.line() << ")";
-      throw ConfigFileParseError(i->source(), i->line(), msg.str());
+}
+
+void ConfigFileParser::mergeIncluded_(
+    const ConfigurationPropertyMap& included,
+    ConfigurationPropertyMap& properties
+) {
+  ParseStatistics::Timer timer(statistics_.get(),
+			       ParseStatistics::INCLUDE_MERGE);
+  for (auto i = included.begin(); i != included.end(); ++i) {
+    mergeIncludedProperty_(*i, properties);
+  }
+}
+
+bool ConfigFileParser::mergeIncludedProperty_(
+    const ConfigurationProperty& property,
+    ConfigurationPropertyMap& properties
+) {
+  if (!properties.hasKey(property.name()) ||
+      (includedPropertyAction() == DUP_OVERWRITE)) {
+    properties.add(property);
+    return true;
+  } else if (includedPropertyAction() == DUP_ERROR) {
+    ConfigurationProperty original= properties[property.name()];
+    std::ostringstream msg;
+    msg << "Duplicate property \"" << property.name()
+	<< "\" (Originally defined at " << original.source() << ":"
+	<< original.line() << ")";
+    ConfigFileParseError error(property.source(), property.line(),
+			       msg.str());
+    if (!errors_) {
+      throw error;
     }
+    errors_->push_back(std::make_shared<ConfigFileParseError>(error));
+  }
+  return false;
+}
+
+void ConfigFileParser::parseIncludeEvents_(
+    const std::string& sourceName, const std::string& includeFilePath,
+    int line, ConfigurationPropertyMap& properties
+) {
+  handler_->onInclude(includeFilePath, sourceName, line);
+
+  // The included file is parsed as a map would be, but its properties
+  // are merged one at a time as the forwarder receives them
+  IncludeForwarder forwarder(*this, properties);
+  ConfigFileParser parser= createIncludeParser_(sourceName);
+  parser.includePool_= nullptr;
+  parser.includeFileCache_.reset();
+  parser.sourceGraph_.reset();
+  parser.recordIncludedFiles_= false;
+  parser.handler_= &forwarder;
+  parser.readFile_(includeFilePath);
+
+  handler_->onIncludeEnd(includeFilePath, sourceName, line);
+}
+
+Token ConfigFileParser::nextToken_(ConfigFileLexer& lexer) {
+  ParseStatistics::Timer timer(statistics_.get(), ParseStatistics::LEX);
+  return lexer.next();
+}
+
+std::shared_ptr<const IncludeFileCache::Entry>
+    ConfigFileParser::parseIncludedFile_(
+    const std::string& sourceName, const std::string& includeFilePath
+) {
+  // Equal keys keep their insertion order, so this is the earliest
+  // directive for the file
+  auto i= prefetched_.lower_bound(includeFilePath);
+  if ((i == prefetched_.end()) || (i->first != includeFilePath)) {
+    return createIncludeParser_(sourceName).parseInclude_(includeFilePath);
+  }
+
+  std::shared_ptr<PrefetchedInclude> include= std::move(i->second);
+  prefetched_.erase(i);
+  includePool_->wait(*include->task);
+  if (include->error) {
+    std::rethrow_exception(include->error);
   }
+  return std::move(include->result);
+}
+
+std::shared_ptr<const IncludeFileCache::Entry>
+    ConfigFileParser::parseInclude_(const std::string& filename) {
+  if (sourceGraph_) {
+    return parseWithGraph_(filename);
+  }
+
+  std::shared_ptr<IncludeFileCache::Entry> entry=
+      std::make_shared<IncludeFileCache::Entry>();
+  std::string key;
+  if (!includeFileCache_ || !fileKey_(filename, key)) {
+    if (recordIncludedFiles_) {
+      parseAndRecordInclude_(filename, *entry);
+    } else {
+      entry->properties= parse(filename);
+    }
+    return entry;
+  }
+
+  // A cached file is only usable if its environment variables still
+  // have the values it substituted, and parsing it here would neither
+  // nest includes too deeply nor include a file that is already being
+  // parsed.  Files are compared by identity, since the same file may be
+  // named differently here than when it was cached.
+  std::shared_ptr<const IncludeFileCache::Entry> cached=
+      includeFileCache_->find(key, [this](const IncludeFileCache::Entry& e) {
+	if (!environmentUnchanged(e.environment, environment_.get())) {
+	  return false;
+	}
+	if (e.depth &&
+	    (getIncludedFrom_().size() + e.depth - 1 > MAX_INCLUDE_DEPTH_)) {
+	  return false;
+	}
+	detail::FileStamp stamp;
+	for (auto i= getIncludedFrom_().begin(); i != getIncludedFrom_().end();
+	     ++i) {
+	  if (!detail::FileStamp::read(*i, stamp)) {
+	    continue;
+	  }
+	  for (auto j= e.files.begin(); j != e.files.end(); ++j) {
+	    if ((stamp.device == j->second.device) &&
+		(stamp.inode == j->second.inode)) {
+	      return false;
+	    }
+	  }
+	}
+	return true;
+      });
+  if (cached) {
+    const std::string& cachedName= cached->files.front().first;
+    if (cachedName == filename) {
+      return cached;
+    }
+
+    // Properties defined in the file itself name it as their source, so
+    // they should carry the name it was included by this time.  Those
+    // from the files it includes keep the names they were first read
+    // with, which refer to the same files.
+    *entry= *cached;
+    entry->files.front().first= filename;
+    entry->properties.clear();
+    for (auto i= cached->properties.begin(); i != cached->properties.end();
+	 ++i) {
+      if (i->source() == cachedName) {
+	entry->properties.add(
+	    ConfigurationProperty(i->name(), i->value(), filename, i->line())
+	);
+      } else {
+	entry->properties.add(*i);
+      }
+    }
+    return entry;
+  }
+
+  if (parseAndRecordInclude_(filename, *entry)) {
+    includeFileCache_->insert(key, entry);
+  }
+  return entry;
+}
+
+bool ConfigFileParser::parseAndRecordInclude_(
+    const std::string& filename, IncludeFileCache::Entry& entry
+) {
+  // Stamp the file before reading it, so a change made while it is
+  // being parsed invalidates the entry
+  detail::FileStamp stamp;
+  if (!detail::FileStamp::read(filename, stamp)) {
+    entry.properties= parse(filename);
+    return false;
+  }
+
+  bool complete= true;
+  includedFiles_.clear();
+  {
+    PointerScope<EnvironmentValues> environmentScope(
+	environmentUsed_, entry.environment
+    );
+    entry.properties= parse(filename);
+  }
+  entry.files.emplace_back(filename, stamp);
+  for (auto i= includedFiles_.begin(); i != includedFiles_.end(); ++i) {
+    const IncludeFileCache::Entry& included= **i;
+    complete= complete && !included.files.empty();
+    entry.files.insert(entry.files.end(), included.files.begin(),
+		       included.files.end());
+    entry.depth= std::max(entry.depth, included.depth + 1);
+    addEnvironmentReferences(included.environment, entry.environment);
+  }
+  includedFiles_.clear();
+  if (!complete) {
+    entry.files.clear();
+  }
+  return complete;
+}
+
+void ConfigFileParser::prefetchIncludes_(const std::string& sourceName,
+					 const char* begin,
+					 const char* end) {
+  // Includes that would fail the checks in parseIncludeDirective_ are
+  // left for it to report
+  if (getIncludedFrom_().size() > MAX_INCLUDE_DEPTH_) {
+    return;
+  }
+
+  const std::vector<std::string> includes= findIncludes(begin, end);
+  for (auto i= includes.begin(); i != includes.end(); ++i) {
+    const std::string includeFilePath= resolveIncludePath(sourceName, *i);
+    if (isIncludedFrom_(includeFilePath) ||
+	(includeFilePath == sourceName)) {
+      continue;
+    }
+
+    std::shared_ptr<PrefetchedInclude> include=
+	std::make_shared<PrefetchedInclude>();
+    std::shared_ptr<ConfigFileParser> parser=
+	std::make_shared<ConfigFileParser>(createIncludeParser_(sourceName));
+    PrefetchedInclude* target= include.get();
+    include->task= includePool_->submit(
+	[target, parser, includeFilePath]() {
+	  try {
+	    target->result= parser->parseInclude_(includeFilePath);
+	  } catch(...) {
+	    target->error= std::current_exception();
+	  }
+	}
+    );
+    prefetched_.emplace(includeFilePath, std::move(include));
+  }
+}
+
+void ConfigFileParser::discardPrefetchedIncludes_() {
+  for (auto i= prefetched_.begin(); i != prefetched_.end(); ++i) {
+    includePool_->cancel(*i->second->task);
+  }
+  prefetched_.clear();
+}
+
+ConfigFileParser ConfigFileParser::createIncludeParser_(
+    const std::string& sourceName
+) {
+  ConfigFileParser parser(usesEnvironmentVars(), duplicatePropertyAction(),
+			  includedPropertyAction(), getIncludedFrom_(),
+			  sourceName);
+  parser.setUsesMemoryMappedInput(usesMemoryMappedInput());
+  // The includer may refer to any of the included file's properties
+  parser.setReferenceResolution(
+      (referenceResolution() == RESOLVE_LAZY) ? RESOLVE_DEFERRED
+					       : referenceResolution()
+  );
+  parser.environmentProvider_= environmentProvider_;
+  parser.environment_= environment_;
+  parser.includePool_= includePool_;
+  parser.includeFileCache_= includeFileCache_;
+  parser.sourceGraph_= sourceGraph_;
+  parser.statistics_= statistics_;
+  parser.recordIncludedFiles_= recordIncludedFiles_ || (bool)includeFileCache_;
+  return parser;
+}
+
+std::string ConfigFileParser::settingsKey_() const {
+  std::string key;
+  key.push_back(usesEnvironmentVars() ? 'E' : '-');
+  key.push_back('0' + duplicatePropertyAction());
+  key.push_back('0' + includedPropertyAction());
+  key.push_back('0' + referenceResolution());
+  return key;
+}
+
+bool ConfigFileParser::fileKey_(const std::string& filename,
+				std::string& key) const {
+  char canonicalPath[PATH_MAX];
+  if (!::realpath(filename.c_str(), canonicalPath)) {
+    return false;
+  }
+  key.assign(canonicalPath);
+  key.push_back('\0');
+  key.append(settingsKey_());
+  return true;
+}
+
+bool ConfigFileParser::snapshotKey_(const std::string& filename,
+				    std::string& key) const {
+  char canonicalPath[PATH_MAX];
+  if (snapshotDirectory_.empty() ||
+      (referenceResolution() == RESOLVE_LAZY) ||
+      !getIncludedFrom_().empty() ||
+      !::realpath(filename.c_str(), canonicalPath)) {
+    return false;
+  }
+
+  // The properties' sources are spelled as filename is, so it is part of
+  // the key along with the file it names
+  key.assign(canonicalPath);
+  key.push_back('\0');
+  key.append(filename);
+  key.push_back('\0');
+  key.append(settingsKey_());
+  return true;
 }
 
 void ConfigFileParser::parseAssignmentOrBlock_(
@@ -191,11 +1241,17 @@ void ConfigFileParser::parseAssignmentOrBlock_(
     ConfigurationPropertyMap& properties
 ) {
   int col= lexer.currentColumn();
-  Token t= lexer.next();
+  Token t= nextToken_(lexer);
   if ((t.type() != TokenType::PUNCTUATION) || (t.line() != name.line())) {
     throw ConfigFileParseError(sourceName, name.line(), col, "'=' expected");
   } else if (t.value() == "{") {
     beginBlock_(name.value());
+    if (handler_) {
+      handler_->onBlockBegin(
+	  contextPrefix_.substr(0, contextPrefix_.size() - 1),
+	  sourceName, name.line()
+      );
+    }
   } else if (t.value() == "=") {
     parseAssignment_(sourceName, name, lexer, valueProcessor, properties);
   } else {
@@ -210,48 +1266,252 @@ void ConfigFileParser::parseAssignment_(
   int col= lexer.currentColumn();
   try {
     lexer.parseNextAsValue();
-    Token t= lexer.next();
+    Token t= nextToken_(lexer);
     if (t.type() != TokenType::VALUE) {
       throw ConfigFileParseError(sourceName, name.line(), col,
 				 "Property value expected");
     }
 
     std::string fullName= getFullName_(name.value());
-    std::string value= valueProcessor.processValue(t.value());
-    if (!properties.hasKey(fullName)) {
-      properties.add(
-	  ConfigurationProperty(fullName, value, sourceName, name.line())
+    if (defersReferences_()) {
+      // The property holds the value as written until it is resolved
+      std::shared_ptr<const ValueTemplate> compiled=
+	  compileValue_(sourceName, valueProcessor, t.value(), name.line(),
+			col);
+      addProperty_(sourceName, fullName, std::string(t.value()),
+		   name.line(), name.column(), properties);
+      deferred_->push_back(
+	  DeferredValue{ std::move(fullName), std::move(compiled),
+			 name.line(), col }
       );
+      return;
+    }
+
+    std::vector<VariableReference> references;
+    std::string value= processValue_(sourceName, valueProcessor, t.value(),
+				     name.line(), col,
+				     recording_ ? &references : nullptr);
+    addProperty_(sourceName, fullName, value, name.line(), name.column(),
+		 properties);
+    if (recording_) {
+      recording_->statements.push_back(
+	  SourceGraph::Statement{ SourceGraph::Statement::ASSIGNMENT,
+				  std::move(fullName), std::string(t.value()),
+				  std::move(value), name.line(),
+				  name.column(), col, std::move(references),
+				  nullptr }
+      );
+    }
+  } catch (const PropertyFormatError& e) {
+    std::ostringstream msg;
+    msg << "Invalid property value (" << e.description() << ")";
+    throw ConfigFileParseError(sourceName, name.line(), col, msg.str());
+  }
+}
+
+std::string ConfigFileParser::processValue_(
+    const std::string& sourceName, ValueProcessor& processor,
+    std::string_view text, int line, int column,
+    std::vector<VariableReference>* references,
+    std::shared_ptr<const ValueTemplate>* compiled
+) {
+  ParseStatistics::Timer timer(statistics_.get(),
+			       ParseStatistics::VALUE_PROCESSING);
+  std::vector<VariableReference> recorded;
+  if (environmentUsed_ && !references) {
+    references= &recorded;
+  }
+  processor.setReferences(references);
+  try {
+    std::string value;
+    if (compiled) {
+      if (!*compiled) {
+	*compiled= std::make_shared<const ValueTemplate>(
+	    processor.compile(text)
+	);
+      }
+      value= processor.evaluate(**compiled);
     } else {
-      ConfigurationProperty original= properties[fullName];
+      value= processor.processValue(text);
+    }
+    processor.setReferences(nullptr);
+    if (environmentUsed_) {
+      addEnvironmentReferences(*references, *environmentUsed_);
+    }
+    return value;
+  } catch (const PropertyFormatError& e) {
+    processor.setReferences(nullptr);
+    std::ostringstream msg;
+    msg << "Invalid property value (" << e.description() << ")";
+    throw ConfigFileParseError(sourceName, line, column, msg.str());
+  }
+}
+
+std::shared_ptr<const ValueTemplate> ConfigFileParser::compileValue_(
+    const std::string& sourceName, ValueProcessor& processor,
+    std::string_view text, int line, int column
+) {
+  ParseStatistics::Timer timer(statistics_.get(),
+			       ParseStatistics::VALUE_PROCESSING);
+  try {
+    return std::make_shared<const ValueTemplate>(processor.compile(text));
+  } catch (const PropertyFormatError& e) {
+    std::ostringstream msg;
+    msg << "Invalid property value (" << e.description() << ")";
+    throw ConfigFileParseError(sourceName, line, column, msg.str());
+  }
+}
+
+void ConfigFileParser::resolveDeferred_(
+    const std::string& sourceName,
+    const std::vector<DeferredValue>& deferred,
+    ValueProcessor& processor, ConfigurationPropertyMap& properties
+) {
+  enum State { UNRESOLVED, RESOLVING, RESOLVED };
+  struct Definition {
+    const DeferredValue* value;
+    State state;
+  };
+
+  // A value was overridden if a later definition or an included file
+  // replaced the property it defined
+  std::unordered_map<std::string_view, Definition> definitions;
+  definitions.reserve(deferred.size());
+  for (auto i= deferred.begin(); i != deferred.end(); ++i) {
+    const ConfigurationProperty* p= properties.find(i->name);
+    if (p && (p->line() == i->line) && (p->source() == sourceName)) {
+      definitions[i->name]= Definition{ &*i, UNRESOLVED };
+    }
+  }
+
+  auto report= [this](const ConfigFileParseError& e) {
+    if (!errors_) {
+      throw e;
+    }
+    errors_->push_back(std::make_shared<ConfigFileParseError>(e));
+  };
+
+  // Each value is resolved after the values it refers to, found by a
+  // depth-first search.  The search keeps the path it followed, with
+  // the next reference to follow from each value on it, so a cycle can
+  // be reported in full.
+  const bool lazy=
+      (referenceResolution() == RESOLVE_LAZY) && (bool)wantedProperties_;
+  std::vector< std::pair<Definition*, size_t> > path;
+  for (auto i= deferred.begin(); i != deferred.end(); ++i) {
+    auto root= definitions.find(i->name);
+    if ((root == definitions.end()) || (root->second.value != &*i) ||
+	(root->second.state != UNRESOLVED) ||
+	(lazy && !wantedProperties_(i->name))) {
+      continue;
+    }
+
+    root->second.state= RESOLVING;
+    path.emplace_back(&root->second, 0);
+    while (!path.empty()) {
+      Definition& d= *path.back().first;
+      const ValueTemplate& compiled= *d.value->compiled;
+      size_t& next= path.back().second;
+      if (next < compiled.numReferences()) {
+	auto j= definitions.find(compiled.name(next++));
+	if ((j == definitions.end()) || (j->second.state == RESOLVED)) {
+	  // Refers to an included property, an environment variable or
+	  // a value already resolved
+	} else if (j->second.state == UNRESOLVED) {
+	  j->second.state= RESOLVING;
+	  path.emplace_back(&j->second, 0);
+	} else {
+	  auto start= path.begin();
+	  while (start->first != &j->second) {
+	    ++start;
+	  }
+	  std::ostringstream msg;
+	  msg << "Invalid property value (Circular reference ";
+	  for (auto k= start; k != path.end(); ++k) {
+	    msg << k->first->value->name << " -> ";
+	    k->first->state= RESOLVED;
+	    properties.erase(k->first->value->name);
+	  }
+	  msg << j->second.value->name << ")";
+	  const DeferredValue& first= *start->first->value;
+	  path.erase(start, path.end());
+	  report(ConfigFileParseError(sourceName, first.line, first.column,
+				      msg.str()));
+	}
+      } else {
+	// Every value this one refers to has been resolved
+	const DeferredValue& v= *d.value;
+	std::shared_ptr<const ValueTemplate> c= v.compiled;
+	try {
+	  properties.add(
+	      ConfigurationProperty(
+		  v.name,
+		  processValue_(sourceName, processor, std::string_view(),
+				v.line, v.column, nullptr, &c),
+		  sourceName, v.line
+	      )
+	  );
+	} catch(const ConfigFileParseError& e) {
+	  properties.erase(v.name);
+	  report(e);
+	}
+	d.state= RESOLVED;
+	path.pop_back();
+      }
+    }
+  }
+
+  if (lazy) {
+    for (auto i= definitions.begin(); i != definitions.end(); ++i) {
+      if (i->second.state == UNRESOLVED) {
+	properties.erase(i->second.value->name);
+      }
+    }
+  }
+}
+
+void ConfigFileParser::addProperty_(const std::string& sourceName,
+				    const std::string& name,
+				    const std::string& value,
+				    int line, int column,
+				    ConfigurationPropertyMap& properties) {
+  bool added= true;
+  {
+    ParseStatistics::Timer timer(statistics_.get(),
+				 ParseStatistics::MAP_INSERT);
+    if (!properties.hasKey(name)) {
+      properties.add(ConfigurationProperty(name, value, sourceName, line));
+    } else {
+      ConfigurationProperty original= properties[name];
       DuplicatePropertyMode mode=
 	(original.source() == sourceName) ? duplicatePropertyAction()
-	                                  : includedPropertyAction();
+					  : includedPropertyAction();
       std::ostringstream msg;
 
       switch (mode) {
-        case DUP_OVERWRITE:
+	case DUP_OVERWRITE:
 	  properties.add(
-	      ConfigurationProperty(fullName, value, sourceName, name.line())
+	      ConfigurationProperty(name, value, sourceName, line)
 	  );
 	  break;
 
-        case DUP_IGNORE:
+	case DUP_IGNORE:
+	  added= false;
 	  break;
 
-        case DUP_ERROR:
-        default:
-	  msg << "Property \"" << fullName
+	case DUP_ERROR:
+	default:
+	  msg << "Property \"" << name
 	      << "\" defined twice; original definition at "
 	      << original.source() << ":" << original.line();
-	  throw ConfigFileParseError(sourceName, name.line(), name.column(),
-				     msg.str());
+	  throw ConfigFileParseError(sourceName, line, column, msg.str());
       }
     }
-  } catch (const PropertyFormatError& e) {
-    std::ostringstream msg;
-    msg << "Invalid property value (" << e.description() << ")";
-    throw ConfigFileParseError(sourceName, name.line(), col, msg.str());
+  }
+
+  // The handler's own time is not charged to the map
+  if (added && handler_) {
+    handler_->onProperty(name, value, sourceName, line);
   }
 }
 
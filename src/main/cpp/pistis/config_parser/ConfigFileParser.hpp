@@ -1,15 +1,27 @@
 #ifndef __PISTIS__CONFIG_PARSER__CONFIGFILEPARSER_HPP__
 #define __PISTIS__CONFIG_PARSER__CONFIGFILEPARSER_HPP__
 
+#include <pistis/config_parser/ApplicationConfigurationError.hpp>
+#include <pistis/config_parser/ConfigurationHandler.hpp>
 #include <pistis/config_parser/ConfigurationPropertyMap.hpp>
+#include <pistis/config_parser/EnvironmentProvider.hpp>
+#include <pistis/config_parser/IncludeFileCache.hpp>
+#include <pistis/config_parser/ParseStatistics.hpp>
+#include <pistis/config_parser/SourceGraph.hpp>
 #include <algorithm>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 
 namespace pistis {
   namespace config_parser {
     namespace detail {
       class ConfigFileLexer;
+      class LazyEnvironment;
+      class TaskPool;
       class Token;
       class ValueProcessor;
     }
@@ -36,6 +48,31 @@ namespace pistis {
 	DUP_OVERWRITE ///< Overwrite duplicate properties
       };
 
+      /** @brief When the variables referenced in property values are
+       *         resolved
+       */
+      enum ReferenceResolution {
+	/** @brief As each value is parsed, so a value can only refer to
+	 *         properties defined before it (the default)
+	 */
+	RESOLVE_IN_ORDER,
+
+	/** @brief Once each file has been parsed, so a value can refer
+	 *         to any property of the file
+	 */
+	RESOLVE_DEFERRED,
+
+	/** @brief As RESOLVE_DEFERRED, but only for the properties
+	 *         wantedProperties() accepts and those they refer to
+	 */
+	RESOLVE_LAZY
+      };
+
+      /** @brief Returns true for the names of properties that will be
+       *         read
+       */
+      typedef std::function<bool (const std::string&)> PropertyFilter;
+
     public:
       ConfigFileParser(
 	  bool useEnvironmentVars= true,
@@ -47,6 +84,25 @@ namespace pistis {
       bool usesEnvironmentVars() const { return useEnvVars_; }
       void setUsesEnvironmentVars(bool v) { useEnvVars_=v; }
 
+      /** @brief Where environment variables come from when
+       *         usesEnvironmentVars() is true
+       *
+       *  Each parse takes one snapshot from the provider, the first time
+       *  it refers to a variable that is not a property, and shares it
+       *  with the parsers for its included files.  Parses running at
+       *  once, or while another thread calls setenv(), each see a
+       *  consistent environment.  The default provider snapshots the
+       *  environment of the process.  Setting null restores it.
+       */
+      const std::shared_ptr<EnvironmentProvider>& environmentProvider() const {
+	return environmentProvider_;
+      }
+      void setEnvironmentProvider(
+	  const std::shared_ptr<EnvironmentProvider>& p
+      ) {
+	environmentProvider_= p ? p : EnvironmentProvider::process();
+      }
+
       DuplicatePropertyMode duplicatePropertyAction() const {
 	return duplicatePropertyAction_;
       }
@@ -61,6 +117,150 @@ namespace pistis {
 	includedPropertyAction_= action;
       }
 
+      /** @brief Whether parse(filename) maps regular files into memory
+       *         instead of reading them as streams
+       *
+       *  Mapping avoids copying the file and is faster for large files,
+       *  but it is off by default.  If another process truncates a file
+       *  while it is mapped, reading the lost pages raises SIGBUS and
+       *  kills the process.  Only turn it on when the configuration
+       *  files are never truncated in place while they are parsed, for
+       *  example when they are replaced by renaming a new file over the
+       *  old one.  Other kinds of files are always read as streams.
+       */
+      bool usesMemoryMappedInput() const { return useMemoryMap_; }
+      void setUsesMemoryMappedInput(bool v) { useMemoryMap_= v; }
+
+      /** @brief When the variables referenced in property values are
+       *         resolved
+       *
+       *  With RESOLVE_DEFERRED, each value is checked and compiled
+       *  into a detail::ValueTemplate as it is parsed.  After the file
+       *  has been parsed, every property still defined by the file is
+       *  resolved after the properties it refers to.  A value may
+       *  therefore refer to a property defined later in the file, and
+       *  sees the property's final value when the property is defined
+       *  more than once.  Properties that refer to each other in a
+       *  cycle are an error, which names every property in the cycle.
+       *  As with RESOLVE_IN_ORDER, a file's values refer to the
+       *  properties of that file, including those merged from the
+       *  files it includes, and then to environment variables.
+       *
+       *  RESOLVE_LAZY resolves only the properties wantedProperties()
+       *  accepts and the properties they refer to, directly or
+       *  indirectly.  The other properties defined by the file are
+       *  left out of the result, so their values are never checked.
+       *  Included files are resolved in full, since their includer may
+       *  refer to any of their properties.
+       *
+       *  Parsing with a ConfigurationHandler always resolves in order,
+       *  and the source graph is only used with RESOLVE_IN_ORDER.
+       */
+      ReferenceResolution referenceResolution() const {
+	return referenceResolution_;
+      }
+      void setReferenceResolution(ReferenceResolution r) {
+	referenceResolution_= r;
+      }
+
+      /** @brief The properties RESOLVE_LAZY resolves, or an empty
+       *         function (the default) to resolve them all
+       */
+      const PropertyFilter& wantedProperties() const {
+	return wantedProperties_;
+      }
+      void setWantedProperties(const PropertyFilter& f) {
+	wantedProperties_= f;
+      }
+
+      /** @brief Number of threads used to parse included files
+       *
+       *  When nonzero, the parser looks ahead for include directives in
+       *  each file it reads from a buffer or a memory-mapped file and
+       *  parses the included files concurrently on a pool of this many
+       *  threads.  Included properties are still merged one file at a
+       *  time, in the order the include directives appear, so the
+       *  result and any error are the same as when parsing serially.
+       *  When zero (the default), included files are parsed one after
+       *  another on the calling thread.
+       */
+      size_t includeThreads() const { return includeThreads_; }
+      void setIncludeThreads(size_t n);
+
+      /** @brief Cache of parsed include files, or null if included files
+       *         are parsed every time they are included
+       */
+      const std::shared_ptr<IncludeFileCache>& includeFileCache() const {
+	return includeFileCache_;
+      }
+      void setIncludeFileCache(const std::shared_ptr<IncludeFileCache>& c) {
+	includeFileCache_= c;
+      }
+
+      /** @brief Record of the files parsed and what they produced, or
+       *         null (the default) to parse every file in full
+       *
+       *  When set, every file this parser and the parsers for its
+       *  included files read goes through the graph, and is reparsed
+       *  only as far as it or the files it includes have changed since
+       *  the graph last saw it.  See SourceGraph.  The graph takes the
+       *  place of the include file cache when both are set.
+       */
+      const std::shared_ptr<SourceGraph>& sourceGraph() const {
+	return sourceGraph_;
+      }
+      void setSourceGraph(const std::shared_ptr<SourceGraph>& g) {
+	sourceGraph_= g;
+      }
+
+      /** @brief Directory holding compiled snapshots of parsed files, or
+       *         empty (the default) to not use snapshots
+       *
+       *  When set, parse(filename) looks in this directory for a
+       *  ConfigurationSnapshot of the file made with the same settings.
+       *  If one exists, none of the files it was built from have
+       *  changed and every environment variable it substituted has the
+       *  same value in the environment of this parse, the properties
+       *  are read from it instead of parsing the file.  Otherwise the
+       *  file is parsed and its snapshot is written to the directory for
+       *  next time.  Failing to read or write a snapshot is not an
+       *  error.
+       */
+      const std::string& snapshotDirectory() const {
+	return snapshotDirectory_;
+      }
+      void setSnapshotDirectory(const std::string& d) {
+	snapshotDirectory_= d;
+      }
+
+      /** @brief Where to add the time spent in each phase of parsing,
+       *         or null (the default) to not measure it
+       *
+       *  Parsers for included files add to the same statistics.
+       */
+      const std::shared_ptr<ParseStatistics>& statistics() const {
+	return statistics_;
+      }
+      void setStatistics(const std::shared_ptr<ParseStatistics>& s) {
+	statistics_= s;
+      }
+
+      /** @brief Snapshot that parse(filename) would use, or an empty
+       *         string if it would not use one
+       */
+      std::string snapshotFile(const std::string& filename) const;
+
+      /** @brief Files read by the last call to parse(filename) or
+       *         parse(filename, errors)
+       *
+       *  The file itself comes first, followed by every file it
+       *  included, directly or indirectly, spelled as the parser
+       *  resolved them.  Watch these to learn when the configuration
+       *  should be reloaded.
+       */
+      const std::vector<std::string>& inputFiles() const {
+	return inputFiles_;
+      }
 
       virtual ConfigurationPropertyMap parse(const std::string& filename);
       virtual ConfigurationPropertyMap parse(const std::string& sourceName,
@@ -72,17 +272,192 @@ namespace pistis {
 						 int initialLine=1,
 						 int initialColumn=1);
 
+      /** @brief Parse the configuration text in [begin, end) in place.
+       *
+       *  The buffer is tokenized without being copied, so it must remain
+       *  valid and unchanged until parseBuffer() returns.
+       */
+      virtual ConfigurationPropertyMap parseBuffer(
+	  const std::string& sourceName, const char* begin, const char* end,
+	  int initialLine=1, int initialColumn=1
+      );
+
+      /** @brief Parse @c filename, passing its contents to @c handler
+       *         as they are parsed instead of returning them
+       *
+       *  No map of the properties is returned or merged from included
+       *  files, so a consumer that routes properties elsewhere reads
+       *  the configuration in one pass.  The parser still keeps each
+       *  file's properties while parsing it, since variable
+       *  substitution and duplicate checks need them.
+       *
+       *  Included files are parsed serially, and the include file
+       *  cache, source graph and snapshots are not used.  If the file
+       *  has more than one error, the error reported may differ from
+       *  the one parse(filename) reports, and handler will have
+       *  received the properties that preceded it.
+       */
+      virtual void parse(const std::string& filename,
+			 ConfigurationHandler& handler);
+      virtual void parse(const std::string& sourceName, std::istream& input,
+			 ConfigurationHandler& handler, int initialLine=1,
+			 int initialColumn=1);
+      virtual void parseText(const std::string& sourceName,
+			     const std::string& text,
+			     ConfigurationHandler& handler,
+			     int initialLine=1, int initialColumn=1);
+
+      /** @brief Parse @c filename, adding every error found to
+       *         @c errors instead of throwing the first
+       *
+       *  After a syntax error, the parser skips the rest of the line.
+       *  If the line opens a block, the block is skipped too, since
+       *  the names of the properties in it are unknown.  A duplicate
+       *  property keeps its first definition, and a file that cannot
+       *  be included contributes no properties.  The properties that
+       *  could be parsed are returned, so one pass over the input
+       *  reports all of its problems.
+       *
+       *  Included files are parsed serially, and the include file
+       *  cache, source graph and snapshots are not used.
+       */
+      virtual ConfigurationPropertyMap parse(
+	  const std::string& filename,
+	  ApplicationConfigurationErrorList& errors
+      );
+      virtual ConfigurationPropertyMap parse(
+	  const std::string& sourceName, std::istream& input,
+	  ApplicationConfigurationErrorList& errors, int initialLine=1,
+	  int initialColumn=1
+      );
+      virtual ConfigurationPropertyMap parseText(
+	  const std::string& sourceName, const std::string& text,
+	  ApplicationConfigurationErrorList& errors, int initialLine=1,
+	  int initialColumn=1
+      );
+
     protected:
       ConfigFileParser(bool useEnvironmentVars,
 		       DuplicatePropertyMode duplicatePropertyAction,
 		       DuplicatePropertyMode includedPropertyAction,
 		       const std::vector<std::string>& includedFiles,
 		       const std::string& includedFrom);
-			 
+
+      /** @brief Parse @c filename without using a snapshot, going
+       *         through the source graph if there is one
+       */
+      ConfigurationPropertyMap parseFile_(const std::string& filename);
+
+      /** @brief Read and parse @c filename in full */
+      ConfigurationPropertyMap readFile_(const std::string& filename);
+
+      /** @brief Parse @c filename, updating its node in the source
+       *         graph
+       */
+      std::shared_ptr<const IncludeFileCache::Entry> parseWithGraph_(
+	  const std::string& filename
+      );
+
+      /** @brief Parse the unchanged file @c sourceName by replaying the
+       *         statements of its node @c previous
+       *
+       *  Returns @c previous itself if none of the files it includes or the
+       *  environment variables it references have changed.
+       */
+      std::shared_ptr<const SourceGraph::Node> replay_(
+	  const std::string& sourceName,
+	  const std::shared_ptr<const SourceGraph::Node>& previous
+      );
+
+      virtual ConfigurationPropertyMap parse_(const std::string& sourceName,
+					      detail::ConfigFileLexer& lexer);
+
+      /** @brief Read the next token, timing it if there are
+       *         statistics
+       */
+      detail::Token nextToken_(detail::ConfigFileLexer& lexer);
+
       virtual void parseIncludeDirective_(const std::string& sourceName,
 					  detail::ConfigFileLexer& lexer,
 					  ConfigurationPropertyMap& properties);
 
+      /** @brief Skip input after a syntax error, up to the next line or,
+       *         if the line opens a block, to the end of the block
+       */
+      void recover_(detail::ConfigFileLexer& lexer);
+
+      /** @brief Throw an error if @c sourceName cannot include
+       *         @c includeFilePath without a loop or nesting too deeply
+       */
+      void checkInclude_(const std::string& sourceName,
+			 const std::string& includeFilePath,
+			 int line, int column);
+
+      /** @brief Merge the properties of an included file into
+       *         @c properties
+       */
+      void mergeIncluded_(const ConfigurationPropertyMap& included,
+			  ConfigurationPropertyMap& properties);
+
+      /** @brief Merge @c property from an included file into
+       *         @c properties
+       *
+       *  Returns true if it was added.
+       */
+      bool mergeIncludedProperty_(const ConfigurationProperty& property,
+				  ConfigurationPropertyMap& properties);
+
+      /** @brief Parse the file @c includeFilePath included at @c line
+       *         of @c sourceName, passing its contents to the handler
+       *         and merging its properties into @c properties as they
+       *         arrive
+       */
+      void parseIncludeEvents_(const std::string& sourceName,
+			       const std::string& includeFilePath, int line,
+			       ConfigurationPropertyMap& properties);
+
+      /** @brief Parse the file @c includeFilePath included from
+       *         @c sourceName
+       *
+       *  Uses the result of parsing the file in the background if
+       *  prefetchIncludes_() started one.
+       */
+      std::shared_ptr<const IncludeFileCache::Entry> parseIncludedFile_(
+	  const std::string& sourceName, const std::string& includeFilePath
+      );
+
+      /** @brief Parse @c filename for the parser that created this one
+       *         with createIncludeParser_(), going through the include
+       *         file cache if there is one
+       */
+      std::shared_ptr<const IncludeFileCache::Entry> parseInclude_(
+	  const std::string& filename
+      );
+
+      /** @brief Stamp and parse the included file @c filename into
+       *         @c entry, recording the files it includes
+       *
+       *  Returns false, leaving @c entry.files empty, if the file or
+       *  any file it includes could not be stamped.
+       */
+      bool parseAndRecordInclude_(const std::string& filename,
+				  IncludeFileCache::Entry& entry);
+
+      /** @brief Start parsing the files included by the configuration
+       *         text in [begin, end) on the include thread pool
+       *
+       *  Include directives are found with a quick scan of the text
+       *  that does not track blocks or values.  It may find directives
+       *  the parser will not act on, whose results are discarded, and
+       *  may miss unusually formatted ones, which are parsed when the
+       *  parser reaches them.
+       */
+      void prefetchIncludes_(const std::string& sourceName,
+			     const char* begin, const char* end);
+
+      /** @brief Cancel prefetches that were never used */
+      void discardPrefetchedIncludes_();
+
       virtual void parseAssignmentOrBlock_(
 	  const std::string& sourceName, const detail::Token& name,
 	  detail::ConfigFileLexer& lexer,
@@ -96,6 +471,38 @@ namespace pistis {
 				    detail::ValueProcessor& valueProcessor,
 				    ConfigurationPropertyMap& properties);
 
+      /** @brief Process the value @c text, which starts at @c line and
+       *         @c column of @c sourceName
+       *
+       *  Appends the variables it references to @c references if it is
+       *  not null.  If @c compiled is not null, the value is evaluated
+       *  from the template it points to, which is compiled from
+       *  @c text first if it is null.
+       */
+      std::string processValue_(
+	  const std::string& sourceName, detail::ValueProcessor& processor,
+	  std::string_view text, int line, int column,
+	  std::vector<detail::VariableReference>* references,
+	  std::shared_ptr<const detail::ValueTemplate>* compiled= nullptr
+      );
+
+      /** @brief Compile the value @c text, which starts at @c line and
+       *         @c column of @c sourceName, for resolving later
+       */
+      std::shared_ptr<const detail::ValueTemplate> compileValue_(
+	  const std::string& sourceName, detail::ValueProcessor& processor,
+	  std::string_view text, int line, int column
+      );
+
+      /** @brief Add the property @c name defined at @c line and
+       *         @c column of @c sourceName, unless it duplicates one
+       *         that should be kept
+       */
+      void addProperty_(const std::string& sourceName,
+			const std::string& name, const std::string& value,
+			int line, int column,
+			ConfigurationPropertyMap& properties);
+
       virtual detail::ValueProcessor* createValueProcessor_(
 	  const ConfigurationPropertyMap& properties,
 	  bool useEnvironmentVars
@@ -107,11 +514,14 @@ namespace pistis {
       const std::string& getPropertyNamePrefix_() const {
 	return contextPrefix_;
       }
-      std::string getFullName_(const std::string& name) const {
-	return contextPrefix_ + name;
+      std::string getFullName_(std::string_view name) const {
+	std::string fullName;
+	fullName.reserve(contextPrefix_.size() + name.size());
+	fullName.append(contextPrefix_).append(name);
+	return fullName;
       }
-      void beginBlock_(const std::string& blockName) {
-	context_.push_back(blockName);
+      void beginBlock_(std::string_view blockName) {
+	context_.emplace_back(blockName);
 	contextPrefix_ += blockName;
 	contextPrefix_.push_back('.');
       }
@@ -148,6 +558,46 @@ namespace pistis {
       }
 	
     private:
+      struct PrefetchedInclude;
+      class IncludeForwarder;
+      struct DeferredValue;
+      class EnvironmentScope;
+
+      /** @brief True if values are compiled as they are parsed and
+       *         resolved once the file has been parsed
+       */
+      bool defersReferences_() const {
+	return (referenceResolution_ != RESOLVE_IN_ORDER) && !handler_;
+      }
+
+      /** @brief Resolve the values in @c deferred that @c sourceName
+       *         still defines, replacing them in @c properties
+       */
+      void resolveDeferred_(const std::string& sourceName,
+			    const std::vector<DeferredValue>& deferred,
+			    detail::ValueProcessor& processor,
+			    ConfigurationPropertyMap& properties);
+
+      ConfigFileParser createIncludeParser_(const std::string& sourceName);
+
+      /** @brief Settings that change the properties read from a file,
+       *         for use in cache and snapshot keys
+       */
+      std::string settingsKey_() const;
+
+      /** @brief Compute the key of @c filename in the include file
+       *         cache or source graph
+       *
+       *  Returns false if the file cannot be found.
+       */
+      bool fileKey_(const std::string& filename, std::string& key) const;
+
+      /** @brief Compute the key of the snapshot for @c filename
+       *
+       *  Returns false if parse(filename) should not use a snapshot.
+       */
+      bool snapshotKey_(const std::string& filename, std::string& key) const;
+
       /** @brief Whether to use environment variables for variable substitutions
        *
        *  If true, if the parser can't find a property with the given
@@ -158,6 +608,13 @@ namespace pistis {
        */
       bool useEnvVars_;
 
+      std::shared_ptr<EnvironmentProvider> environmentProvider_;
+
+      /** @brief Environment of the parse in progress, shared with the
+       *         parsers for included files, or null between parses
+       */
+      std::shared_ptr<detail::LazyEnvironment> environment_;
+
       /** @brief Action to take when a duplicate property occurs in the
        *         file being parsed.
        */
@@ -168,6 +625,104 @@ namespace pistis {
        */
       DuplicatePropertyMode includedPropertyAction_;
 
+      /** @brief Whether parse(filename) maps regular files into memory
+       *
+       *  If true, the lexer tokenizes the mapped file directly instead
+       *  of reading it line-by-line through a stream.  Files that cannot
+       *  be mapped, such as pipes, are always read as streams.
+       */
+      bool useMemoryMap_;
+
+      ReferenceResolution referenceResolution_;
+      PropertyFilter wantedProperties_;
+
+      /** @brief Where to add the values of the file being parsed for
+       *         resolving later, when defersReferences_() is true
+       */
+      std::vector<DeferredValue>* deferred_;
+
+      /** @brief Number of threads in includePool_ */
+      size_t includeThreads_;
+
+      /** @brief Pool for parsing included files, if this parser created
+       *         one
+       *
+       *  Only the parser that created a pool owns it.  Parsers for
+       *  included files share their includer's pool through
+       *  includePool_, so that the pool is never destroyed by one of its
+       *  own threads.
+       */
+      std::shared_ptr<detail::TaskPool> ownedIncludePool_;
+
+      /** @brief Pool for parsing included files, or null to parse them
+       *         on the calling thread
+       */
+      detail::TaskPool* includePool_;
+
+      /** @brief Cache of parsed include files, shared with the parsers
+       *         for included files
+       */
+      std::shared_ptr<IncludeFileCache> includeFileCache_;
+
+      /** @brief Source graph, shared with the parsers for included
+       *         files
+       */
+      std::shared_ptr<SourceGraph> sourceGraph_;
+
+      /** @brief Statistics shared with the parsers for included files */
+      std::shared_ptr<ParseStatistics> statistics_;
+
+      /** @brief Directory for compiled snapshots, or empty to not use
+       *         them
+       */
+      std::string snapshotDirectory_;
+
+      /** @brief Whether to record the files included by the file being
+       *         parsed in includedFiles_
+       *
+       *  True while parsing a file for a snapshot or an include file
+       *  cache entry, so its input files can be listed.  When errors
+       *  are collected, included files are added to inputFiles_
+       *  instead.
+       */
+      bool recordIncludedFiles_;
+
+      /** @brief Files included by the file being parsed, while
+       *         recordIncludedFiles_ is true
+       */
+      std::vector< std::shared_ptr<const IncludeFileCache::Entry> >
+	  includedFiles_;
+
+      /** @brief Node to record the statements of the file being parsed
+       *         in, or null if they are not recorded
+       */
+      SourceGraph::Node* recording_;
+
+      /** @brief Where to add the environment variables substituted into
+       *         the values of the file being parsed, with their values,
+       *         or null if they are not recorded
+       */
+      std::vector< std::pair<std::string, std::string> >* environmentUsed_;
+
+      /** @brief Files read by the last call to parse(filename) or
+       *         parse(filename, errors)
+       */
+      std::vector<std::string> inputFiles_;
+
+      /** @brief Where to pass the contents of the file being parsed,
+       *         or null when building a property map
+       */
+      ConfigurationHandler* handler_;
+
+      /** @brief Where to add errors found, or null to throw them */
+      ApplicationConfigurationErrorList* errors_;
+
+      /** @brief Included files being parsed in the background, by
+       *         path, in the order their include directives appear
+       */
+      std::multimap< std::string, std::shared_ptr<PrefetchedInclude> >
+	  prefetched_;
+
       /** @brief Context stack for blocks */
       std::vector<std::string> context_;
 
@@ -0,0 +1,27 @@
+#include "ConfigurationHandler.hpp"
+
+using namespace pistis::config_parser;
+
+ConfigurationHandler::~ConfigurationHandler() {
+  // Intentionally left blank
+}
+
+void ConfigurationHandler::onBlockBegin(const std::string&,
+					const std::string&, int) {
+  // Intentionally left blank
+}
+
+void ConfigurationHandler::onBlockEnd(const std::string&,
+				      const std::string&, int) {
+  // Intentionally left blank
+}
+
+void ConfigurationHandler::onInclude(const std::string&,
+				     const std::string&, int) {
+  // Intentionally left blank
+}
+
+void ConfigurationHandler::onIncludeEnd(const std::string&,
+					const std::string&, int) {
+  // Intentionally left blank
+}
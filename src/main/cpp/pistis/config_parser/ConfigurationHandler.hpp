@@ -0,0 +1,63 @@
+#ifndef __PISTIS__CONFIG_PARSER__CONFIGURATIONHANDLER_HPP__
+#define __PISTIS__CONFIG_PARSER__CONFIGURATIONHANDLER_HPP__
+
+#include <string>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief Receives the contents of a configuration file from
+     *         ConfigFileParser as it parses them
+     *
+     *  Properties arrive in the order the parser settles them, which
+     *  is file order, with the properties of an included file arriving
+     *  between onInclude() and onIncludeEnd().  Duplicate properties
+     *  are handled as parse() would handle them, except that a property
+     *  overwritten by a later definition arrives once for each
+     *  definition.  Applying the properties in order, each replacing
+     *  any earlier one with the same name, gives the properties parse()
+     *  would return.
+     *
+     *  Only onProperty() must be implemented.  The other methods do
+     *  nothing by default.  Exceptions thrown by a handler stop the
+     *  parse and propagate to its caller.
+     */
+    class ConfigurationHandler {
+    public:
+      virtual ~ConfigurationHandler();
+
+      /** @brief The property @c name, with its full name, has the
+       *         processed @c value, from @c line of @c source
+       */
+      virtual void onProperty(const std::string& name,
+			      const std::string& value,
+			      const std::string& source, int line) = 0;
+
+      /** @brief The block with the full name @c name begins at @c line
+       *         of @c source
+       */
+      virtual void onBlockBegin(const std::string& name,
+				const std::string& source, int line);
+
+      /** @brief The block with the full name @c name ends at @c line
+       *         of @c source
+       */
+      virtual void onBlockEnd(const std::string& name,
+			      const std::string& source, int line);
+
+      /** @brief @c line of @c source includes @c filename, whose
+       *         properties follow
+       */
+      virtual void onInclude(const std::string& filename,
+			     const std::string& source, int line);
+
+      /** @brief All properties of the file @c filename included at
+       *         @c line of @c source have arrived
+       */
+      virtual void onIncludeEnd(const std::string& filename,
+				const std::string& source, int line);
+    };
+
+  }
+}
+#endif
@@ -2,35 +2,57 @@
 
 using namespace pistis::config_parser;
 
-const std::regex ConfigurationProperty::LEGAL_NAME_REX_(
-    "[A-Za-z][A-Za-z0-9_]*(?:\\.[A-Za-z0-9_]+)*$"
-);
-
 ConfigurationProperty::ConfigurationProperty(const std::string& name, 
 					     const std::string& value,
 					     const std::string& source,
 					     int line):
-    name_(name), value_(value), source_(source), line_(line) {
+    name_(name), value_(value), source_(source), line_(line),
+    parsed_(nullptr) {
+  // Intentionally left blank
+}
+
+ConfigurationProperty::ConfigurationProperty(
+    const ConfigurationProperty& other
+):
+    name_(other.name_), value_(other.value_), source_(other.source_),
+    line_(other.line_), parsed_(nullptr) {
   // Intentionally left blank
 }
 
 ConfigurationProperty::ConfigurationProperty(ConfigurationProperty&& other):
     name_(std::move(other.name_)), value_(std::move(other.value_)),
-    source_(std::move(other.source_)), line_(other.line_) {
+    source_(std::move(other.source_)), line_(other.line_),
+    parsed_(other.parsed_.exchange(nullptr)) {
   // Intentionally left blank
 }
 
 ConfigurationProperty::~ConfigurationProperty() {
-  // Intentionally left blank
+  delete parsed_.load();
+}
+
+ConfigurationProperty& ConfigurationProperty::operator=(
+    const ConfigurationProperty& other
+) {
+  if (this != &other) {
+    name_= other.name_;
+    value_= other.value_;
+    source_= other.source_;
+    line_= other.line_;
+    delete parsed_.exchange(nullptr);
+  }
+  return *this;
 }
 
 ConfigurationProperty& ConfigurationProperty::operator=(
     ConfigurationProperty&& other
 ) {
-  name_= std::move(other.name_);
-  value_= std::move(other.value_);
-  source_= std::move(other.source_);
-  line_= other.line_;
+  if (this != &other) {
+    name_= std::move(other.name_);
+    value_= std::move(other.value_);
+    source_= std::move(other.source_);
+    line_= other.line_;
+    delete parsed_.exchange(other.parsed_.exchange(nullptr));
+  }
   return *this;
 }
 
@@ -79,6 +101,89 @@ double ConfigurationProperty::valueAsDouble_(const std::string& value,
   });
 }
 
+const detail::ParsedValueCache::Int64Result&
+    ConfigurationProperty::cachedInt64_() const {
+  return cache_().int64.get([this]() {
+    return pistis::util::toInt64Quietly(value(), 0);
+  });
+}
+
+const detail::ParsedValueCache::DoubleResult&
+    ConfigurationProperty::cachedDouble_() const {
+  return cache_().dbl.get([this]() {
+    return pistis::util::toDoubleQuietly(value());
+  });
+}
+
+const std::vector<std::string>* ConfigurationProperty::cachedSplit_(
+    const std::string& separator
+) const {
+  const detail::ParsedValueCache::SplitValue& split=
+      cache_().split.get([this, &separator]() {
+	static const pistis::util::SplitIterator END_OF_SPLIT;
+	detail::ParsedValueCache::SplitValue result;
+	result.separator= separator;
+	for (auto i= pistis::util::SplitIterator(value(), separator);
+	     i != END_OF_SPLIT;
+	     ++i) {
+	  result.items.push_back(*i);
+	}
+	return result;
+      });
+  return (split.separator == separator) ? &split.items : nullptr;
+}
+
+const std::vector<detail::ParsedValueCache::Int64Result>*
+    ConfigurationProperty::cachedListOfInt64_(
+	const std::string& separator
+    ) const {
+  const std::vector<std::string>* items= cachedSplit_(separator);
+  if (!items) {
+    return nullptr;
+  }
+  return &cache_().listOfInt64.get([items]() {
+    std::vector<detail::ParsedValueCache::Int64Result> result;
+    result.reserve(items->size());
+    for (auto i= items->begin(); i != items->end(); ++i) {
+      result.push_back(pistis::util::toInt64Quietly(*i, 0));
+    }
+    return result;
+  });
+}
+
+const std::vector<detail::ParsedValueCache::DoubleResult>*
+    ConfigurationProperty::cachedListOfDouble_(
+	const std::string& separator
+    ) const {
+  const std::vector<std::string>* items= cachedSplit_(separator);
+  if (!items) {
+    return nullptr;
+  }
+  return &cache_().listOfDouble.get([items]() {
+    std::vector<detail::ParsedValueCache::DoubleResult> result;
+    result.reserve(items->size());
+    for (auto i= items->begin(); i != items->end(); ++i) {
+      result.push_back(pistis::util::toDoubleQuietly(*i));
+    }
+    return result;
+  });
+}
+
+detail::ParsedValueCache& ConfigurationProperty::cache_() const {
+  detail::ParsedValueCache* cache= parsed_.load(std::memory_order_acquire);
+  if (!cache) {
+    // Threads that lose the race to install a cache use the winner's
+    detail::ParsedValueCache* fresh= new detail::ParsedValueCache();
+    if (parsed_.compare_exchange_strong(cache, fresh,
+					std::memory_order_acq_rel)) {
+      cache= fresh;
+    } else {
+      delete fresh;
+    }
+  }
+  return *cache;
+}
+
 std::ostream& pistis::config_parser::operator<<(
     std::ostream& out, const ConfigurationProperty& p
 ) {
@@ -5,9 +5,12 @@
 #include <pistis/util/StringUtil.hpp>
 #include <pistis/config_parser/InvalidPropertyValueError.hpp>
 #include <pistis/config_parser/PropertyFormatError.hpp>
-#include <regex>
+#include <pistis/config_parser/detail/LegalName.hpp>
+#include <pistis/config_parser/detail/ParsedValueCache.hpp>
+#include <atomic>
 #include <set>
 #include <sstream>
+#include <string_view>
 #include <vector>
 #include <float.h>
 #include <limits.h>
@@ -15,13 +18,22 @@
 namespace pistis {
   namespace config_parser {
 
+    /** @brief A property read from a configuration file
+     *
+     *  Conversions of the value to numbers and to lists of numbers or
+     *  strings are parsed once and cached, so repeated typed reads of
+     *  the same property do not parse the value again.  The cache is
+     *  allocated on the first such read and is safe to populate from
+     *  several threads at once.  Copies of a property start with an
+     *  empty cache.
+     */
     class ConfigurationProperty {
     public:
       ConfigurationProperty(const std::string& name, 
 			    const std::string& value,
 			    const std::string& source,
 			    int line);
-      ConfigurationProperty(const ConfigurationProperty& other)= default;
+      ConfigurationProperty(const ConfigurationProperty& other);
       ConfigurationProperty(ConfigurationProperty&& other);
       ~ConfigurationProperty();
 	
@@ -88,13 +100,17 @@ namespace pistis {
       }
       
       std::vector<std::string> valueAsList(const std::string& separator) const {
+	std::vector<std::string> result;
+	if (stripCached_(separator, result)) {
+	  return result;
+	}
 	return valueAsList(separator, [](const std::string& v) -> std::string {
 	  auto stripped = util::strip(v);
 	  if (stripped.empty()) {
 	    throw PropertyFormatError("List contains a missing value");
 	  }
 	  return std::move(stripped);
-        });
+	});
       }
 
       std::vector<std::string> valueAsRestrictedList(
@@ -123,6 +139,10 @@ namespace pistis {
       }
 
       std::set<std::string> valueAsSet(const std::string& separator) const {
+	std::set<std::string> result;
+	if (stripCached_(separator, result)) {
+	  return result;
+	}
 	return valueAsSet(separator, [](const std::string& v) -> std::string {
 	  auto stripped = util::strip(v);
 	  if (stripped.empty()) {
@@ -141,30 +161,42 @@ namespace pistis {
 	    [&legalValues, this](const std::string& v) -> std::string {
 	      return valueInSet_(util::strip(v), legalValues);
 	    }
-        );
+	);
       }
 
-      int valueAsInt() const { return valueAsInt_(value()); }
+      int valueAsInt() const { return valueAsIntInRange(INT_MIN, INT_MAX); }
       int valueAsIntInRange(int minValue, int maxValue) const {
-	return valueAsInt_(value(), minValue, maxValue);
+	const detail::ParsedValueCache::Int64Result& i= cachedInt64_();
+	return inRange_(i, minValue, maxValue)
+		   ? (int)i.first : valueAsInt_(value(), minValue, maxValue);
       }
 
       template <typename OutFn>
       void valueAsListOfInt(const std::string& separator,
 			    const OutFn& out) const {
-	valueAsList(separator, [this](const std::string& v) {
-	  return this->valueAsInt_(v);
-	}, out);
+	const auto* cached= cachedListOfInt64_(separator);
+	if (cached && allInRange_(*cached, INT_MIN, INT_MAX)) {
+	  for (auto i= cached->begin(); i != cached->end(); ++i) {
+	    out((int)i->first);
+	  }
+	} else {
+	  valueAsList(separator, [this](const std::string& v) {
+	    return this->valueAsInt_(v);
+	  }, out);
+	}
       }
 
       std::vector<int> valueAsListOfInt(const std::string& separator) const {
-	return valueAsList(separator, [this](const std::string& v) {
-	  return this->valueAsInt_(v);
-	});
+	return valueAsListOfInt(separator, INT_MIN, INT_MAX);
       }
 
       std::vector<int> valueAsListOfInt(const std::string& separator,
 					int minValue, int maxValue) const {
+	std::vector<int> result;
+	if (convertCached_(cachedListOfInt64_(separator), minValue, maxValue,
+			   result)) {
+	  return result;
+	}
 	return valueAsList(separator,
 			   [this,minValue,maxValue](const std::string& v) {
 	  return this->valueAsInt_(v, minValue, maxValue);
@@ -172,43 +204,60 @@ namespace pistis {
       }
 
       std::set<int> valueAsSetOfInt(const std::string& separator) const {
-	return valueAsSet(separator, [this](const std::string& v) {
-	  return this->valueAsInt_(v);
-	});
+	return valueAsSetOfInt(separator, INT_MIN, INT_MAX);
       }
 
       std::set<int> valueAsSetOfInt(const std::string& separator,
 				    int minValue, int maxValue) const {
+	std::set<int> result;
+	if (convertCached_(cachedListOfInt64_(separator), minValue, maxValue,
+			   result)) {
+	  return result;
+	}
 	return valueAsSet(separator,
 			  [this, minValue, maxValue](const std::string& v) {
 	  return this->valueAsInt_(v, minValue, maxValue);
 	});
       }
 
-      double valueAsDouble() const { return valueAsDouble_(value()); }
+      double valueAsDouble() const {
+	return valueAsDoubleInRange(-DBL_MAX, DBL_MAX);
+      }
       double valueAsDoubleInRange(double minValue, double maxValue) const {
-	return valueAsDouble_(value(), minValue, maxValue);
+	const detail::ParsedValueCache::DoubleResult& d= cachedDouble_();
+	return inRange_(d, minValue, maxValue)
+		   ? d.first : valueAsDouble_(value(), minValue, maxValue);
       }
 
       template <typename OutFnT>
       void valueAsListOfDouble(const std::string& separator,
 			       const OutFnT& output) const {
-	valueAsList(separator, [this](const std::string& v) {
-	  return this->valueAsDouble_(v);
-	}, output);
+	const auto* cached= cachedListOfDouble_(separator);
+	if (cached && allInRange_(*cached, -DBL_MAX, DBL_MAX)) {
+	  for (auto i= cached->begin(); i != cached->end(); ++i) {
+	    output(i->first);
+	  }
+	} else {
+	  valueAsList(separator, [this](const std::string& v) {
+	    return this->valueAsDouble_(v);
+	  }, output);
+	}
       }
 
       std::vector<double> valueAsListOfDouble(
 	  const std::string& separator
       ) const {
-	return valueAsList(separator, [this](const std::string& v) {
-	  return this->valueAsDouble_(v);
-	});
+	return valueAsListOfDouble(separator, -DBL_MAX, DBL_MAX);
       }
 
       std::vector<double> valueAsListOfDouble(const std::string& separator,
 					      double minValue,
 					      double maxValue) const {
+	std::vector<double> result;
+	if (convertCached_(cachedListOfDouble_(separator), minValue,
+			   maxValue, result)) {
+	  return result;
+	}
 	return valueAsList(separator,
 			   [this,minValue,maxValue](const std::string& v) {
 	  return this->valueAsDouble_(v, minValue, maxValue);
@@ -216,23 +265,24 @@ namespace pistis {
       }
 
       std::set<double> valueAsSetOfDouble(const std::string& separator) const {
-	return valueAsSet(separator, [this](const std::string& v) {
-	  return this->valueAsDouble_(v);
-	});
+	return valueAsSetOfDouble(separator, -DBL_MAX, DBL_MAX);
       }
 
       std::set<double> valueAsSetOfDouble(const std::string& separator,
 					  double minValue,
 					  double maxValue) const {
+	std::set<double> result;
+	if (convertCached_(cachedListOfDouble_(separator), minValue,
+			   maxValue, result)) {
+	  return result;
+	}
 	return valueAsSet(separator,
 			  [this, minValue, maxValue](const std::string& v) {
 	  return this->valueAsDouble_(v, minValue, maxValue);
 	});
       }
 
-      ConfigurationProperty& operator=(
-	  const ConfigurationProperty& other
-      ) = default;
+      ConfigurationProperty& operator=(const ConfigurationProperty& other);
       
       ConfigurationProperty& operator=(ConfigurationProperty&& other);
 
@@ -246,8 +296,13 @@ namespace pistis {
 	       (source() != other.source()) || (line() != other.line());
       }
 
-      static bool isLegalName(const std::string& name) {
-	return std::regex_match(name, LEGAL_NAME_REX_);
+      /** @brief True if @c name is a legal property name
+       *
+       *  May be evaluated at compile time, so names known in advance can
+       *  be checked with static_assert.
+       */
+      static constexpr bool isLegalName(std::string_view name) {
+	return detail::isLegalName(name);
       }
 
     protected:
@@ -303,13 +358,121 @@ namespace pistis {
 			    double minValue=-DBL_MAX,
 			    double maxValue=DBL_MAX) const;
 
+      /** @brief The value converted to an integer, parsing it if it has
+       *         not been parsed before
+       */
+      const detail::ParsedValueCache::Int64Result& cachedInt64_() const;
+
+      /** @brief The value converted to a double, parsing it if it has
+       *         not been parsed before
+       */
+      const detail::ParsedValueCache::DoubleResult& cachedDouble_() const;
+
+      /** @brief The value split on @c separator, or null if the cache
+       *         holds the value split on a different separator
+       */
+      const std::vector<std::string>* cachedSplit_(
+	  const std::string& separator
+      ) const;
+
+      /** @brief Each item in the value split on @c separator converted
+       *         to an integer, or null if the cache holds a list split on
+       *         a different separator
+       */
+      const std::vector<detail::ParsedValueCache::Int64Result>*
+	  cachedListOfInt64_(const std::string& separator) const;
+
+      /** @brief Each item in the value split on @c separator converted
+       *         to a double, or null if the cache holds a list split on a
+       *         different separator
+       */
+      const std::vector<detail::ParsedValueCache::DoubleResult>*
+	  cachedListOfDouble_(const std::string& separator) const;
+
+      /** @brief True if @c v converted successfully and lies in
+       *         [minValue, maxValue]
+       *
+       *  Values that fail this test take the uncached path, which
+       *  reports the error exactly as it always has.
+       */
+      template <typename T, typename BoundT>
+      static bool inRange_(
+	  const std::pair<T, util::NumConversionResult>& v,
+	  BoundT minValue, BoundT maxValue
+      ) {
+	return (v.second == util::NumConversionResult::OK) &&
+	       !(v.first < minValue) && !(v.first > maxValue);
+      }
+
+      template <typename T, typename BoundT>
+      static bool allInRange_(
+	  const std::vector< std::pair<T, util::NumConversionResult> >& v,
+	  BoundT minValue, BoundT maxValue
+      ) {
+	for (auto i= v.begin(); i != v.end(); ++i) {
+	  if (!inRange_(*i, minValue, maxValue)) {
+	    return false;
+	  }
+	}
+	return true;
+      }
+
+      /** @brief Fill @c result from a cached list, if there is one and
+       *         every item in it is legal
+       */
+      template <typename T, typename BoundT, typename ResultT>
+      static bool convertCached_(
+	  const std::vector< std::pair<T, util::NumConversionResult> >* v,
+	  BoundT minValue, BoundT maxValue, ResultT& result
+      ) {
+	if (!v || !allInRange_(*v, minValue, maxValue)) {
+	  return false;
+	}
+	reserve_(result, v->size());
+	for (auto i= v->begin(); i != v->end(); ++i) {
+	  result.insert(result.end(), (BoundT)i->first);
+	}
+	return true;
+      }
+
+      template <typename T>
+      static void reserve_(std::vector<T>& v, size_t n) { v.reserve(n); }
+
+      template <typename T>
+      static void reserve_(std::set<T>&, size_t) { }
+
+      /** @brief Fill @c result with the stripped items from the cached
+       *         split of the value, if there is one and no item is blank
+       */
+      template <typename ResultT>
+      bool stripCached_(const std::string& separator,
+			ResultT& result) const {
+	const std::vector<std::string>* items= cachedSplit_(separator);
+	if (!items) {
+	  return false;
+	}
+	reserve_(result, items->size());
+	for (auto i= items->begin(); i != items->end(); ++i) {
+	  std::string stripped= util::strip(*i);
+	  if (stripped.empty()) {
+	    result.clear();
+	    return false;
+	  }
+	  result.insert(result.end(), std::move(stripped));
+	}
+	return true;
+      }
+
     private:
+      detail::ParsedValueCache& cache_() const;
+
       std::string name_;
       std::string value_;
       std::string source_;
       int line_;
 
-      static const std::regex LEGAL_NAME_REX_;
+      /** @brief Parsed forms of value_, allocated on first use */
+      mutable std::atomic<detail::ParsedValueCache*> parsed_;
     };
 
     std::ostream& operator<<(std::ostream& out,
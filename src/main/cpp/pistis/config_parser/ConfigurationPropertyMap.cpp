@@ -4,6 +4,23 @@
 using namespace pistis::exceptions;
 using namespace pistis::config_parser;
 
+namespace {
+  /** @brief Search key that compares equal to every name beginning with
+   *         @c prefix
+   *
+   *  Names with the prefix are contiguous in the map, so
+   *  upper_bound(PrefixKey{ prefix }) finds the end of the run without
+   *  building the prefix's successor string.
+   */
+  struct PrefixKey {
+    std::string_view prefix;
+  };
+
+  bool operator<(const PrefixKey& key, const std::string& name) {
+    return name.compare(0, key.prefix.size(), key.prefix) > 0;
+  }
+}
+
 ConfigurationPropertyMap::ConfigurationPropertyMap():
     properties_() {
   // Intentionally left blank
@@ -22,13 +39,36 @@ ConfigurationPropertyMap::~ConfigurationPropertyMap() {
 
 std::vector<ConfigurationProperty>
     ConfigurationPropertyMap::getPropertiesWithPrefix(
-	const std::string& prefix
+	std::string_view prefix
+    ) const {
+  const PropertyRange<PropertyIterator> range= propertiesWithPrefix(prefix);
+  return std::vector<ConfigurationProperty>(range.begin(), range.end());
+}
+
+PropertyRange<ConfigurationPropertyMap::PropertyIterator>
+    ConfigurationPropertyMap::propertiesWithPrefix(
+	std::string_view prefix
+    ) const {
+  return PropertyRange<PropertyIterator>(
+      PropertyIterator(properties_.lower_bound(prefix)),
+      PropertyIterator(properties_.upper_bound(PrefixKey{ prefix }))
+  );
+}
+
+PropertyRange<ConfigurationPropertyMap::PropertyIterator>
+    ConfigurationPropertyMap::propertiesUnder(
+	std::string_view blockName
     ) const {
-  std::vector<ConfigurationProperty> result;
-  getPropertiesWithPrefix(prefix, [&result](const ConfigurationProperty& p) {
-    result.push_back(p);
-  });
-  return std::move(result);
+  // Names in the block begin with blockName + ".", and all such names
+  // sort before blockName + "/", since '/' follows '.'
+  std::string bound;
+  bound.reserve(blockName.size() + 1);
+  bound.append(blockName).push_back('.');
+  auto first= properties_.lower_bound(bound);
+  bound.back()= '/';
+  auto last= properties_.lower_bound(bound);
+  return PropertyRange<PropertyIterator>(PropertyIterator(first),
+					 PropertyIterator(last));
 }
 
 void ConfigurationPropertyMap::add(const ConfigurationProperty& p) {
@@ -41,22 +81,22 @@ void ConfigurationPropertyMap::add(const ConfigurationProperty& p) {
 }
 
 void ConfigurationPropertyMap::add(ConfigurationProperty&& p) {
-  auto i= properties_.find(p.name());
-  if (i != properties_.end()) {
+  auto i= properties_.lower_bound(p.name());
+  if ((i != properties_.end()) && (i->first == p.name())) {
     i->second= std::move(p);
   } else {
-    properties_.insert(
-	 std::pair<std::string, ConfigurationProperty>(p.name(), p)
-    );
+    // The key is copied from p before p is moved into the value
+    properties_.emplace_hint(i, p.name(), std::move(p));
   }
 }
 
 const ConfigurationProperty& ConfigurationPropertyMap::operator[](
-    const std::string& key
+    std::string_view key
 ) const {
   auto i= properties_.find(key);
   if (i == properties_.end()) {
-    throw NoSuchItem("Property with name \"" + key + "\"", PISTIS_EX_HERE);
+    throw NoSuchItem("Property with name \"" + std::string(key) + "\"",
+		     PISTIS_EX_HERE);
   }
   return i->second;
 }
@@ -2,14 +2,24 @@
 #define __PISTIS__CONFIG_PARSER__CONFIGURATIONPROPERTYMAP_HPP__
 
 #include <pistis/config_parser/ConfigurationProperty.hpp>
+#include <pistis/config_parser/PropertyRange.hpp>
 #include <iterator>
 #include <map>
+#include <string_view>
 
 namespace pistis {
   namespace config_parser {
 
     class ConfigurationPropertyMap {
     protected:
+      /** @brief Map from property name to property
+       *
+       *  The transparent comparator lets lookups use any string-like key,
+       *  such as a std::string_view or a literal, without constructing a
+       *  std::string.
+       */
+      typedef std::map<std::string, ConfigurationProperty, std::less<>>
+	  PropertyMap;
 
       template <typename Derived, typename Value>
       class BaseIterator {
@@ -44,12 +54,12 @@ namespace pistis {
       protected:
 	BaseIterator(): p_() { }
 	BaseIterator(
-	    const std::map<std::string, ConfigurationProperty>::const_iterator& p
+	    const PropertyMap::const_iterator& p
 	):
 	    p_(p) {
 	  // Intentionally left blank
 	}
-	std::map<std::string, ConfigurationProperty>::const_iterator p_;
+	PropertyMap::const_iterator p_;
       };
 
     public:
@@ -69,8 +79,8 @@ namespace pistis {
 
       private:
 	PropertyIterator(
-	    const std::map<std::string, ConfigurationProperty>::const_iterator& p
-        ):
+	    const PropertyMap::const_iterator& p
+	):
 	    BaseIterator<PropertyIterator, ConfigurationProperty>(p) {
 	  // Intentionally left blank
 	}
@@ -86,7 +96,7 @@ namespace pistis {
 
       private:
 	NameIterator(
-	    const std::map<std::string, ConfigurationProperty>::const_iterator& p
+	    const PropertyMap::const_iterator& p
 	):
 	    BaseIterator<NameIterator, std::string>(p) {
 	  // Intentionally left blank
@@ -116,29 +126,37 @@ namespace pistis {
 	return NameIterator(properties_.end());
       }
 
-      bool hasKey(const std::string& key) const {
+      /** @brief Returns the property named @c key, or null if there is
+       *         no such property
+       */
+      const ConfigurationProperty* find(std::string_view key) const {
+	auto i= properties_.find(key);
+	return (i != properties_.end()) ? &(i->second) : nullptr;
+      }
+
+      bool hasKey(std::string_view key) const {
 	return properties_.find(key) != properties_.end();
       }
 
-      const std::string& getValue(const std::string& key,
+      const std::string& getValue(std::string_view key,
 				  const std::string& dv) const {
 	auto i= properties_.find(key);
 	return (i != properties_.end()) ? i->second.value() : dv;
       }
 
-      int getValueAsInt(const std::string& key, int dv) const {
+      int getValueAsInt(std::string_view key, int dv) const {
 	auto i= properties_.find(key);
 	return (i != properties_.end()) ? i->second.valueAsInt() : dv;
       }
 
-      double getValueAsDouble(const std::string& key, double dv) const {
+      double getValueAsDouble(std::string_view key, double dv) const {
 	auto i= properties_.find(key);
 	return (i != properties_.end()) ? i->second.valueAsDouble() : dv;
       }
 
       template <typename Fn>
       auto getValue(
-	  const std::string& key,
+	  std::string_view key,
 	  const decltype((*(Fn*)0)(*(std::string*)0))& dv,
 	  const Fn& format
       ) const -> decltype(format(*(std::string*)0)) {
@@ -146,6 +164,19 @@ namespace pistis {
 	return (i != properties_.end()) ? i->second.valueAs(format) : dv;
       }
 
+      /** @brief Returns a view of the properties whose names satisfy
+       *         @c f, without copying them
+       *
+       *  @c f is called with a property's name when the view is
+       *  traversed, not when it is created.
+       */
+      template <typename Fn>
+      FilteredPropertyRange<PropertyIterator, Fn> propertiesMatching(
+	  const Fn& f
+      ) const {
+	return FilteredPropertyRange<PropertyIterator, Fn>(begin(), end(), f);
+      }
+
       template <typename Fn, typename OutFn>
       void getPropertiesMatching(const Fn& f, const OutFn& output) const {
 	for (auto i= properties_.begin(); i != properties_.end(); ++i) {
@@ -161,28 +192,53 @@ namespace pistis {
       ) const {
 	std::vector<ConfigurationProperty> result;
 	getPropertiesMatching(f, [&result](const ConfigurationProperty& p) {
-          result.push_back(p);
+	  result.push_back(p);
 	});
 	return std::move(result);
       }
 
+      /** @brief Returns a view of the properties whose names begin with
+       *         @c prefix, without copying them
+       *
+       *  The view refers to this map's storage and is valid until the
+       *  map is modified or destroyed.
+       */
+      PropertyRange<PropertyIterator> propertiesWithPrefix(
+	  std::string_view prefix
+      ) const;
+
       template <typename OutFn>
-      void getPropertiesWithPrefix(const std::string& prefix,
+      void getPropertiesWithPrefix(std::string_view prefix,
 				   const OutFn& output) const {
-	auto i= properties_.lower_bound(prefix);
-	while ((i != properties_.end()) && util::startsWith(i->first, prefix)) {
-	  output(i->second);
-	  ++i;
+	for (const ConfigurationProperty& p : propertiesWithPrefix(prefix)) {
+	  output(p);
 	}
       }
 
       std::vector<ConfigurationProperty> getPropertiesWithPrefix(
-	  const std::string& prefix
+	  std::string_view prefix
+      ) const;
+
+      /** @brief Returns the properties whose names begin with
+       *         blockName + ".", i.e. the properties defined in block
+       *         @c blockName and the blocks nested inside it.
+       *
+       *  The view refers to this map's storage and is valid until the
+       *  map is modified or destroyed.
+       */
+      PropertyRange<PropertyIterator> propertiesUnder(
+	  std::string_view blockName
       ) const;
 
       void add(const ConfigurationProperty& p);
       void add(ConfigurationProperty&& p);
-      void erase(const std::string& key) { properties_.erase(key); }
+      void erase(std::string_view key) {
+	// std::map::erase has no heterogeneous overload until C++23
+	auto i= properties_.find(key);
+	if (i != properties_.end()) {
+	  properties_.erase(i);
+	}
+      }
       void clear() { properties_.clear(); }
 
       ConfigurationPropertyMap& operator=(
@@ -193,10 +249,12 @@ namespace pistis {
 	properties_= std::move(other.properties_);
 	return *this;
       }
-      const ConfigurationProperty& operator[](const std::string& key) const;
+      const ConfigurationProperty& operator[](std::string_view key) const;
 
     private:
-      std::map<std::string, ConfigurationProperty> properties_;
+      PropertyMap properties_;
+
+      friend class FlatConfigurationPropertyMap;
     };
 
   }
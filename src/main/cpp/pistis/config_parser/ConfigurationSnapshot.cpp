@@ -0,0 +1,462 @@
+#include "ConfigurationSnapshot.hpp"
+#include "ConfigurationSnapshotError.hpp"
+#include "EnvironmentSnapshot.hpp"
+#include "detail/MemoryMappedFile.hpp"
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser;
+using namespace pistis::config_parser::detail;
+
+// Every record is a multiple of eight bytes and every table starts on an
+// eight-byte boundary, so records can be read in place from the mapping.
+
+struct ConfigurationSnapshot::StringRef {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct ConfigurationSnapshot::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t fileSize;
+  StringRef key;
+  uint32_t numProperties;
+  uint32_t numSources;
+  uint32_t numInputs;
+  uint32_t numEnvironment;
+  uint64_t propertiesOffset;
+  uint64_t sourcesOffset;
+  uint64_t inputsOffset;
+  uint64_t environmentOffset;
+  uint64_t stringsOffset;
+  uint64_t stringsSize;
+};
+
+struct ConfigurationSnapshot::PropertyRecord {
+  StringRef name;
+  StringRef value;
+  uint32_t source;
+  int32_t line;
+};
+
+struct ConfigurationSnapshot::InputRecord {
+  StringRef path;
+  uint64_t device;
+  uint64_t inode;
+  int64_t size;
+  int64_t modifiedSeconds;
+  int64_t modifiedNanoseconds;
+  uint64_t contentHash;
+};
+
+struct ConfigurationSnapshot::EnvironmentRecord {
+  StringRef name;
+  StringRef value;
+};
+
+namespace {
+  const char SNAPSHOT_MAGIC[8]= { 'P', 'I', 'S', 'T', 'I', 'S', 'C', 'S' };
+  const uint32_t SNAPSHOT_VERSION= 2;
+  const uint32_t SNAPSHOT_BYTE_ORDER= 0x01020304;
+
+  /** @brief 64-bit FNV-1a hash of [begin, end) */
+  uint64_t fnv1a(const char* begin, const char* end) {
+    uint64_t h= 0xcbf29ce484222325ULL;
+    for (const char* p= begin; p != end; ++p) {
+      h= (h ^ (unsigned char)*p) * 0x100000001b3ULL;
+    }
+    return h;
+  }
+
+  bool hashFile(const std::string& path, uint64_t& hash) {
+    MemoryMappedFile file(path);
+    if (file.error() || !file.isMapped()) {
+      return false;
+    }
+    hash= fnv1a(file.begin(), file.end());
+    return true;
+  }
+
+  size_t roundUp(size_t n) {
+    return (n + 7) & ~(size_t)7;
+  }
+
+  /** @brief Whether a table of @c count records of @c recordSize bytes
+   *         at @c offset lies within a file of @c fileSize bytes
+   */
+  bool tableFits(uint64_t offset, uint64_t count, uint64_t recordSize,
+		 uint64_t fileSize) {
+    // count is at most 2^32 and recordSize is small, so this cannot
+    // overflow
+    return !(offset & 7) && (offset <= fileSize) &&
+	   (count * recordSize <= fileSize - offset);
+  }
+
+  std::string errnoMessage(const std::string& what, int error) {
+    std::ostringstream msg;
+    msg << what << " (" << strerror(error) << ")";
+    return msg.str();
+  }
+}
+
+ConfigurationSnapshot::ConfigurationSnapshot(const std::string& filename):
+    filename_(filename), file_(new MemoryMappedFile(filename)),
+    header_(nullptr), properties_(nullptr), sources_(nullptr),
+    inputs_(nullptr), environment_(nullptr), strings_(nullptr) {
+  if (file_->error()) {
+    throw ConfigurationSnapshotError(
+	filename, errnoMessage("Cannot open snapshot", file_->error())
+    );
+  } else if (!file_->isMapped() || (file_->size() < sizeof(Header))) {
+    throw ConfigurationSnapshotError(filename, "Not a snapshot");
+  }
+
+  const char* base= file_->begin();
+  const uint64_t fileSize= file_->size();
+  header_= reinterpret_cast<const Header*>(base);
+  if (memcmp(header_->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC))) {
+    throw ConfigurationSnapshotError(filename, "Not a snapshot");
+  } else if (header_->byteOrder != SNAPSHOT_BYTE_ORDER) {
+    throw ConfigurationSnapshotError(filename,
+				     "Snapshot has the wrong byte order");
+  } else if (header_->version != SNAPSHOT_VERSION) {
+    std::ostringstream msg;
+    msg << "Cannot read version " << header_->version << " snapshots";
+    throw ConfigurationSnapshotError(filename, msg.str());
+  } else if ((header_->fileSize != fileSize) ||
+	     !tableFits(header_->propertiesOffset, header_->numProperties,
+			sizeof(PropertyRecord), fileSize) ||
+	     !tableFits(header_->sourcesOffset, header_->numSources,
+			sizeof(StringRef), fileSize) ||
+	     !tableFits(header_->inputsOffset, header_->numInputs,
+			sizeof(InputRecord), fileSize) ||
+	     !tableFits(header_->environmentOffset, header_->numEnvironment,
+			sizeof(EnvironmentRecord), fileSize) ||
+	     !tableFits(header_->stringsOffset, header_->stringsSize, 1,
+			fileSize)) {
+    throw ConfigurationSnapshotError(filename,
+				     "Snapshot is truncated or corrupt");
+  }
+
+  properties_= reinterpret_cast<const PropertyRecord*>(
+      base + header_->propertiesOffset
+  );
+  sources_= reinterpret_cast<const StringRef*>(base + header_->sourcesOffset);
+  inputs_= reinterpret_cast<const InputRecord*>(base + header_->inputsOffset);
+  environment_= reinterpret_cast<const EnvironmentRecord*>(
+      base + header_->environmentOffset
+  );
+  strings_= base + header_->stringsOffset;
+}
+
+ConfigurationSnapshot::~ConfigurationSnapshot() {
+  // Intentionally left blank
+}
+
+std::string_view ConfigurationSnapshot::key() const {
+  return string_(header_->key);
+}
+
+size_t ConfigurationSnapshot::size() const {
+  return header_->numProperties;
+}
+
+ConfigurationSnapshot::Property ConfigurationSnapshot::property(
+    size_t i
+) const {
+  return property_(properties_[i]);
+}
+
+std::optional<ConfigurationSnapshot::Property> ConfigurationSnapshot::find(
+    std::string_view name
+) const {
+  const PropertyRecord* end= properties_ + header_->numProperties;
+  const PropertyRecord* p= std::lower_bound(
+      properties_, end, name,
+      [this](const PropertyRecord& r, std::string_view n) {
+	return string_(r.name) < n;
+      }
+  );
+  if ((p == end) || (string_(p->name) != name)) {
+    return std::nullopt;
+  }
+  return property_(*p);
+}
+
+size_t ConfigurationSnapshot::numInputFiles() const {
+  return header_->numInputs;
+}
+
+ConfigurationSnapshot::InputFile ConfigurationSnapshot::inputFile(
+    size_t i
+) const {
+  const InputRecord& record= inputs_[i];
+  InputFile input;
+  input.path= string_(record.path);
+  input.stamp.device= record.device;
+  input.stamp.inode= record.inode;
+  input.stamp.size= record.size;
+  input.stamp.modifiedSeconds= record.modifiedSeconds;
+  input.stamp.modifiedNanoseconds= record.modifiedNanoseconds;
+  input.contentHash= record.contentHash;
+  return input;
+}
+
+size_t ConfigurationSnapshot::numEnvironmentVariables() const {
+  return header_->numEnvironment;
+}
+
+ConfigurationSnapshot::EnvironmentVariable
+    ConfigurationSnapshot::environmentVariable(size_t i) const {
+  EnvironmentVariable variable;
+  variable.name= string_(environment_[i].name);
+  variable.value= string_(environment_[i].value);
+  return variable;
+}
+
+bool ConfigurationSnapshot::isFresh(
+    const EnvironmentSnapshot& environment
+) const {
+  for (size_t i= 0; i < numEnvironmentVariables(); ++i) {
+    const EnvironmentVariable variable= environmentVariable(i);
+    const std::string* value= environment.find(variable.name);
+    if (!value || (*value != variable.value)) {
+      return false;
+    }
+  }
+  return inputFilesFresh_();
+}
+
+bool ConfigurationSnapshot::isFresh() const {
+  for (size_t i= 0; i < numEnvironmentVariables(); ++i) {
+    const EnvironmentVariable variable= environmentVariable(i);
+    const char* value= ::getenv(std::string(variable.name).c_str());
+    if (!value || (variable.value != value)) {
+      return false;
+    }
+  }
+  return inputFilesFresh_();
+}
+
+ConfigurationPropertyMap ConfigurationSnapshot::toPropertyMap() const {
+  // Convert each source once, and reuse the buffers for names and
+  // values, so building a property copies each string only once
+  std::vector<std::string> sources;
+  sources.reserve(header_->numSources);
+  for (size_t i= 0; i < header_->numSources; ++i) {
+    sources.emplace_back(string_(sources_[i]));
+  }
+
+  ConfigurationPropertyMap properties;
+  std::string name;
+  std::string value;
+  for (size_t i= 0; i < size(); ++i) {
+    const PropertyRecord& record= properties_[i];
+    if (record.source >= header_->numSources) {
+      throw ConfigurationSnapshotError(filename_,
+				       "Snapshot is truncated or corrupt");
+    }
+    name.assign(string_(record.name));
+    value.assign(string_(record.value));
+    properties.add(ConfigurationProperty(name, value, sources[record.source],
+					 record.line));
+  }
+  return properties;
+}
+
+void ConfigurationSnapshot::write(
+    const std::string& filename, std::string_view key,
+    const ConfigurationPropertyMap& properties,
+    const std::vector< std::pair<std::string, FileStamp> >& inputFiles,
+    const std::vector< std::pair<std::string, std::string> >& environment
+) {
+  std::string strings;
+  auto addString= [&strings](std::string_view s) {
+    StringRef ref;
+    ref.offset= (uint32_t)strings.size();
+    ref.length= (uint32_t)s.size();
+    strings.append(s);
+    return ref;
+  };
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.version= SNAPSHOT_VERSION;
+  header.byteOrder= SNAPSHOT_BYTE_ORDER;
+  header.key= addString(key);
+
+  std::vector<PropertyRecord> propertyRecords;
+  std::vector<StringRef> sources;
+  std::map<std::string, uint32_t> sourceIndex;
+  propertyRecords.reserve(properties.size());
+  for (auto i= properties.begin(); i != properties.end(); ++i) {
+    auto j= sourceIndex.find(i->source());
+    if (j == sourceIndex.end()) {
+      j= sourceIndex.emplace(i->source(), (uint32_t)sources.size()).first;
+      sources.push_back(addString(i->source()));
+    }
+
+    PropertyRecord record;
+    record.name= addString(i->name());
+    record.value= addString(i->value());
+    record.source= j->second;
+    record.line= i->line();
+    propertyRecords.push_back(record);
+  }
+
+  std::vector<InputRecord> inputs;
+  for (auto i= inputFiles.begin(); i != inputFiles.end(); ++i) {
+    // Hash the file, then check that it is still the one that was
+    // parsed, so the hash matches the parsed contents
+    InputRecord record;
+    FileStamp stamp;
+    if (!hashFile(i->first, record.contentHash) ||
+	!FileStamp::read(i->first, stamp) || (stamp != i->second)) {
+      throw ConfigurationSnapshotError(
+	  filename, "\"" + i->first + "\" changed while it was parsed"
+      );
+    }
+    record.path= addString(i->first);
+    record.device= stamp.device;
+    record.inode= stamp.inode;
+    record.size= stamp.size;
+    record.modifiedSeconds= stamp.modifiedSeconds;
+    record.modifiedNanoseconds= stamp.modifiedNanoseconds;
+    inputs.push_back(record);
+  }
+
+  std::vector<EnvironmentRecord> environmentRecords;
+  environmentRecords.reserve(environment.size());
+  for (auto i= environment.begin(); i != environment.end(); ++i) {
+    EnvironmentRecord record;
+    record.name= addString(i->first);
+    record.value= addString(i->second);
+    environmentRecords.push_back(record);
+  }
+
+  if (strings.size() > UINT32_MAX) {
+    throw ConfigurationSnapshotError(filename,
+				     "Too much text for one snapshot");
+  }
+
+  header.numProperties= (uint32_t)propertyRecords.size();
+  header.numSources= (uint32_t)sources.size();
+  header.numInputs= (uint32_t)inputs.size();
+  header.numEnvironment= (uint32_t)environmentRecords.size();
+  header.propertiesOffset= sizeof(Header);
+  header.sourcesOffset= header.propertiesOffset +
+      propertyRecords.size() * sizeof(PropertyRecord);
+  header.inputsOffset= header.sourcesOffset +
+      sources.size() * sizeof(StringRef);
+  header.environmentOffset= header.inputsOffset +
+      inputs.size() * sizeof(InputRecord);
+  header.stringsOffset= header.environmentOffset +
+      environmentRecords.size() * sizeof(EnvironmentRecord);
+  header.stringsSize= strings.size();
+  header.fileSize= roundUp(header.stringsOffset + strings.size());
+
+  std::string image;
+  image.reserve(header.fileSize);
+  image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  image.append(reinterpret_cast<const char*>(propertyRecords.data()),
+	       propertyRecords.size() * sizeof(PropertyRecord));
+  image.append(reinterpret_cast<const char*>(sources.data()),
+	       sources.size() * sizeof(StringRef));
+  image.append(reinterpret_cast<const char*>(inputs.data()),
+	       inputs.size() * sizeof(InputRecord));
+  image.append(reinterpret_cast<const char*>(environmentRecords.data()),
+	       environmentRecords.size() * sizeof(EnvironmentRecord));
+  image.append(strings);
+  image.resize(header.fileSize, '\0');
+
+  std::string tmpName= filename + ".XXXXXX";
+  int fd= ::mkstemp(&tmpName[0]);
+  if (fd < 0) {
+    throw ConfigurationSnapshotError(
+	filename, errnoMessage("Cannot create snapshot", errno)
+    );
+  }
+
+  const char* p= image.data();
+  const char* const end= image.data() + image.size();
+  while (p != end) {
+    ssize_t n= ::write(fd, p, end - p);
+    if ((n < 0) && (errno != EINTR)) {
+      int error= errno;
+      ::close(fd);
+      ::unlink(tmpName.c_str());
+      throw ConfigurationSnapshotError(
+	  filename, errnoMessage("Cannot write snapshot", error)
+      );
+    } else if (n > 0) {
+      p += n;
+    }
+  }
+
+  if ((::close(fd) < 0) || (::rename(tmpName.c_str(), filename.c_str()) < 0)) {
+    int error= errno;
+    ::unlink(tmpName.c_str());
+    throw ConfigurationSnapshotError(
+	filename, errnoMessage("Cannot write snapshot", error)
+    );
+  }
+}
+
+std::string ConfigurationSnapshot::fileNameFor(std::string_view key) {
+  static const char HEX[]= "0123456789abcdef";
+  uint64_t h= fnv1a(key.data(), key.data() + key.size());
+  std::string name(16, '0');
+  for (int i= 15; i >= 0; --i, h >>= 4) {
+    name[i]= HEX[h & 0xF];
+  }
+  return name + ".snapshot";
+}
+
+std::string_view ConfigurationSnapshot::string_(const StringRef& ref) const {
+  if ((ref.offset > header_->stringsSize) ||
+      (ref.length > header_->stringsSize - ref.offset)) {
+    throw ConfigurationSnapshotError(filename_,
+				     "Snapshot is truncated or corrupt");
+  }
+  return std::string_view(strings_ + ref.offset, ref.length);
+}
+
+ConfigurationSnapshot::Property ConfigurationSnapshot::property_(
+    const PropertyRecord& record
+) const {
+  if (record.source >= header_->numSources) {
+    throw ConfigurationSnapshotError(filename_,
+				     "Snapshot is truncated or corrupt");
+  }
+
+  Property p;
+  p.name= string_(record.name);
+  p.value= string_(record.value);
+  p.source= string_(sources_[record.source]);
+  p.line= record.line;
+  return p;
+}
+
+bool ConfigurationSnapshot::inputFilesFresh_() const {
+  for (size_t i= 0; i < numInputFiles(); ++i) {
+    const InputFile input= inputFile(i);
+    const std::string path(input.path);
+    FileStamp stamp;
+    uint64_t hash;
+    if (!FileStamp::read(path, stamp) || (stamp.size != input.stamp.size)) {
+      return false;
+    } else if ((stamp != input.stamp) &&
+	       (!hashFile(path, hash) || (hash != input.contentHash))) {
+      return false;
+    }
+  }
+  return true;
+}
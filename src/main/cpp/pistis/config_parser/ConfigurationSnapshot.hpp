@@ -0,0 +1,171 @@
+#ifndef __PISTIS__CONFIG_PARSER__CONFIGURATIONSNAPSHOT_HPP__
+#define __PISTIS__CONFIG_PARSER__CONFIGURATIONSNAPSHOT_HPP__
+
+#include <pistis/config_parser/ConfigurationPropertyMap.hpp>
+#include <pistis/config_parser/detail/FileStamp.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+      class MemoryMappedFile;
+    }
+
+    class EnvironmentSnapshot;
+
+    /** @brief Read-only view of a compiled configuration snapshot
+     *
+     *  A snapshot is a binary file holding the properties parsed from a
+     *  configuration file, after includes are merged and variables are
+     *  substituted.  It contains a string table, a table of property
+     *  records sorted by name (the key index), a table of property
+     *  sources, a table of the files the properties were parsed from,
+     *  with their stamps and a hash of their contents, and a table of
+     *  the environment variables substituted into the properties, with
+     *  the values they had.
+     *
+     *  Opening a snapshot maps the file into memory and checks its
+     *  header.  It does not examine or allocate anything per property,
+     *  and lookups read the mapped file directly.  Snapshots are
+     *  written in the byte order of the machine that writes them and
+     *  are rejected by machines with a different one.
+     */
+    class ConfigurationSnapshot {
+    public:
+      /** @brief A property in the snapshot
+       *
+       *  The strings refer to the mapped file and are valid until the
+       *  snapshot is destroyed.
+       */
+      struct Property {
+	std::string_view name;
+	std::string_view value;
+	std::string_view source;
+	int line;
+      };
+
+      /** @brief A file the snapshot was built from */
+      struct InputFile {
+	std::string_view path;
+	detail::FileStamp stamp;
+	uint64_t contentHash;
+      };
+
+      /** @brief An environment variable the snapshot's properties
+       *         substituted, and the value it had
+       */
+      struct EnvironmentVariable {
+	std::string_view name;
+	std::string_view value;
+      };
+
+    public:
+      /** @brief Map the snapshot in @c filename
+       *
+       *  Throws ConfigurationSnapshotError if the file cannot be mapped
+       *  or is not a snapshot this library can read.
+       */
+      explicit ConfigurationSnapshot(const std::string& filename);
+      ConfigurationSnapshot(const ConfigurationSnapshot&) = delete;
+      ~ConfigurationSnapshot();
+
+      const std::string& filename() const { return filename_; }
+
+      /** @brief Identifies what the snapshot was compiled from
+       *
+       *  Written by whoever created the snapshot.  ConfigFileParser
+       *  stores the configuration file's path and the parser settings
+       *  here.
+       */
+      std::string_view key() const;
+
+      /** @brief Number of properties */
+      size_t size() const;
+
+      /** @brief The @c i-th property, in order by name */
+      Property property(size_t i) const;
+
+      /** @brief Property named @c name, if there is one */
+      std::optional<Property> find(std::string_view name) const;
+
+      size_t numInputFiles() const;
+      InputFile inputFile(size_t i) const;
+
+      size_t numEnvironmentVariables() const;
+      EnvironmentVariable environmentVariable(size_t i) const;
+
+      /** @brief True if no input file has changed since the snapshot
+       *         was written, and every environment variable it
+       *         substituted has the same value in @c environment
+       *
+       *  Files whose stamps are unchanged are not read.  Files that
+       *  were touched or replaced are compared by their contents.
+       */
+      bool isFresh(const EnvironmentSnapshot& environment) const;
+
+      /** @brief As isFresh(environment), with the variables looked up
+       *         in the environment of this process
+       */
+      bool isFresh() const;
+
+      ConfigurationPropertyMap toPropertyMap() const;
+
+      /** @brief Write a snapshot of @c properties to @c filename
+       *
+       *  @c inputFiles lists the files @c properties were parsed from,
+       *  stamped before they were parsed, and @c environment lists the
+       *  (name, value) pairs of the environment variables substituted
+       *  into them.  Throws
+       *  ConfigurationSnapshotError if an input file changed since it
+       *  was stamped or the snapshot cannot be written.  The snapshot
+       *  is written to a temporary file that replaces @c filename once
+       *  it is complete, so readers never see a partial snapshot.
+       */
+      static void write(
+	  const std::string& filename, std::string_view key,
+	  const ConfigurationPropertyMap& properties,
+	  const std::vector< std::pair<std::string, detail::FileStamp> >&
+	      inputFiles,
+	  const std::vector< std::pair<std::string, std::string> >&
+	      environment=
+		  std::vector< std::pair<std::string, std::string> >()
+      );
+
+      /** @brief Name for the snapshot file of @c key, without a
+       *         directory
+       */
+      static std::string fileNameFor(std::string_view key);
+
+      ConfigurationSnapshot& operator=(const ConfigurationSnapshot&) = delete;
+
+    private:
+      struct StringRef;
+      struct Header;
+      struct PropertyRecord;
+      struct InputRecord;
+      struct EnvironmentRecord;
+
+      std::string filename_;
+      std::unique_ptr<detail::MemoryMappedFile> file_;
+      const Header* header_;
+      const PropertyRecord* properties_;
+      const StringRef* sources_;
+      const InputRecord* inputs_;
+      const EnvironmentRecord* environment_;
+      const char* strings_;
+
+      std::string_view string_(const StringRef& ref) const;
+      Property property_(const PropertyRecord& record) const;
+      bool inputFilesFresh_() const;
+    };
+
+  }
+}
+#endif
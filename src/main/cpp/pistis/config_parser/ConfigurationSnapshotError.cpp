@@ -0,0 +1,14 @@
+#include "ConfigurationSnapshotError.hpp"
+
+using namespace pistis::config_parser;
+
+ConfigurationSnapshotError::ConfigurationSnapshotError(
+    const std::string& snapshotFile, const std::string& description
+):
+    ApplicationConfigurationError(snapshotFile, 0, 0, description) {
+  // Intentionally left blank
+}
+
+ConfigurationSnapshotError::~ConfigurationSnapshotError() noexcept {
+  // Intentionally left blank
+}
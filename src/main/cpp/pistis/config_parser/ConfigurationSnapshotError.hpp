@@ -0,0 +1,20 @@
+#ifndef __PISTIS__CONFIG_PARSER__CONFIGURATIONSNAPSHOTERROR_HPP__
+#define __PISTIS__CONFIG_PARSER__CONFIGURATIONSNAPSHOTERROR_HPP__
+
+#include <pistis/config_parser/ApplicationConfigurationError.hpp>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief A configuration snapshot could not be read or written */
+    class ConfigurationSnapshotError : public ApplicationConfigurationError {
+    public:
+      ConfigurationSnapshotError(const std::string& snapshotFile,
+				 const std::string& description);
+      virtual ~ConfigurationSnapshotError() noexcept;
+    };
+
+  }
+}
+#endif
+
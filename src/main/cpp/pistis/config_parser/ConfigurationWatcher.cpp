@@ -0,0 +1,197 @@
+#include "ConfigurationWatcher.hpp"
+#include "ConfigurationWatcherError.hpp"
+#include <pistis/filesystem/Path.hpp>
+#include <sstream>
+#include <tuple>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser;
+
+namespace path = pistis::filesystem::path;
+
+namespace {
+  // Events on a watched file's directory that may change the file the
+  // name refers to
+  const uint32_t DIRECTORY_EVENTS=
+      IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY |
+      IN_CLOSE_WRITE | IN_ATTRIB | IN_ONLYDIR;
+
+  // Events on the watched file itself, which follow it wherever its
+  // name points, such as through a symbolic link
+  const uint32_t FILE_EVENTS=
+      IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+
+  std::string systemError(const std::string& what, int error) {
+    std::ostringstream msg;
+    msg << what << " (" << strerror(error) << ")";
+    return msg.str();
+  }
+}
+
+ConfigurationWatcher::ConfigurationWatcher(
+    const std::vector<std::string>& files, ReloadFn reload,
+    std::chrono::milliseconds delay
+):
+    reload_(std::move(reload)), delay_(delay), mutex_(), files_(files),
+    directoryWatches_(), fileWatches_(), inotifyFd_(-1), stopFd_(-1),
+    reloads_(0), failedReloads_(0), thread_() {
+  const std::string name= files.empty() ? std::string() : files.front();
+  inotifyFd_= ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFd_ < 0) {
+    throw ConfigurationWatcherError(
+	name, systemError("Cannot initialize inotify", errno)
+    );
+  }
+  stopFd_= ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (stopFd_ < 0) {
+    const int error= errno;
+    ::close(inotifyFd_);
+    throw ConfigurationWatcherError(
+	name, systemError("Cannot create event descriptor", error)
+    );
+  }
+
+  watch_();
+  thread_= std::thread([this]() { run_(); });
+}
+
+ConfigurationWatcher::~ConfigurationWatcher() {
+  stop();
+  ::close(stopFd_);
+  ::close(inotifyFd_);
+}
+
+std::vector<std::string> ConfigurationWatcher::files() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return files_;
+}
+
+void ConfigurationWatcher::stop() {
+  if (thread_.joinable()) {
+    const uint64_t one= 1;
+    // Cannot fail short of the counter overflowing
+    (void)::write(stopFd_, &one, sizeof(one));
+    thread_.join();
+  }
+}
+
+void ConfigurationWatcher::watch_() {
+  // Adding a watch for a path that is already watched returns its
+  // existing descriptor, so events queued for it while the files were
+  // being reloaded still match.  A file renamed over a watched one is a
+  // different file, and gets a new descriptor.
+  std::map< int, std::set<std::string> > directoryWatches;
+  std::set<int> fileWatches;
+  const std::vector<std::string> watched= files();
+  for (auto i= watched.begin(); i != watched.end(); ++i) {
+    std::string directory;
+    std::string name;
+    std::tie(directory, name)= path::splitFile(*i);
+    if (directory.empty()) {
+      directory= path::isAbsolute(*i) ? "/" : ".";
+    }
+
+    // A file or directory that cannot be watched is skipped.  The
+    // reload it will take to fix it must be triggered by another file.
+    const int directoryWd=
+	::inotify_add_watch(inotifyFd_, directory.c_str(), DIRECTORY_EVENTS);
+    if (directoryWd >= 0) {
+      directoryWatches[directoryWd].insert(name);
+    }
+    const int fileWd= ::inotify_add_watch(inotifyFd_, i->c_str(), FILE_EVENTS);
+    if (fileWd >= 0) {
+      fileWatches.insert(fileWd);
+    }
+  }
+
+  for (auto i= directoryWatches_.begin(); i != directoryWatches_.end();
+       ++i) {
+    if (!directoryWatches.count(i->first) && !fileWatches.count(i->first)) {
+      ::inotify_rm_watch(inotifyFd_, i->first);
+    }
+  }
+  for (auto i= fileWatches_.begin(); i != fileWatches_.end(); ++i) {
+    if (!directoryWatches.count(*i) && !fileWatches.count(*i)) {
+      ::inotify_rm_watch(inotifyFd_, *i);
+    }
+  }
+  directoryWatches_.swap(directoryWatches);
+  fileWatches_.swap(fileWatches);
+}
+
+bool ConfigurationWatcher::isWatched_(int wd, const char* name) const {
+  if (fileWatches_.count(wd)) {
+    return true;
+  }
+  auto i= directoryWatches_.find(wd);
+  return (i != directoryWatches_.end()) && name && i->second.count(name);
+}
+
+void ConfigurationWatcher::run_() {
+  typedef std::chrono::steady_clock Clock;
+  alignas(struct inotify_event) char buffer[16384];
+  bool pending= false;
+  Clock::time_point deadline;
+
+  while (true) {
+    int timeout= -1;
+    if (pending) {
+      const auto remaining= std::chrono::duration_cast<
+	  std::chrono::milliseconds>(deadline - Clock::now());
+      timeout= (remaining.count() > 0) ? (int)remaining.count() + 1 : 0;
+    }
+
+    struct pollfd fds[2]= { { stopFd_, POLLIN, 0 },
+			    { inotifyFd_, POLLIN, 0 } };
+    if (::poll(fds, 2, timeout) < 0) {
+      if (errno == EINTR) {
+	continue;
+      }
+      break;
+    }
+    if (fds[0].revents) {
+      break;
+    }
+
+    if (fds[1].revents & POLLIN) {
+      ssize_t n;
+      while ((n= ::read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+	const char* p= buffer;
+	while (p < buffer + n) {
+	  const struct inotify_event* event=
+	      reinterpret_cast<const struct inotify_event*>(p);
+	  if ((event->mask & IN_Q_OVERFLOW) ||
+	      isWatched_(event->wd, event->len ? event->name : nullptr)) {
+	    // Each change pushes the reload back, so a burst of changes
+	    // reloads once, after the last of them
+	    pending= true;
+	    deadline= Clock::now() + delay_;
+	  }
+	  p += sizeof(struct inotify_event) + event->len;
+	}
+      }
+    }
+
+    if (pending && (Clock::now() >= deadline)) {
+      pending= false;
+      try {
+	std::vector<std::string> files= reload_();
+	{
+	  std::unique_lock<std::mutex> lock(mutex_);
+	  files_= std::move(files);
+	}
+	++reloads_;
+      } catch(...) {
+	++failedReloads_;
+      }
+
+      // Even when the reload fails, the files may have been replaced
+      watch_();
+    }
+  }
+}
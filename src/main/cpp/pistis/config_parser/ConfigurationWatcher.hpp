@@ -0,0 +1,122 @@
+#ifndef __PISTIS__CONFIG_PARSER__CONFIGURATIONWATCHER_HPP__
+#define __PISTIS__CONFIG_PARSER__CONFIGURATIONWATCHER_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief Calls a function to reload a configuration whenever one of
+     *         the files it was read from changes
+     *
+     *  The watcher uses inotify, so it costs nothing while the files
+     *  are unchanged.  It watches each file and the directory that
+     *  holds it, which catches editors that write a temporary file and
+     *  rename it over the original as well as writes in place.  Changes
+     *  that arrive in a burst are coalesced: the reload function runs
+     *  once, on the watcher's own thread, after no change has been seen
+     *  for delay() milliseconds.
+     *
+     *  The reload function returns the files the new configuration was
+     *  read from, and the watcher watches those from then on, so files
+     *  that become included or stop being included are followed.
+     *  ConfigFileParser::inputFiles() and
+     *  ApplicationConfiguration::inputFiles() list them.  For example:
+     *  <code>
+     *    ReloadableConfiguration<MyConfiguration> config;
+     *    config.reload("app.cfg");
+     *    ConfigurationWatcher watcher(
+     *        config.current()->inputFiles(),
+     *        [&config]() {
+     *          config.reload("app.cfg");
+     *          return config.current()->inputFiles();
+     *        }
+     *    );
+     *  </code>
+     *  If the reload function throws, the watcher keeps watching the
+     *  files it watched before and counts the failure.
+     *
+     *  The watcher is only available on Linux.
+     */
+    class ConfigurationWatcher {
+    public:
+      typedef std::function<std::vector<std::string> ()> ReloadFn;
+
+    public:
+      /** @brief Start watching @c files, calling @c reload after they
+       *         change
+       *
+       *  Throws ConfigurationWatcherError if inotify cannot be set up.
+       *  Files that do not exist are watched for their creation.
+       */
+      ConfigurationWatcher(
+	  const std::vector<std::string>& files, ReloadFn reload,
+	  std::chrono::milliseconds delay= std::chrono::milliseconds(100)
+      );
+      ConfigurationWatcher(const ConfigurationWatcher&) = delete;
+      ~ConfigurationWatcher();
+
+      /** @brief Time without changes to wait for before reloading */
+      std::chrono::milliseconds delay() const { return delay_; }
+
+      /** @brief The files being watched */
+      std::vector<std::string> files() const;
+
+      /** @brief Number of times the reload function has returned */
+      uint64_t reloads() const { return reloads_.load(); }
+
+      /** @brief Number of times the reload function has thrown */
+      uint64_t failedReloads() const { return failedReloads_.load(); }
+
+      /** @brief Stop watching and wait for the watcher's thread to
+       *         finish, including any reload in progress
+       *
+       *  Must not be called from the reload function.
+       */
+      void stop();
+
+      ConfigurationWatcher& operator=(const ConfigurationWatcher&) = delete;
+
+    private:
+      /** @brief Replace the current watches with watches on files_ */
+      void watch_();
+
+      /** @brief True if the inotify event for @c wd and @c name is a
+       *         change to a watched file
+       */
+      bool isWatched_(int wd, const char* name) const;
+
+      void run_();
+
+      ReloadFn reload_;
+      std::chrono::milliseconds delay_;
+
+      /** @brief Guards files_ */
+      mutable std::mutex mutex_;
+      std::vector<std::string> files_;
+
+      /** @brief Watched directories, with the names of the watched
+       *         files in each
+       */
+      std::map< int, std::set<std::string> > directoryWatches_;
+      std::set<int> fileWatches_;
+
+      int inotifyFd_;
+      int stopFd_;
+      std::atomic<uint64_t> reloads_;
+      std::atomic<uint64_t> failedReloads_;
+      std::thread thread_;
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,14 @@
+#include "ConfigurationWatcherError.hpp"
+
+using namespace pistis::config_parser;
+
+ConfigurationWatcherError::ConfigurationWatcherError(
+    const std::string& filename, const std::string& description
+):
+    ApplicationConfigurationError(filename, 0, 0, description) {
+  // Intentionally left blank
+}
+
+ConfigurationWatcherError::~ConfigurationWatcherError() noexcept {
+  // Intentionally left blank
+}
@@ -0,0 +1,20 @@
+#ifndef __PISTIS__CONFIG_PARSER__CONFIGURATIONWATCHERERROR_HPP__
+#define __PISTIS__CONFIG_PARSER__CONFIGURATIONWATCHERERROR_HPP__
+
+#include <pistis/config_parser/ApplicationConfigurationError.hpp>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief A ConfigurationWatcher could not be started */
+    class ConfigurationWatcherError : public ApplicationConfigurationError {
+    public:
+      ConfigurationWatcherError(const std::string& filename,
+				const std::string& description);
+      virtual ~ConfigurationWatcherError() noexcept;
+    };
+
+  }
+}
+#endif
+
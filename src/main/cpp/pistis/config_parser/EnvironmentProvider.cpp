@@ -0,0 +1,40 @@
+#include "EnvironmentProvider.hpp"
+#include <utility>
+
+using namespace pistis::config_parser;
+
+EnvironmentProvider::EnvironmentProvider() {
+  // Intentionally left blank
+}
+
+EnvironmentProvider::~EnvironmentProvider() {
+  // Intentionally left blank
+}
+
+std::shared_ptr<const EnvironmentSnapshot>
+    EnvironmentProvider::snapshot() const {
+  return EnvironmentSnapshot::ofProcess();
+}
+
+const std::shared_ptr<EnvironmentProvider>& EnvironmentProvider::process() {
+  static const std::shared_ptr<EnvironmentProvider> PROVIDER=
+      std::make_shared<EnvironmentProvider>();
+  return PROVIDER;
+}
+
+FixedEnvironmentProvider::FixedEnvironmentProvider(
+    std::shared_ptr<const EnvironmentSnapshot> environment
+):
+    environment_(environment ? std::move(environment)
+		             : std::make_shared<const EnvironmentSnapshot>()) {
+  // Intentionally left blank
+}
+
+FixedEnvironmentProvider::~FixedEnvironmentProvider() {
+  // Intentionally left blank
+}
+
+std::shared_ptr<const EnvironmentSnapshot>
+    FixedEnvironmentProvider::snapshot() const {
+  return environment_;
+}
@@ -0,0 +1,53 @@
+#ifndef __PISTIS__CONFIG_PARSER__ENVIRONMENTPROVIDER_HPP__
+#define __PISTIS__CONFIG_PARSER__ENVIRONMENTPROVIDER_HPP__
+
+#include <pistis/config_parser/EnvironmentSnapshot.hpp>
+#include <memory>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief Supplies the environment variables that ${name} references
+     *         resolve to
+     *
+     *  A ConfigFileParser asks its provider for a snapshot the first time
+     *  a parse refers to a variable, and resolves the rest of the parse,
+     *  included files too, from that snapshot.  The default provider
+     *  snapshots the environment of the process.  Give a parser a
+     *  FixedEnvironmentProvider to parse against a known environment,
+     *  such as in a test.
+     */
+    class EnvironmentProvider {
+    public:
+      EnvironmentProvider();
+      virtual ~EnvironmentProvider();
+
+      /** @brief The environment a parse starting now should see
+       *
+       *  May be called from any thread.  Must not return null.
+       */
+      virtual std::shared_ptr<const EnvironmentSnapshot> snapshot() const;
+
+      /** @brief A provider for the environment of the process, shared by
+       *         every parser that is not given another one
+       */
+      static const std::shared_ptr<EnvironmentProvider>& process();
+    };
+
+    /** @brief Supplies the same snapshot to every parse */
+    class FixedEnvironmentProvider : public EnvironmentProvider {
+    public:
+      FixedEnvironmentProvider(
+	  std::shared_ptr<const EnvironmentSnapshot> environment
+      );
+      virtual ~FixedEnvironmentProvider();
+
+      virtual std::shared_ptr<const EnvironmentSnapshot> snapshot() const;
+
+    private:
+      std::shared_ptr<const EnvironmentSnapshot> environment_;
+    };
+
+  }
+}
+#endif
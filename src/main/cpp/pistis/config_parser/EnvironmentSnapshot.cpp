@@ -0,0 +1,58 @@
+#include "EnvironmentSnapshot.hpp"
+#include <string.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser;
+
+EnvironmentSnapshot::EnvironmentSnapshot():
+    variables_(), index_() {
+  // Intentionally left blank
+}
+
+EnvironmentSnapshot::EnvironmentSnapshot(
+    std::initializer_list< std::pair<std::string, std::string> > variables
+):
+    variables_(), index_() {
+  index_.reserve(variables.size());
+  for (auto i= variables.begin(); i != variables.end(); ++i) {
+    set(i->first, i->second);
+  }
+}
+
+EnvironmentSnapshot::~EnvironmentSnapshot() {
+  // Intentionally left blank
+}
+
+void EnvironmentSnapshot::set(std::string_view name, std::string_view value) {
+  auto i= index_.find(name);
+  if (i != index_.end()) {
+    i->second->assign(value.data(), value.size());
+  } else {
+    variables_.emplace_back(std::string(name), std::string(value));
+    std::pair<std::string, std::string>& v= variables_.back();
+    index_.emplace(std::string_view(v.first), &v.second);
+  }
+}
+
+std::shared_ptr<const EnvironmentSnapshot> EnvironmentSnapshot::ofProcess() {
+  std::shared_ptr<EnvironmentSnapshot> snapshot=
+      std::make_shared<EnvironmentSnapshot>();
+  size_t n= 0;
+  for (char** p= environ; p && *p; ++p) {
+    ++n;
+  }
+  snapshot->index_.reserve(n);
+
+  // getenv() returns the first definition of a name, so later ones are
+  // skipped rather than replacing it
+  for (char** p= environ; p && *p; ++p) {
+    const char* eq= ::strchr(*p, '=');
+    if (eq) {
+      std::string_view name(*p, eq - *p);
+      if (!snapshot->find(name)) {
+	snapshot->set(name, std::string_view(eq + 1));
+      }
+    }
+  }
+  return snapshot;
+}
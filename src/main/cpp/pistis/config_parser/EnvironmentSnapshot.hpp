@@ -0,0 +1,76 @@
+#ifndef __PISTIS__CONFIG_PARSER__ENVIRONMENTSNAPSHOT_HPP__
+#define __PISTIS__CONFIG_PARSER__ENVIRONMENTSNAPSHOT_HPP__
+
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <stddef.h>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief Environment variables as they were at one moment, hashed
+     *         by name
+     *
+     *  A snapshot never changes once it is shared, so any number of
+     *  threads may look variables up in it while others call setenv().
+     *  Looking a variable up hashes its name, where getenv() compares
+     *  it against every variable in the environment.
+     */
+    class EnvironmentSnapshot {
+    public:
+      /** @brief A snapshot with no variables */
+      EnvironmentSnapshot();
+
+      /** @brief A snapshot of @c variables, given as (name, value)
+       *         pairs
+       */
+      EnvironmentSnapshot(
+	  std::initializer_list< std::pair<std::string, std::string> >
+	      variables
+      );
+
+      EnvironmentSnapshot(const EnvironmentSnapshot&) = delete;
+      ~EnvironmentSnapshot();
+
+      /** @brief Number of variables in the snapshot */
+      size_t size() const { return variables_.size(); }
+      bool empty() const { return variables_.empty(); }
+
+      /** @brief The value of the variable @c name, or null if the
+       *         snapshot has no such variable
+       */
+      const std::string* find(std::string_view name) const {
+	auto i= index_.find(name);
+	return (i != index_.end()) ? i->second : nullptr;
+      }
+
+      /** @brief Set the variable @c name to @c value, adding it if the
+       *         snapshot does not have it
+       */
+      void set(std::string_view name, std::string_view value);
+
+      /** @brief Snapshot the environment of this process
+       *
+       *  Copying the environment is no safer against a concurrent
+       *  setenv() than getenv() is, but it happens once instead of once
+       *  per lookup.
+       */
+      static std::shared_ptr<const EnvironmentSnapshot> ofProcess();
+
+      EnvironmentSnapshot& operator=(const EnvironmentSnapshot&) = delete;
+
+    private:
+      // The index refers to the names in variables_, which stay put
+      // as a deque grows
+      std::deque< std::pair<std::string, std::string> > variables_;
+      std::unordered_map<std::string_view, std::string*> index_;
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,143 @@
+#include "FlatConfigurationPropertyMap.hpp"
+#include <pistis/exceptions/NoSuchItem.hpp>
+
+using namespace pistis::exceptions;
+using namespace pistis::config_parser;
+
+FlatConfigurationPropertyMap::FlatConfigurationPropertyMap():
+    keys_(), properties_(), index_() {
+  // Intentionally left blank
+}
+
+FlatConfigurationPropertyMap::FlatConfigurationPropertyMap(
+    const ConfigurationPropertyMap& properties
+):
+    keys_(), properties_(properties.begin(), properties.end()), index_() {
+  buildKeys_();
+  buildIndex_();
+}
+
+FlatConfigurationPropertyMap::FlatConfigurationPropertyMap(
+    ConfigurationPropertyMap&& properties
+):
+    keys_(), properties_(), index_() {
+  // Nodes come out of the map in sorted order
+  properties_.reserve(properties.size());
+  while (!properties.properties_.empty()) {
+    auto node= properties.properties_.extract(properties.properties_.begin());
+    properties_.push_back(std::move(node.mapped()));
+  }
+  buildKeys_();
+  buildIndex_();
+}
+
+FlatConfigurationPropertyMap::FlatConfigurationPropertyMap(
+    const FlatConfigurationPropertyMap& other
+):
+    keys_(), properties_(other.properties_), index_(other.index_) {
+  buildKeys_();
+}
+
+FlatConfigurationPropertyMap::FlatConfigurationPropertyMap(
+    FlatConfigurationPropertyMap&& other
+):
+    keys_(std::move(other.keys_)), properties_(std::move(other.properties_)),
+    index_(std::move(other.index_)) {
+  other.keys_.clear();
+  other.properties_.clear();
+  other.index_.clear();
+}
+
+FlatConfigurationPropertyMap::~FlatConfigurationPropertyMap() {
+  // Intentionally left blank
+}
+
+std::vector<ConfigurationProperty>
+    FlatConfigurationPropertyMap::getPropertiesWithPrefix(
+	std::string_view prefix
+    ) const {
+  const PropertyRange<PropertyIterator> range= propertiesWithPrefix(prefix);
+  return std::vector<ConfigurationProperty>(range.begin(), range.end());
+}
+
+PropertyRange<FlatConfigurationPropertyMap::PropertyIterator>
+    FlatConfigurationPropertyMap::propertiesWithPrefix(
+	std::string_view prefix
+    ) const {
+  if (!prefix.empty() && (prefix.back() == '.')) {
+    return propertiesUnder(prefix.substr(0, prefix.size() - 1));
+  }
+
+  // Names that begin with prefix are contiguous, so binary search for the
+  // first one that does not
+  size_t first= lowerBound_(prefix);
+  size_t last= first;
+  size_t n= size() - first;
+  while (n) {
+    const size_t half= n / 2;
+    if (key_(last + half).substr(0, prefix.size()) == prefix) {
+      last += half + 1;
+      n -= half + 1;
+    } else {
+      n= half;
+    }
+  }
+  return PropertyRange<PropertyIterator>(properties_.begin() + first,
+					 properties_.begin() + last);
+}
+
+FlatConfigurationPropertyMap& FlatConfigurationPropertyMap::operator=(
+    const FlatConfigurationPropertyMap& other
+) {
+  if (this != &other) {
+    properties_= other.properties_;
+    index_= other.index_;
+    keys_.clear();
+    buildKeys_();
+  }
+  return *this;
+}
+
+FlatConfigurationPropertyMap& FlatConfigurationPropertyMap::operator=(
+    FlatConfigurationPropertyMap&& other
+) {
+  if (this != &other) {
+    keys_= std::move(other.keys_);
+    properties_= std::move(other.properties_);
+    index_= std::move(other.index_);
+    other.keys_.clear();
+    other.properties_.clear();
+    other.index_.clear();
+  }
+  return *this;
+}
+
+const ConfigurationProperty& FlatConfigurationPropertyMap::operator[](
+    std::string_view key
+) const {
+  const ConfigurationProperty* p= find(key);
+  if (!p) {
+    throw NoSuchItem("Property with name \"" + std::string(key) + "\"",
+		     PISTIS_EX_HERE);
+  }
+  return *p;
+}
+
+void FlatConfigurationPropertyMap::buildKeys_() {
+  keys_.reserve(properties_.size());
+  for (auto i= properties_.begin(); i != properties_.end(); ++i) {
+    keys_.push_back(i->name());
+  }
+}
+
+void FlatConfigurationPropertyMap::buildIndex_() {
+  size_t numNodes= 0;
+  for (size_t i= 0; i < properties_.size(); ++i) {
+    numNodes+= detail::SegmentTrie::nodesAdded(i ? key_(i - 1) : "",
+					       key_(i));
+  }
+  index_.reserve(numNodes);
+  for (size_t i= 0; i < properties_.size(); ++i) {
+    index_.insert(properties_[i].name(), i);
+  }
+}
@@ -0,0 +1,261 @@
+#ifndef __PISTIS__CONFIG_PARSER__FLATCONFIGURATIONPROPERTYMAP_HPP__
+#define __PISTIS__CONFIG_PARSER__FLATCONFIGURATIONPROPERTYMAP_HPP__
+
+#include <pistis/config_parser/ConfigurationProperty.hpp>
+#include <pistis/config_parser/ConfigurationPropertyMap.hpp>
+#include <pistis/config_parser/PropertyRange.hpp>
+#include <pistis/config_parser/detail/SegmentTrie.hpp>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief Read-only map of configuration properties stored in sorted
+     *         arrays
+     *
+     *  A FlatConfigurationPropertyMap is built from a finished
+     *  ConfigurationPropertyMap and offers the same lookup and iteration
+     *  methods.  The properties are stored in one array, sorted by
+     *  name, which makes prefix scans sequential.  Lookups binary search
+     *  a parallel array of views of the properties' names, so each name
+     *  is stored once and searches touch far less memory than a walk
+     *  down a tree.  A detail::SegmentTrie over the names locates the
+     *  properties in a block without searching.
+     */
+    class FlatConfigurationPropertyMap {
+    public:
+      typedef std::vector<ConfigurationProperty>::const_iterator
+	  PropertyIterator;
+
+      class NameIterator {
+      public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef std::string value_type;
+	typedef ptrdiff_t difference_type;
+	typedef const std::string& reference;
+	typedef const std::string* pointer;
+
+      public:
+	NameIterator(): p_() { }
+
+	const std::string& operator*() const { return p_->name(); }
+	const std::string* operator->() const { return &(p_->name()); }
+
+	bool operator==(const NameIterator& other) const {
+	  return p_ == other.p_;
+	}
+	bool operator!=(const NameIterator& other) const {
+	  return p_ != other.p_;
+	}
+	NameIterator& operator++() {
+	  ++p_;
+	  return *this;
+	}
+	NameIterator operator++(int) {
+	  NameIterator tmp(*this);
+	  ++p_;
+	  return tmp;
+	}
+
+      private:
+	NameIterator(const PropertyIterator& p): p_(p) { }
+
+	PropertyIterator p_;
+
+	friend class FlatConfigurationPropertyMap;
+      };
+
+    public:
+      FlatConfigurationPropertyMap();
+      explicit FlatConfigurationPropertyMap(
+	  const ConfigurationPropertyMap& properties
+      );
+
+      /** @brief Build the map from @c properties, moving the properties
+       *         out of it.
+       *
+       *  @c properties is empty afterwards.
+       */
+      explicit FlatConfigurationPropertyMap(
+	  ConfigurationPropertyMap&& properties
+      );
+      FlatConfigurationPropertyMap(const FlatConfigurationPropertyMap& other);
+      FlatConfigurationPropertyMap(FlatConfigurationPropertyMap&& other);
+      ~FlatConfigurationPropertyMap();
+
+      bool empty() const { return properties_.empty(); }
+      size_t size() const { return properties_.size(); }
+
+      PropertyIterator begin() const { return properties_.begin(); }
+      PropertyIterator end() const { return properties_.end(); }
+      NameIterator beginNames() const {
+	return NameIterator(properties_.begin());
+      }
+      NameIterator endNames() const {
+	return NameIterator(properties_.end());
+      }
+
+      /** @brief Returns the property named @c key, or null if there is
+       *         no such property
+       */
+      const ConfigurationProperty* find(std::string_view key) const {
+	const size_t i= lowerBound_(key);
+	return ((i < size()) && (key_(i) == key)) ? &properties_[i] : nullptr;
+      }
+
+      bool hasKey(std::string_view key) const {
+	return find(key) != nullptr;
+      }
+
+      const std::string& getValue(std::string_view key,
+				  const std::string& dv) const {
+	const ConfigurationProperty* p= find(key);
+	return p ? p->value() : dv;
+      }
+
+      int getValueAsInt(std::string_view key, int dv) const {
+	const ConfigurationProperty* p= find(key);
+	return p ? p->valueAsInt() : dv;
+      }
+
+      double getValueAsDouble(std::string_view key, double dv) const {
+	const ConfigurationProperty* p= find(key);
+	return p ? p->valueAsDouble() : dv;
+      }
+
+      template <typename Fn>
+      auto getValue(
+	  std::string_view key,
+	  const decltype((*(Fn*)0)(*(std::string*)0))& dv,
+	  const Fn& format
+      ) const -> decltype(format(*(std::string*)0)) {
+	const ConfigurationProperty* p= find(key);
+	return p ? p->valueAs(format) : dv;
+      }
+
+      /** @brief Returns a view of the properties whose names satisfy
+       *         @c f, without copying them
+       *
+       *  @c f is called with a property's name when the view is
+       *  traversed, not when it is created.
+       */
+      template <typename Fn>
+      FilteredPropertyRange<PropertyIterator, Fn> propertiesMatching(
+	  const Fn& f
+      ) const {
+	return FilteredPropertyRange<PropertyIterator, Fn>(begin(), end(), f);
+      }
+
+      template <typename Fn, typename OutFn>
+      void getPropertiesMatching(const Fn& f, const OutFn& output) const {
+	for (auto i= properties_.begin(); i != properties_.end(); ++i) {
+	  if (f(i->name())) {
+	    output(*i);
+	  }
+	}
+      }
+
+      template <typename Fn>
+      std::vector<ConfigurationProperty> getPropertiesMatching(
+	  const Fn& f
+      ) const {
+	std::vector<ConfigurationProperty> result;
+	getPropertiesMatching(f, [&result](const ConfigurationProperty& p) {
+	  result.push_back(p);
+	});
+	return result;
+      }
+
+      /** @brief Returns the properties whose names begin with
+       *         blockName + ".", i.e. the properties defined in block
+       *         @c blockName and the blocks nested inside it.
+       *
+       *  The view refers to this map's storage and is valid until the
+       *  map is modified or destroyed.
+       */
+      PropertyRange<PropertyIterator> propertiesUnder(
+	  std::string_view blockName
+      ) const {
+	const std::pair<size_t, size_t> range= index_.rangeUnder(blockName);
+	return PropertyRange<PropertyIterator>(
+	    properties_.begin() + range.first,
+	    properties_.begin() + range.second
+	);
+      }
+
+      /** @brief Returns a view of the properties whose names begin with
+       *         @c prefix, without copying them
+       *
+       *  The view refers to this map's storage and is valid until the
+       *  map is modified or destroyed.
+       */
+      PropertyRange<PropertyIterator> propertiesWithPrefix(
+	  std::string_view prefix
+      ) const;
+
+      template <typename OutFn>
+      void getPropertiesWithPrefix(std::string_view prefix,
+				   const OutFn& output) const {
+	for (const ConfigurationProperty& p : propertiesWithPrefix(prefix)) {
+	  output(p);
+	}
+      }
+
+      std::vector<ConfigurationProperty> getPropertiesWithPrefix(
+	  std::string_view prefix
+      ) const;
+
+      FlatConfigurationPropertyMap& operator=(
+	  const FlatConfigurationPropertyMap& other
+      );
+      FlatConfigurationPropertyMap& operator=(
+	  FlatConfigurationPropertyMap&& other
+      );
+      const ConfigurationProperty& operator[](std::string_view key) const;
+
+    protected:
+      /** @brief Name of the i-th property, read through the key array */
+      std::string_view key_(size_t i) const { return keys_[i]; }
+
+      /** @brief Index of the first property whose name is not less than
+       *         @c key, or size() if there is none
+       */
+      size_t lowerBound_(std::string_view key) const {
+	size_t first= 0;
+	size_t n= size();
+	while (n) {
+	  const size_t half= n / 2;
+	  if (key_(first + half) < key) {
+	    first += half + 1;
+	    n -= half + 1;
+	  } else {
+	    n= half;
+	  }
+	}
+	return first;
+      }
+
+    private:
+      void buildKeys_();
+      void buildIndex_();
+
+      /** @brief Views of the names of the properties in properties_
+       *
+       *  Moving properties_ keeps its elements in place, so the views
+       *  stay valid, but a copy must view its own properties.
+       */
+      std::vector<std::string_view> keys_;
+
+      /** @brief Properties in the sorted order of their names */
+      std::vector<ConfigurationProperty> properties_;
+
+      /** @brief Maps each name to its index in properties_ */
+      detail::SegmentTrie index_;
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,73 @@
+#include "IncludeFileCache.hpp"
+
+using namespace pistis::config_parser;
+
+namespace {
+  bool isCurrent(const IncludeFileCache::Entry& entry) {
+    detail::FileStamp stamp;
+    for (auto i= entry.files.begin(); i != entry.files.end(); ++i) {
+      if (!detail::FileStamp::read(i->first, stamp) ||
+	  (stamp != i->second)) {
+	return false;
+      }
+    }
+    return true;
+  }
+}
+
+IncludeFileCache::IncludeFileCache():
+    mutex_(), entries_(), hits_(0), misses_(0) {
+  // Intentionally left blank
+}
+
+IncludeFileCache::~IncludeFileCache() {
+  // Intentionally left blank
+}
+
+size_t IncludeFileCache::size() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void IncludeFileCache::clear() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+std::shared_ptr<const IncludeFileCache::Entry> IncludeFileCache::find(
+    const std::string& key,
+    const std::function<bool (const Entry&)>& usable
+) {
+  std::shared_ptr<const Entry> entry;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto i= entries_.find(key);
+    if (i != entries_.end()) {
+      entry= i->second;
+    }
+  }
+
+  // Check the files without holding the lock, since that means a stat()
+  // call for each of them
+  if (entry && !isCurrent(*entry)) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto i= entries_.find(key);
+    if ((i != entries_.end()) && (i->second == entry)) {
+      entries_.erase(i);
+    }
+    entry.reset();
+  }
+
+  if (entry && usable(*entry)) {
+    ++hits_;
+    return entry;
+  }
+  ++misses_;
+  return std::shared_ptr<const Entry>();
+}
+
+void IncludeFileCache::insert(const std::string& key,
+			      std::shared_ptr<const Entry> entry) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  entries_[key]= std::move(entry);
+}
@@ -0,0 +1,107 @@
+#ifndef __PISTIS__CONFIG_PARSER__INCLUDEFILECACHE_HPP__
+#define __PISTIS__CONFIG_PARSER__INCLUDEFILECACHE_HPP__
+
+#include <pistis/config_parser/ConfigurationPropertyMap.hpp>
+#include <pistis/config_parser/detail/FileStamp.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief Properties parsed from included files, for reuse by later
+     *         include directives
+     *
+     *  Give a ConfigFileParser (or ApplicationConfiguration) an
+     *  IncludeFileCache and every file it includes is parsed once and
+     *  reused wherever else it is included.  Use a new cache for each
+     *  load to share parses within one load only, or keep one cache for
+     *  the life of the process to share them across loads.
+     *
+     *  Entries are keyed by the canonical path of the included file
+     *  and the parser settings that affect its properties.  An entry is
+     *  used only if none of the files it was built from has changed
+     *  identity, size or modification time since it was parsed, and
+     *  ConfigFileParser also rejects an entry if an environment variable
+     *  substituted into its values has a different value now.  The
+     *  cache may be shared by any number of parsers and threads.
+     */
+    class IncludeFileCache {
+    public:
+      /** @brief The result of parsing an included file */
+      struct Entry {
+	/** @brief The file and every file it includes, directly or
+	 *         indirectly, with their stamps when they were parsed
+	 *
+	 *  The first element is the file itself.  Paths are spelled as
+	 *  the parser resolved them.
+	 */
+	std::vector< std::pair<std::string, detail::FileStamp> > files;
+
+	/** @brief How deeply the file's includes are nested, or zero if
+	 *         it includes no files
+	 */
+	size_t depth;
+
+	/** @brief Properties of the file, with those of its includes
+	 *         merged in
+	 */
+	ConfigurationPropertyMap properties;
+
+	/** @brief Names and values of the environment variables
+	 *         substituted into the values of the file and its includes
+	 */
+	std::vector< std::pair<std::string, std::string> > environment;
+
+	Entry(): files(), depth(0), properties(), environment() { }
+      };
+
+    public:
+      IncludeFileCache();
+      IncludeFileCache(const IncludeFileCache&) = delete;
+      ~IncludeFileCache();
+
+      /** @brief Number of lookups answered from the cache */
+      uint64_t hits() const { return hits_.load(); }
+
+      /** @brief Number of lookups that had to parse the file */
+      uint64_t misses() const { return misses_.load(); }
+
+      /** @brief Number of files in the cache */
+      size_t size() const;
+
+      void clear();
+
+      /** @brief Look up the entry for @c key
+       *
+       *  Returns null and counts a miss if there is no entry, if any
+       *  file the entry was built from has changed, or if @c usable
+       *  rejects the entry.  Entries with changed files are removed.
+       */
+      std::shared_ptr<const Entry> find(
+	  const std::string& key,
+	  const std::function<bool (const Entry&)>& usable
+      );
+
+      void insert(const std::string& key, std::shared_ptr<const Entry> entry);
+
+      IncludeFileCache& operator=(const IncludeFileCache&) = delete;
+
+    private:
+      mutable std::mutex mutex_;
+      std::unordered_map< std::string, std::shared_ptr<const Entry> >
+	  entries_;
+      std::atomic<uint64_t> hits_;
+      std::atomic<uint64_t> misses_;
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,50 @@
+#include "ParseStatistics.hpp"
+
+using namespace pistis::config_parser;
+
+ParseStatistics::ParseStatistics(AllocationCountFn countAllocations):
+    countAllocations_(countAllocations), phases_() {
+  clear();
+}
+
+ParseStatistics::~ParseStatistics() {
+  // Intentionally left blank
+}
+
+ParseStatistics::PhaseTotals ParseStatistics::phase(Phase p) const {
+  PhaseTotals totals;
+  totals.count= phases_[p].count.load(std::memory_order_relaxed);
+  totals.nanoseconds= phases_[p].nanoseconds.load(std::memory_order_relaxed);
+  totals.allocations= phases_[p].allocations.load(std::memory_order_relaxed);
+  return totals;
+}
+
+void ParseStatistics::add(Phase p, uint64_t nanoseconds,
+			  uint64_t allocations) {
+  phases_[p].count.fetch_add(1, std::memory_order_relaxed);
+  phases_[p].nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+  phases_[p].allocations.fetch_add(allocations, std::memory_order_relaxed);
+}
+
+void ParseStatistics::clear() {
+  for (int i= 0; i < NUM_PHASES; ++i) {
+    phases_[i].count.store(0, std::memory_order_relaxed);
+    phases_[i].nanoseconds.store(0, std::memory_order_relaxed);
+    phases_[i].allocations.store(0, std::memory_order_relaxed);
+  }
+}
+
+const char* ParseStatistics::phaseName(Phase p) {
+  switch (p) {
+    case LEX:              return "lex";
+    case VALUE_PROCESSING: return "value processing";
+    case INCLUDE_MERGE:    return "include merge";
+    case MAP_INSERT:       return "map insert";
+    default:               return "**UNKNOWN**";
+  }
+}
+
+std::ostream& pistis::config_parser::operator<<(std::ostream& out,
+						ParseStatistics::Phase p) {
+  return out << ParseStatistics::phaseName(p);
+}
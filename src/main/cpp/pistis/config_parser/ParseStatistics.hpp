@@ -0,0 +1,116 @@
+#ifndef __PISTIS__CONFIG_PARSER__PARSESTATISTICS_HPP__
+#define __PISTIS__CONFIG_PARSER__PARSESTATISTICS_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief Time and allocations spent in each phase of parsing
+     *
+     *  Give a ConfigFileParser a ParseStatistics to find out where a
+     *  slow configuration spends its time.  The parser and the parsers
+     *  it creates for included files add to the same totals, from any
+     *  number of threads.  Phases do not overlap: time spent parsing an
+     *  included file is counted in that file's phases, not in
+     *  INCLUDE_MERGE.
+     *
+     *  Allocations are counted only if the program supplies a function
+     *  that returns the number of allocations made so far, usually by
+     *  replacing the global operator new.  Counts from concurrent parses
+     *  include allocations made by other threads.
+     */
+    class ParseStatistics {
+    public:
+      enum Phase {
+	LEX,              ///< Reading and tokenizing input
+	VALUE_PROCESSING, ///< Escapes and variable substitution
+	INCLUDE_MERGE,    ///< Merging included properties
+	MAP_INSERT,       ///< Adding properties to the map
+	NUM_PHASES
+      };
+
+      struct PhaseTotals {
+	uint64_t count;        ///< Times the phase was entered
+	uint64_t nanoseconds;  ///< Total time spent in the phase
+	uint64_t allocations;  ///< Total allocations made in the phase
+      };
+
+      typedef uint64_t (*AllocationCountFn)();
+
+      /** @brief Adds the time and allocations between its construction
+       *         and destruction to a phase
+       *
+       *  Does nothing if the statistics are null.
+       */
+      class Timer {
+      public:
+	Timer(ParseStatistics* statistics, Phase phase):
+	    statistics_(statistics), phase_(phase), start_(), allocations_(0) {
+	  if (statistics_) {
+	    allocations_= statistics_->allocationCount_();
+	    start_= std::chrono::steady_clock::now();
+	  }
+	}
+	Timer(const Timer&) = delete;
+	~Timer() {
+	  if (statistics_) {
+	    const auto elapsed= std::chrono::steady_clock::now() - start_;
+	    statistics_->add(
+		phase_,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+		    elapsed
+		).count(),
+		statistics_->allocationCount_() - allocations_
+	    );
+	  }
+	}
+
+	Timer& operator=(const Timer&) = delete;
+
+      private:
+	ParseStatistics* statistics_;
+	Phase phase_;
+	std::chrono::steady_clock::time_point start_;
+	uint64_t allocations_;
+      };
+
+    public:
+      explicit ParseStatistics(AllocationCountFn countAllocations= nullptr);
+      ParseStatistics(const ParseStatistics&) = delete;
+      ~ParseStatistics();
+
+      PhaseTotals phase(Phase p) const;
+
+      /** @brief Add one entry into @c p lasting @c nanoseconds */
+      void add(Phase p, uint64_t nanoseconds, uint64_t allocations);
+
+      void clear();
+
+      static const char* phaseName(Phase p);
+
+      ParseStatistics& operator=(const ParseStatistics&) = delete;
+
+    private:
+      struct Counters {
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> nanoseconds;
+	std::atomic<uint64_t> allocations;
+      };
+
+      AllocationCountFn countAllocations_;
+      Counters phases_[NUM_PHASES];
+
+      uint64_t allocationCount_() const {
+	return countAllocations_ ? countAllocations_() : 0;
+      }
+    };
+
+    std::ostream& operator<<(std::ostream& out, ParseStatistics::Phase p);
+
+  }
+}
+#endif
@@ -0,0 +1,148 @@
+#ifndef __PISTIS__CONFIG_PARSER__PROPERTYRANGE_HPP__
+#define __PISTIS__CONFIG_PARSER__PROPERTYRANGE_HPP__
+
+#include <iterator>
+#include <utility>
+#include <stddef.h>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief A range of properties in a property map
+     *
+     *  A PropertyRange is a pair of iterators into a map's storage that
+     *  can be used in a range-based for loop or passed to the standard
+     *  algorithms.  It does not copy any properties and is valid until
+     *  the map it refers to is modified or destroyed.
+     */
+    template <typename Iterator>
+    class PropertyRange {
+    public:
+      typedef Iterator iterator;
+      typedef Iterator const_iterator;
+      typedef typename std::iterator_traits<Iterator>::value_type
+	  value_type;
+
+    public:
+      PropertyRange(): begin_(), end_() { }
+      PropertyRange(const Iterator& begin, const Iterator& end):
+	  begin_(begin), end_(end) {
+	// Intentionally left blank
+      }
+
+      Iterator begin() const { return begin_; }
+      Iterator end() const { return end_; }
+      bool empty() const { return begin_ == end_; }
+
+      /** @brief Number of properties in the range
+       *
+       *  Takes time proportional to the size of the range unless
+       *  @c Iterator is a random-access iterator.
+       */
+      size_t size() const { return std::distance(begin_, end_); }
+
+      operator std::pair<Iterator, Iterator>() const {
+	return std::make_pair(begin_, end_);
+      }
+
+    private:
+      Iterator begin_;
+      Iterator end_;
+    };
+
+    /** @brief The properties in a range whose names satisfy a predicate
+     *
+     *  The predicate is called with each property's name as the range is
+     *  traversed, so a FilteredPropertyRange costs nothing to create and
+     *  nothing to skip a property.  Iterators refer to the predicate
+     *  stored in the range and are valid as long as both the range and
+     *  the map it refers to are.
+     */
+    template <typename Iterator, typename Predicate>
+    class FilteredPropertyRange {
+    public:
+      class FilteredIterator {
+      public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef typename std::iterator_traits<Iterator>::value_type
+	    value_type;
+	typedef ptrdiff_t difference_type;
+	typedef const value_type& reference;
+	typedef const value_type* pointer;
+
+      public:
+	FilteredIterator(): p_(), end_(), predicate_(nullptr) { }
+
+	reference operator*() const { return *p_; }
+	pointer operator->() const { return &(*p_); }
+
+	bool operator==(const FilteredIterator& other) const {
+	  return p_ == other.p_;
+	}
+	bool operator!=(const FilteredIterator& other) const {
+	  return p_ != other.p_;
+	}
+	FilteredIterator& operator++() {
+	  ++p_;
+	  skip_();
+	  return *this;
+	}
+	FilteredIterator operator++(int) {
+	  FilteredIterator tmp(*this);
+	  ++(*this);
+	  return tmp;
+	}
+
+      private:
+	FilteredIterator(const Iterator& p, const Iterator& end,
+			 const Predicate* predicate):
+	    p_(p), end_(end), predicate_(predicate) {
+	  skip_();
+	}
+
+	void skip_() {
+	  while ((p_ != end_) && !(*predicate_)(p_->name())) {
+	    ++p_;
+	  }
+	}
+
+	Iterator p_;
+	Iterator end_;
+	const Predicate* predicate_;
+
+	friend class FilteredPropertyRange;
+      };
+
+      typedef FilteredIterator iterator;
+      typedef FilteredIterator const_iterator;
+      typedef typename FilteredIterator::value_type value_type;
+
+    public:
+      FilteredPropertyRange(const Iterator& begin, const Iterator& end,
+			    const Predicate& predicate):
+	  begin_(begin), end_(end), predicate_(predicate) {
+	// Intentionally left blank
+      }
+
+      /** @brief Returns an iterator to the first matching property
+       *
+       *  Takes time proportional to the number of properties that
+       *  precede it in the underlying range.
+       */
+      FilteredIterator begin() const {
+	return FilteredIterator(begin_, end_, &predicate_);
+      }
+      FilteredIterator end() const {
+	return FilteredIterator(end_, end_, &predicate_);
+      }
+      bool empty() const { return begin() == end(); }
+
+    private:
+      Iterator begin_;
+      Iterator end_;
+      Predicate predicate_;
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,200 @@
+#ifndef __PISTIS__CONFIG_PARSER__RELOADABLECONFIGURATION_HPP__
+#define __PISTIS__CONFIG_PARSER__RELOADABLECONFIGURATION_HPP__
+
+#include <atomic>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief Holds the current version of a configuration that can be
+     *         reloaded while other threads read it
+     *
+     *  ApplicationConfiguration::load() sets the fields of the object it
+     *  is called on, so it cannot be called while other threads read
+     *  them.  ReloadableConfiguration instead builds each new
+     *  configuration in a fresh object made by a factory, loads and
+     *  validates it, and only then publishes it.  Published objects are
+     *  never modified.  If loading or validation throws, the current
+     *  configuration stays in place and the exception propagates.
+     *
+     *  ConfigT is usually a subclass of ApplicationConfiguration, but
+     *  may be any type, such as ConfigurationPropertyMap, when reloads
+     *  go through reload(loadFn).
+     *
+     *  Threads can read the configuration two ways:
+     *  <ul>
+     *    <li>current() returns a shared pointer to the current version.
+     *        It is safe from any thread, but copying a shared pointer
+     *        that other threads are replacing may take a lock.</li>
+     *    <li>A Reader, owned by one thread, keeps a reference to the
+     *        version it last saw and checks a version counter on each
+     *        get().  Only the first get() after a reload does more than
+     *        one atomic load, so request paths neither lock nor
+     *        wait.</li>
+     *  </ul>
+     *  A version stays alive until every Reader holding it has moved on
+     *  and every pointer from current() has been released.
+     */
+    template <typename ConfigT>
+    class ReloadableConfiguration {
+    public:
+      typedef std::function<std::unique_ptr<ConfigT> ()> Factory;
+      typedef std::function<void (const ConfigT&)> Validator;
+
+      /** @brief Per-thread view of a ReloadableConfiguration */
+      class Reader {
+      public:
+	explicit Reader(const ReloadableConfiguration& source):
+	    source_(&source), version_(source.version()),
+	    current_(source.current()) {
+	  // Intentionally left blank
+	}
+
+	/** @brief The current configuration
+	 *
+	 *  The reference is valid until the next call to get() on this
+	 *  Reader, or until the Reader is destroyed.
+	 */
+	const ConfigT& get() {
+	  const uint64_t v= source_->version();
+	  if (v != version_) {
+	    current_= source_->current();
+	    version_= v;
+	  }
+	  return *current_;
+	}
+
+	const ConfigT& operator*() { return get(); }
+	const ConfigT* operator->() { return &get(); }
+
+      private:
+	const ReloadableConfiguration* source_;
+	uint64_t version_;
+	std::shared_ptr<const ConfigT> current_;
+      };
+
+    public:
+      /** @brief Start with a default-constructed ConfigT, and make new
+       *         ones the same way
+       */
+      ReloadableConfiguration():
+	  ReloadableConfiguration(
+	      []() { return std::unique_ptr<ConfigT>(new ConfigT()); }
+	  ) {
+	// Intentionally left blank
+      }
+
+      /** @brief Start with an object made by @c factory, and make new
+       *         ones the same way
+       */
+      explicit ReloadableConfiguration(const Factory& factory):
+	  factory_(factory), validator_(), reloadMutex_(),
+	  current_(factory_()), version_(0) {
+	// Intentionally left blank
+      }
+
+      ReloadableConfiguration(const ReloadableConfiguration&) = delete;
+
+      /** @brief The current configuration */
+      std::shared_ptr<const ConfigT> current() const {
+	return std::atomic_load(&current_);
+      }
+
+      /** @brief Number of configurations published since construction */
+      uint64_t version() const {
+	return version_.load(std::memory_order_acquire);
+      }
+
+      /** @brief Check each new configuration before it is published
+       *
+       *  @c validator should throw to reject a configuration.
+       */
+      void setValidator(const Validator& validator) {
+	std::lock_guard<std::mutex> lock(reloadMutex_);
+	validator_= validator;
+      }
+
+      /** @brief Make a new configuration, load it with @c loadFn,
+       *         validate it and publish it
+       *
+       *  Reloads are serialized.  Returns the new configuration.
+       */
+      std::shared_ptr<const ConfigT> reload(
+	  const std::function<void (ConfigT&)>& loadFn
+      ) {
+	std::lock_guard<std::mutex> lock(reloadMutex_);
+	std::shared_ptr<ConfigT> next(factory_());
+	loadFn(*next);
+	return publish_(next);
+      }
+
+      /** @brief Reload from the configuration file @c filename */
+      std::shared_ptr<const ConfigT> reload(const std::string& filename) {
+	return reload([&filename](ConfigT& c) { c.load(filename); });
+      }
+
+      /** @brief Reload from configuration text read from @c input */
+      std::shared_ptr<const ConfigT> reload(const std::string& sourceName,
+					    std::istream& input) {
+	return reload(
+	    [&sourceName, &input](ConfigT& c) { c.load(sourceName, input); }
+	);
+      }
+
+      /** @brief Reload from the configuration text @c text */
+      std::shared_ptr<const ConfigT> reloadFromText(
+	  const std::string& sourceName, const std::string& text
+      ) {
+	return reload(
+	    [&sourceName, &text](ConfigT& c) {
+	      c.loadFromText(sourceName, text);
+	    }
+	);
+      }
+
+      /** @brief Validate and publish a configuration built elsewhere */
+      void publish(const std::shared_ptr<const ConfigT>& config) {
+	std::lock_guard<std::mutex> lock(reloadMutex_);
+	publish_(config);
+      }
+
+      ReloadableConfiguration& operator=(const ReloadableConfiguration&)
+	  = delete;
+
+    private:
+      Factory factory_;
+      Validator validator_;
+
+      /** @brief Serializes reloads and changes to validator_ */
+      std::mutex reloadMutex_;
+
+      /** @brief The current configuration
+       *
+       *  Only accessed through std::atomic_load and std::atomic_store.
+       */
+      std::shared_ptr<const ConfigT> current_;
+
+      /** @brief Incremented after each store to current_ */
+      std::atomic<uint64_t> version_;
+
+      std::shared_ptr<const ConfigT> publish_(
+	  const std::shared_ptr<const ConfigT>& config
+      ) {
+	if (validator_) {
+	  validator_(*config);
+	}
+	std::atomic_store(&current_, config);
+	version_.fetch_add(1, std::memory_order_release);
+	return config;
+      }
+    };
+
+  }
+}
+#endif
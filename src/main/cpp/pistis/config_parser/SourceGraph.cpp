@@ -0,0 +1,99 @@
+#include "SourceGraph.hpp"
+
+using namespace pistis::config_parser;
+
+SourceGraph::SourceGraph():
+    mutex_(), nodes_(), roots_(), filesParsed_(0), filesReplayed_(0), filesReused_(0),
+    valuesReprocessed_(0) {
+  // Intentionally left blank
+}
+
+SourceGraph::~SourceGraph() {
+  // Intentionally left blank
+}
+
+size_t SourceGraph::size() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return nodes_.size();
+}
+
+std::vector< std::shared_ptr<const SourceGraph::Node> >
+    SourceGraph::nodes() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::vector< std::shared_ptr<const Node> > result;
+  result.reserve(nodes_.size());
+  for (auto i= nodes_.begin(); i != nodes_.end(); ++i) {
+    result.push_back(i->second);
+  }
+  return result;
+}
+
+std::shared_ptr<const SourceGraph::Node> SourceGraph::find(
+    const std::string& key
+) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto i= nodes_.find(key);
+  return (i == nodes_.end()) ? std::shared_ptr<const Node>() : i->second;
+}
+
+void SourceGraph::insert(const std::string& key,
+			 std::shared_ptr<const Node> node) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  nodes_[key]= std::move(node);
+}
+
+void SourceGraph::clear() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  nodes_.clear();
+  roots_.clear();
+}
+
+size_t SourceGraph::prune(const std::string& rootKey) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  roots_.insert(rootKey);
+
+  // An includer holds the results of its included files, so those
+  // results lead to the nodes it includes
+  std::unordered_map<const IncludeFileCache::Entry*, const Node*> owners;
+  for (auto i= nodes_.begin(); i != nodes_.end(); ++i) {
+    owners.emplace(i->second->result.get(), i->second.get());
+  }
+
+  std::unordered_set<const Node*> reached;
+  std::vector<const Node*> pending;
+  for (auto i= roots_.begin(); i != roots_.end(); ++i) {
+    auto node= nodes_.find(*i);
+    if ((node != nodes_.end()) && reached.insert(node->second.get()).second) {
+      pending.push_back(node->second.get());
+    }
+  }
+  while (!pending.empty()) {
+    const Node* node= pending.back();
+    pending.pop_back();
+    for (auto i= node->includes.begin(); i != node->includes.end(); ++i) {
+      auto owner= owners.find(i->get());
+      if ((owner != owners.end()) && reached.insert(owner->second).second) {
+	pending.push_back(owner->second);
+      }
+    }
+  }
+
+  size_t removed= 0;
+  for (auto i= nodes_.begin(); i != nodes_.end(); ) {
+    if (reached.count(i->second.get())) {
+      ++i;
+    } else {
+      i= nodes_.erase(i);
+      ++removed;
+    }
+  }
+  return removed;
+}
+
+void SourceGraph::count(uint64_t parsed, uint64_t replayed, uint64_t reused,
+			uint64_t reprocessed) {
+  filesParsed_ += parsed;
+  filesReplayed_ += replayed;
+  filesReused_ += reused;
+  valuesReprocessed_ += reprocessed;
+}
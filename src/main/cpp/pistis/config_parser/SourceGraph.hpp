@@ -0,0 +1,179 @@
+#ifndef __PISTIS__CONFIG_PARSER__SOURCEGRAPH_HPP__
+#define __PISTIS__CONFIG_PARSER__SOURCEGRAPH_HPP__
+
+#include <pistis/config_parser/IncludeFileCache.hpp>
+#include <pistis/config_parser/detail/FileStamp.hpp>
+#include <pistis/config_parser/detail/ValueProcessor.hpp>
+#include <pistis/config_parser/detail/ValueTemplate.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+
+    /** @brief The files a configuration was parsed from, what each of
+     *         them says and the properties each of them produced, for
+     *         reparsing only what has changed
+     *
+     *  Give a ConfigFileParser (or ApplicationConfiguration) a
+     *  SourceGraph and keep it between loads.  Each file the parser
+     *  reads, whether named to parse(filename) or reached through an
+     *  include directive, becomes a node holding the file's stamp, its
+     *  statements and its properties.  The next parse of the file then
+     *  does only as much work as the changes since require:
+     *  <ul>
+     *    <li>A file is lexed and parsed again only if its own stamp
+     *        has changed.</li>
+     *    <li>An unchanged file whose included files and referenced
+     *        environment variables are also unchanged reuses its
+     *        properties as they are.</li>
+     *    <li>Otherwise the file's statements are replayed in order,
+     *        merging the new properties of its included files.  A
+     *        value is substituted again only if a variable it
+     *        references now has a different value.  The value is
+     *        compiled into a detail::ValueTemplate the first time, so
+     *        later substitutions only concatenate.</li>
+     *  </ul>
+     *  The result, including any error, is the same as parsing the
+     *  files from scratch.
+     *
+     *  Nodes are keyed by the canonical path of the file and the parser
+     *  settings that affect its properties.  The graph may be shared by
+     *  any number of parsers and threads.
+     *
+     *  After each top-level parse, the parser calls prune() to remove
+     *  the nodes of files that no file named to a top-level parse
+     *  includes any more, so files dropped from include directives do
+     *  not accumulate.  The graph keeps every file ever named to a
+     *  top-level parse, and everything it includes, until clear() is
+     *  called, so call clear() when a long-lived graph stops being
+     *  used for some of its top-level files.
+     */
+    class SourceGraph {
+    public:
+      /** @brief An assignment or include directive in a file */
+      struct Statement {
+	enum Kind {
+	  ASSIGNMENT,
+	  INCLUDE
+	};
+
+	Kind kind;
+
+	/** @brief Full name of the property assigned, or the resolved
+	 *         path of the file included
+	 */
+	std::string name;
+
+	/** @brief Value as written in the file, before escapes and
+	 *         variables were processed
+	 */
+	std::string text;
+
+	/** @brief Value after processing */
+	std::string value;
+
+	int line;
+	int nameColumn;
+	int valueColumn;
+
+	/** @brief Variables substituted into the value, in order */
+	std::vector<detail::VariableReference> references;
+
+	/** @brief The value compiled into a template, or null until a
+	 *         replay has had to substitute its variables again
+	 */
+	std::shared_ptr<const detail::ValueTemplate> compiled;
+      };
+
+      struct Node {
+	/** @brief The file, spelled as the parser resolved it */
+	std::string filename;
+
+	/** @brief Stamp of the file when it was parsed */
+	detail::FileStamp stamp;
+
+	/** @brief Assignments and include directives, in file order */
+	std::vector<Statement> statements;
+
+	/** @brief Results of the include directives, in order */
+	std::vector< std::shared_ptr<const IncludeFileCache::Entry> >
+	    includes;
+
+	/** @brief Properties of the file and the files it includes */
+	std::shared_ptr<const IncludeFileCache::Entry> result;
+      };
+
+    public:
+      SourceGraph();
+      SourceGraph(const SourceGraph&) = delete;
+      ~SourceGraph();
+
+      /** @brief Number of files lexed and parsed */
+      uint64_t filesParsed() const { return filesParsed_.load(); }
+
+      /** @brief Number of files whose statements were replayed */
+      uint64_t filesReplayed() const { return filesReplayed_.load(); }
+
+      /** @brief Number of files whose properties were reused */
+      uint64_t filesReused() const { return filesReused_.load(); }
+
+      /** @brief Number of values substituted again during replays */
+      uint64_t valuesReprocessed() const {
+	return valuesReprocessed_.load();
+      }
+
+      /** @brief Number of files in the graph */
+      size_t size() const;
+
+      /** @brief All nodes, in no particular order */
+      std::vector< std::shared_ptr<const Node> > nodes() const;
+
+      /** @brief The node for @c key, or null if there is none */
+      std::shared_ptr<const Node> find(const std::string& key) const;
+
+      void insert(const std::string& key, std::shared_ptr<const Node> node);
+
+      /** @brief Remove every node, and forget the top-level files */
+      void clear();
+
+      /** @brief Record @c rootKey as the key of a file named to a
+       *         top-level parse, then remove the nodes that no such file
+       *         includes, directly or indirectly
+       *
+       *  A parse running on another thread may lose nodes it has
+       *  inserted but its top-level file does not yet reach.  That only
+       *  costs parsing those files again.  Returns the number of nodes
+       *  removed.
+       */
+      size_t prune(const std::string& rootKey);
+
+      /** @brief Add to the counters returned by filesParsed(),
+       *         filesReplayed(), filesReused() and valuesReprocessed()
+       */
+      void count(uint64_t parsed, uint64_t replayed, uint64_t reused,
+		 uint64_t reprocessed);
+
+      SourceGraph& operator=(const SourceGraph&) = delete;
+
+    private:
+      mutable std::mutex mutex_;
+      std::unordered_map< std::string, std::shared_ptr<const Node> > nodes_;
+
+      /** @brief Keys of the files named to top-level parses */
+      std::unordered_set<std::string> roots_;
+      std::atomic<uint64_t> filesParsed_;
+      std::atomic<uint64_t> filesReplayed_;
+      std::atomic<uint64_t> filesReused_;
+      std::atomic<uint64_t> valuesReprocessed_;
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,249 @@
+#include "CharacterScanner.hpp"
+
+#if defined(__x86_64__)
+#define PISTIS_CONFIG_PARSER_HAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+using namespace pistis::config_parser::detail;
+
+namespace {
+
+  bool isNameClass(char ch) {
+    return CharacterScanner::isAlnum(ch) || (ch == '_') || (ch == '.');
+  }
+
+  const char* skipWhitespaceScalar(const char* p, const char* end) {
+    while ((p != end) && CharacterScanner::isWhitespace(*p)) {
+      ++p;
+    }
+    return p;
+  }
+
+  const char* skipNameCharsScalar(const char* p, const char* end) {
+    while ((p != end) && isNameClass(*p)) {
+      ++p;
+    }
+    return p;
+  }
+
+  const char* findEitherScalar(const char* p, const char* end, char a,
+			       char b) {
+    while ((p != end) && (*p != a) && (*p != b)) {
+      ++p;
+    }
+    return p;
+  }
+
+#ifdef PISTIS_CONFIG_PARSER_HAS_X86_SIMD
+
+  // Bytes with the high bit set compare as negative, so they fall outside
+  // every range tested below and are never whitespace or name characters.
+
+  inline __m128i whitespaceMask16(__m128i c) {
+    const __m128i space= _mm_set1_epi8(' ');
+    const __m128i belowTab= _mm_set1_epi8('\t' - 1);
+    const __m128i aboveCr= _mm_set1_epi8('\r' + 1);
+    return _mm_or_si128(
+        _mm_cmpeq_epi8(c, space),
+	_mm_and_si128(_mm_cmpgt_epi8(c, belowTab), _mm_cmplt_epi8(c, aboveCr))
+    );
+  }
+
+  inline __m128i nameMask16(__m128i c) {
+    const __m128i lower= _mm_or_si128(c, _mm_set1_epi8(0x20));
+    const __m128i digit= _mm_and_si128(
+        _mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+	_mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1))
+    );
+    const __m128i letter= _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+	_mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1))
+    );
+    const __m128i punct= _mm_or_si128(
+        _mm_cmpeq_epi8(c, _mm_set1_epi8('_')),
+	_mm_cmpeq_epi8(c, _mm_set1_epi8('.'))
+    );
+    return _mm_or_si128(_mm_or_si128(digit, letter), punct);
+  }
+
+  const char* skipWhitespaceSse2(const char* p, const char* end) {
+    while ((end - p) >= 16) {
+      __m128i c= _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      unsigned int miss= ~_mm_movemask_epi8(whitespaceMask16(c)) & 0xFFFF;
+      if (miss) {
+	return p + __builtin_ctz(miss);
+      }
+      p += 16;
+    }
+    return skipWhitespaceScalar(p, end);
+  }
+
+  const char* skipNameCharsSse2(const char* p, const char* end) {
+    while ((end - p) >= 16) {
+      __m128i c= _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      unsigned int miss= ~_mm_movemask_epi8(nameMask16(c)) & 0xFFFF;
+      if (miss) {
+	return p + __builtin_ctz(miss);
+      }
+      p += 16;
+    }
+    return skipNameCharsScalar(p, end);
+  }
+
+  const char* findEitherSse2(const char* p, const char* end, char a,
+			     char b) {
+    const __m128i va= _mm_set1_epi8(a);
+    const __m128i vb= _mm_set1_epi8(b);
+    while ((end - p) >= 16) {
+      __m128i c= _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      unsigned int hit= _mm_movemask_epi8(
+          _mm_or_si128(_mm_cmpeq_epi8(c, va), _mm_cmpeq_epi8(c, vb))
+      );
+      if (hit) {
+	return p + __builtin_ctz(hit);
+      }
+      p += 16;
+    }
+    return findEitherScalar(p, end, a, b);
+  }
+
+  __attribute__((target("avx2")))
+  inline __m256i whitespaceMask32(__m256i c) {
+    const __m256i space= _mm256_set1_epi8(' ');
+    const __m256i belowTab= _mm256_set1_epi8('\t' - 1);
+    const __m256i aboveCr= _mm256_set1_epi8('\r' + 1);
+    return _mm256_or_si256(
+        _mm256_cmpeq_epi8(c, space),
+	_mm256_and_si256(_mm256_cmpgt_epi8(c, belowTab),
+			 _mm256_cmpgt_epi8(aboveCr, c))
+    );
+  }
+
+  __attribute__((target("avx2")))
+  inline __m256i nameMask32(__m256i c) {
+    const __m256i lower= _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    const __m256i digit= _mm256_and_si256(
+        _mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+	_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c)
+    );
+    const __m256i letter= _mm256_and_si256(
+        _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+	_mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower)
+    );
+    const __m256i punct= _mm256_or_si256(
+        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')),
+	_mm256_cmpeq_epi8(c, _mm256_set1_epi8('.'))
+    );
+    return _mm256_or_si256(_mm256_or_si256(digit, letter), punct);
+  }
+
+  __attribute__((target("avx2")))
+  const char* skipWhitespaceAvx2(const char* p, const char* end) {
+    while ((end - p) >= 32) {
+      __m256i c= _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      unsigned int miss= ~_mm256_movemask_epi8(whitespaceMask32(c));
+      if (miss) {
+	return p + __builtin_ctz(miss);
+      }
+      p += 32;
+    }
+    return skipWhitespaceSse2(p, end);
+  }
+
+  __attribute__((target("avx2")))
+  const char* skipNameCharsAvx2(const char* p, const char* end) {
+    while ((end - p) >= 32) {
+      __m256i c= _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      unsigned int miss= ~_mm256_movemask_epi8(nameMask32(c));
+      if (miss) {
+	return p + __builtin_ctz(miss);
+      }
+      p += 32;
+    }
+    return skipNameCharsSse2(p, end);
+  }
+
+  __attribute__((target("avx2")))
+  const char* findEitherAvx2(const char* p, const char* end, char a,
+			     char b) {
+    const __m256i va= _mm256_set1_epi8(a);
+    const __m256i vb= _mm256_set1_epi8(b);
+    while ((end - p) >= 32) {
+      __m256i c= _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      unsigned int hit= _mm256_movemask_epi8(
+          _mm256_or_si256(_mm256_cmpeq_epi8(c, va), _mm256_cmpeq_epi8(c, vb))
+      );
+      if (hit) {
+	return p + __builtin_ctz(hit);
+      }
+      p += 32;
+    }
+    return findEitherSse2(p, end, a, b);
+  }
+
+#endif
+
+  CharacterScanner::Implementation bestImplementation() {
+    if (CharacterScanner::isSupported(CharacterScanner::AVX2)) {
+      return CharacterScanner::AVX2;
+    } else if (CharacterScanner::isSupported(CharacterScanner::SSE2)) {
+      return CharacterScanner::SSE2;
+    }
+    return CharacterScanner::SCALAR;
+  }
+}
+
+CharacterScanner::CharacterScanner(Implementation implementation):
+    implementation_(isSupported(implementation) ? implementation
+		                                : bestImplementation()),
+    skipWhitespace_(&skipWhitespaceScalar),
+    skipNameChars_(&skipNameCharsScalar),
+    findEither_(&findEitherScalar) {
+#ifdef PISTIS_CONFIG_PARSER_HAS_X86_SIMD
+  if (implementation_ == AVX2) {
+    skipWhitespace_= &skipWhitespaceAvx2;
+    skipNameChars_= &skipNameCharsAvx2;
+    findEither_= &findEitherAvx2;
+  } else if (implementation_ == SSE2) {
+    skipWhitespace_= &skipWhitespaceSse2;
+    skipNameChars_= &skipNameCharsSse2;
+    findEither_= &findEitherSse2;
+  }
+#endif
+}
+
+const CharacterScanner& CharacterScanner::instance() {
+  static const CharacterScanner SCANNER(bestImplementation());
+  return SCANNER;
+}
+
+bool CharacterScanner::isSupported(Implementation implementation) {
+  switch (implementation) {
+    case SCALAR:
+      return true;
+
+#ifdef PISTIS_CONFIG_PARSER_HAS_X86_SIMD
+    case SSE2:
+      // Part of the x86-64 baseline
+      return true;
+
+    case AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+
+    default:
+      return false;
+  }
+}
+
+std::ostream& pistis::config_parser::detail::operator<<(
+    std::ostream& out, CharacterScanner::Implementation impl
+) {
+  switch (impl) {
+    case CharacterScanner::SCALAR: return out << "SCALAR";
+    case CharacterScanner::SSE2:   return out << "SSE2";
+    case CharacterScanner::AVX2:   return out << "AVX2";
+    default:                       return out << "**UNKNOWN**";
+  }
+}
@@ -0,0 +1,97 @@
+#ifndef __PISTIS__CONFIG_PARSER__DETAIL__CHARACTERSCANNER_HPP__
+#define __PISTIS__CONFIG_PARSER__DETAIL__CHARACTERSCANNER_HPP__
+
+#include <ostream>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+
+      /** @brief Finds runs of characters in a buffer that belong to the
+       *         character classes used by the configuration file lexer.
+       *
+       *  Each scan examines 16 (SSE2) or 32 (AVX2) bytes at a time where
+       *  the processor supports it, and one byte at a time otherwise.
+       *  All implementations return identical results.  Character classes
+       *  are ASCII-only and do not depend on the current locale.
+       */
+      class CharacterScanner {
+      public:
+	enum Implementation {
+	  SCALAR, ///< One byte at a time
+	  SSE2,   ///< 16 bytes at a time
+	  AVX2    ///< 32 bytes at a time
+	};
+
+      public:
+	/** @brief Create a scanner that uses @c implementation
+	 *
+	 *  If the processor does not support @c implementation, the
+	 *  scanner uses the best implementation it does support.
+	 */
+	explicit CharacterScanner(Implementation implementation);
+
+	/** @brief Scanner using the best implementation this processor
+	 *         supports.
+	 */
+	static const CharacterScanner& instance();
+
+	/** @brief True if this processor can run @c implementation */
+	static bool isSupported(Implementation implementation);
+
+	Implementation implementation() const { return implementation_; }
+
+	/** @brief Returns a pointer to the first character in
+	 *         [p, end) that is not whitespace, or @c end if there
+	 *         is none.
+	 */
+	const char* skipWhitespace(const char* p, const char* end) const {
+	  // Most runs of whitespace are short, so check the first
+	  // character before handing off to the vector scanner
+	  return ((p == end) || !isWhitespace(*p)) ? p
+	                                           : skipWhitespace_(p, end);
+	}
+
+	/** @brief Returns a pointer to the first character in [p, end)
+	 *         that is not a letter, digit, underscore or period, or
+	 *         @c end if there is none.
+	 */
+	const char* skipNameChars(const char* p, const char* end) const {
+	  return skipNameChars_(p, end);
+	}
+
+	/** @brief Returns a pointer to the first occurrence of @c a or
+	 *         @c b in [p, end), or @c end if neither occurs.
+	 */
+	const char* findEither(const char* p, const char* end, char a,
+			       char b) const {
+	  return findEither_(p, end, a, b);
+	}
+
+	static bool isWhitespace(char ch) {
+	  return (ch == ' ') || ((ch >= '\t') && (ch <= '\r'));
+	}
+
+	static bool isAlnum(char ch) {
+	  return ((ch >= '0') && (ch <= '9')) ||
+	         (((ch | 0x20) >= 'a') && ((ch | 0x20) <= 'z'));
+	}
+
+      private:
+	typedef const char* (*SkipFn)(const char*, const char*);
+	typedef const char* (*FindEitherFn)(const char*, const char*, char,
+					    char);
+
+	Implementation implementation_;
+	SkipFn skipWhitespace_;
+	SkipFn skipNameChars_;
+	FindEitherFn findEither_;
+      };
+
+      std::ostream& operator<<(std::ostream& out,
+			       CharacterScanner::Implementation impl);
+
+    }
+  }
+}
+#endif
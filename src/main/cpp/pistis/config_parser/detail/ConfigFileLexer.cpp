@@ -2,19 +2,39 @@
 #include <pistis/util/StringUtil.hpp>
 #include <string>
 #include <ctype.h>
+#include <string.h>
 
 using namespace pistis::util;
 using namespace pistis::config_parser;
 using namespace pistis::config_parser::detail;
 
+const size_t ConfigFileLexer::DEFAULT_CHUNK_SIZE;
+
 ConfigFileLexer::ConfigFileLexer(std::istream& input, int initialLine,
-				 int initialColumn):
-    input_(input), line_(initialLine), column_(initialColumn), text_(),
-    current_(), state_(AT_START) {
-  if (!std::getline(input_, text_)) {
+				 int initialColumn, size_t chunkSize):
+    input_(&input), next_(nullptr), end_(nullptr), line_(initialLine),
+    column_(initialColumn), buffer_(chunkSize ? chunkSize : 1),
+    lineBegin_(nullptr), lineEnd_(nullptr),
+    current_(nullptr), state_(AT_START),
+    scanner_(CharacterScanner::instance()) {
+  next_= buffer_.data();
+  end_= next_;
+  if (!fetchLine_()) {
+    state_ = AT_EOF;
+  }
+  current_ = lineBegin_;
+}
+
+ConfigFileLexer::ConfigFileLexer(const char* begin, const char* end,
+				 int initialLine, int initialColumn):
+    input_(nullptr), next_(begin), end_(end), line_(initialLine),
+    column_(initialColumn), buffer_(), lineBegin_(nullptr), lineEnd_(nullptr),
+    current_(nullptr), state_(AT_START),
+    scanner_(CharacterScanner::instance()) {
+  if (!fetchLine_()) {
     state_ = AT_EOF;
   }
-  current_ = text_.begin();
+  current_ = lineBegin_;
 }
 
 ConfigFileLexer::~ConfigFileLexer() {
@@ -34,27 +54,40 @@ Token ConfigFileLexer::next() {
 
     case AT_EOF:
     default:
-      return Token(TokenType::END_OF_FILE, "", line_, column_);
+      return Token(TokenType::END_OF_FILE, nullptr, nullptr, line_, column_);
   }
 }
 
+std::string ConfigFileLexer::skipLine() {
+  if (state_ == AT_EOF) {
+    return std::string();
+  }
+  std::string rest(current_, lineEnd_);
+  readNextLine_();
+  return rest;
+}
+
 Token ConfigFileLexer::parseText_() {
   if (!skipWhitespace_()) {
-    return Token(TokenType::END_OF_FILE, "", line_, column_);
+    return Token(TokenType::END_OF_FILE, nullptr, nullptr, line_, column_);
   }
   if (isNameChar(*current_, '.')) {
     auto start= current_;
-    int col= column_;
-    char prev= *current_;
-    ++current_;
-    ++column_;
-    while (isNameChar(*current_, prev)) {
-      prev= *current_;
-      ++current_;
-      ++column_;
+    auto end= scanner_.skipNameChars(start + 1, lineEnd_);
+
+    // A period only continues the name when it follows a letter or digit
+    for (auto p= start + 1; p != end; ++p) {
+      if ((*p == '.') && !CharacterScanner::isAlnum(p[-1])) {
+	end= p;
+	break;
+      }
     }
+
+    int col= column_;
+    column_ += end - start;
+    current_= end;
     state_= AT_TEXT;
-    return Token(TokenType::NAME, std::string(start, current_), line_, col);
+    return makeToken_(TokenType::NAME, start, current_, line_, col);
   } else if ((*current_ == '#') && (state_ == AT_START)) {
     ++current_;
     ++column_;
@@ -62,17 +95,20 @@ Token ConfigFileLexer::parseText_() {
 
     auto start= current_;
     int col= column_;
-    current_= text_.end();
-    column_= text_.size()+1;
+    current_= lineEnd_;
+    column_= (lineEnd_ - lineBegin_)+1;
     state_= AT_TEXT;
-    return Token(TokenType::COMMENT, rstrip(std::string(start, current_)),
-		 line_, col);
+    auto end= current_;
+    while ((end != start) && isspace(end[-1])) {
+      --end;
+    }
+    return makeToken_(TokenType::COMMENT, start, end, line_, col);
   } else {
     state_= AT_TEXT;
     ++current_;
     ++column_;
-    return Token(TokenType::PUNCTUATION, std::string(1, current_[-1]),
-		 line_, column_-1);
+    return makeToken_(TokenType::PUNCTUATION, current_-1, current_,
+		      line_, column_-1);
   }
 }
 
@@ -80,45 +116,46 @@ Token ConfigFileLexer::parseValue_(bool singleLine) {
   skipWhitespaceInLine_();
   auto start= current_;
   int col= column_;
-  current_= text_.end();
-  column_= text_.size()+1;
+  current_= lineEnd_;
+  column_= (lineEnd_ - lineBegin_)+1;
   state_= AT_TEXT;
-  if (singleLine || (current_ == start) || (text_.back() != '\\')) {
+  if (singleLine || (current_ == start) || (lineEnd_[-1] != '\\')) {
     auto end= current_;
     while ((end != start) && isspace(end[-1])) {
       --end;
     }
-    return Token(TokenType::VALUE, std::string(start, end), line_, col);
+    return makeToken_(TokenType::VALUE, start, end, line_, col);
   } else {
-    std::ostringstream value;
+    // Each line is copied as soon as it is read, since reading the
+    // next one may overwrite it
+    std::string value(start, current_ - 1);
     int line= line_;
-    --current_;
-    value << std::string(start, current_);
     while (readNextLine_()) {
-      if (text_.empty() || (text_.back() != '\\')) {
-	value << "\n" << text_;
+      value.push_back('\n');
+      if ((lineBegin_ == lineEnd_) || (lineEnd_[-1] != '\\')) {
+	value.append(lineBegin_, lineEnd_);
 	state_= AT_TEXT;
-	current_= text_.end();
-	column_= text_.size()+1;
+	current_= lineEnd_;
+	column_= (lineEnd_ - lineBegin_)+1;
 	break;
       } else {
-	text_.erase(text_.size()-1);
-	value << "\n" << text_;
+	value.append(lineBegin_, lineEnd_ - 1);
       }
     }
-    return Token(TokenType::VALUE, rstrip(value.str()), line, col);
+    return Token(TokenType::VALUE, rstrip(value), line, col);
   }
 }
 
 Token ConfigFileLexer::parseQuotedString_() {
   auto i= current_;
   int col= column_;
-  while ((current_ != text_.end()) && (*current_ != '"')) {
-    ++current_;
-    ++column_;
-  }
+  auto quote= static_cast<const char*>(
+      ::memchr(current_, '"', lineEnd_ - current_)
+  );
+  current_= quote ? quote : lineEnd_;
+  column_ += current_ - i;
   state_= AT_TEXT;
-  return Token(TokenType::VALUE, std::string(i, current_), line_, col);
+  return makeToken_(TokenType::VALUE, i, current_, line_, col);
 }
 
 bool ConfigFileLexer::skipWhitespace_() {
@@ -131,20 +168,16 @@ bool ConfigFileLexer::skipWhitespace_() {
 }
 
 bool ConfigFileLexer::skipWhitespaceInLine_() {
-  while (current_ != text_.end()) {
-    if (!isspace(*current_)) {
-      return true;
-    }
-    ++current_;
-    ++column_;
-  }
-  return false;
+  auto p= scanner_.skipWhitespace(current_, lineEnd_);
+  column_ += p - current_;
+  current_= p;
+  return current_ != lineEnd_;
 }
 
 bool ConfigFileLexer::readNextLine_() {
-  if (std::getline(input_, text_)) {
+  if (fetchLine_()) {
     state_= AT_START;
-    current_= text_.begin();
+    current_= lineBegin_;
     ++line_;
     column_= 1;
     return true;
@@ -154,3 +187,54 @@ bool ConfigFileLexer::readNextLine_() {
   }
 }
 
+bool ConfigFileLexer::fetchLine_() {
+  // When the line does not end in the text already read, read more
+  // and search only the new text
+  size_t searched= 0;
+  const char* eol= nullptr;
+  while (true) {
+    if (next_ + searched != end_) {
+      eol= static_cast<const char*>(
+	  ::memchr(next_ + searched, '\n', (end_ - next_) - searched)
+      );
+    }
+    if (eol) {
+      break;
+    }
+    searched= end_ - next_;
+    if (!readChunk_()) {
+      break;
+    }
+  }
+
+  if (next_ == end_) {
+    return false;
+  }
+  lineBegin_= next_;
+  lineEnd_= eol ? eol : end_;
+  next_= eol ? eol + 1 : end_;
+  return true;
+}
+
+bool ConfigFileLexer::readChunk_() {
+  if (!input_) {
+    return false;
+  }
+
+  const size_t unread= end_ - next_;
+  if (unread && (next_ != buffer_.data())) {
+    ::memmove(buffer_.data(), next_, unread);
+  }
+  if (unread > buffer_.size() / 2) {
+    // The unread text is part of one line, which must be kept whole.
+    // Growing the buffer before it is full means each read fills at
+    // least half of it, so no more is moved than is read.
+    buffer_.resize(buffer_.size() * 2);
+  }
+
+  input_->read(buffer_.data() + unread, buffer_.size() - unread);
+  const size_t n= input_->gcount();
+  next_= buffer_.data();
+  end_= next_ + unread + n;
+  return n > 0;
+}
@@ -1,8 +1,11 @@
 #ifndef __PISTIS__CONFIG_PARSER__DETAIL__CONFIGFILELEXER_HPP__
 #define __PISTIS__CONFIG_PARSER__DETAIL__CONFIGFILELEXER_HPP__
 
+#include <pistis/config_parser/detail/CharacterScanner.hpp>
 #include <pistis/config_parser/detail/Token.hpp>
 #include <iostream>
+#include <vector>
+#include <stddef.h>
 
 namespace pistis {
   namespace config_parser {
@@ -10,14 +13,43 @@ namespace pistis {
 
       class ConfigFileLexer {
       public:
+	/** @brief Default number of characters read from a stream at a
+	 *         time
+	 */
+	static const size_t DEFAULT_CHUNK_SIZE= 65536;
+
+      public:
+	/** @brief Tokenize the characters read from @c input
+	 *
+	 *  The stream is read @c chunkSize characters at a time into a
+	 *  buffer that slides over the input, so the memory used does
+	 *  not depend on the size of the input, only on the length of
+	 *  its longest line.  Lines and values that span chunks are
+	 *  joined in the buffer.
+	 */
 	ConfigFileLexer(std::istream& input, int initialLine=1,
-			int initialColumn=1);
+			int initialColumn=1,
+			size_t chunkSize= DEFAULT_CHUNK_SIZE);
+
+	/** @brief Tokenize the characters in [begin, end) in place.
+	 *
+	 *  Lines are located directly in the buffer, so no text is
+	 *  copied until a token is returned.  The buffer must remain
+	 *  valid and unchanged for the lifetime of the lexer.
+	 */
+	ConfigFileLexer(const char* begin, const char* end,
+			int initialLine=1, int initialColumn=1);
 	ConfigFileLexer(const ConfigFileLexer&) = delete;
 	~ConfigFileLexer();
 
 	int currentLine() const { return line_; }
 	int currentColumn() const { return column_; }
 
+	/** @brief Size of the buffer the lexer reads a stream into, or
+	 *         zero when tokenizing a buffer in place
+	 */
+	size_t bufferSize() const { return buffer_.size(); }
+
 	/** @brief Parse the next sequence as a value.
 	 *
 	 *  During the next call to @tt next(), the lexer collects
@@ -37,6 +69,15 @@ namespace pistis {
 	 */
 	void parseNextAsQuotedString() { state_= AT_QT_STRING; }
 
+	/** @brief Skip the rest of the current line
+	 *
+	 *  The next call to @tt next() returns the first token of the
+	 *  following line.  Used to resume after a syntax error.
+	 *
+	 *  @returns The text skipped
+	 */
+	std::string skipLine();
+
 	/** @brief Read the next token from the input source.
 	 *
 	 *  @returns The next token from the input stream.
@@ -56,7 +97,8 @@ namespace pistis {
 	 *  @throws  Does not throw
 	 */
 	static bool isNameChar(char ch, char prev) {
-	  return isalnum(ch) || (ch == '_') || ((ch == '.') && isalnum(prev));
+	  return CharacterScanner::isAlnum(ch) || (ch == '_') ||
+	         ((ch == '.') && CharacterScanner::isAlnum(prev));
 	}
 
       protected:
@@ -117,20 +159,60 @@ namespace pistis {
 	 */
 	bool skipWhitespaceInLine_();
 
-	/** @brief Read the next line from the input stream.
+	/** @brief Read the next line from the input source.
 	 *
-	 *  @returns True if a line was read from input_; false if input_
+	 *  @returns True if a line was read; false if the input source
 	 *             has reached the end of file.
 	 */
 	bool readNextLine_();
 
+	/** @brief Locate the next line in the input source without
+	 *         changing the line number or state.
+	 *
+	 *  On success, lineBegin_ and lineEnd_ delimit the text of the
+	 *  line, excluding the terminating newline.
+	 *
+	 *  @returns True if a line was found; false at end of file.
+	 */
+	bool fetchLine_();
+
+	/** @brief Read the next chunk of the stream into the buffer,
+	 *         keeping the unread text in [next_, end_)
+	 *
+	 *  The unread text moves to the start of the buffer, which grows
+	 *  if the text already fills it.
+	 *
+	 *  @returns True if characters were read; false at the end of the
+	 *             stream or when tokenizing a buffer.
+	 */
+	bool readChunk_();
+
+	/** @brief Create a token whose value is the text in [begin, end).
+	 *
+	 *  When tokenizing a buffer, the token refers to the buffer
+	 *  directly.  When reading a stream, the current line is
+	 *  overwritten by later chunks, so the token gets its own copy.
+	 */
+	Token makeToken_(TokenType type, const char* begin, const char* end,
+			 int line, int column) const {
+	  if (input_) {
+	    return Token(type, std::string(begin, end), line, column);
+	  }
+	  return Token(type, begin, end, line, column);
+	}
+
       private:
-	std::istream& input_;
+	std::istream* input_; ///< Input stream, or null for a buffer
+	const char* next_; ///< Start of the next unread line in the buffer
+	const char* end_;  ///< End of the buffer
 	int line_;
 	int column_;
-	std::string text_;  ///< Text of current line
-	std::string::const_iterator current_; ///< Current position
+	std::vector<char> buffer_; ///< Chunks read from the stream
+	const char* lineBegin_; ///< Start of current line
+	const char* lineEnd_; ///< End of current line
+	const char* current_; ///< Current position
 	State state_; ///< Current state
+	const CharacterScanner& scanner_;
       };
 
     }
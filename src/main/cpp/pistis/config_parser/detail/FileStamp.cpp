@@ -0,0 +1,22 @@
+#include "FileStamp.hpp"
+#include <sys/stat.h>
+
+using namespace pistis::config_parser::detail;
+
+FileStamp::FileStamp():
+    device(0), inode(0), size(0), modifiedSeconds(0), modifiedNanoseconds(0) {
+  // Intentionally left blank
+}
+
+bool FileStamp::read(const std::string& path, FileStamp& stamp) {
+  struct stat info;
+  if (::stat(path.c_str(), &info) < 0) {
+    return false;
+  }
+  stamp.device= info.st_dev;
+  stamp.inode= info.st_ino;
+  stamp.size= info.st_size;
+  stamp.modifiedSeconds= info.st_mtim.tv_sec;
+  stamp.modifiedNanoseconds= info.st_mtim.tv_nsec;
+  return true;
+}
@@ -0,0 +1,47 @@
+#ifndef __PISTIS__CONFIG_PARSER__DETAIL__FILESTAMP_HPP__
+#define __PISTIS__CONFIG_PARSER__DETAIL__FILESTAMP_HPP__
+
+#include <string>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+
+      /** @brief Identity, size and modification time of a file
+       *
+       *  Two stamps of the same path are equal unless the file was
+       *  replaced, resized or modified in between (to the resolution of
+       *  the file system's timestamps).
+       */
+      struct FileStamp {
+	uint64_t device;
+	uint64_t inode;
+	int64_t size;
+	int64_t modifiedSeconds;
+	int64_t modifiedNanoseconds;
+
+	FileStamp();
+
+	/** @brief Stamp the file at @c path
+	 *
+	 *  Returns false, leaving @c stamp unchanged, if the file cannot
+	 *  be examined.
+	 */
+	static bool read(const std::string& path, FileStamp& stamp);
+
+	bool operator==(const FileStamp& other) const {
+	  return (device == other.device) && (inode == other.inode) &&
+		 (size == other.size) &&
+		 (modifiedSeconds == other.modifiedSeconds) &&
+		 (modifiedNanoseconds == other.modifiedNanoseconds);
+	}
+	bool operator!=(const FileStamp& other) const {
+	  return !(*this == other);
+	}
+      };
+
+    }
+  }
+}
+#endif
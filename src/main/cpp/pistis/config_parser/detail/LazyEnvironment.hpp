@@ -0,0 +1,52 @@
+#ifndef __PISTIS__CONFIG_PARSER__DETAIL__LAZYENVIRONMENT_HPP__
+#define __PISTIS__CONFIG_PARSER__DETAIL__LAZYENVIRONMENT_HPP__
+
+#include <pistis/config_parser/EnvironmentProvider.hpp>
+#include <pistis/config_parser/detail/ParsedValueCache.hpp>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+
+      /** @brief The environment one parse sees, snapshotted the first
+       *         time the parse looks up a variable
+       *
+       *  A parse and the parsers for its included files share one
+       *  LazyEnvironment, so they resolve variables from the same
+       *  snapshot, and a parse that refers to no variable never takes
+       *  one.  Any number of threads may look variables up at once.
+       */
+      class LazyEnvironment {
+      public:
+	LazyEnvironment(std::shared_ptr<EnvironmentProvider> provider):
+	    provider_(std::move(provider)), snapshot_() {
+	  // Intentionally left blank
+	}
+	LazyEnvironment(const LazyEnvironment&) = delete;
+
+	const EnvironmentSnapshot& snapshot() {
+	  return *snapshot_.get([this]() { return provider_->snapshot(); });
+	}
+
+	/** @brief The value of the variable @c name, or null if it is not
+	 *         defined
+	 */
+	const std::string* find(std::string_view name) {
+	  return snapshot().find(name);
+	}
+
+	LazyEnvironment& operator=(const LazyEnvironment&) = delete;
+
+      private:
+	std::shared_ptr<EnvironmentProvider> provider_;
+	CachedValue< std::shared_ptr<const EnvironmentSnapshot> > snapshot_;
+      };
+
+    }
+  }
+}
+#endif
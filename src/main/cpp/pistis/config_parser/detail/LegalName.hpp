@@ -0,0 +1,89 @@
+#ifndef __PISTIS__CONFIG_PARSER__DETAIL__LEGALNAME_HPP__
+#define __PISTIS__CONFIG_PARSER__DETAIL__LEGALNAME_HPP__
+
+#include <array>
+#include <string_view>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+
+      /** @brief Deterministic finite automaton that recognizes legal
+       *         property names
+       *
+       *  A legal name is one or more segments separated by periods.
+       *  Each segment is a nonempty run of ASCII letters, digits and
+       *  underscores, and the first segment must begin with a letter.
+       *  This is the language of the regular expression
+       *  "[A-Za-z][A-Za-z0-9_]*(\.[A-Za-z0-9_]+)*".
+       *
+       *  Everything here is constexpr, so names known at compile time
+       *  can be checked with static_assert.
+       */
+      namespace legal_name {
+
+	enum State : uint8_t {
+	  START,    ///< Nothing read yet
+	  SEGMENT,  ///< Inside a segment; the only accepting state
+	  PERIOD,   ///< Just read a period
+	  REJECT    ///< Not a legal name, whatever follows
+	};
+
+	enum CharClass : uint8_t {
+	  OTHER,
+	  LETTER,
+	  DIGIT_OR_UNDERSCORE,
+	  DOT
+	};
+
+	constexpr std::array<CharClass, 256> classifyCharacters() {
+	  std::array<CharClass, 256> classes{};
+	  for (int ch= 'A'; ch <= 'Z'; ++ch) {
+	    classes[ch]= LETTER;
+	    classes[ch + ('a' - 'A')]= LETTER;
+	  }
+	  for (int ch= '0'; ch <= '9'; ++ch) {
+	    classes[ch]= DIGIT_OR_UNDERSCORE;
+	  }
+	  classes['_']= DIGIT_OR_UNDERSCORE;
+	  classes['.']= DOT;
+	  return classes;
+	}
+
+	/** @brief Character class of each byte */
+	inline constexpr std::array<CharClass, 256> CHARACTER_CLASSES=
+	    classifyCharacters();
+
+	/** @brief Next state, indexed by current state and character
+	 *         class
+	 */
+	inline constexpr State TRANSITIONS[4][4]= {
+	  //              OTHER   LETTER   DIGIT_OR_UNDERSCORE  DOT
+	  /* START   */ { REJECT, SEGMENT, REJECT,              REJECT },
+	  /* SEGMENT */ { REJECT, SEGMENT, SEGMENT,             PERIOD },
+	  /* PERIOD  */ { REJECT, SEGMENT, SEGMENT,             REJECT },
+	  /* REJECT  */ { REJECT, REJECT,  REJECT,              REJECT }
+	};
+
+	constexpr State next(State state, char ch) {
+	  return TRANSITIONS[state][CHARACTER_CLASSES[(uint8_t)ch]];
+	}
+
+      }
+
+      /** @brief True if @c name is a legal property name */
+      constexpr bool isLegalName(std::string_view name) {
+	legal_name::State state= legal_name::START;
+	for (auto i= name.begin();
+	     (i != name.end()) && (state != legal_name::REJECT);
+	     ++i) {
+	  state= legal_name::next(state, *i);
+	}
+	return state == legal_name::SEGMENT;
+      }
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,43 @@
+#include "MemoryMappedFile.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser::detail;
+
+MemoryMappedFile::MemoryMappedFile(const std::string& filename):
+    data_(nullptr), size_(0), error_(0), mapped_(false) {
+  int fd= ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error_= errno;
+    return;
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) < 0) {
+    error_= errno;
+  } else if (!S_ISREG(info.st_mode)) {
+    // Leave unmapped so the caller reads it as a stream
+  } else if (!info.st_size) {
+    mapped_= true;
+  } else {
+    void* p= ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      error_= errno;
+    } else {
+      ::madvise(p, info.st_size, MADV_SEQUENTIAL);
+      data_= static_cast<const char*>(p);
+      size_= info.st_size;
+      mapped_= true;
+    }
+  }
+  ::close(fd);
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+  if (size_) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef __PISTIS__CONFIG_PARSER__DETAIL__MEMORYMAPPEDFILE_HPP__
+#define __PISTIS__CONFIG_PARSER__DETAIL__MEMORYMAPPEDFILE_HPP__
+
+#include <string>
+#include <stddef.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+
+      /** @brief Read-only memory mapping of an entire file
+       *
+       *  The file is mapped when the MemoryMappedFile is constructed and
+       *  unmapped when it is destroyed.  Only regular files are mapped.
+       *  Other kinds of files (pipes, character devices, etc.) are opened
+       *  successfully but not mapped, and callers should fall back to
+       *  reading them as a stream.
+       *
+       *  The mapping is not a copy.  If the file is truncated while it
+       *  is mapped, touching the pages past its new end raises SIGBUS,
+       *  so only map files that are replaced by rename(), never
+       *  rewritten in place.
+       */
+      class MemoryMappedFile {
+      public:
+	MemoryMappedFile(const std::string& filename);
+	MemoryMappedFile(const MemoryMappedFile&) = delete;
+	~MemoryMappedFile();
+
+	/** @brief The errno value from opening or mapping the file, or
+	 *         zero if no error occurred.
+	 */
+	int error() const { return error_; }
+
+	/** @brief True if the file's contents are available through
+	 *         begin() and end()
+	 *
+	 *  An empty regular file is considered mapped, even though
+	 *  begin() and end() are both null.
+	 */
+	bool isMapped() const { return mapped_; }
+
+	const char* begin() const { return data_; }
+	const char* end() const { return data_ + size_; }
+	size_t size() const { return size_; }
+
+	MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+      private:
+	const char* data_;
+	size_t size_;
+	int error_;
+	bool mapped_;
+      };
+
+    }
+  }
+}
+#endif
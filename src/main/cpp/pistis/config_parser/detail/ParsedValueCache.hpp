@@ -0,0 +1,88 @@
+#ifndef __PISTIS__CONFIG_PARSER__DETAIL__PARSEDVALUECACHE_HPP__
+#define __PISTIS__CONFIG_PARSER__DETAIL__PARSEDVALUECACHE_HPP__
+
+#include <pistis/util/NumUtil.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+
+      /** @brief A value that is computed the first time it is needed and
+       *         read without locking afterwards
+       *
+       *  Any number of threads may call get() at once.  One of them
+       *  computes the value while the others wait for it.  If the
+       *  computation throws, the value stays unset and the next caller
+       *  tries again.
+       */
+      template <typename T>
+      class CachedValue {
+      public:
+	CachedValue(): state_(EMPTY), value_() { }
+	CachedValue(const CachedValue&) = delete;
+
+	template <typename ComputeFn>
+	const T& get(const ComputeFn& compute) {
+	  int state= state_.load(std::memory_order_acquire);
+	  while (state != READY) {
+	    if ((state == EMPTY) &&
+		state_.compare_exchange_weak(state, BUSY,
+					     std::memory_order_acquire)) {
+	      try {
+		value_= compute();
+	      } catch(...) {
+		state_.store(EMPTY, std::memory_order_release);
+		throw;
+	      }
+	      state_.store(READY, std::memory_order_release);
+	      break;
+	    } else if (state == BUSY) {
+	      std::this_thread::yield();
+	    }
+	    state= state_.load(std::memory_order_acquire);
+	  }
+	  return value_;
+	}
+
+	CachedValue& operator=(const CachedValue&) = delete;
+
+      private:
+	enum { EMPTY, BUSY, READY };
+
+	std::atomic<int> state_;
+	T value_;
+      };
+
+      /** @brief Results of converting a property's value to other types
+       *
+       *  Conversions record the value and the conversion result, rather
+       *  than throwing, so values that fail to convert are cached too.
+       *  Lists are cached for the first separator they are requested
+       *  with.
+       */
+      struct ParsedValueCache {
+	typedef std::pair<int64_t, util::NumConversionResult> Int64Result;
+	typedef std::pair<double, util::NumConversionResult> DoubleResult;
+
+	struct SplitValue {
+	  std::string separator;
+	  std::vector<std::string> items;
+	};
+
+	CachedValue<Int64Result> int64;
+	CachedValue<DoubleResult> dbl;
+	CachedValue<SplitValue> split;
+	CachedValue< std::vector<Int64Result> > listOfInt64;
+	CachedValue< std::vector<DoubleResult> > listOfDouble;
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,164 @@
+#include "SegmentTrie.hpp"
+#include <algorithm>
+
+using namespace pistis::config_parser::detail;
+
+namespace {
+  /** @brief Returns the segment that starts at @c start and the position
+   *         of the "." that ends it, or npos if it is the last segment
+   */
+  std::pair<std::string_view, size_t> nextSegment(std::string_view name,
+						  size_t start) {
+    const size_t dot= name.find('.', start);
+    return std::make_pair(
+	name.substr(start, (dot == std::string_view::npos) ? dot
+							   : dot - start),
+	dot
+    );
+  }
+}
+
+const size_t SegmentTrie::NONE;
+
+SegmentTrie::SegmentTrie(): nodes_(1), segments_(), size_(0) {
+  // Intentionally left blank
+}
+
+void SegmentTrie::reserve(size_t numNodes) {
+  nodes_.reserve(numNodes + 1);  // Plus the root
+}
+
+size_t SegmentTrie::nodesAdded(std::string_view previous,
+			       std::string_view name) {
+  size_t common= 0;
+  while ((common < previous.size()) && (common < name.size()) &&
+	 (previous[common] == name[common])) {
+    ++common;
+  }
+
+  // Segments wholly inside the common prefix are already present
+  size_t start= 0;
+  if (common) {
+    const size_t dot= name.rfind('.', common - 1);
+    start= (dot == std::string_view::npos) ? 0 : dot + 1;
+  }
+  return 1 + std::count(name.begin() + start, name.end(), '.');
+}
+
+void SegmentTrie::insert(std::string_view name, size_t value) {
+  size_t node= 0;
+  size_t start= 0;
+
+  while (true) {
+    auto segment= nextSegment(name, start);
+    nodes_[node].first= std::min(nodes_[node].first, value);
+    nodes_[node].last= std::max(nodes_[node].last, value + 1);
+    node= addChild_(node, segment.first);
+    if (segment.second == std::string_view::npos) {
+      break;
+    }
+    start= segment.second + 1;
+  }
+
+  if (nodes_[node].value == NONE) {
+    ++size_;
+  }
+  nodes_[node].value= value;
+}
+
+size_t SegmentTrie::find(std::string_view name) const {
+  const size_t node= findNode_(name);
+  return (node == NONE) ? NONE : nodes_[node].value;
+}
+
+std::pair<size_t, size_t> SegmentTrie::rangeUnder(
+    std::string_view blockName
+) const {
+  const size_t node= findNode_(blockName);
+  if ((node == NONE) || (nodes_[node].first == NONE)) {
+    return std::make_pair((size_t)0, (size_t)0);
+  }
+  return std::make_pair(nodes_[node].first, nodes_[node].last);
+}
+
+size_t SegmentTrie::shortestPrefixOf(std::string_view name) const {
+  size_t node= 0;
+  size_t start= 0;
+
+  while (true) {
+    auto segment= nextSegment(name, start);
+
+    // Names ending at a child of this node are prefixes of name when
+    // their last segment is a prefix of this segment.  Check them from
+    // shortest to longest.
+    for (size_t n= 0; n <= segment.first.size(); ++n) {
+      const size_t child= findChild_(node, segment.first.substr(0, n));
+      if ((child != NONE) && (nodes_[child].value != NONE)) {
+	return start + n;
+      }
+    }
+
+    if (segment.second == std::string_view::npos) {
+      return NONE;
+    }
+    node= findChild_(node, segment.first);
+    if (node == NONE) {
+      return NONE;
+    }
+    start= segment.second + 1;
+  }
+}
+
+void SegmentTrie::clear() {
+  nodes_.assign(1, Node());
+  segments_.clear();
+  size_= 0;
+}
+
+std::vector<SegmentTrie::Child>::const_iterator SegmentTrie::lowerBound_(
+    const std::vector<Child>& children, std::string_view segment
+) const {
+  return std::lower_bound(children.begin(), children.end(), segment,
+			  [this](const Child& c, std::string_view s) {
+			    return segment_(c) < s;
+			  });
+}
+
+size_t SegmentTrie::findChild_(size_t node,
+			       std::string_view segment) const {
+  const std::vector<Child>& children= nodes_[node].children;
+  auto i= lowerBound_(children, segment);
+  return ((i != children.end()) && (segment_(*i) == segment)) ? i->node
+							      : NONE;
+}
+
+size_t SegmentTrie::addChild_(size_t node, std::string_view segment) {
+  std::vector<Child>& children= nodes_[node].children;
+  auto i= lowerBound_(children, segment);
+  if ((i != children.end()) && (segment_(*i) == segment)) {
+    return i->node;
+  }
+
+  const size_t child= nodes_.size();
+  children.insert(
+      children.begin() + (i - children.begin()),
+      Child{ (uint32_t)segments_.size(), (uint32_t)segment.size(), child }
+  );
+  segments_.append(segment);
+  nodes_.push_back(Node());  // Invalidates children
+  return child;
+}
+
+size_t SegmentTrie::findNode_(std::string_view name) const {
+  size_t node= 0;
+  size_t start= 0;
+
+  while (true) {
+    auto segment= nextSegment(name, start);
+    node= findChild_(node, segment.first);
+    if ((node == NONE) || (segment.second == std::string_view::npos)) {
+      return node;
+    }
+    start= segment.second + 1;
+  }
+}
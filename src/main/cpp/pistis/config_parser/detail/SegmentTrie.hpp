@@ -0,0 +1,130 @@
+#ifndef __PISTIS__CONFIG_PARSER__DETAIL__SEGMENTTRIE_HPP__
+#define __PISTIS__CONFIG_PARSER__DETAIL__SEGMENTTRIE_HPP__
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+
+      /** @brief Trie of property names keyed on their "."-separated
+       *         segments
+       *
+       *  Each name in the trie carries a value.  The trie is laid out
+       *  like the blocks in a configuration file: the node for "a.b" is
+       *  the child "b" of the node for "a", and the properties in block
+       *  "a.b" are the descendants of that node.
+       *
+       *  When names are inserted in sorted order with increasing values
+       *  (for example, their indices in a sorted array), the values of
+       *  all names in a block form a contiguous range, which
+       *  rangeUnder() returns without visiting the names themselves.
+       *
+       *  The segments are copied into one buffer owned by the trie, so
+       *  a name adds no allocations of its own.
+       */
+      class SegmentTrie {
+      public:
+	static const size_t NONE= (size_t)-1;
+
+      public:
+	SegmentTrie();
+
+	/** @brief Number of names in the trie */
+	size_t size() const { return size_; }
+	bool empty() const { return !size_; }
+
+	/** @brief Make room for @c numNodes nodes before inserting names */
+	void reserve(size_t numNodes);
+
+	/** @brief Number of nodes inserting @c name adds once
+	 *         @c previous, the name before it in sorted order, is
+	 *         already in the trie.
+	 *
+	 *  May overestimate when one name is a prefix of another, which
+	 *  is harmless when sizing reserve().
+	 */
+	static size_t nodesAdded(std::string_view previous,
+				 std::string_view name);
+
+	/** @brief Add @c name with @c value, replacing the value if
+	 *         @c name is already present
+	 */
+	void insert(std::string_view name, size_t value);
+
+	/** @brief Returns the value for @c name, or NONE if @c name is
+	 *         not in the trie.
+	 */
+	size_t find(std::string_view name) const;
+
+	/** @brief Returns [first, last) such that the values of all
+	 *         names beginning with blockName + "." lie in that range.
+	 *
+	 *  The range is empty if no names begin with blockName + ".".
+	 *  It contains only those names if values were inserted in the
+	 *  sorted order of their names.
+	 */
+	std::pair<size_t, size_t> rangeUnder(std::string_view blockName) const;
+
+	/** @brief Returns the length of the shortest name in the trie
+	 *         that is a prefix of @c name, or NONE if there is none.
+	 *
+	 *  "Prefix" has its plain string meaning: "ab", "abc." and
+	 *  "abc.d" are all prefixes of "abc.de".  The cost depends on the
+	 *  length of @c name, not on the number of names in the trie.
+	 */
+	size_t shortestPrefixOf(std::string_view name) const;
+
+	void clear();
+
+      private:
+	/** @brief A segment, stored in segments_, and the node it leads
+	 *         to
+	 */
+	struct Child {
+	  uint32_t offset;
+	  uint32_t length;
+	  size_t node;
+	};
+
+	struct Node {
+	  /** @brief Child nodes, sorted by segment */
+	  std::vector<Child> children;
+
+	  /** @brief Value of the name that ends at this node, or NONE */
+	  size_t value;
+
+	  /** @brief Range of values of the descendants of this node */
+	  size_t first;
+	  size_t last;
+
+	  Node(): children(), value(NONE), first(NONE), last(0) { }
+	};
+
+	std::string_view segment_(const Child& child) const {
+	  return std::string_view(segments_.data() + child.offset,
+				  child.length);
+	}
+	std::vector<Child>::const_iterator lowerBound_(
+	    const std::vector<Child>& children, std::string_view segment
+	) const;
+	size_t findChild_(size_t node, std::string_view segment) const;
+	size_t addChild_(size_t node, std::string_view segment);
+	size_t findNode_(std::string_view name) const;
+
+	std::vector<Node> nodes_;
+
+	/** @brief Text of every segment in the trie, end to end */
+	std::string segments_;
+	size_t size_;
+      };
+
+    }
+  }
+}
+#endif
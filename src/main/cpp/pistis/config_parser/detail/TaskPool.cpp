@@ -0,0 +1,95 @@
+#include "TaskPool.hpp"
+
+using namespace pistis::config_parser::detail;
+
+TaskPool::Task::Task(std::function<void ()>&& fn):
+    fn_(std::move(fn)), state_(PENDING), mutex_(), finished_() {
+  // Intentionally left blank
+}
+
+TaskPool::TaskPool(size_t numThreads):
+    mutex_(), ready_(), queue_(), stopping_(false), threads_() {
+  threads_.reserve(numThreads);
+  for (size_t i= 0; i < numThreads; ++i) {
+    threads_.emplace_back([this]() { work_(); });
+  }
+}
+
+TaskPool::~TaskPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stopping_= true;
+  }
+  ready_.notify_all();
+  for (auto i= threads_.begin(); i != threads_.end(); ++i) {
+    i->join();
+  }
+
+  // With no worker threads, queued tasks would never run
+  while (!queue_.empty()) {
+    std::shared_ptr<Task> task= std::move(queue_.front());
+    queue_.pop_front();
+    run_(*task);
+  }
+}
+
+std::shared_ptr<TaskPool::Task> TaskPool::submit(std::function<void ()> fn) {
+  std::shared_ptr<Task> task= std::make_shared<Task>(std::move(fn));
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push_back(task);
+  }
+  ready_.notify_one();
+  return task;
+}
+
+void TaskPool::wait(Task& task) {
+  if (!run_(task)) {
+    std::unique_lock<std::mutex> lock(task.mutex_);
+    task.finished_.wait(lock, [&task]() { return task.done(); });
+  }
+}
+
+void TaskPool::cancel(Task& task) {
+  int state= Task::PENDING;
+  if (task.state_.compare_exchange_strong(state, Task::RUNNING)) {
+    finish_(task);
+  }
+}
+
+bool TaskPool::run_(Task& task) {
+  int state= Task::PENDING;
+  if (!task.state_.compare_exchange_strong(state, Task::RUNNING)) {
+    return false;
+  }
+  task.fn_();
+  finish_(task);
+  return true;
+}
+
+void TaskPool::finish_(Task& task) {
+  // Release whatever the task captured now, rather than when the last
+  // reference to it goes away
+  task.fn_= nullptr;
+  {
+    std::unique_lock<std::mutex> lock(task.mutex_);
+    task.state_.store(Task::DONE);
+  }
+  task.finished_.notify_all();
+}
+
+void TaskPool::work_() {
+  while (true) {
+    std::shared_ptr<Task> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+	return;
+      }
+      task= std::move(queue_.front());
+      queue_.pop_front();
+    }
+    run_(*task);
+  }
+}
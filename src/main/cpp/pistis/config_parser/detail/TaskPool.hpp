@@ -0,0 +1,97 @@
+#ifndef __PISTIS__CONFIG_PARSER__DETAIL__TASKPOOL_HPP__
+#define __PISTIS__CONFIG_PARSER__DETAIL__TASKPOOL_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+
+      /** @brief Runs tasks on a fixed set of worker threads
+       *
+       *  A thread that waits for a task that has not started yet runs
+       *  the task itself instead of blocking.  Tasks may therefore
+       *  submit and wait for other tasks without deadlocking the pool,
+       *  however many of them are outstanding.
+       *
+       *  Destroying the pool runs every task still in its queue, then
+       *  joins the worker threads.
+       */
+      class TaskPool {
+      public:
+	class Task {
+	public:
+	  Task(std::function<void ()>&& fn);
+	  Task(const Task&) = delete;
+
+	  /** @brief True once the task has run or been cancelled */
+	  bool done() const { return state_.load() == DONE; }
+
+	  Task& operator=(const Task&) = delete;
+
+	private:
+	  enum { PENDING, RUNNING, DONE };
+
+	  std::function<void ()> fn_;
+	  std::atomic<int> state_;
+	  std::mutex mutex_;
+	  std::condition_variable finished_;
+
+	  friend class TaskPool;
+	};
+
+      public:
+	explicit TaskPool(size_t numThreads);
+	TaskPool(const TaskPool&) = delete;
+	~TaskPool();
+
+	size_t numThreads() const { return threads_.size(); }
+
+	/** @brief Queue @c fn to run on a worker thread
+	 *
+	 *  @c fn must not throw.  Tasks that can fail should catch their
+	 *  exceptions and hand them to whoever waits for them.
+	 */
+	std::shared_ptr<Task> submit(std::function<void ()> fn);
+
+	/** @brief Wait for @c task to finish, running it on this thread
+	 *         if no worker has started it
+	 */
+	void wait(Task& task);
+
+	/** @brief Keep @c task from running if it has not started yet
+	 *
+	 *  Has no effect on a task that is running or done.
+	 */
+	void cancel(Task& task);
+
+	TaskPool& operator=(const TaskPool&) = delete;
+
+      private:
+	/** @brief Run @c task unless another thread already has
+	 *
+	 *  Returns false if the task was already started or cancelled.
+	 */
+	bool run_(Task& task);
+	void finish_(Task& task);
+	void work_();
+
+	std::mutex mutex_;
+	std::condition_variable ready_;
+	std::deque< std::shared_ptr<Task> > queue_;
+	bool stopping_;
+	std::vector<std::thread> threads_;
+      };
+
+    }
+  }
+}
+#endif
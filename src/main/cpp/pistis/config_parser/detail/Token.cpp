@@ -3,20 +3,54 @@
 using namespace pistis::config_parser::detail;
 
 Token::Token(TokenType type, const std::string& value, int line, int column):
-    type_(type), value_(value), line_(line), column_(column) {
+    type_(type), text_(value), value_(text_), line_(line), column_(column),
+    owned_(true) {
+  // Intentionally left blank
+}
+
+Token::Token(TokenType type, std::string&& value, int line, int column):
+    type_(type), text_(std::move(value)), value_(text_), line_(line),
+    column_(column), owned_(true) {
+  // Intentionally left blank
+}
+
+Token::Token(TokenType type, const char* begin, const char* end, int line,
+	     int column):
+    type_(type), text_(), value_(begin, end - begin), line_(line),
+    column_(column), owned_(false) {
   // Intentionally left blank
 }
 
 Token::Token(const Token& other):
-    type_(other.type_), value_(other.value_), line_(other.line_),
-    column_(other.column_) {
+    type_(other.type_), text_(other.text_),
+    value_(other.owned_ ? std::string_view(text_) : other.value_),
+    line_(other.line_), column_(other.column_), owned_(other.owned_) {
+  // Intentionally left blank
+}
+
+Token::Token(Token&& other):
+    type_(other.type_), text_(std::move(other.text_)),
+    value_(other.owned_ ? std::string_view(text_) : other.value_),
+    line_(other.line_), column_(other.column_), owned_(other.owned_) {
   // Intentionally left blank
 }
 
 Token& Token::operator=(const Token& other) {
   type_= other.type();
-  value_= other.value_;
+  text_= other.text_;
+  value_= other.owned_ ? std::string_view(text_) : other.value_;
+  line_= other.line();
+  column_= other.column();
+  owned_= other.owned_;
+  return *this;
+}
+
+Token& Token::operator=(Token&& other) {
+  type_= other.type();
+  text_= std::move(other.text_);
+  value_= other.owned_ ? std::string_view(text_) : other.value_;
   line_= other.line();
   column_= other.column();
+  owned_= other.owned_;
   return *this;
 }
@@ -4,23 +4,49 @@
 #include <pistis/config_parser/detail/TokenType.hpp>
 #include <iostream>
 #include <string>
+#include <string_view>
 
 namespace pistis {
   namespace config_parser {
     namespace detail {
 
-      /** @brief Token from a configuration file */
+      /** @brief Token from a configuration file
+       *
+       *  A token either owns a copy of its text or refers to a span of
+       *  characters in the lexer's source buffer.  Spans avoid an
+       *  allocation per token, but are only valid while the source
+       *  buffer is.  Copying a token that owns its text copies the
+       *  text; copying a span copies only the span.
+       */
       class Token {
       public:
+	/** @brief Create a token that owns a copy of @c value */
 	Token(TokenType type, const std::string& value, int line, int column);
+
+	/** @brief Create a token that takes ownership of @c value */
+	Token(TokenType type, std::string&& value, int line, int column);
+
+	/** @brief Create a token that refers to the characters in
+	 *         [begin, end) without copying them.
+	 */
+	Token(TokenType type, const char* begin, const char* end, int line,
+	      int column);
+
 	Token(const Token& other);
+	Token(Token&& other);
 
 	TokenType type() const { return type_; }
-	const std::string& value() const { return value_; }
+	std::string_view value() const { return value_; }
 	int line() const { return line_; }
 	int column() const { return column_; }
 
+	/** @brief True if the token owns its text, false if it refers to
+	 *         the source buffer
+	 */
+	bool ownsValue() const { return owned_; }
+
 	Token& operator=(const Token& other);
+	Token& operator=(Token&& other);
 	bool operator==(const Token& other) const {
 	  return (type() == other.type()) && (value() == other.value()) &&
   	         (line() == other.line()) && (column() == other.column());
@@ -32,9 +58,11 @@ namespace pistis {
 
       private:
 	TokenType type_;
-	std::string value_;
+	std::string text_; ///< Storage for the value when the token owns it
+	std::string_view value_;
 	int line_;
 	int column_;
+	bool owned_;
       };
 
       inline std::ostream& operator<<(std::ostream& out, const Token& t) {
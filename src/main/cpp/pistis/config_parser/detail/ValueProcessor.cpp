@@ -4,13 +4,16 @@
 #include <iomanip>
 #include <sstream>
 #include <stdlib.h>
+#include <string.h>
 
 using namespace pistis::config_parser;
 using namespace pistis::config_parser::detail;
 
 ValueProcessor::ValueProcessor(const ConfigurationPropertyMap& properties,
 			       bool useEnvironmentVars):
-    properties_(properties), useEnvVars_(useEnvironmentVars) {
+    properties_(properties), useEnvVars_(useEnvironmentVars),
+    environment_(nullptr), references_(nullptr),
+    scanner_(CharacterScanner::instance()) {
   // Intentionally left blank
 }
 
@@ -18,17 +21,59 @@ ValueProcessor::~ValueProcessor() {
   // Intentionally left blank
 }
 
-std::string ValueProcessor::processValue(const std::string& value) {
-  std::string::const_iterator i = value.begin();
-  std::string::const_iterator j;
-  int state = 1;
+std::string ValueProcessor::processValue(std::string_view value) {
+  const char* const end = value.data() + value.size();
+
+  // Most values have no escapes or references, and come back unchanged
+  // up to the first null character, if any.  The scanner finds them in
+  // one pass, where the state machine in translate_() spends several
+  // branches on each character.
+  if (value.empty()) {
+    return std::string();
+  } else if (scanner_.findEither(value.data(), end, '$', '\\') == end) {
+    const char* const nul=
+        static_cast<const char*>(::memchr(value.data(), 0, value.size()));
+    return std::string(value.data(), nul ? nul : end);
+  }
+
   std::string prepared;
+  prepared.reserve(value.size());
+  translate_(value, prepared, nullptr);
+  return prepared;
+}
+
+ValueTemplate ValueProcessor::compile(std::string_view value) {
+  ValueTemplate compiled;
+  std::string literal;
+  literal.reserve(value.size());
+  translate_(value, literal, &compiled);
+  compiled.appendLiteral(literal);
+  return compiled;
+}
+
+std::string ValueProcessor::evaluate(const ValueTemplate& compiled) {
+  std::string value;
+  value.reserve(compiled.sizeHint());
+  value += compiled.literal(0);
+  for (size_t i= 0; i < compiled.numReferences(); ++i) {
+    value += resolveVariable_(compiled.name(i));
+    value += compiled.literal(i + 1);
+  }
+  return value;
+}
+
+void ValueProcessor::translate_(std::string_view value,
+				std::string& prepared,
+				ValueTemplate* compiled) {
+  const char* i = value.data();
+  const char* const end = value.data() + value.size();
+  const char* j = nullptr;
+  int state = 1;
   unsigned int unicodeChar;
   bool nameIsLegal;
 
-  prepared.reserve(value.size());
   while (state) {
-    char ch= (i != value.end()) ? *i : 0;
+    char ch= (i != end) ? *i : 0;
     switch (state) {
       case 0:
         // Reached the end of the input
@@ -126,13 +171,20 @@ std::string ValueProcessor::processValue(const std::string& value) {
 	      "Incomplete property reference \"${" + std::string(j,i) + "\""
 	  );
 	} else if (ch == '}') {
-	  std::string name(j, i);
+	  std::string_view name(j, i - j);
 	  if (!nameIsLegal) {
 	    throw PropertyFormatError(
-	        "\"${" + name + "}\" does not contain a legal property name"
+	        "\"${" + std::string(name) +
+		"}\" does not contain a legal property name"
 	    );
 	  }
-	  prepared += resolveVariable_(name);
+	  if (compiled) {
+	    compiled->appendLiteral(prepared);
+	    compiled->appendReference(name);
+	    prepared.clear();
+	  } else {
+	    prepared += resolveVariable_(name);
+	  }
 	  state = 1;
 	  ++i;
 	} else {
@@ -240,20 +292,41 @@ std::string ValueProcessor::processValue(const std::string& value) {
 	throw PropertyFormatError("Illegal state while preparing value");
     }
   }
-  return prepared;
 }
 
-std::string ValueProcessor::resolveVariable_(const std::string& name) {
-  if (properties().hasKey(name)) {
-    return properties()[name].value();
+std::string ValueProcessor::resolveVariable_(std::string_view name) {
+  const ConfigurationProperty* p= properties().find(name);
+  if (p) {
+    if (references_) {
+      references_->push_back(
+	  VariableReference{ std::string(name), p->value(), false }
+      );
+    }
+    return p->value();
+  } else if (usesEnvironmentVars() && environment_) {
+    const std::string* envValue= environment_->find(name);
+    if (envValue) {
+      if (references_) {
+	references_->push_back(
+	    VariableReference{ std::string(name), *envValue, true }
+	);
+      }
+      return *envValue;
+    }
   } else if (usesEnvironmentVars()) {
-    const char* envValue= getenv(name.c_str());
+    // getenv() needs a null-terminated name
+    const char* envValue= getenv(std::string(name).c_str());
     if (envValue) {
+      if (references_) {
+	references_->push_back(
+	    VariableReference{ std::string(name), envValue, true }
+	);
+      }
       return std::string(envValue);
     }
   }
   throw PropertyFormatError(
-      "Cannot resolve referenced property \"${" + name + "}\""
+      "Cannot resolve referenced property \"${" + std::string(name) + "}\""
   );
 }
 
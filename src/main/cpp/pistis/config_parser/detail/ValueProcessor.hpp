@@ -2,11 +2,29 @@
 #define __PISTIS__CONFIG_PARSER__DETAIL__VALUEPROCESSOR_HPP__
 
 #include <pistis/config_parser/ConfigurationPropertyMap.hpp>
+#include <pistis/config_parser/detail/CharacterScanner.hpp>
+#include <pistis/config_parser/detail/LazyEnvironment.hpp>
+#include <pistis/config_parser/detail/ValueTemplate.hpp>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace pistis {
   namespace config_parser {
     namespace detail {
+
+      /** @brief A variable substituted into a property value, and the
+       *         value it had
+       */
+      struct VariableReference {
+	std::string name;
+	std::string value;
+
+	/** @brief True if the variable named an environment variable
+	 *         rather than a property
+	 */
+	bool fromEnvironment;
+      };
 	
       /** @brief Replaces escape sequences and performs variable
        *         substitution in a configuration file property value
@@ -23,10 +41,49 @@ namespace pistis {
 	bool usesEnvironmentVars() const { return useEnvVars_; }
 	void setUseEnvironmentVars(bool v) { useEnvVars_ = v; }
 
-	virtual std::string processValue(const std::string& text);
+	/** @brief Where to look up environment variables, or null (the
+	 *         default) to call getenv() for each one
+	 */
+	LazyEnvironment* environment() const { return environment_; }
+	void setEnvironment(LazyEnvironment* e) { environment_= e; }
+
+	/** @brief Where to append the variables processValue() resolves, or
+	 *         null (the default) to not record them
+	 */
+	std::vector<VariableReference>* references() const {
+	  return references_;
+	}
+	void setReferences(std::vector<VariableReference>* r) {
+	  references_= r;
+	}
+
+	/** @brief Replace the escape sequences and variable references in
+	 *         @c text
+	 *
+	 *  A value with neither is found with CharacterScanner and
+	 *  returned after one scan and one copy.
+	 */
+	virtual std::string processValue(std::string_view text);
+
+	/** @brief Decode the escape sequences in @c text and compile it
+	 *         into a template, without resolving its variables
+	 *
+	 *  Throws PropertyFormatError if @c text is malformed, just as
+	 *  processValue() would.
+	 */
+	ValueTemplate compile(std::string_view text);
+
+	/** @brief Substitute the current values of the variables
+	 *         @c compiled references
+	 *
+	 *  Gives the same result as processValue() on the text
+	 *  @c compiled was compiled from, and records the variables it
+	 *  resolves the same way.
+	 */
+	std::string evaluate(const ValueTemplate& compiled);
 
       protected:
-	virtual std::string resolveVariable_(const std::string& name);
+	virtual std::string resolveVariable_(std::string_view name);
 	static void encodeUtf8_(unsigned int unicodeChar, std::string& output);
 	static bool isHexDigit_(char ch) {
 	  return ((ch >= '0') && (ch <= '9')) ||
@@ -35,9 +92,22 @@ namespace pistis {
 	}
 	static unsigned int hexValue_(char ch);
 
+	/** @brief Append @c value to @c prepared with its escape sequences
+	 *         decoded and its variables substituted
+	 *
+	 *  If @c compiled is not null, the variables are appended to it
+	 *  instead of being resolved, along with the text before each.
+	 *  @c prepared then holds the text after the last one.
+	 */
+	void translate_(std::string_view value, std::string& prepared,
+			ValueTemplate* compiled);
+
       private:
 	const ConfigurationPropertyMap& properties_;
 	bool useEnvVars_;
+	LazyEnvironment* environment_;
+	std::vector<VariableReference>* references_;
+	const CharacterScanner& scanner_;
       };
 
     }
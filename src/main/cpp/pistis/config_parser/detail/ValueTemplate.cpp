@@ -0,0 +1,24 @@
+#include "ValueTemplate.hpp"
+
+using namespace pistis::config_parser::detail;
+
+ValueTemplate::ValueTemplate():
+    literals_(1), names_(), literalSize_(0), sizeHint_(0) {
+  // Intentionally left blank
+}
+
+ValueTemplate::~ValueTemplate() {
+  // Intentionally left blank
+}
+
+void ValueTemplate::appendLiteral(std::string_view text) {
+  literals_.back().append(text.data(), text.size());
+  literalSize_ += text.size();
+  sizeHint_ += text.size();
+}
+
+void ValueTemplate::appendReference(std::string_view name) {
+  names_.emplace_back(name);
+  literals_.emplace_back();
+  sizeHint_ += name.size() + 3;
+}
@@ -0,0 +1,86 @@
+#ifndef __PISTIS__CONFIG_PARSER__DETAIL__VALUETEMPLATE_HPP__
+#define __PISTIS__CONFIG_PARSER__DETAIL__VALUETEMPLATE_HPP__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stddef.h>
+
+namespace pistis {
+  namespace config_parser {
+    namespace detail {
+
+      /** @brief A property value compiled into literal text and the
+       *         variables substituted between it
+       *
+       *  The literal text has its escape sequences decoded already, so
+       *  evaluating the template again after a variable changes only
+       *  concatenates the literals with the variables' new values.
+       *  ValueProcessor::compile() creates templates and
+       *  ValueProcessor::evaluate() evaluates them.
+       *
+       *  A template with n references has n + 1 literals, some of which
+       *  may be empty.  Literal i comes just before reference i.
+       */
+      class ValueTemplate {
+      public:
+	/** @brief Template for the empty value */
+	ValueTemplate();
+	ValueTemplate(const ValueTemplate&) = default;
+	ValueTemplate(ValueTemplate&&) = default;
+	~ValueTemplate();
+
+	/** @brief Number of variables the template references */
+	size_t numReferences() const { return names_.size(); }
+
+	/** @brief True if the template references no variables */
+	bool isConstant() const { return names_.empty(); }
+
+	/** @brief The literal text before reference @c i, or after the
+	 *         last reference if @c i is numReferences()
+	 */
+	const std::string& literal(size_t i) const { return literals_[i]; }
+
+	/** @brief Name of the variable at reference @c i */
+	const std::string& name(size_t i) const { return names_[i]; }
+
+	/** @brief Total length of the literal text */
+	size_t literalSize() const { return literalSize_; }
+
+	/** @brief Length of the value if each variable's value were as
+	 *         long as the "${name}" that references it
+	 *
+	 *  This is about as long as the text the template was compiled
+	 *  from, and a good guess at how much space evaluating it needs.
+	 */
+	size_t sizeHint() const { return sizeHint_; }
+
+	/** @brief Append @c text to the last literal */
+	void appendLiteral(std::string_view text);
+
+	/** @brief Append a reference to the variable @c name, followed by
+	 *         an empty literal
+	 */
+	void appendReference(std::string_view name);
+
+	ValueTemplate& operator=(const ValueTemplate&) = default;
+	ValueTemplate& operator=(ValueTemplate&&) = default;
+
+	bool operator==(const ValueTemplate& other) const {
+	  return (literals_ == other.literals_) && (names_ == other.names_);
+	}
+	bool operator!=(const ValueTemplate& other) const {
+	  return !(*this == other);
+	}
+
+      private:
+	std::vector<std::string> literals_;
+	std::vector<std::string> names_;
+	size_t literalSize_;
+	size_t sizeHint_;
+      };
+
+    }
+  }
+}
+#endif
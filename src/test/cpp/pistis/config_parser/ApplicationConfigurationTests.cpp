@@ -6,6 +6,7 @@
 #include <pistis/typeutil/Enum.hpp>
 #include <pistis/util/StringUtil.hpp>
 #include <pistis/config_parser/ApplicationConfiguration.hpp>
+#include <pistis/config_parser/ConfigFileParseError.hpp>
 #include <pistis/config_parser/InvalidPropertyValueError.hpp>
 #include <pistis/config_parser/PropertyFormatError.hpp>
 #include <pistis/config_parser/RequiredPropertyMissingError.hpp>
@@ -491,6 +492,103 @@ TEST(ApplicationConfigurationTests, UnknownProperties) {
 	       UnknownPropertyError);
 }
 
+TEST(ApplicationConfigurationTests, LoadStreaming) {
+  TestAppConfig truth(false);
+  TestAppConfig appConfig(false);
+
+  truth.load(resourceDir() + "test_app_config.cfg");
+  appConfig.loadStreaming(resourceDir() + "test_app_config.cfg");
+
+  EXPECT_EQ(appConfig.intValue(), truth.intValue());
+  EXPECT_EQ(appConfig.doubleValue(), truth.doubleValue());
+  EXPECT_EQ(appConfig.strValue(), truth.strValue());
+  EXPECT_EQ(appConfig.enumValue(), truth.enumValue());
+  EXPECT_EQ(appConfig.fmtValue(), truth.fmtValue());
+  EXPECT_EQ(appConfig.intList(), truth.intList());
+  EXPECT_EQ(appConfig.strSetInSet(), truth.strSetInSet());
+  EXPECT_EQ(appConfig.intPrefixList(), truth.intPrefixList());
+  EXPECT_EQ(appConfig.enumPrefixList(), truth.enumPrefixList());
+  EXPECT_EQ(appConfig.strPrefixSetInRange(), truth.strPrefixSetInRange());
+
+  TestAppConfig fromText(false);
+  fromText.loadStreamingFromText("test", "int.single= 7\nstr.single= q\n");
+  EXPECT_EQ(fromText.intValue(), 7);
+  EXPECT_EQ(fromText.strValue(), "q");
+
+  TestAppConfig unknownForbidden(false);
+  TestAppConfig unknownIgnored(true);
+  unknownIgnored.loadStreaming(resourceDir() + "unknown_properties.cfg");
+  EXPECT_EQ(unknownIgnored.strValue(), "abc");
+  EXPECT_THROW(
+      unknownForbidden.loadStreaming(resourceDir() + "unknown_properties.cfg"),
+      UnknownPropertyError
+  );
+  EXPECT_THROW(
+      appConfig.loadStreamingFromText("test", "str.single= q\n"),
+      RequiredPropertyMissingError
+  );
+}
+
+TEST(ApplicationConfigurationTests, LoadReportingAllErrors) {
+  const std::string TEXT=
+      "str.single= q\n"
+      "int.list= 1, x\n"
+      "bogus= 1\n"
+      "also.bogus= 2\n"
+      "double.single 0.5\n";
+  TestAppConfig config(false);
+  ApplicationConfigurationErrorList errors;
+
+  config.loadFromText("test", TEXT, errors);
+  EXPECT_EQ(config.strValue(), "q");
+
+  int parseErrors= 0;
+  int unknown= 0;
+  int invalid= 0;
+  int missing= 0;
+  for (auto i= errors.begin(); i != errors.end(); ++i) {
+    const ApplicationConfigurationError* e= i->get();
+    parseErrors += dynamic_cast<const ConfigFileParseError*>(e) ? 1 : 0;
+    unknown += dynamic_cast<const UnknownPropertyError*>(e) ? 1 : 0;
+    invalid += dynamic_cast<const InvalidPropertyValueError*>(e) ? 1 : 0;
+    missing += dynamic_cast<const RequiredPropertyMissingError*>(e) ? 1 : 0;
+  }
+  EXPECT_EQ(errors.size(), 5);
+  EXPECT_EQ(parseErrors, 1);
+  EXPECT_EQ(unknown, 2);
+  EXPECT_EQ(invalid, 1);
+  EXPECT_EQ(missing, 1);
+
+  errors.clear();
+  config.load(resourceDir() + "test_app_config.cfg", errors);
+  EXPECT_TRUE(errors.empty());
+  EXPECT_EQ(config.intValue(), 15);
+  ASSERT_EQ(config.inputFiles().size(), 1);
+  EXPECT_EQ(config.inputFiles()[0], resourceDir() + "test_app_config.cfg");
+}
+
+TEST(ApplicationConfigurationTests, LoadWithDeferredReferences) {
+  const std::string TEXT=
+      "str.single= ${base}/x\n"
+      "int.single= ${int.base}\n"
+      "int.base= 12\n"
+      "base= abc\n"
+      "unknown= ${missing}\n";
+  TestAppConfig config(true);
+
+  // In order, the forward references cannot be resolved
+  EXPECT_THROW(config.loadFromText("test", TEXT), ConfigFileParseError);
+
+  // Lazily, the unknown property's missing reference is never resolved
+  config.setReferenceResolution(ConfigFileParser::RESOLVE_LAZY);
+  config.loadFromText("test", TEXT);
+  EXPECT_EQ(config.strValue(), "abc/x");
+  EXPECT_EQ(config.intValue(), 12);
+
+  config.setReferenceResolution(ConfigFileParser::RESOLVE_DEFERRED);
+  EXPECT_THROW(config.loadFromText("test", TEXT), ConfigFileParseError);
+}
+
 TEST(ApplicationConfigurationTests, EmptyValues) {
   TestAppConfig config(false);
   
@@ -549,6 +647,14 @@ TEST(ApplicationConfigurationTests, RegisterPropertyOverlappingPrefix) {
   config.registerPrefix("abd", iv);
   EXPECT_THROW(config.registerProperty("abdef", v),
 	       ApplicationConfigurationError);
+
+  config.registerPrefix("x.y.", iv);
+  EXPECT_THROW(config.registerProperty("x.y.z", v),
+	       ApplicationConfigurationError);
+  EXPECT_THROW(config.registerPrefix("x.y.z", iv),
+	       ApplicationConfigurationError);
+  config.registerProperty("x.y", v);
+  config.registerProperty("x.yz", v);
 }
 
 TEST(ApplicationConfigurationTests, RegisterPrefixOverlappingProperty) {
@@ -561,4 +667,8 @@ TEST(ApplicationConfigurationTests, RegisterPrefixOverlappingProperty) {
   config.registerProperty("abcefij", v);
   EXPECT_THROW(config.registerPrefix("abc", iv),
 	       ApplicationConfigurationError);
+  config.registerPrefix("abd", iv);
+  config.registerPrefix("abcefi.", iv);
+  EXPECT_THROW(config.registerPrefix("de", iv),
+	       ApplicationConfigurationError);
 }
@@ -5,7 +5,13 @@
 
 #include <pistis/config_parser/ConfigFileParser.hpp>
 #include <pistis/config_parser/ConfigFileParseError.hpp>
+#include <pistis/config_parser/ConfigurationHandler.hpp>
+#include <pistis/config_parser/EnvironmentProvider.hpp>
+#include <pistis/config_parser/IncludeFileCache.hpp>
+#include <pistis/config_parser/SourceGraph.hpp>
 #include <gtest/gtest.h>
+#include <map>
+#include <sstream>
 #include <stdlib.h>
 
 using namespace pistis::config_parser;
@@ -28,6 +34,50 @@ namespace {
     return RESOURCE_DIR;
   }
 
+  // Records the events a parser passes to it, one per line
+  class RecordingHandler : public ConfigurationHandler {
+  public:
+    virtual void onProperty(const std::string& name,
+			    const std::string& value,
+			    const std::string& source, int line) override {
+      events_ << "property " << name << "=" << value << " " << line << "\n";
+      properties_.erase(name);
+      properties_.emplace(name,
+			  ConfigurationProperty(name, value, source, line));
+    }
+
+    virtual void onBlockBegin(const std::string& name,
+			      const std::string&, int line) override {
+      events_ << "begin " << name << " " << line << "\n";
+    }
+
+    virtual void onBlockEnd(const std::string& name,
+			    const std::string&, int line) override {
+      events_ << "end " << name << " " << line << "\n";
+    }
+
+    virtual void onInclude(const std::string& filename,
+			   const std::string&, int line) override {
+      events_ << "include " << filename << " " << line << "\n";
+    }
+
+    virtual void onIncludeEnd(const std::string& filename,
+			      const std::string&, int line) override {
+      events_ << "end include " << filename << " " << line << "\n";
+    }
+
+    std::string events() const { return events_.str(); }
+
+    /** @brief The properties received, the last of each name winning */
+    const std::map<std::string, ConfigurationProperty>& properties() const {
+      return properties_;
+    }
+
+  private:
+    std::ostringstream events_;
+    std::map<std::string, ConfigurationProperty> properties_;
+  };
+
   ::testing::AssertionResult verifyConfigFileSyntaxError(
       ConfigFileParser& parser,
       const std::string& filename,
@@ -202,3 +252,492 @@ TEST(ConfigFileParserTests, ParseText) {
   EXPECT_EQ(properties[P2.name()], P2);
   EXPECT_EQ(properties[P3.name()], P3);
 }
+
+TEST(ConfigFileParserTests, ParseWithoutMemoryMap) {
+  const std::string SOURCE_1 = resourceDir() + "assignment_test.cfg";
+  const std::string SOURCE_2 = resourceDir() + "include_test.cfg";
+  ConfigFileParser mapped;
+  ConfigFileParser streamed;
+
+  EXPECT_FALSE(mapped.usesMemoryMappedInput());
+  mapped.setUsesMemoryMappedInput(true);
+  EXPECT_TRUE(mapped.usesMemoryMappedInput());
+  EXPECT_FALSE(streamed.usesMemoryMappedInput());
+
+  for (const std::string& source : { SOURCE_1, SOURCE_2 }) {
+    ConfigurationPropertyMap truth = streamed.parse(source);
+    ConfigurationPropertyMap properties = mapped.parse(source);
+    EXPECT_EQ(properties.size(), truth.size());
+    for (auto i = truth.begin(); i != truth.end(); ++i) {
+      EXPECT_EQ(properties[i->name()], *i);
+    }
+  }
+}
+
+TEST(ConfigFileParserTests, ParseIncludesInParallel) {
+  const std::vector<std::string> SOURCES{
+    "assignment_test.cfg", "include_test.cfg", "overwrite_included.cfg",
+    "recursive.cfg", "include_nonexistent.cfg", "include_within_block.cfg"
+  };
+
+  for (auto mode : { ConfigFileParser::DUP_IGNORE,
+		     ConfigFileParser::DUP_OVERWRITE,
+		     ConfigFileParser::DUP_ERROR }) {
+    ConfigFileParser serial(true, ConfigFileParser::DUP_ERROR, mode);
+    ConfigFileParser parallel(true, ConfigFileParser::DUP_ERROR, mode);
+    parallel.setIncludeThreads(4);
+    EXPECT_EQ(serial.includeThreads(), 0);
+    EXPECT_EQ(parallel.includeThreads(), 4);
+
+    for (const std::string& name : SOURCES) {
+      const std::string source= resourceDir() + name;
+      std::string serialError;
+      std::string parallelError;
+      ConfigurationPropertyMap truth;
+      ConfigurationPropertyMap properties;
+
+      try {
+	truth= serial.parse(source);
+      } catch(const ConfigFileParseError& e) {
+	serialError= e.what();
+      }
+      try {
+	properties= parallel.parse(source);
+      } catch(const ConfigFileParseError& e) {
+	parallelError= e.what();
+      }
+
+      EXPECT_EQ(parallelError, serialError) << source;
+      EXPECT_EQ(properties.size(), truth.size()) << source;
+      for (auto i = truth.begin(); i != truth.end(); ++i) {
+	EXPECT_EQ(properties[i->name()], *i) << source;
+      }
+    }
+  }
+}
+
+TEST(ConfigFileParserTests, ParseIncludesWithCache) {
+  const std::vector<std::string> SOURCES{
+    "assignment_test.cfg", "include_test.cfg", "overwrite_included.cfg",
+    "recursive.cfg", "include_nonexistent.cfg", "include_within_block.cfg"
+  };
+
+  for (auto mode : { ConfigFileParser::DUP_IGNORE,
+		     ConfigFileParser::DUP_OVERWRITE,
+		     ConfigFileParser::DUP_ERROR }) {
+    for (size_t threads : { 0, 4 }) {
+      std::shared_ptr<IncludeFileCache> cache=
+	  std::make_shared<IncludeFileCache>();
+      ConfigFileParser uncached(true, ConfigFileParser::DUP_ERROR, mode);
+      ConfigFileParser cached(true, ConfigFileParser::DUP_ERROR, mode);
+      cached.setIncludeThreads(threads);
+      cached.setIncludeFileCache(cache);
+      EXPECT_EQ(uncached.includeFileCache(), nullptr);
+      EXPECT_EQ(cached.includeFileCache(), cache);
+
+      // The second pass is answered from the cache
+      for (int pass= 0; pass < 2; ++pass) {
+	for (const std::string& name : SOURCES) {
+	  const std::string source= resourceDir() + name;
+	  std::string uncachedError;
+	  std::string cachedError;
+	  ConfigurationPropertyMap truth;
+	  ConfigurationPropertyMap properties;
+
+	  try {
+	    truth= uncached.parse(source);
+	  } catch(const ConfigFileParseError& e) {
+	    uncachedError= e.what();
+	  }
+	  try {
+	    properties= cached.parse(source);
+	  } catch(const ConfigFileParseError& e) {
+	    cachedError= e.what();
+	  }
+
+	  EXPECT_EQ(cachedError, uncachedError) << source << " pass " << pass;
+	  EXPECT_EQ(properties.size(), truth.size()) << source << " pass " << pass;
+	  for (auto i = truth.begin(); i != truth.end(); ++i) {
+	    EXPECT_EQ(properties[i->name()], *i) << source << " pass " << pass;
+	  }
+	}
+      }
+      EXPECT_GT(cache->hits(), 0) << mode << " " << threads;
+    }
+  }
+}
+
+TEST(ConfigFileParserTests, ParseWithSourceGraph) {
+  const std::vector<std::string> SOURCES{
+    "assignment_test.cfg", "include_test.cfg", "overwrite_included.cfg",
+    "recursive.cfg", "include_nonexistent.cfg", "include_within_block.cfg"
+  };
+
+  for (auto mode : { ConfigFileParser::DUP_IGNORE,
+		     ConfigFileParser::DUP_OVERWRITE,
+		     ConfigFileParser::DUP_ERROR }) {
+    for (size_t threads : { 0, 4 }) {
+      std::shared_ptr<SourceGraph> graph= std::make_shared<SourceGraph>();
+      ConfigFileParser full(true, ConfigFileParser::DUP_ERROR, mode);
+      ConfigFileParser incremental(true, ConfigFileParser::DUP_ERROR, mode);
+      incremental.setIncludeThreads(threads);
+      incremental.setSourceGraph(graph);
+      EXPECT_EQ(full.sourceGraph(), nullptr);
+      EXPECT_EQ(incremental.sourceGraph(), graph);
+
+      // The second pass reuses the files parsed by the first
+      for (int pass= 0; pass < 2; ++pass) {
+	for (const std::string& name : SOURCES) {
+	  const std::string source= resourceDir() + name;
+	  std::string fullError;
+	  std::string incrementalError;
+	  ConfigurationPropertyMap truth;
+	  ConfigurationPropertyMap properties;
+
+	  try {
+	    truth= full.parse(source);
+	  } catch(const ConfigFileParseError& e) {
+	    fullError= e.what();
+	  }
+	  try {
+	    properties= incremental.parse(source);
+	  } catch(const ConfigFileParseError& e) {
+	    incrementalError= e.what();
+	  }
+
+	  EXPECT_EQ(incrementalError, fullError) << source << " pass " << pass;
+	  EXPECT_EQ(properties.size(), truth.size()) << source << " pass " << pass;
+	  for (auto i = truth.begin(); i != truth.end(); ++i) {
+	    EXPECT_EQ(properties[i->name()], *i) << source << " pass " << pass;
+	  }
+	}
+      }
+      EXPECT_GT(graph->filesReused(), 0) << mode << " " << threads;
+    }
+  }
+}
+
+TEST(ConfigFileParserTests, ParseWithHandler) {
+  const std::string SOURCE= resourceDir() + "include_test.cfg";
+  const std::string INCLUDED= resourceDir() + "included.cfg";
+  ConfigFileParser parser(true, ConfigFileParser::DUP_ERROR,
+			  ConfigFileParser::DUP_IGNORE);
+  RecordingHandler handler;
+
+  parser.parse(SOURCE, handler);
+  EXPECT_EQ(handler.events(),
+	    "property p1=apple 3\n"
+	    "property p2=banana 4\n"
+	    "include " + INCLUDED + " 7\n"
+	    "property p3=orange 3\n"
+	    "end include " + INCLUDED + " 7\n"
+	    "property p4=kiwi 8\n");
+}
+
+TEST(ConfigFileParserTests, ParseTextWithHandler) {
+  ConfigFileParser parser(true, ConfigFileParser::DUP_ERROR,
+			  ConfigFileParser::DUP_ERROR);
+  RecordingHandler handler;
+
+  parser.parseText("test", "a {\n  b {\n    x= 1\n  }\n  y= 2\n}\n",
+		   handler);
+  EXPECT_EQ(handler.events(),
+	    "begin a 1\n"
+	    "begin a.b 2\n"
+	    "property a.b.x=1 3\n"
+	    "end a.b 4\n"
+	    "property a.y=2 5\n"
+	    "end a 6\n");
+}
+
+TEST(ConfigFileParserTests, HandlerMatchesParse) {
+  const std::vector<std::string> SOURCES{
+    "assignment_test.cfg", "duplicate_assignment.cfg", "include_test.cfg",
+    "overwrite_included.cfg", "recursive.cfg", "include_nonexistent.cfg",
+    "include_within_block.cfg"
+  };
+
+  for (auto duplicateMode : { ConfigFileParser::DUP_IGNORE,
+			      ConfigFileParser::DUP_OVERWRITE,
+			      ConfigFileParser::DUP_ERROR }) {
+    for (auto includedMode : { ConfigFileParser::DUP_IGNORE,
+			       ConfigFileParser::DUP_OVERWRITE,
+			       ConfigFileParser::DUP_ERROR }) {
+      ConfigFileParser parser(true, duplicateMode, includedMode);
+
+      for (const std::string& name : SOURCES) {
+	const std::string source= resourceDir() + name;
+	bool truthFailed= false;
+	bool handlerFailed= false;
+	ConfigurationPropertyMap truth;
+	RecordingHandler handler;
+
+	try {
+	  truth= parser.parse(source);
+	} catch(const ConfigFileParseError& e) {
+	  truthFailed= true;
+	}
+	try {
+	  parser.parse(source, handler);
+	} catch(const ConfigFileParseError& e) {
+	  handlerFailed= true;
+	}
+
+	EXPECT_EQ(handlerFailed, truthFailed) << source;
+	if (!truthFailed) {
+	  EXPECT_EQ(handler.properties().size(), truth.size()) << source;
+	  for (auto i = truth.begin(); i != truth.end(); ++i) {
+	    auto j= handler.properties().find(i->name());
+	    ASSERT_NE(j, handler.properties().end()) << source;
+	    EXPECT_EQ(j->second, *i) << source;
+	  }
+	}
+      }
+    }
+  }
+}
+
+TEST(ConfigFileParserTests, ParseReportingAllErrors) {
+  const std::string TEXT=
+      "a= 1\n"
+      "b c= 2\n"
+      "d= ${undefined}\n"
+      "a= 3\n"
+      "e f {\n"
+      "  g= 4\n"
+      "  h= {\n"
+      "}\n"
+      "}\n"
+      "i {\n"
+      "  j= 5\n"
+      "include \"x.cfg\"\n"
+      "}\n"
+      "k= 6\n"
+      "l {\n";
+  const std::vector<std::string> ERRORS{
+    "line 2, column 2 of test: '=' expected",
+    "line 3, column 3 of test: Invalid property value",
+    "line 4, column 1 of test: Property \"a\" defined twice",
+    "line 5, column 2 of test: '=' expected",
+    "line 9, column 1 of test: Syntax error ('}' unexpected)",
+    "line 12, column 15 of test: Cannot include a file from within a block",
+    "line 15, column 4 of test: '}' expected"
+  };
+  ConfigFileParser parser(false, ConfigFileParser::DUP_ERROR,
+			  ConfigFileParser::DUP_ERROR);
+  ApplicationConfigurationErrorList errors;
+
+  ConfigurationPropertyMap properties= parser.parseText("test", TEXT, errors);
+  EXPECT_EQ(properties.size(), 3);
+  EXPECT_EQ(properties["a"].value(), "1");
+  EXPECT_EQ(properties["i.j"].value(), "5");
+  EXPECT_EQ(properties["k"].value(), "6");
+
+  ASSERT_EQ(errors.size(), ERRORS.size());
+  for (size_t i= 0; i < ERRORS.size(); ++i) {
+    EXPECT_NE(std::string(errors[i]->what()).find(ERRORS[i]),
+	      std::string::npos) << errors[i]->what();
+    EXPECT_TRUE(dynamic_cast<const ConfigFileParseError*>(errors[i].get()));
+  }
+
+  // Without a list, the first error is thrown
+  EXPECT_THROW(parser.parseText("test", TEXT), ConfigFileParseError);
+}
+
+TEST(ConfigFileParserTests, ParseReportingIncludeErrors) {
+  const std::string SOURCE= resourceDir() + "include_test.cfg";
+  ConfigFileParser parser(true, ConfigFileParser::DUP_ERROR,
+			  ConfigFileParser::DUP_ERROR);
+  ApplicationConfigurationErrorList errors;
+
+  // The included properties after the duplicate are still merged
+  ConfigurationPropertyMap properties= parser.parse(SOURCE, errors);
+  ASSERT_EQ(errors.size(), 1);
+  EXPECT_NE(std::string(errors[0]->what()).find("Duplicate property"),
+	    std::string::npos) << errors[0]->what();
+  EXPECT_EQ(properties.size(), 4);
+  EXPECT_EQ(properties["p2"].value(), "banana");
+  EXPECT_EQ(properties["p3"].value(), "orange");
+
+  // The same files are read as without the error list
+  ConfigFileParser reference;
+  reference.parse(SOURCE);
+  EXPECT_EQ(parser.inputFiles().size(), 2);
+  EXPECT_EQ(parser.inputFiles(), reference.inputFiles());
+
+  errors.clear();
+  properties= parser.parse(resourceDir() + "include_nonexistent.cfg", errors);
+  EXPECT_EQ(errors.size(), 1);
+
+  errors.clear();
+  properties= parser.parse(resourceDir() + "no_such_file.cfg", errors);
+  EXPECT_EQ(errors.size(), 1);
+  EXPECT_TRUE(properties.empty());
+  EXPECT_TRUE(parser.inputFiles().empty());
+}
+
+TEST(ConfigFileParserTests, ResolveReferencesDeferred) {
+  const std::string SOURCE= resourceDir() + "deferred.cfg";
+  const std::string TEXT=
+      "url= ${host}:${p3}/${path}\n"
+      "host= example.com\n"
+      "path= a\n"
+      "include \"included.cfg\"\n"
+      "copy= ${path}\n"
+      "path= b\n"
+      "block {\n"
+      "  x= ${block.y}\n"
+      "  y= \\t${p2}\n"
+      "}\n";
+  ConfigFileParser parser(false, ConfigFileParser::DUP_OVERWRITE,
+			  ConfigFileParser::DUP_IGNORE);
+
+  // In order, a reference to a property defined later is an error
+  EXPECT_EQ(parser.referenceResolution(), ConfigFileParser::RESOLVE_IN_ORDER);
+  EXPECT_THROW(parser.parseText(SOURCE, TEXT), ConfigFileParseError);
+
+  // Deferred, every reference sees the property's final value
+  parser.setReferenceResolution(ConfigFileParser::RESOLVE_DEFERRED);
+  ConfigurationPropertyMap properties= parser.parseText(SOURCE, TEXT);
+  EXPECT_EQ(properties.size(), 8);
+  EXPECT_EQ(properties["url"].value(), "example.com:orange/b");
+  EXPECT_EQ(properties["url"].line(), 1);
+  EXPECT_EQ(properties["copy"].value(), "b");
+  EXPECT_EQ(properties["path"].value(), "b");
+  EXPECT_EQ(properties["block.x"].value(), "\tgrapefruit");
+  EXPECT_EQ(properties["block.y"].value(), "\tgrapefruit");
+  EXPECT_EQ(properties["p3"].value(), "orange");
+}
+
+TEST(ConfigFileParserTests, DeferredReferenceCycle) {
+  const std::string TEXT=
+      "a= ${b}\n"
+      "b= x${c}\n"
+      "c= ${a}y\n"
+      "d= ${a}\n"
+      "e= ${e}\n"
+      "f= fine\n";
+  const std::vector<std::string> ERRORS{
+    "line 1, column 3 of test: Invalid property value (Circular reference "
+        "a -> b -> c -> a)",
+    "line 4, column 3 of test: Invalid property value",
+    "line 5, column 3 of test: Invalid property value (Circular reference "
+        "e -> e)"
+  };
+  ConfigFileParser parser(false);
+  ApplicationConfigurationErrorList errors;
+
+  parser.setReferenceResolution(ConfigFileParser::RESOLVE_DEFERRED);
+  ConfigurationPropertyMap properties= parser.parseText("test", TEXT, errors);
+  EXPECT_EQ(properties.size(), 1);
+  EXPECT_EQ(properties["f"].value(), "fine");
+
+  ASSERT_EQ(errors.size(), ERRORS.size());
+  for (size_t i= 0; i < ERRORS.size(); ++i) {
+    EXPECT_NE(std::string(errors[i]->what()).find(ERRORS[i]),
+	      std::string::npos) << errors[i]->what();
+  }
+
+  // Without a list, the first error is thrown
+  try {
+    parser.parseText("test", TEXT);
+    FAIL() << "ConfigFileParseError not thrown";
+  } catch(const ConfigFileParseError& e) {
+    EXPECT_NE(std::string(e.what()).find(ERRORS[0]), std::string::npos)
+        << e.what();
+  }
+}
+
+TEST(ConfigFileParserTests, ResolveReferencesLazily) {
+  const std::string TEXT=
+      "wanted= ${base}/x\n"
+      "base= ${root}\n"
+      "root= /r\n"
+      "unwanted= ${missing}\n"
+      "cycle= ${cycle}\n"
+      "other= ${root}\n";
+  ConfigFileParser parser(false);
+
+  parser.setReferenceResolution(ConfigFileParser::RESOLVE_LAZY);
+  parser.setWantedProperties(
+      [](const std::string& name) { return name == "wanted"; }
+  );
+
+  // Properties nothing wanted refers to are dropped unevaluated
+  ConfigurationPropertyMap properties= parser.parseText("test", TEXT);
+  EXPECT_EQ(properties.size(), 3);
+  EXPECT_EQ(properties["wanted"].value(), "/r/x");
+  EXPECT_EQ(properties["base"].value(), "/r");
+  EXPECT_EQ(properties["root"].value(), "/r");
+  EXPECT_FALSE(properties.hasKey("unwanted"));
+  EXPECT_FALSE(properties.hasKey("other"));
+
+  // Deferred, every property is resolved
+  parser.setReferenceResolution(ConfigFileParser::RESOLVE_DEFERRED);
+  EXPECT_THROW(parser.parseText("test", TEXT), ConfigFileParseError);
+}
+
+TEST(ConfigFileParserTests, ParseWithEnvironmentProvider) {
+  // Counts the snapshots parses take
+  class CountingProvider : public FixedEnvironmentProvider {
+  public:
+    CountingProvider(std::shared_ptr<const EnvironmentSnapshot> e):
+	FixedEnvironmentProvider(std::move(e)), count(0) {
+      // Intentionally left blank
+    }
+
+    virtual std::shared_ptr<const EnvironmentSnapshot> snapshot() const {
+      ++count;
+      return FixedEnvironmentProvider::snapshot();
+    }
+
+    mutable int count;
+  };
+
+  const std::string SOURCE= resourceDir() + "environment.cfg";
+  const std::string TEXT=
+      "home= ${HOME}\n"
+      "data= ${HOME}/data\n"
+      "include \"included.cfg\"\n"
+      "p1= ${p2}:${USER}\n";
+  std::shared_ptr<CountingProvider> provider=
+      std::make_shared<CountingProvider>(
+	  std::shared_ptr<const EnvironmentSnapshot>(
+	      new EnvironmentSnapshot{ { "HOME", "/home/test" },
+				       { "USER", "test" } }
+	  )
+      );
+  ConfigFileParser parser;
+
+  EXPECT_EQ(parser.environmentProvider(), EnvironmentProvider::process());
+  parser.setEnvironmentProvider(provider);
+  EXPECT_EQ(parser.environmentProvider(), provider);
+
+  // One snapshot serves the whole parse, included files too
+  ConfigurationPropertyMap properties= parser.parseText(SOURCE, TEXT);
+  EXPECT_EQ(properties["home"].value(), "/home/test");
+  EXPECT_EQ(properties["data"].value(), "/home/test/data");
+  EXPECT_EQ(properties["p1"].value(), "grapefruit:test");
+  EXPECT_EQ(provider->count, 1);
+
+  // A parse that refers to no variables takes none
+  properties= parser.parseText(SOURCE, "a= 1\nb= ${a}\n");
+  EXPECT_EQ(properties["b"].value(), "1");
+  EXPECT_EQ(provider->count, 1);
+
+  parser.parseText(SOURCE, TEXT);
+  EXPECT_EQ(provider->count, 2);
+
+  // The provider's environment replaces the process environment
+  setenv("ConfigFileParserTests.var", "x", 1);
+  EXPECT_THROW(parser.parseText(SOURCE, "a= ${ConfigFileParserTests.var}\n"),
+	       ConfigFileParseError);
+  unsetenv("ConfigFileParserTests.var");
+
+  parser.setUsesEnvironmentVars(false);
+  EXPECT_THROW(parser.parseText(SOURCE, TEXT), ConfigFileParseError);
+  EXPECT_EQ(provider->count, 3);
+
+  parser.setEnvironmentProvider(nullptr);
+  EXPECT_EQ(parser.environmentProvider(), EnvironmentProvider::process());
+}
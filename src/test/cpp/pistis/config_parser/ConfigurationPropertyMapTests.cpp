@@ -359,3 +359,161 @@ TEST(ConfigurationPropertyMapTests, Clear) {
   EXPECT_THROW(map[P2.name()], NoSuchItem);
   EXPECT_THROW(map[P3.name()], NoSuchItem);
 }
+
+TEST(ConfigurationPropertyMapTests, Find) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "banana", "someSource", 2);
+  ConfigurationPropertyMap map;
+
+  map.add(P1);
+  map.add(P2);
+
+  ASSERT_NE(map.find(P1.name()), nullptr);
+  EXPECT_EQ(*map.find(P1.name()), P1);
+  ASSERT_NE(map.find("p2"), nullptr);
+  EXPECT_EQ(*map.find("p2"), P2);
+  EXPECT_EQ(map.find("p3"), nullptr);
+}
+
+TEST(ConfigurationPropertyMapTests, LookupWithStringView) {
+  static const ConfigurationProperty P1("a.b", "  12  ", "someSource", 1);
+  static const ConfigurationProperty P2("a.c", "0.25", "someSource", 2);
+  static const ConfigurationProperty P3("a.d", "cherry", "someSource", 3);
+  const std::string text("a.b a.c a.d a.e");
+  const std::string_view b(text.data(), 3);
+  const std::string_view c(text.data() + 4, 3);
+  const std::string_view d(text.data() + 8, 3);
+  const std::string_view e(text.data() + 12, 3);
+  ConfigurationPropertyMap map;
+
+  map.add(P1);
+  map.add(P2);
+  map.add(P3);
+
+  EXPECT_TRUE(map.hasKey(b));
+  EXPECT_FALSE(map.hasKey(e));
+  EXPECT_EQ(map[d], P3);
+  EXPECT_THROW(map[e], NoSuchItem);
+  EXPECT_EQ(map.getValue(d, "default"), "cherry");
+  EXPECT_EQ(map.getValue(e, "default"), "default");
+  EXPECT_EQ(map.getValueAsInt(b, -1), 12);
+  EXPECT_EQ(map.getValueAsInt(e, -1), -1);
+  EXPECT_EQ(map.getValueAsDouble(c, -1.0), 0.25);
+  EXPECT_EQ(map.getValueAsDouble(e, -1.0), -1.0);
+
+  std::vector<ConfigurationProperty> matches=
+      map.getPropertiesWithPrefix(std::string_view(text.data(), 2));
+  EXPECT_EQ(matches.size(), 3);
+
+  map.erase(c);
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_FALSE(map.hasKey(c));
+  map.erase(e);
+  EXPECT_EQ(map.size(), 2);
+}
+
+TEST(ConfigurationPropertyMapTests, PropertiesUnder) {
+  static const ConfigurationProperty P1("a", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("a.b", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("a.b.c", "cherry", "someSource", 3);
+  static const ConfigurationProperty P4("a.bc", "lemon", "someSource", 4);
+  static const ConfigurationProperty P5("ab", "lime", "someSource", 5);
+  ConfigurationPropertyMap map;
+
+  map.add(P5);
+  map.add(P4);
+  map.add(P3);
+  map.add(P2);
+  map.add(P1);
+
+  auto range= map.propertiesUnder("a");
+  std::vector<ConfigurationProperty> matches(range.begin(), range.end());
+  ASSERT_EQ(matches.size(), 3);
+  EXPECT_EQ(matches[0], P2);
+  EXPECT_EQ(matches[1], P3);
+  EXPECT_EQ(matches[2], P4);
+
+  range= map.propertiesUnder("a.b");
+  matches.assign(range.begin(), range.end());
+  ASSERT_EQ(matches.size(), 1);
+  EXPECT_EQ(matches[0], P3);
+
+  range= map.propertiesUnder("ab");
+  EXPECT_TRUE(range.empty());
+}
+
+TEST(ConfigurationPropertyMapTests, PropertiesWithPrefix) {
+  static const ConfigurationProperty P1("a.b", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("a.bc", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("a.c", "cherry", "someSource", 3);
+  static const ConfigurationProperty P4("ab", "lemon", "someSource", 4);
+  static const ConfigurationProperty P5("b", "lime", "someSource", 5);
+  ConfigurationPropertyMap map;
+
+  map.add(P5);
+  map.add(P4);
+  map.add(P3);
+  map.add(P2);
+  map.add(P1);
+
+  auto range= map.propertiesWithPrefix("a.b");
+  EXPECT_EQ(range.size(), 2);
+  std::vector<ConfigurationProperty> matches;
+  for (const ConfigurationProperty& p : range) {
+    matches.push_back(p);
+  }
+  ASSERT_EQ(matches.size(), 2);
+  EXPECT_EQ(matches[0], P1);
+  EXPECT_EQ(matches[1], P2);
+
+  range= map.propertiesWithPrefix("a");
+  matches.assign(range.begin(), range.end());
+  ASSERT_EQ(matches.size(), 4);
+  EXPECT_EQ(matches[0], P1);
+  EXPECT_EQ(matches[3], P4);
+
+  range= map.propertiesWithPrefix("a.");
+  EXPECT_EQ(range.size(), 3);
+  EXPECT_EQ(std::count_if(range.begin(), range.end(),
+			  [](const ConfigurationProperty& p) {
+			    return p.value().size() > 5;
+			  }), 2);
+
+  EXPECT_EQ(map.propertiesWithPrefix("").size(), 5);
+  EXPECT_TRUE(map.propertiesWithPrefix("a.bcd").empty());
+  EXPECT_TRUE(map.propertiesWithPrefix("c").empty());
+  EXPECT_TRUE(map.propertiesWithPrefix("0").empty());
+}
+
+TEST(ConfigurationPropertyMapTests, PropertiesMatching) {
+  static const ConfigurationProperty P1("a.b", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("a.bc", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("a.c", "cherry", "someSource", 3);
+  static const ConfigurationProperty P4("ab", "lemon", "someSource", 4);
+  static const ConfigurationProperty P5("b", "lime", "someSource", 5);
+  ConfigurationPropertyMap map;
+
+  map.add(P5);
+  map.add(P4);
+  map.add(P3);
+  map.add(P2);
+  map.add(P1);
+
+  auto range= map.propertiesMatching([](const std::string& name) {
+    return name.back() != 'b';
+  });
+  std::vector<ConfigurationProperty> matches;
+  for (const ConfigurationProperty& p : range) {
+    matches.push_back(p);
+  }
+  ASSERT_EQ(matches.size(), 2);
+  EXPECT_EQ(matches[0], P2);
+  EXPECT_EQ(matches[1], P3);
+  EXPECT_FALSE(range.empty());
+
+  auto none= map.propertiesMatching([](const std::string&) {
+    return false;
+  });
+  EXPECT_TRUE(none.empty());
+  EXPECT_TRUE(none.begin() == none.end());
+}
@@ -7,6 +7,8 @@
 #include <pistis/util/StringUtil.hpp>
 #include <pistis/config_parser/ConfigurationProperty.hpp>
 #include <gtest/gtest.h>
+#include <thread>
+#include <vector>
 
 using namespace pistis::config_parser;
 using namespace pistis::exceptions;
@@ -259,3 +261,66 @@ TEST(ConfigurationPropertyTests, ValueAsSetOfDouble) {
   EXPECT_TRUE(checkSequences(p.valueAsSetOfDouble(","), TRUTH));
   EXPECT_THROW(bad.valueAsSetOfDouble(","), InvalidPropertyValueError);
 }
+
+TEST(ConfigurationPropertyTests, RepeatedConversions) {
+  ConfigurationProperty p("test", "4, 7, 19", "someSource", 1);
+  ConfigurationProperty n("test", "52", "someSource", 2);
+  ConfigurationProperty bad("test", "4,,bad", "someSource", 3);
+
+  // Conversions give the same results after their values are cached
+  for (int i= 0; i < 2; ++i) {
+    EXPECT_EQ(n.valueAsInt(), 52);
+    EXPECT_NEAR(n.valueAsDouble(), 52.0, 1e-10);
+    EXPECT_THROW(n.valueAsIntInRange(0, 50), InvalidPropertyValueError);
+    EXPECT_EQ(n.valueAsIntInRange(50, 60), 52);
+    EXPECT_THROW(bad.valueAsInt(), InvalidPropertyValueError);
+
+    EXPECT_TRUE(checkSequences(p.valueAsListOfInt(","),
+			       std::vector<int>{ 4, 7, 19 }));
+    EXPECT_TRUE(checkSequences(p.valueAsListOfDouble(","),
+			       std::vector<double>{ 4.0, 7.0, 19.0 }));
+    EXPECT_TRUE(checkSequences(p.valueAsList(","),
+			       std::vector<std::string>{ "4", "7", "19" }));
+    EXPECT_TRUE(checkSequences(p.valueAsSet(","),
+			       std::vector<std::string>{ "19", "4", "7" }));
+    EXPECT_THROW(p.valueAsListOfInt(",", 0, 10), InvalidPropertyValueError);
+    EXPECT_THROW(bad.valueAsListOfInt(","), InvalidPropertyValueError);
+    EXPECT_THROW(bad.valueAsList(","), InvalidPropertyValueError);
+  }
+
+  // Lists split on a different separator are not taken from the cache
+  EXPECT_TRUE(checkSequences(p.valueAsList(" "),
+			     std::vector<std::string>{ "4,", "7,", "19" }));
+
+  // Copies convert their own values
+  ConfigurationProperty q(p);
+  q= n;
+  EXPECT_EQ(q.valueAsInt(), 52);
+  ConfigurationProperty r(std::move(q));
+  EXPECT_EQ(r.valueAsInt(), 52);
+  r= ConfigurationProperty("test", "3", "someSource", 4);
+  EXPECT_EQ(r.valueAsInt(), 3);
+}
+
+TEST(ConfigurationPropertyTests, ConcurrentConversions) {
+  static const std::vector<int> TRUTH{ 4, 7, 3, 4, 19, 3 };
+  const ConfigurationProperty p("test", "4,7,3,4,19,3", "someSource", 1);
+  const ConfigurationProperty n("test", "52", "someSource", 2);
+  std::vector<std::thread> threads;
+  std::vector<int> failures(8, 0);
+
+  for (size_t i= 0; i < failures.size(); ++i) {
+    threads.emplace_back([&p, &n, &failures, i]() {
+      for (int j= 0; j < 1000; ++j) {
+	failures[i] += (n.valueAsInt() != 52) ||
+	               (p.valueAsListOfInt(",") != TRUTH);
+      }
+    });
+  }
+  for (auto i= threads.begin(); i != threads.end(); ++i) {
+    i->join();
+  }
+  for (size_t i= 0; i < failures.size(); ++i) {
+    EXPECT_EQ(failures[i], 0) << "Thread " << i;
+  }
+}
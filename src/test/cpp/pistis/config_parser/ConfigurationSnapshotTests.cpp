@@ -0,0 +1,319 @@
+/** @file ConfigurationSnapshotTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::ConfigurationSnapshot
+ */
+
+#include <pistis/config_parser/ConfigurationSnapshot.hpp>
+#include <pistis/config_parser/ConfigurationSnapshotError.hpp>
+#include <pistis/config_parser/ConfigFileParser.hpp>
+#include <pistis/config_parser/EnvironmentProvider.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser;
+using namespace pistis::config_parser::detail;
+
+namespace {
+  // Scratch directory for configuration files and snapshots
+  class TempDir {
+  public:
+    TempDir(): name_() {
+      char tmpl[]= "/tmp/ConfigurationSnapshotTests.XXXXXX";
+      if (mkdtemp(tmpl)) {
+	name_= tmpl;
+      }
+    }
+
+    ~TempDir() {
+      if (!name_.empty()) {
+	// Snapshots have generated names, so remove everything
+	std::string command= "rm -rf '" + name_ + "'";
+	if (system(command.c_str())) {
+	  // Nothing to be done
+	}
+      }
+    }
+
+    const std::string& name() const { return name_; }
+
+    std::string path(const std::string& filename) const {
+      return name_ + "/" + filename;
+    }
+
+    std::string write(const std::string& filename, const std::string& text) {
+      const std::string p= path(filename);
+      std::ofstream out(p.c_str(), std::ios::out | std::ios::trunc);
+      out << text;
+      return p;
+    }
+
+  private:
+    std::string name_;
+  };
+
+  std::vector< std::pair<std::string, FileStamp> > stampFiles(
+      const std::vector<std::string>& files
+  ) {
+    std::vector< std::pair<std::string, FileStamp> > stamps;
+    for (const std::string& f : files) {
+      FileStamp stamp;
+      EXPECT_TRUE(FileStamp::read(f, stamp)) << f;
+      stamps.emplace_back(f, stamp);
+    }
+    return stamps;
+  }
+
+  ::testing::AssertionResult verifySameProperties(
+      const ConfigurationPropertyMap& truth,
+      const ConfigurationPropertyMap& properties
+  ) {
+    if (properties.size() != truth.size()) {
+      return ::testing::AssertionFailure()
+	  << "There are " << properties.size() << " properties, but there "
+	  << "should be " << truth.size();
+    }
+    for (auto i= truth.begin(); i != truth.end(); ++i) {
+      if (!properties.hasKey(i->name())) {
+	return ::testing::AssertionFailure()
+	    << "Property " << i->name() << " is missing";
+      } else if (properties[i->name()] != *i) {
+	const ConfigurationProperty& p= properties[i->name()];
+	return ::testing::AssertionFailure()
+	    << "Property " << i->name() << " is [" << p.value() << "] from "
+	    << p.source() << ":" << p.line() << "; it should be ["
+	    << i->value() << "] from " << i->source() << ":" << i->line();
+      }
+    }
+    return ::testing::AssertionSuccess();
+  }
+}
+
+TEST(ConfigurationSnapshotTests, WriteAndRead) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  const std::string config= dir.write("app.cfg", "unused= file\n");
+  const std::string snapshotFile= dir.path("app.snapshot");
+
+  ConfigurationPropertyMap properties;
+  properties.add(ConfigurationProperty("b.x", "1", "app.cfg", 3));
+  properties.add(ConfigurationProperty("a", "", "app.cfg", 1));
+  properties.add(ConfigurationProperty("b.y", "two words", "other.cfg", 7));
+  properties.add(ConfigurationProperty("c", std::string("nul\0byte", 8),
+				       "other.cfg", 9));
+  ConfigurationSnapshot::write(snapshotFile, "the key", properties,
+			       stampFiles({ config }));
+
+  ConfigurationSnapshot snapshot(snapshotFile);
+  EXPECT_EQ(snapshot.filename(), snapshotFile);
+  EXPECT_EQ(snapshot.key(), "the key");
+  ASSERT_EQ(snapshot.size(), 4);
+
+  const std::vector<std::string> NAMES{ "a", "b.x", "b.y", "c" };
+  for (size_t i= 0; i < NAMES.size(); ++i) {
+    const ConfigurationProperty& truth= properties[NAMES[i]];
+    ConfigurationSnapshot::Property p= snapshot.property(i);
+    EXPECT_EQ(p.name, truth.name());
+    EXPECT_EQ(p.value, truth.value());
+    EXPECT_EQ(p.source, truth.source());
+    EXPECT_EQ(p.line, truth.line());
+
+    std::optional<ConfigurationSnapshot::Property> found=
+	snapshot.find(NAMES[i]);
+    ASSERT_TRUE(found.has_value()) << NAMES[i];
+    EXPECT_EQ(found->name, truth.name());
+    EXPECT_EQ(found->value, truth.value());
+  }
+  EXPECT_FALSE(snapshot.find("").has_value());
+  EXPECT_FALSE(snapshot.find("b").has_value());
+  EXPECT_FALSE(snapshot.find("d").has_value());
+
+  ASSERT_EQ(snapshot.numInputFiles(), 1);
+  EXPECT_EQ(snapshot.inputFile(0).path, config);
+  EXPECT_TRUE(snapshot.isFresh());
+  EXPECT_TRUE(verifySameProperties(properties, snapshot.toPropertyMap()));
+}
+
+TEST(ConfigurationSnapshotTests, RejectInvalidSnapshots) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  EXPECT_THROW(ConfigurationSnapshot(dir.path("missing.snapshot")),
+	       ConfigurationSnapshotError);
+  EXPECT_THROW(ConfigurationSnapshot(dir.write("empty.snapshot", "")),
+	       ConfigurationSnapshotError);
+  EXPECT_THROW(
+      ConfigurationSnapshot(
+	  dir.write("text.snapshot", std::string(200, 'x'))
+      ),
+      ConfigurationSnapshotError
+  );
+
+  ConfigurationPropertyMap properties;
+  properties.add(ConfigurationProperty("a", "1", "app.cfg", 1));
+  const std::string snapshotFile= dir.path("truncated.snapshot");
+  ConfigurationSnapshot::write(snapshotFile, "key", properties,
+			       stampFiles({ }));
+  struct stat info;
+  ASSERT_EQ(::stat(snapshotFile.c_str(), &info), 0);
+  ASSERT_EQ(::truncate(snapshotFile.c_str(), info.st_size - 8), 0);
+  EXPECT_THROW(ConfigurationSnapshot s(snapshotFile),
+	       ConfigurationSnapshotError);
+}
+
+TEST(ConfigurationSnapshotTests, DetectChangedInputs) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  const std::string config= dir.write("app.cfg", "a= 1\n");
+  const std::string snapshotFile= dir.path("app.snapshot");
+  ConfigurationSnapshot::write(snapshotFile, "key", ConfigurationPropertyMap(),
+			       stampFiles({ config }));
+
+  // Touching the file without changing it leaves the snapshot fresh
+  const struct timespec times[2]= { { 0, UTIME_OMIT }, { 12345, 0 } };
+  ASSERT_EQ(::utimensat(AT_FDCWD, config.c_str(), times, 0), 0);
+  EXPECT_TRUE(ConfigurationSnapshot(snapshotFile).isFresh());
+
+  dir.write("app.cfg", "a= 2\n");
+  EXPECT_FALSE(ConfigurationSnapshot(snapshotFile).isFresh());
+  dir.write("app.cfg", "a= 1\n");
+  EXPECT_TRUE(ConfigurationSnapshot(snapshotFile).isFresh());
+  ::unlink(config.c_str());
+  EXPECT_FALSE(ConfigurationSnapshot(snapshotFile).isFresh());
+}
+
+TEST(ConfigurationSnapshotTests, ParseWithSnapshot) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  dir.write("included.cfg", "i= included\nshared= from included\n");
+  const std::string config= dir.write(
+      "app.cfg",
+      "a= 1\nb {\n  c= ${a}2\n}\ninclude \"included.cfg\"\nd= ${i}\n"
+  );
+  const std::string snapshots= dir.path("snapshots");
+  ASSERT_EQ(::mkdir(snapshots.c_str(), 0700), 0);
+
+  ConfigFileParser uncached(false);
+  ConfigFileParser parser(false);
+  EXPECT_EQ(parser.snapshotFile(config), "");
+  parser.setSnapshotDirectory(snapshots);
+  const std::string snapshotFile= parser.snapshotFile(config);
+  EXPECT_EQ(snapshotFile.substr(0, snapshots.size()), snapshots);
+
+  // Whether environment variables are substituted is part of the key
+  ConfigFileParser withEnvironment(true);
+  withEnvironment.setSnapshotDirectory(snapshots);
+  EXPECT_NE(withEnvironment.snapshotFile(config), "");
+  EXPECT_NE(withEnvironment.snapshotFile(config), snapshotFile);
+
+  // The first parse writes the snapshot
+  ConfigurationPropertyMap truth= uncached.parse(config);
+  ASSERT_EQ(truth.size(), 5);
+  EXPECT_TRUE(verifySameProperties(truth, parser.parse(config)));
+  {
+    ConfigurationSnapshot snapshot(snapshotFile);
+    EXPECT_EQ(snapshot.numInputFiles(), 2);
+    EXPECT_TRUE(snapshot.isFresh());
+    EXPECT_TRUE(verifySameProperties(truth, snapshot.toPropertyMap()));
+
+    // Replace the snapshot with one whose properties differ from the
+    // file's, to see that the next parse reads them
+    ConfigurationPropertyMap altered= snapshot.toPropertyMap();
+    altered.add(ConfigurationProperty("from_snapshot", "yes", config, 99));
+    std::vector< std::pair<std::string, FileStamp> > inputs;
+    for (size_t i= 0; i < snapshot.numInputFiles(); ++i) {
+      inputs.emplace_back(std::string(snapshot.inputFile(i).path),
+			  snapshot.inputFile(i).stamp);
+    }
+    ConfigurationSnapshot::write(snapshotFile, snapshot.key(), altered,
+				 inputs);
+  }
+  ConfigurationPropertyMap fromSnapshot= parser.parse(config);
+  EXPECT_EQ(fromSnapshot.size(), 6);
+  EXPECT_TRUE(fromSnapshot.hasKey("from_snapshot"));
+
+  // Changing an included file makes the parser read the text again
+  dir.write("included.cfg", "i= changed\n");
+  truth= uncached.parse(config);
+  EXPECT_EQ(truth["d"].value(), "changed");
+  EXPECT_TRUE(verifySameProperties(truth, parser.parse(config)));
+  EXPECT_TRUE(ConfigurationSnapshot(snapshotFile).isFresh());
+
+  // A corrupt snapshot is replaced
+  std::ofstream(snapshotFile.c_str(), std::ios::out | std::ios::trunc)
+      << "garbage";
+  EXPECT_TRUE(verifySameProperties(truth, parser.parse(config)));
+  EXPECT_EQ(ConfigurationSnapshot(snapshotFile).size(), truth.size());
+}
+
+TEST(ConfigurationSnapshotTests, DetectChangedEnvironment) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  dir.write("included.cfg", "dir= ${SNAPSHOT_TEST_HOME}/data\n");
+  const std::string config= dir.write(
+      "app.cfg", "include \"included.cfg\"\nuser= ${SNAPSHOT_TEST_USER}\n"
+  );
+  const std::string snapshots= dir.path("snapshots");
+  ASSERT_EQ(::mkdir(snapshots.c_str(), 0700), 0);
+
+  auto environment= [](const std::string& home, const std::string& user) {
+    return std::shared_ptr<const EnvironmentSnapshot>(
+	new EnvironmentSnapshot{ { "SNAPSHOT_TEST_HOME", home },
+				 { "SNAPSHOT_TEST_USER", user },
+				 { "SNAPSHOT_TEST_UNUSED", "x" } }
+    );
+  };
+  ConfigFileParser parser;
+  parser.setSnapshotDirectory(snapshots);
+  parser.setEnvironmentProvider(
+      std::make_shared<FixedEnvironmentProvider>(environment("/a", "ann"))
+  );
+  const std::string snapshotFile= parser.snapshotFile(config);
+
+  // The snapshot records the variables the file and its includes used
+  EXPECT_EQ(parser.parse(config)["dir"].value(), "/a/data");
+  {
+    ConfigurationSnapshot snapshot(snapshotFile);
+    ASSERT_EQ(snapshot.numEnvironmentVariables(), 2);
+    std::map<std::string, std::string> variables;
+    for (size_t i= 0; i < snapshot.numEnvironmentVariables(); ++i) {
+      variables.emplace(snapshot.environmentVariable(i).name,
+			snapshot.environmentVariable(i).value);
+    }
+    EXPECT_EQ(variables["SNAPSHOT_TEST_HOME"], "/a");
+    EXPECT_EQ(variables["SNAPSHOT_TEST_USER"], "ann");
+    EXPECT_TRUE(snapshot.isFresh(*environment("/a", "ann")));
+    EXPECT_FALSE(snapshot.isFresh(*environment("/b", "ann")));
+    EXPECT_FALSE(snapshot.isFresh(EnvironmentSnapshot()));
+
+    // Mark the snapshot, to see that the next parse reads it
+    ConfigurationPropertyMap altered= snapshot.toPropertyMap();
+    altered.add(ConfigurationProperty("from_snapshot", "yes", config, 99));
+    std::vector< std::pair<std::string, FileStamp> > inputs;
+    for (size_t i= 0; i < snapshot.numInputFiles(); ++i) {
+      inputs.emplace_back(std::string(snapshot.inputFile(i).path),
+			  snapshot.inputFile(i).stamp);
+    }
+    ConfigurationSnapshot::write(
+	snapshotFile, snapshot.key(), altered, inputs,
+	{ { "SNAPSHOT_TEST_HOME", "/a" }, { "SNAPSHOT_TEST_USER", "ann" } }
+    );
+  }
+  EXPECT_TRUE(parser.parse(config).hasKey("from_snapshot"));
+
+  // A variable with a new value makes the parser read the text again
+  parser.setEnvironmentProvider(
+      std::make_shared<FixedEnvironmentProvider>(environment("/b", "ann"))
+  );
+  ConfigurationPropertyMap properties= parser.parse(config);
+  EXPECT_FALSE(properties.hasKey("from_snapshot"));
+  EXPECT_EQ(properties["dir"].value(), "/b/data");
+  EXPECT_TRUE(
+      ConfigurationSnapshot(snapshotFile).isFresh(*environment("/b", "ann"))
+  );
+}
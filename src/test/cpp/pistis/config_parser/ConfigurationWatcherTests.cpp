@@ -0,0 +1,184 @@
+/** @file ConfigurationWatcherTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::ConfigurationWatcher
+ */
+
+#include <pistis/config_parser/ConfigurationWatcher.hpp>
+#include <pistis/config_parser/ConfigFileParser.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser;
+
+namespace {
+  // Scratch directory for configuration files the tests rewrite
+  class TempDir {
+  public:
+    TempDir(): name_() {
+      char tmpl[]= "/tmp/ConfigurationWatcherTests.XXXXXX";
+      if (mkdtemp(tmpl)) {
+	name_= tmpl;
+      }
+    }
+
+    ~TempDir() {
+      for (const std::string& f : files_) {
+	unlink(f.c_str());
+      }
+      if (!name_.empty()) {
+	rmdir(name_.c_str());
+      }
+    }
+
+    const std::string& name() const { return name_; }
+
+    std::string write(const std::string& filename, const std::string& text) {
+      const std::string path= name_ + "/" + filename;
+      std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+      out << text;
+      files_.push_back(path);
+      return path;
+    }
+
+  private:
+    std::string name_;
+    std::vector<std::string> files_;
+  };
+
+  // Reparses the root file when the watcher asks it to
+  class Reloader {
+  public:
+    Reloader(const std::string& root):
+	root_(root), mutex_(), value_(), files_() {
+      parse();
+    }
+
+    std::vector<std::string> parse() {
+      ConfigFileParser parser(false, ConfigFileParser::DUP_ERROR,
+			      ConfigFileParser::DUP_OVERWRITE);
+      ConfigurationPropertyMap properties= parser.parse(root_);
+      std::unique_lock<std::mutex> lock(mutex_);
+      value_= properties["value"].value();
+      files_= parser.inputFiles();
+      return files_;
+    }
+
+    std::string value() const {
+      std::unique_lock<std::mutex> lock(mutex_);
+      return value_;
+    }
+
+    std::vector<std::string> files() const {
+      std::unique_lock<std::mutex> lock(mutex_);
+      return files_;
+    }
+
+  private:
+    std::string root_;
+    mutable std::mutex mutex_;
+    std::string value_;
+    std::vector<std::string> files_;
+  };
+
+  bool waitFor(const std::function<bool ()>& condition) {
+    auto deadline= std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition()) {
+      if (std::chrono::steady_clock::now() > deadline) {
+	return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+  }
+}
+
+TEST(ConfigurationWatcherTests, ReloadOnChange) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  const std::string settings= dir.write("settings.cfg", "value= 1\n");
+  const std::string root= dir.write("root.cfg", "include \"settings.cfg\"\n");
+  Reloader reloader(root);
+  EXPECT_EQ(reloader.value(), "1");
+  EXPECT_EQ(reloader.files(), std::vector<std::string>({ root, settings }));
+
+  ConfigurationWatcher watcher(reloader.files(),
+			       [&reloader]() { return reloader.parse(); },
+			       std::chrono::milliseconds(20));
+  EXPECT_EQ(watcher.delay(), std::chrono::milliseconds(20));
+  EXPECT_EQ(watcher.files(), reloader.files());
+  EXPECT_EQ(watcher.reloads(), 0);
+
+  // Written in place
+  dir.write("settings.cfg", "value= 2\n");
+  EXPECT_TRUE(waitFor([&reloader]() { return reloader.value() == "2"; }));
+
+  // Written to a temporary file and renamed over the original
+  const std::string tmp= dir.name() + "/settings.cfg.tmp";
+  {
+    std::ofstream out(tmp.c_str());
+    out << "value= 3\n";
+  }
+  ASSERT_EQ(rename(tmp.c_str(), settings.c_str()), 0);
+  EXPECT_TRUE(waitFor([&reloader]() { return reloader.value() == "3"; }));
+  EXPECT_GE(watcher.reloads(), 2);
+  EXPECT_EQ(watcher.failedReloads(), 0);
+
+  // Files are watched as they become included
+  const std::string more= dir.write("more.cfg", "value= 4\n");
+  dir.write("root.cfg", "include \"settings.cfg\"\ninclude \"more.cfg\"\n");
+  EXPECT_TRUE(waitFor([&watcher]() { return watcher.files().size() == 3; }));
+  dir.write("more.cfg", "value= 5\n");
+  EXPECT_TRUE(waitFor([&reloader]() { return reloader.value() == "5"; }));
+  EXPECT_EQ(watcher.files(),
+	    std::vector<std::string>({ root, settings, more }));
+}
+
+TEST(ConfigurationWatcherTests, CoalesceBursts) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  const std::string root= dir.write("root.cfg", "value= 0\n");
+  Reloader reloader(root);
+
+  ConfigurationWatcher watcher(reloader.files(),
+			       [&reloader]() { return reloader.parse(); },
+			       std::chrono::milliseconds(500));
+  for (int i= 1; i <= 10; ++i) {
+    dir.write("root.cfg", "value= " + std::to_string(i) + "\n");
+  }
+  EXPECT_TRUE(waitFor([&reloader]() { return reloader.value() == "10"; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  EXPECT_EQ(watcher.reloads(), 1);
+}
+
+TEST(ConfigurationWatcherTests, FailedReload) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  const std::string root= dir.write("root.cfg", "value= 1\n");
+  Reloader reloader(root);
+
+  ConfigurationWatcher watcher(reloader.files(),
+			       [&reloader]() { return reloader.parse(); },
+			       std::chrono::milliseconds(20));
+  dir.write("root.cfg", "value= ${missing}\n");
+  EXPECT_TRUE(waitFor([&watcher]() { return watcher.failedReloads() == 1; }));
+  EXPECT_EQ(reloader.value(), "1");
+  EXPECT_EQ(watcher.files(), std::vector<std::string>({ root }));
+
+  dir.write("root.cfg", "value= 2\n");
+  EXPECT_TRUE(waitFor([&reloader]() { return reloader.value() == "2"; }));
+
+  watcher.stop();
+  dir.write("root.cfg", "value= 3\n");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(reloader.value(), "2");
+}
@@ -0,0 +1,72 @@
+/** @file EnvironmentProviderTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::EnvironmentProvider and
+ *  pistis::config_parser::EnvironmentSnapshot
+ */
+
+#include <pistis/config_parser/EnvironmentProvider.hpp>
+#include <pistis/config_parser/EnvironmentSnapshot.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <stdlib.h>
+
+using namespace pistis::config_parser;
+
+TEST(EnvironmentProviderTests, SnapshotLookup) {
+  EnvironmentSnapshot empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty.find("HOME"), nullptr);
+
+  EnvironmentSnapshot snapshot{ { "HOME", "/home/test" },
+				{ "EMPTY", "" } };
+  EXPECT_EQ(snapshot.size(), 2);
+  ASSERT_NE(snapshot.find("HOME"), nullptr);
+  EXPECT_EQ(*snapshot.find("HOME"), "/home/test");
+  ASSERT_NE(snapshot.find("EMPTY"), nullptr);
+  EXPECT_EQ(*snapshot.find("EMPTY"), "");
+  EXPECT_EQ(snapshot.find("HOM"), nullptr);
+
+  snapshot.set("HOME", "/root");
+  snapshot.set("USER", "root");
+  EXPECT_EQ(snapshot.size(), 3);
+  EXPECT_EQ(*snapshot.find("HOME"), "/root");
+  EXPECT_EQ(*snapshot.find("USER"), "root");
+}
+
+TEST(EnvironmentProviderTests, SnapshotProcessEnvironment) {
+  setenv("EnvironmentProviderTests.var", "before", 1);
+  unsetenv("EnvironmentProviderTests.unset");
+  std::shared_ptr<const EnvironmentSnapshot> snapshot=
+      EnvironmentProvider::process()->snapshot();
+
+  ASSERT_NE(snapshot->find("EnvironmentProviderTests.var"), nullptr);
+  EXPECT_EQ(*snapshot->find("EnvironmentProviderTests.var"), "before");
+  EXPECT_EQ(snapshot->find("EnvironmentProviderTests.unset"), nullptr);
+
+  // The snapshot does not see later changes, but the next one does
+  setenv("EnvironmentProviderTests.var", "after", 1);
+  setenv("EnvironmentProviderTests.unset", "set", 1);
+  EXPECT_EQ(*snapshot->find("EnvironmentProviderTests.var"), "before");
+  EXPECT_EQ(snapshot->find("EnvironmentProviderTests.unset"), nullptr);
+
+  snapshot= EnvironmentProvider::process()->snapshot();
+  EXPECT_EQ(*snapshot->find("EnvironmentProviderTests.var"), "after");
+  EXPECT_EQ(*snapshot->find("EnvironmentProviderTests.unset"), "set");
+
+  unsetenv("EnvironmentProviderTests.var");
+  unsetenv("EnvironmentProviderTests.unset");
+}
+
+TEST(EnvironmentProviderTests, FixedProvider) {
+  std::shared_ptr<const EnvironmentSnapshot> environment(
+      new EnvironmentSnapshot{ { "HOME", "/home/test" } }
+  );
+  FixedEnvironmentProvider provider(environment);
+  EXPECT_EQ(provider.snapshot(), environment);
+  EXPECT_EQ(provider.snapshot(), environment);
+
+  FixedEnvironmentProvider empty(nullptr);
+  ASSERT_NE(empty.snapshot(), nullptr);
+  EXPECT_TRUE(empty.snapshot()->empty());
+}
@@ -0,0 +1,370 @@
+/** @file FlatConfigurationPropertyMapTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::FlatConfigurationPropertyMap.
+ */
+
+#include <pistis/exceptions/NoSuchItem.hpp>
+#include <pistis/config_parser/FlatConfigurationPropertyMap.hpp>
+#include <pistis/config_parser/InvalidPropertyValueError.hpp>
+#include <pistis/config_parser/PropertyFormatError.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+using namespace pistis::exceptions;
+using namespace pistis::config_parser;
+
+namespace {
+  ConfigurationPropertyMap createMap(
+      const std::vector<ConfigurationProperty>& properties
+  ) {
+    ConfigurationPropertyMap map;
+    for (auto i= properties.begin(); i != properties.end(); ++i) {
+      map.add(*i);
+    }
+    return map;
+  }
+}
+
+TEST(FlatConfigurationPropertyMapTests, Construct) {
+  FlatConfigurationPropertyMap map;
+
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_TRUE(map.beginNames() == map.endNames());
+  EXPECT_FALSE(map.hasKey("p1"));
+  EXPECT_THROW(map["p1"], NoSuchItem);
+}
+
+TEST(FlatConfigurationPropertyMapTests, ConstructFromPropertyMap) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("p3", "cherry", "someSource", 3);
+  const ConfigurationPropertyMap original= createMap({ P2, P3, P1 });
+  FlatConfigurationPropertyMap map(original);
+
+  EXPECT_FALSE(map.empty());
+  EXPECT_EQ(map.size(), 3);
+  EXPECT_EQ(map[P1.name()], P1);
+  EXPECT_EQ(map[P2.name()], P2);
+  EXPECT_EQ(map[P3.name()], P3);
+  EXPECT_THROW(map["bad"], NoSuchItem);
+  EXPECT_EQ(original.size(), 3);
+}
+
+TEST(FlatConfigurationPropertyMapTests, MoveFromPropertyMap) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("p3", "cherry", "someSource", 3);
+  ConfigurationPropertyMap original= createMap({ P2, P3, P1 });
+  FlatConfigurationPropertyMap map(std::move(original));
+
+  EXPECT_TRUE(original.empty());
+  EXPECT_EQ(map.size(), 3);
+  EXPECT_EQ(map[P1.name()], P1);
+  EXPECT_EQ(map[P2.name()], P2);
+  EXPECT_EQ(map[P3.name()], P3);
+}
+
+TEST(FlatConfigurationPropertyMapTests, MoveConstructionAndAssignment) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "banana", "someSource", 2);
+  FlatConfigurationPropertyMap original(createMap({ P1, P2 }));
+  FlatConfigurationPropertyMap moved(std::move(original));
+
+  EXPECT_TRUE(original.empty());
+  EXPECT_FALSE(original.hasKey(P1.name()));
+  EXPECT_EQ(moved.size(), 2);
+  EXPECT_EQ(moved[P1.name()], P1);
+  EXPECT_EQ(moved[P2.name()], P2);
+
+  original= std::move(moved);
+  EXPECT_TRUE(moved.empty());
+  EXPECT_EQ(original.size(), 2);
+  EXPECT_EQ(original[P1.name()], P1);
+  EXPECT_EQ(original[P2.name()], P2);
+}
+
+TEST(FlatConfigurationPropertyMapTests, CopyConstructionAndAssignment) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("a.much.longer.property.name",
+					"banana", "someSource", 2);
+  std::unique_ptr<FlatConfigurationPropertyMap> original(
+      new FlatConfigurationPropertyMap(createMap({ P1, P2 }))
+  );
+  FlatConfigurationPropertyMap copy(*original);
+  FlatConfigurationPropertyMap assigned;
+  assigned= *original;
+
+  // The copies must not refer to the original's names
+  original.reset();
+  EXPECT_EQ(copy.size(), 2);
+  EXPECT_EQ(copy[P1.name()], P1);
+  EXPECT_EQ(copy[P2.name()], P2);
+  EXPECT_EQ(copy.propertiesUnder("a.much").size(), 1);
+  EXPECT_EQ(assigned.size(), 2);
+  EXPECT_EQ(assigned[P1.name()], P1);
+  EXPECT_EQ(assigned[P2.name()], P2);
+}
+
+TEST(FlatConfigurationPropertyMapTests, NameIteration) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("p3", "cherry", "someSource", 3);
+  FlatConfigurationPropertyMap map(createMap({ P2, P3, P1 }));
+  FlatConfigurationPropertyMap::NameIterator i;
+  std::vector<std::string> names;
+
+  std::copy(map.beginNames(), map.endNames(), std::back_inserter(names));
+  ASSERT_EQ(names.size(), map.size());
+  EXPECT_EQ(names[0], P1.name());
+  EXPECT_EQ(names[1], P2.name());
+  EXPECT_EQ(names[2], P3.name());
+
+  names.clear();
+  i= map.beginNames();
+  while (i != map.endNames()) {
+    names.push_back(*i++);
+  }
+  ASSERT_EQ(names.size(), map.size());
+  EXPECT_EQ(names[0], P1.name());
+  EXPECT_EQ(names[1], P2.name());
+  EXPECT_EQ(names[2], P3.name());
+}
+
+TEST(FlatConfigurationPropertyMapTests, ValueIteration) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("p3", "cherry", "someSource", 3);
+  FlatConfigurationPropertyMap map(createMap({ P2, P3, P1 }));
+  std::vector<ConfigurationProperty> values(map.begin(), map.end());
+
+  ASSERT_EQ(values.size(), map.size());
+  EXPECT_EQ(values[0], P1);
+  EXPECT_EQ(values[1], P2);
+  EXPECT_EQ(values[2], P3);
+}
+
+TEST(FlatConfigurationPropertyMapTests, Find) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "banana", "someSource", 2);
+  FlatConfigurationPropertyMap map(createMap({ P1, P2 }));
+
+  ASSERT_NE(map.find("p1"), nullptr);
+  EXPECT_EQ(*map.find("p1"), P1);
+  ASSERT_NE(map.find(P2.name()), nullptr);
+  EXPECT_EQ(*map.find(P2.name()), P2);
+  EXPECT_EQ(map.find("p0"), nullptr);
+  EXPECT_EQ(map.find("p3"), nullptr);
+}
+
+TEST(FlatConfigurationPropertyMapTests, HasKey) {
+  std::vector<ConfigurationProperty> properties;
+  for (int i= 0; i < 100; ++i) {
+    properties.push_back(
+	ConfigurationProperty("key" + std::to_string(i * 2), "value",
+			      "someSource", i)
+    );
+  }
+  FlatConfigurationPropertyMap map(createMap(properties));
+
+  // Every other name is missing, so searches end on both sides of
+  // each key
+  for (int i= 0; i < 200; ++i) {
+    EXPECT_EQ(map.hasKey("key" + std::to_string(i)), !(i % 2)) << i;
+  }
+  EXPECT_FALSE(map.hasKey(""));
+  EXPECT_FALSE(map.hasKey("key"));
+  EXPECT_FALSE(map.hasKey("zzz"));
+}
+
+TEST(FlatConfigurationPropertyMapTests, GetValue) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("p3", "cherry", "someSource", 3);
+  FlatConfigurationPropertyMap map(createMap({ P2, P1, P3 }));
+
+  EXPECT_EQ(map.getValue(P2.name(), "default"), P2.value());
+  EXPECT_EQ(map.getValue("noneSuch", "default"), "default");
+}
+
+TEST(FlatConfigurationPropertyMapTests, GetValueAsInt) {
+  static const ConfigurationProperty P1("p1", "  55  ", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "  55  bad", "someSource", 2);
+  FlatConfigurationPropertyMap map(createMap({ P2, P1 }));
+
+  EXPECT_EQ(map.getValueAsInt(P1.name(), -1), 55);
+  EXPECT_EQ(map.getValueAsInt("noneSuch", -1), -1);
+  EXPECT_THROW(map.getValueAsInt(P2.name(), -1), InvalidPropertyValueError);
+}
+
+TEST(FlatConfigurationPropertyMapTests, GetValueAsDouble) {
+  static const ConfigurationProperty P1("p1", "  0.5  ", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "  0.5  bad", "someSource", 2);
+  FlatConfigurationPropertyMap map(createMap({ P2, P1 }));
+
+  EXPECT_EQ(map.getValueAsDouble(P1.name(), -1.0), 0.5);
+  EXPECT_EQ(map.getValueAsDouble("noneSuch", -1.0), -1.0);
+  EXPECT_THROW(map.getValueAsDouble(P2.name(), -1.0),
+	       InvalidPropertyValueError);
+}
+
+TEST(FlatConfigurationPropertyMapTests, GetFormattedValue) {
+  static const ConfigurationProperty P1("p1", "##good", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "badvalue", "someSource", 2);
+  FlatConfigurationPropertyMap map(createMap({ P2, P1 }));
+  auto formatter = [](const std::string& s) {
+    if ((s.size() < 3) || (s[0] != '#') || (s[1] != '#')) {
+      throw PropertyFormatError("\"##\" prefix missing");
+    }
+    return s.substr(2);
+  };
+
+  EXPECT_EQ(map.getValue(P1.name(), "default", formatter), "good");
+  EXPECT_EQ(map.getValue("noneSuch", "default", formatter), "default");
+  EXPECT_THROW(map.getValue(P2.name(), "default", formatter),
+	       InvalidPropertyValueError);
+}
+
+TEST(FlatConfigurationPropertyMapTests, GetPropertiesMatching) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p1.1", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("p2", "cherry", "someSource", 3);
+  static const ConfigurationProperty P4("p4.4", "lime", "someSource", 5);
+  FlatConfigurationPropertyMap map(createMap({ P1, P2, P3, P4 }));
+
+  std::vector<ConfigurationProperty> matches = map.getPropertiesMatching(
+      [](const std::string& s) { return s.find('.') != std::string::npos; }
+  );
+  ASSERT_EQ(matches.size(), 2);
+  EXPECT_EQ(matches[0], P2);
+  EXPECT_EQ(matches[1], P4);
+}
+
+TEST(FlatConfigurationPropertyMapTests, GetPropertiesWithPrefix) {
+  static const ConfigurationProperty P1("p1", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("p2", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("p1.1", "lemon", "someSource", 4);
+  static const ConfigurationProperty P4("p2.1", "lime", "someSource", 5);
+  static const ConfigurationProperty P5("p1.3", "pineapple", "someSource", 2);
+  static const ConfigurationProperty P6("p1.2", "strawberry", "someSource", 3);
+  static const ConfigurationProperty P7("p5", "kiwi", "someSource", 4);
+  static const ConfigurationProperty P8("p5:1", "mango", "someSource", 5);
+  FlatConfigurationPropertyMap map(
+      createMap({ P1, P2, P3, P4, P5, P6, P7, P8 })
+  );
+
+  std::vector<ConfigurationProperty> matches=
+      map.getPropertiesWithPrefix("p1.");
+  ASSERT_EQ(matches.size(), 3);
+  EXPECT_EQ(matches[0], P3);  // p1.1
+  EXPECT_EQ(matches[1], P6);  // p1.2
+  EXPECT_EQ(matches[2], P5);  // p1.3
+
+  // Matches run to the end of the map
+  matches= map.getPropertiesWithPrefix("p5:1");
+  ASSERT_EQ(matches.size(), 1);
+  EXPECT_EQ(matches[0], P8);
+
+  matches= map.getPropertiesWithPrefix("p4:");
+  EXPECT_TRUE(matches.empty());
+
+  matches= map.getPropertiesWithPrefix("");
+  EXPECT_EQ(matches.size(), map.size());
+}
+
+TEST(FlatConfigurationPropertyMapTests, PropertiesUnder) {
+  static const ConfigurationProperty P1("a", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("a.b", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("a.b.c", "cherry", "someSource", 3);
+  static const ConfigurationProperty P4("a.bc", "lemon", "someSource", 4);
+  static const ConfigurationProperty P5("ab", "lime", "someSource", 5);
+  FlatConfigurationPropertyMap map(createMap({ P5, P4, P3, P2, P1 }));
+
+  auto range= map.propertiesUnder("a");
+  std::vector<ConfigurationProperty> matches(range.begin(), range.end());
+  ASSERT_EQ(matches.size(), 3);
+  EXPECT_EQ(matches[0], P2);
+  EXPECT_EQ(matches[1], P3);
+  EXPECT_EQ(matches[2], P4);
+
+  range= map.propertiesUnder("a.b");
+  matches.assign(range.begin(), range.end());
+  ASSERT_EQ(matches.size(), 1);
+  EXPECT_EQ(matches[0], P3);
+
+  range= map.propertiesUnder("ab");
+  EXPECT_TRUE(range.empty());
+
+  // Prefixes ending in "." use the same index
+  matches= map.getPropertiesWithPrefix("a.");
+  ASSERT_EQ(matches.size(), 3);
+  EXPECT_EQ(matches[0], P2);
+  EXPECT_EQ(matches[2], P4);
+}
+
+TEST(FlatConfigurationPropertyMapTests, PropertiesWithPrefix) {
+  static const ConfigurationProperty P1("a.b", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("a.bc", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("a.c", "cherry", "someSource", 3);
+  static const ConfigurationProperty P4("ab", "lemon", "someSource", 4);
+  static const ConfigurationProperty P5("b", "lime", "someSource", 5);
+  FlatConfigurationPropertyMap map(createMap({ P1, P2, P3, P4, P5 }));
+
+  auto range= map.propertiesWithPrefix("a.b");
+  EXPECT_EQ(range.size(), 2);
+  std::vector<ConfigurationProperty> matches;
+  for (const ConfigurationProperty& p : range) {
+    matches.push_back(p);
+  }
+  ASSERT_EQ(matches.size(), 2);
+  EXPECT_EQ(matches[0], P1);
+  EXPECT_EQ(matches[1], P2);
+
+  range= map.propertiesWithPrefix("a");
+  matches.assign(range.begin(), range.end());
+  ASSERT_EQ(matches.size(), 4);
+  EXPECT_EQ(matches[0], P1);
+  EXPECT_EQ(matches[3], P4);
+
+  range= map.propertiesWithPrefix("a.");
+  EXPECT_EQ(range.size(), 3);
+  EXPECT_EQ(std::count_if(range.begin(), range.end(),
+			  [](const ConfigurationProperty& p) {
+			    return p.value().size() > 5;
+			  }), 2);
+
+  EXPECT_EQ(map.propertiesWithPrefix("").size(), 5);
+  EXPECT_TRUE(map.propertiesWithPrefix("a.bcd").empty());
+  EXPECT_TRUE(map.propertiesWithPrefix("c").empty());
+  EXPECT_TRUE(map.propertiesWithPrefix("0").empty());
+}
+
+TEST(FlatConfigurationPropertyMapTests, PropertiesMatching) {
+  static const ConfigurationProperty P1("a.b", "apple", "someSource", 1);
+  static const ConfigurationProperty P2("a.bc", "banana", "someSource", 2);
+  static const ConfigurationProperty P3("a.c", "cherry", "someSource", 3);
+  static const ConfigurationProperty P4("ab", "lemon", "someSource", 4);
+  static const ConfigurationProperty P5("b", "lime", "someSource", 5);
+  FlatConfigurationPropertyMap map(createMap({ P1, P2, P3, P4, P5 }));
+
+  auto range= map.propertiesMatching([](const std::string& name) {
+    return name.back() != 'b';
+  });
+  std::vector<ConfigurationProperty> matches;
+  for (const ConfigurationProperty& p : range) {
+    matches.push_back(p);
+  }
+  ASSERT_EQ(matches.size(), 2);
+  EXPECT_EQ(matches[0], P2);
+  EXPECT_EQ(matches[1], P3);
+  EXPECT_FALSE(range.empty());
+
+  auto none= map.propertiesMatching([](const std::string&) {
+    return false;
+  });
+  EXPECT_TRUE(none.empty());
+  EXPECT_TRUE(none.begin() == none.end());
+}
@@ -0,0 +1,183 @@
+/** @file IncludeFileCacheTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::IncludeFileCache
+ */
+
+#include <pistis/config_parser/IncludeFileCache.hpp>
+#include <pistis/config_parser/ConfigFileParser.hpp>
+#include <pistis/config_parser/ConfigFileParseError.hpp>
+#include <pistis/config_parser/EnvironmentProvider.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser;
+
+namespace {
+  // Scratch directory for configuration files the tests rewrite
+  class TempDir {
+  public:
+    TempDir(): name_() {
+      char tmpl[]= "/tmp/IncludeFileCacheTests.XXXXXX";
+      if (mkdtemp(tmpl)) {
+	name_= tmpl;
+      }
+    }
+
+    ~TempDir() {
+      for (const std::string& f : files_) {
+	unlink(f.c_str());
+      }
+      if (!name_.empty()) {
+	rmdir(name_.c_str());
+      }
+    }
+
+    const std::string& name() const { return name_; }
+
+    std::string write(const std::string& filename, const std::string& text) {
+      const std::string path= name_ + "/" + filename;
+      std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+      out << text;
+      files_.push_back(path);
+      return path;
+    }
+
+  private:
+    std::string name_;
+    std::vector<std::string> files_;
+  };
+
+  std::unique_ptr<ConfigFileParser> createParser(
+      const std::shared_ptr<IncludeFileCache>& cache
+  ) {
+    std::unique_ptr<ConfigFileParser> parser(
+	new ConfigFileParser(false, ConfigFileParser::DUP_ERROR,
+			     ConfigFileParser::DUP_OVERWRITE)
+    );
+    parser->setIncludeFileCache(cache);
+    return parser;
+  }
+
+  ::testing::AssertionResult verifySameProperties(
+      const ConfigurationPropertyMap& truth,
+      const ConfigurationPropertyMap& properties
+  ) {
+    if (properties.size() != truth.size()) {
+      return ::testing::AssertionFailure()
+	  << "Parsed " << properties.size() << " properties, but there "
+	  << "should be " << truth.size();
+    }
+    for (auto i= truth.begin(); i != truth.end(); ++i) {
+      if (!properties.hasKey(i->name())) {
+	return ::testing::AssertionFailure()
+	    << "Property " << i->name() << " is missing";
+      } else if (properties[i->name()] != *i) {
+	const ConfigurationProperty& p= properties[i->name()];
+	return ::testing::AssertionFailure()
+	    << "Property " << i->name() << " is [" << p.value() << "] from "
+	    << p.source() << ":" << p.line() << "; it should be ["
+	    << i->value() << "] from " << i->source() << ":" << i->line();
+      }
+    }
+    return ::testing::AssertionSuccess();
+  }
+}
+
+TEST(IncludeFileCacheTests, ReuseAndInvalidate) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  const std::string common= dir.write("common.cfg", "c1= one\nc2= two\n");
+  dir.write("a.cfg", "include \"common.cfg\"\na1= alpha\n");
+  dir.write("b.cfg", "include \"./common.cfg\"\nb1= beta\n");
+  const std::string root=
+      dir.write("root.cfg", "include \"a.cfg\"\ninclude \"b.cfg\"\nr= root\n");
+
+  std::shared_ptr<IncludeFileCache> cache=
+      std::make_shared<IncludeFileCache>();
+  std::unique_ptr<ConfigFileParser> uncached= createParser(nullptr);
+  ConfigurationPropertyMap truth= uncached->parse(root);
+  ASSERT_EQ(truth.size(), 5);
+
+  // a.cfg, common.cfg and b.cfg are parsed.  The second include of
+  // common.cfg is spelled differently, but is the same file.
+  std::unique_ptr<ConfigFileParser> parser= createParser(cache);
+  EXPECT_TRUE(verifySameProperties(truth, parser->parse(root)));
+  EXPECT_EQ(cache->misses(), 3);
+  EXPECT_EQ(cache->hits(), 1);
+  EXPECT_EQ(cache->size(), 3);
+
+  // Another parser sharing the cache reuses a.cfg and b.cfg
+  std::unique_ptr<ConfigFileParser> other= createParser(cache);
+  EXPECT_TRUE(verifySameProperties(truth, other->parse(root)));
+  EXPECT_EQ(cache->misses(), 3);
+  EXPECT_EQ(cache->hits(), 3);
+
+  // Changing common.cfg invalidates it and every file that includes it
+  dir.write("common.cfg", "c1= one\nc2= two\nc3= three\n");
+  truth= uncached->parse(root);
+  ASSERT_EQ(truth.size(), 6);
+  EXPECT_TRUE(verifySameProperties(truth, parser->parse(root)));
+  EXPECT_EQ(cache->misses(), 6);
+  EXPECT_EQ(cache->hits(), 4);
+  EXPECT_EQ(cache->size(), 3);
+
+  cache->clear();
+  EXPECT_EQ(cache->size(), 0);
+  EXPECT_TRUE(verifySameProperties(truth, parser->parse(root)));
+  EXPECT_EQ(cache->misses(), 9);
+}
+
+TEST(IncludeFileCacheTests, RecursiveIncludeFromCache) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  dir.write("loop_1.cfg", "include \"loop_2.cfg\"\n");
+  dir.write("loop_2.cfg", "x= 1\n");
+  const std::string first= dir.write("first.cfg", "include \"loop_1.cfg\"\n");
+
+  std::shared_ptr<IncludeFileCache> cache=
+      std::make_shared<IncludeFileCache>();
+  std::unique_ptr<ConfigFileParser> parser= createParser(cache);
+  EXPECT_EQ(parser->parse(first).size(), 1);
+
+  // loop_2.cfg now includes loop_1.cfg, so the cached entry for
+  // loop_1.cfg is stale and the recursion must still be reported
+  dir.write("loop_2.cfg", "include \"loop_1.cfg\"\n");
+  EXPECT_THROW(parser->parse(first), ConfigFileParseError);
+}
+
+TEST(IncludeFileCacheTests, InvalidateChangedEnvironment) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  dir.write("inc.cfg", "x = ${FOO}\n");
+  const std::string root= dir.write("root.cfg", "include \"inc.cfg\"\n");
+
+  std::shared_ptr<IncludeFileCache> cache=
+      std::make_shared<IncludeFileCache>();
+  auto parse= [&cache, &root](const std::string& foo) {
+    ConfigFileParser parser(true, ConfigFileParser::DUP_ERROR,
+			    ConfigFileParser::DUP_OVERWRITE);
+    parser.setIncludeFileCache(cache);
+    parser.setEnvironmentProvider(
+	std::make_shared<FixedEnvironmentProvider>(
+	    std::shared_ptr<const EnvironmentSnapshot>(
+		new EnvironmentSnapshot{ { "FOO", foo } }
+	    )
+	)
+    );
+    return parser.parse(root)["x"].value();
+  };
+
+  EXPECT_EQ(parse("one"), "one");
+  EXPECT_EQ(parse("one"), "one");
+  EXPECT_EQ(cache->hits(), 1);
+
+  // The entry for inc.cfg substituted FOO=one, so it cannot be used
+  EXPECT_EQ(parse("two"), "two");
+  EXPECT_EQ(cache->hits(), 1);
+  EXPECT_EQ(cache->misses(), 2);
+}
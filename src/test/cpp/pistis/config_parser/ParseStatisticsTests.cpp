@@ -0,0 +1,97 @@
+/** @file ParseStatisticsTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::ParseStatistics
+ */
+
+#include <pistis/config_parser/ParseStatistics.hpp>
+#include <pistis/config_parser/ConfigFileParser.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <stdlib.h>
+
+using namespace pistis::config_parser;
+
+namespace {
+  const std::string& resourceDir() {
+    static std::string RESOURCE_DIR;
+    if (RESOURCE_DIR.empty()) {
+      const char* d= getenv("UT_RESOURCE_DIR");
+      if (d) {
+	RESOURCE_DIR= d;
+      }
+      if (RESOURCE_DIR.empty()) {
+	RESOURCE_DIR= "./";
+      } else if (RESOURCE_DIR[RESOURCE_DIR.size()-1] != '/') {
+	RESOURCE_DIR += "/";
+      }
+    }
+    return RESOURCE_DIR;
+  }
+
+  uint64_t fakeAllocations= 0;
+
+  uint64_t countFakeAllocations() {
+    return fakeAllocations;
+  }
+}
+
+TEST(ParseStatisticsTests, Timer) {
+  ParseStatistics statistics(&countFakeAllocations);
+  for (int i= 0; i < ParseStatistics::NUM_PHASES; ++i) {
+    ParseStatistics::PhaseTotals totals=
+	statistics.phase((ParseStatistics::Phase)i);
+    EXPECT_EQ(totals.count, 0);
+    EXPECT_EQ(totals.nanoseconds, 0);
+    EXPECT_EQ(totals.allocations, 0);
+  }
+
+  {
+    ParseStatistics::Timer timer(&statistics, ParseStatistics::MAP_INSERT);
+    fakeAllocations += 3;
+  }
+  {
+    ParseStatistics::Timer timer(&statistics, ParseStatistics::MAP_INSERT);
+    ParseStatistics::Timer ignored(nullptr, ParseStatistics::LEX);
+    fakeAllocations += 2;
+  }
+  ParseStatistics::PhaseTotals totals=
+      statistics.phase(ParseStatistics::MAP_INSERT);
+  EXPECT_EQ(totals.count, 2);
+  EXPECT_EQ(totals.allocations, 5);
+  EXPECT_EQ(statistics.phase(ParseStatistics::LEX).count, 0);
+
+  statistics.add(ParseStatistics::LEX, 1000, 7);
+  totals= statistics.phase(ParseStatistics::LEX);
+  EXPECT_EQ(totals.count, 1);
+  EXPECT_EQ(totals.nanoseconds, 1000);
+  EXPECT_EQ(totals.allocations, 7);
+
+  statistics.clear();
+  EXPECT_EQ(statistics.phase(ParseStatistics::LEX).count, 0);
+  EXPECT_EQ(statistics.phase(ParseStatistics::MAP_INSERT).count, 0);
+}
+
+TEST(ParseStatisticsTests, CollectFromParser) {
+  std::shared_ptr<ParseStatistics> statistics=
+      std::make_shared<ParseStatistics>();
+  ConfigFileParser parser;
+  EXPECT_EQ(parser.statistics(), nullptr);
+  parser.setStatistics(statistics);
+  EXPECT_EQ(parser.statistics(), statistics);
+
+  // include_test.cfg assigns p1, p2 and p4 and includes included.cfg,
+  // which assigns p2 and p3
+  EXPECT_EQ(parser.parse(resourceDir() + "include_test.cfg").size(), 4);
+  EXPECT_GT(statistics->phase(ParseStatistics::LEX).count, 5);
+  EXPECT_EQ(statistics->phase(ParseStatistics::VALUE_PROCESSING).count, 5);
+  EXPECT_EQ(statistics->phase(ParseStatistics::MAP_INSERT).count, 5);
+  EXPECT_EQ(statistics->phase(ParseStatistics::INCLUDE_MERGE).count, 1);
+  EXPECT_EQ(statistics->phase(ParseStatistics::MAP_INSERT).allocations, 0);
+}
+
+TEST(ParseStatisticsTests, PhaseName) {
+  EXPECT_STREQ(ParseStatistics::phaseName(ParseStatistics::LEX), "lex");
+  EXPECT_STREQ(ParseStatistics::phaseName(ParseStatistics::INCLUDE_MERGE),
+	       "include merge");
+}
@@ -0,0 +1,151 @@
+/** @file ReloadableConfigurationTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::ReloadableConfiguration
+ */
+
+#include <pistis/config_parser/ReloadableConfiguration.hpp>
+#include <pistis/config_parser/ApplicationConfiguration.hpp>
+#include <pistis/config_parser/ConfigFileParseError.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace pistis::config_parser;
+
+namespace {
+  class ServerConfig : public ApplicationConfiguration {
+  public:
+    ServerConfig(): ApplicationConfiguration(false), port_(80), copy_(80),
+		    name_("default") {
+      registerProperty_("port", true, false, port_);
+      registerProperty_("copy", false, false, copy_);
+      registerProperty_("name", false, false, name_);
+    }
+
+    int port() const { return port_; }
+    int copy() const { return copy_; }
+    const std::string& name() const { return name_; }
+
+  private:
+    int port_;
+    int copy_;
+    std::string name_;
+  };
+
+  std::string configText(int port, const std::string& name) {
+    std::ostringstream text;
+    text << "port= " << port << "\ncopy= " << port << "\nname= " << name
+	 << "\n";
+    return text.str();
+  }
+}
+
+TEST(ReloadableConfigurationTests, Reload) {
+  ReloadableConfiguration<ServerConfig> config;
+  EXPECT_EQ(config.version(), 0);
+  EXPECT_EQ(config.current()->port(), 80);
+  EXPECT_EQ(config.current()->name(), "default");
+
+  std::shared_ptr<const ServerConfig> first= config.current();
+  std::shared_ptr<const ServerConfig> second=
+      config.reloadFromText("test", configText(8080, "second"));
+  EXPECT_EQ(config.version(), 1);
+  EXPECT_EQ(config.current(), second);
+  EXPECT_EQ(second->port(), 8080);
+  EXPECT_EQ(second->name(), "second");
+
+  // Earlier versions are untouched
+  EXPECT_EQ(first->port(), 80);
+  EXPECT_EQ(first->name(), "default");
+
+  std::istringstream input(configText(9090, "third"));
+  config.reload("test", input);
+  EXPECT_EQ(config.version(), 2);
+  EXPECT_EQ(config.current()->port(), 9090);
+  EXPECT_EQ(second->port(), 8080);
+}
+
+TEST(ReloadableConfigurationTests, FailedReloadKeepsCurrent) {
+  ReloadableConfiguration<ServerConfig> config;
+  config.reloadFromText("test", configText(8080, "good"));
+  std::shared_ptr<const ServerConfig> good= config.current();
+
+  EXPECT_THROW(config.reloadFromText("test", "port= not_a_number\n"),
+	       ApplicationConfigurationError);
+  EXPECT_THROW(config.reloadFromText("test", "name= no_port\n"),
+	       ApplicationConfigurationError);
+  EXPECT_EQ(config.current(), good);
+  EXPECT_EQ(config.version(), 1);
+
+  config.setValidator([](const ServerConfig& c) {
+    if (c.port() < 1024) {
+      throw std::invalid_argument("Port must be at least 1024");
+    }
+  });
+  EXPECT_THROW(config.reloadFromText("test", configText(80, "privileged")),
+	       std::invalid_argument);
+  EXPECT_EQ(config.current(), good);
+  config.reloadFromText("test", configText(1024, "ok"));
+  EXPECT_EQ(config.current()->name(), "ok");
+}
+
+TEST(ReloadableConfigurationTests, Reader) {
+  ReloadableConfiguration<ServerConfig> config;
+  ReloadableConfiguration<ServerConfig>::Reader reader(config);
+  EXPECT_EQ(reader.get().port(), 80);
+
+  config.reloadFromText("test", configText(8080, "new"));
+  EXPECT_EQ(reader->port(), 8080);
+  EXPECT_EQ((*reader).name(), "new");
+}
+
+TEST(ReloadableConfigurationTests, ReloadMap) {
+  ReloadableConfiguration<ConfigurationPropertyMap> properties;
+  EXPECT_EQ(properties.current()->size(), 0);
+
+  ConfigFileParser parser;
+  properties.reload([&parser](ConfigurationPropertyMap& m) {
+    m= parser.parseText("test", "a= 1\nb= 2\n");
+  });
+  EXPECT_EQ(properties.current()->size(), 2);
+  EXPECT_EQ((*properties.current())["b"].value(), "2");
+}
+
+TEST(ReloadableConfigurationTests, ReadWhileReloading) {
+  const int NUM_READERS= 4;
+  const int NUM_RELOADS= 200;
+  ReloadableConfiguration<ServerConfig> config;
+  std::atomic<bool> done(false);
+  std::atomic<int> inconsistent(0);
+  std::vector<std::thread> readers;
+
+  for (int i= 0; i < NUM_READERS; ++i) {
+    readers.emplace_back([&config, &done, &inconsistent]() {
+      ReloadableConfiguration<ServerConfig>::Reader reader(config);
+      int lastPort= 0;
+      while (!done.load()) {
+	const ServerConfig& c= reader.get();
+	// Every published version has port == copy, and versions only
+	// move forward
+	if ((c.port() != c.copy()) || (c.port() < lastPort)) {
+	  ++inconsistent;
+	}
+	lastPort= c.port();
+      }
+    });
+  }
+
+  for (int i= 1; i <= NUM_RELOADS; ++i) {
+    config.reloadFromText("test", configText(1000 + i, "reload"));
+  }
+  done= true;
+  for (auto& t : readers) {
+    t.join();
+  }
+  EXPECT_EQ(inconsistent.load(), 0);
+  EXPECT_EQ(config.version(), NUM_RELOADS);
+  EXPECT_EQ(config.current()->port(), 1000 + NUM_RELOADS);
+}
@@ -0,0 +1,304 @@
+/** @file SourceGraphTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::SourceGraph
+ */
+
+#include <pistis/config_parser/SourceGraph.hpp>
+#include <pistis/config_parser/ConfigFileParser.hpp>
+#include <pistis/config_parser/ConfigFileParseError.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser;
+
+namespace {
+  // Scratch directory for configuration files the tests rewrite
+  class TempDir {
+  public:
+    TempDir(): name_() {
+      char tmpl[]= "/tmp/SourceGraphTests.XXXXXX";
+      if (mkdtemp(tmpl)) {
+	name_= tmpl;
+      }
+    }
+
+    ~TempDir() {
+      for (const std::string& f : files_) {
+	unlink(f.c_str());
+      }
+      if (!name_.empty()) {
+	rmdir(name_.c_str());
+      }
+    }
+
+    const std::string& name() const { return name_; }
+
+    std::string write(const std::string& filename, const std::string& text) {
+      const std::string path= name_ + "/" + filename;
+      std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+      out << text;
+      files_.push_back(path);
+      return path;
+    }
+
+  private:
+    std::string name_;
+    std::vector<std::string> files_;
+  };
+
+  std::unique_ptr<ConfigFileParser> createParser(
+      const std::shared_ptr<SourceGraph>& graph,
+      ConfigFileParser::DuplicatePropertyMode includedPropertyAction=
+	  ConfigFileParser::DUP_OVERWRITE
+  ) {
+    std::unique_ptr<ConfigFileParser> parser(
+	new ConfigFileParser(true, ConfigFileParser::DUP_ERROR,
+			     includedPropertyAction)
+    );
+    parser->setSourceGraph(graph);
+    return parser;
+  }
+
+  ::testing::AssertionResult verifySameProperties(
+      const ConfigurationPropertyMap& truth,
+      const ConfigurationPropertyMap& properties
+  ) {
+    if (properties.size() != truth.size()) {
+      return ::testing::AssertionFailure()
+	  << "Parsed " << properties.size() << " properties, but there "
+	  << "should be " << truth.size();
+    }
+    for (auto i= truth.begin(); i != truth.end(); ++i) {
+      if (!properties.hasKey(i->name())) {
+	return ::testing::AssertionFailure()
+	    << "Property " << i->name() << " is missing";
+      } else if (properties[i->name()] != *i) {
+	const ConfigurationProperty& p= properties[i->name()];
+	return ::testing::AssertionFailure()
+	    << "Property " << i->name() << " is [" << p.value() << "] from "
+	    << p.source() << ":" << p.line() << "; it should be ["
+	    << i->value() << "] from " << i->source() << ":" << i->line();
+      }
+    }
+    return ::testing::AssertionSuccess();
+  }
+}
+
+TEST(SourceGraphTests, ReparseChangedFiles) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  dir.write("common.cfg", "c1= one\nc2= two\n");
+  dir.write("a.cfg", "include \"common.cfg\"\na1= alpha-${c1}\n");
+  dir.write("b.cfg", "b1= beta\n");
+  const std::string root=
+      dir.write("root.cfg", "include \"a.cfg\"\ninclude \"b.cfg\"\n"
+			    "x= ${a1}\ny= ${b1}\nz= plain\n");
+
+  std::shared_ptr<SourceGraph> graph= std::make_shared<SourceGraph>();
+  std::unique_ptr<ConfigFileParser> full= createParser(nullptr);
+  std::unique_ptr<ConfigFileParser> parser= createParser(graph);
+  ConfigurationPropertyMap truth= full->parse(root);
+  ASSERT_EQ(truth.size(), 7);
+
+  EXPECT_TRUE(verifySameProperties(truth, parser->parse(root)));
+  EXPECT_EQ(graph->size(), 4);
+  EXPECT_EQ(graph->filesParsed(), 4);
+  EXPECT_EQ(graph->filesReplayed(), 0);
+  EXPECT_EQ(graph->filesReused(), 0);
+
+  // Nothing has changed, so every file is reused
+  EXPECT_TRUE(verifySameProperties(truth, parser->parse(root)));
+  EXPECT_EQ(graph->filesParsed(), 4);
+  EXPECT_EQ(graph->filesReplayed(), 0);
+  EXPECT_EQ(graph->filesReused(), 4);
+
+  // b.cfg is parsed again and root.cfg is replayed, substituting only
+  // the value of y again
+  dir.write("b.cfg", "b1= beta too\n");
+  truth= full->parse(root);
+  EXPECT_EQ(truth["y"].value(), "beta too");
+  EXPECT_TRUE(verifySameProperties(truth, parser->parse(root)));
+  EXPECT_EQ(graph->filesParsed(), 5);
+  EXPECT_EQ(graph->filesReplayed(), 1);
+  EXPECT_EQ(graph->filesReused(), 6);
+  EXPECT_EQ(graph->valuesReprocessed(), 1);
+
+  // A change to common.cfg reaches root.cfg through a.cfg
+  dir.write("common.cfg", "c1= uno\nc2= two\nc3= three\n");
+  truth= full->parse(root);
+  EXPECT_EQ(truth["x"].value(), "alpha-uno");
+  EXPECT_TRUE(verifySameProperties(truth, parser->parse(root)));
+  EXPECT_EQ(graph->filesParsed(), 6);
+  EXPECT_EQ(graph->filesReplayed(), 3);
+  EXPECT_EQ(graph->filesReused(), 7);
+  EXPECT_EQ(graph->valuesReprocessed(), 3);
+
+  // A change that does not affect any reference substitutes nothing
+  dir.write("common.cfg", "c1= uno\nc2= dos\n");
+  truth= full->parse(root);
+  EXPECT_TRUE(verifySameProperties(truth, parser->parse(root)));
+  EXPECT_EQ(graph->filesReplayed(), 5);
+  EXPECT_EQ(graph->valuesReprocessed(), 3);
+
+  // Another parser sharing the graph reuses everything
+  std::unique_ptr<ConfigFileParser> other= createParser(graph);
+  EXPECT_TRUE(verifySameProperties(truth, other->parse(root)));
+  EXPECT_EQ(graph->filesParsed(), 7);
+  EXPECT_EQ(graph->filesReused(), 12);
+
+  graph->clear();
+  EXPECT_EQ(graph->size(), 0);
+  EXPECT_TRUE(verifySameProperties(truth, parser->parse(root)));
+  EXPECT_EQ(graph->filesParsed(), 11);
+}
+
+TEST(SourceGraphTests, ReplayReportsErrors) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  dir.write("a.cfg", "a1= 1\n");
+  const std::string root=
+      dir.write("root.cfg", "include \"a.cfg\"\nx= ${a1}\n");
+
+  std::shared_ptr<SourceGraph> graph= std::make_shared<SourceGraph>();
+  std::unique_ptr<ConfigFileParser> full=
+      createParser(nullptr, ConfigFileParser::DUP_ERROR);
+  std::unique_ptr<ConfigFileParser> parser=
+      createParser(graph, ConfigFileParser::DUP_ERROR);
+  EXPECT_TRUE(verifySameProperties(full->parse(root), parser->parse(root)));
+
+  // x is now defined by a.cfg as well, and the duplicate must be
+  // reported while replaying root.cfg
+  dir.write("a.cfg", "a1= 1\nx= 2\n");
+  std::string fullError;
+  std::string replayError;
+  try {
+    full->parse(root);
+  } catch(const ConfigFileParseError& e) {
+    fullError= e.what();
+  }
+  try {
+    parser->parse(root);
+  } catch(const ConfigFileParseError& e) {
+    replayError= e.what();
+  }
+  EXPECT_FALSE(fullError.empty());
+  EXPECT_EQ(replayError, fullError);
+
+  // So must a reference that no longer resolves
+  dir.write("a.cfg", "a2= 1\n");
+  fullError.clear();
+  replayError.clear();
+  try {
+    full->parse(root);
+  } catch(const ConfigFileParseError& e) {
+    fullError= e.what();
+  }
+  try {
+    parser->parse(root);
+  } catch(const ConfigFileParseError& e) {
+    replayError= e.what();
+  }
+  EXPECT_FALSE(fullError.empty());
+  EXPECT_EQ(replayError, fullError);
+
+  dir.write("a.cfg", "a1= 3\n");
+  ConfigurationPropertyMap properties= parser->parse(root);
+  EXPECT_EQ(properties["x"].value(), "3");
+}
+
+TEST(SourceGraphTests, ReplayChangedEnvironment) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  const std::string root=
+      dir.write("root.cfg", "home= ${SOURCE_GRAPH_TEST_VAR}/home\n"
+			    "other= fixed\n");
+
+  std::shared_ptr<SourceGraph> graph= std::make_shared<SourceGraph>();
+  std::unique_ptr<ConfigFileParser> parser= createParser(graph);
+  setenv("SOURCE_GRAPH_TEST_VAR", "/first", 1);
+  EXPECT_EQ(parser->parse(root)["home"].value(), "/first/home");
+  EXPECT_EQ(parser->parse(root)["home"].value(), "/first/home");
+  EXPECT_EQ(graph->filesReused(), 1);
+
+  setenv("SOURCE_GRAPH_TEST_VAR", "/second", 1);
+  EXPECT_EQ(parser->parse(root)["home"].value(), "/second/home");
+  EXPECT_EQ(graph->filesParsed(), 1);
+  EXPECT_EQ(graph->filesReplayed(), 1);
+  EXPECT_EQ(graph->valuesReprocessed(), 1);
+
+  unsetenv("SOURCE_GRAPH_TEST_VAR");
+  EXPECT_THROW(parser->parse(root), ConfigFileParseError);
+}
+
+TEST(SourceGraphTests, ReplayReusesCompiledValues) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  const std::string root=
+      dir.write("root.cfg", "home= \\t${SOURCE_GRAPH_TEST_VAR}/home\n"
+			    "other= fixed\n");
+
+  std::shared_ptr<SourceGraph> graph= std::make_shared<SourceGraph>();
+  std::unique_ptr<ConfigFileParser> parser= createParser(graph);
+  setenv("SOURCE_GRAPH_TEST_VAR", "/first", 1);
+  EXPECT_EQ(parser->parse(root)["home"].value(), "\t/first/home");
+  ASSERT_EQ(graph->size(), 1);
+  EXPECT_FALSE(graph->nodes()[0]->statements[0].compiled);
+
+  setenv("SOURCE_GRAPH_TEST_VAR", "/second", 1);
+  EXPECT_EQ(parser->parse(root)["home"].value(), "\t/second/home");
+  std::shared_ptr<const detail::ValueTemplate> compiled=
+      graph->nodes()[0]->statements[0].compiled;
+  ASSERT_TRUE(compiled);
+  EXPECT_EQ(compiled->numReferences(), 1);
+  EXPECT_EQ(compiled->literal(0), "\t");
+
+  setenv("SOURCE_GRAPH_TEST_VAR", "/third", 1);
+  EXPECT_EQ(parser->parse(root)["home"].value(), "\t/third/home");
+  EXPECT_EQ(graph->nodes()[0]->statements[0].compiled, compiled);
+  EXPECT_EQ(graph->filesReplayed(), 2);
+  EXPECT_EQ(graph->valuesReprocessed(), 2);
+
+  unsetenv("SOURCE_GRAPH_TEST_VAR");
+  EXPECT_THROW(parser->parse(root), ConfigFileParseError);
+}
+
+TEST(SourceGraphTests, PruneFilesNoLongerIncluded) {
+  TempDir dir;
+  ASSERT_FALSE(dir.name().empty());
+  dir.write("a.cfg", "a1= 1\n");
+  dir.write("b.cfg", "b1= 2\n");
+  dir.write("c.cfg", "c1= 3\n");
+  const std::string root=
+      dir.write("root.cfg", "include \"a.cfg\"\ninclude \"b.cfg\"\n");
+  const std::string other= dir.write("other.cfg", "include \"c.cfg\"\n");
+
+  std::shared_ptr<SourceGraph> graph= std::make_shared<SourceGraph>();
+  std::unique_ptr<ConfigFileParser> parser= createParser(graph);
+  EXPECT_EQ(parser->parse(root).size(), 2);
+  EXPECT_EQ(parser->parse(other).size(), 1);
+  EXPECT_EQ(graph->size(), 5);
+
+  // b.cfg is no longer included by anything, but other.cfg still
+  // includes c.cfg
+  dir.write("root.cfg", "include \"a.cfg\"\n");
+  EXPECT_EQ(parser->parse(root).size(), 1);
+  EXPECT_EQ(graph->size(), 4);
+  for (const std::shared_ptr<const SourceGraph::Node>& n : graph->nodes()) {
+    EXPECT_NE(n->filename, dir.name() + "/b.cfg");
+  }
+
+  // Replaying root.cfg keeps the files it still includes
+  dir.write("a.cfg", "a1= 4\n");
+  EXPECT_EQ(parser->parse(root)["a1"].value(), "4");
+  EXPECT_EQ(graph->size(), 4);
+  EXPECT_EQ(graph->prune("no such key"), 0);
+
+  graph->clear();
+  EXPECT_EQ(parser->parse(root).size(), 1);
+  EXPECT_EQ(graph->size(), 2);
+}
@@ -0,0 +1,115 @@
+/** @file CharacterScannerTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::detail::CharacterScanner
+ */
+
+#include <pistis/config_parser/detail/CharacterScanner.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <ctype.h>
+
+using namespace pistis::config_parser::detail;
+
+namespace {
+  std::vector<CharacterScanner::Implementation> supportedImplementations() {
+    std::vector<CharacterScanner::Implementation> result;
+    for (auto impl : { CharacterScanner::SCALAR, CharacterScanner::SSE2,
+	               CharacterScanner::AVX2 }) {
+      if (CharacterScanner::isSupported(impl)) {
+	result.push_back(impl);
+      }
+    }
+    return result;
+  }
+
+  // Random text drawn mostly from the classes the scanner distinguishes,
+  // plus some bytes with the high bit set
+  std::string randomText(std::mt19937& rng, size_t length,
+			 const std::string& alphabet) {
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    std::string text;
+    for (size_t i= 0; i < length; ++i) {
+      text.push_back(alphabet[pick(rng)]);
+    }
+    return text;
+  }
+}
+
+TEST(CharacterScannerTests, ClassifyCharacters) {
+  for (int i= 0; i < 128; ++i) {
+    char ch= (char)i;
+    EXPECT_EQ(CharacterScanner::isWhitespace(ch), (bool)isspace(i)) << i;
+    EXPECT_EQ(CharacterScanner::isAlnum(ch), (bool)isalnum(i)) << i;
+  }
+  for (int i= 128; i < 256; ++i) {
+    EXPECT_FALSE(CharacterScanner::isWhitespace((char)i)) << i;
+    EXPECT_FALSE(CharacterScanner::isAlnum((char)i)) << i;
+  }
+}
+
+TEST(CharacterScannerTests, FallBackToSupportedImplementation) {
+  EXPECT_TRUE(CharacterScanner::isSupported(CharacterScanner::SCALAR));
+  EXPECT_TRUE(
+      CharacterScanner::isSupported(
+          CharacterScanner::instance().implementation()
+      )
+  );
+  for (auto impl : { CharacterScanner::SCALAR, CharacterScanner::SSE2,
+	             CharacterScanner::AVX2 }) {
+    CharacterScanner scanner(impl);
+    EXPECT_TRUE(CharacterScanner::isSupported(scanner.implementation()));
+  }
+}
+
+TEST(CharacterScannerTests, ImplementationsAgree) {
+  const std::string ALPHABET= " \t\r\n\v\fabcXYZ019_.${}\\\"#=-\x80\xff";
+  const CharacterScanner scalar(CharacterScanner::SCALAR);
+  std::mt19937 rng(12345);
+
+  for (auto impl : supportedImplementations()) {
+    const CharacterScanner scanner(impl);
+    for (size_t length= 0; length < 100; ++length) {
+      for (int trial= 0; trial < 20; ++trial) {
+	// Long runs of one class exercise the vector loops, random text
+	// exercises the boundaries
+	std::string text=
+	    randomText(rng, length / 2, (trial & 1) ? " \t" : "aZ9_.") +
+	    randomText(rng, length - length / 2, ALPHABET);
+	const char* begin= text.data();
+	const char* end= begin + text.size();
+
+	for (size_t offset= 0; offset <= std::min(text.size(), (size_t)3);
+	     ++offset) {
+	  const char* p= begin + offset;
+	  EXPECT_EQ(scanner.skipWhitespace(p, end),
+		    scalar.skipWhitespace(p, end))
+	      << impl << " [" << text << "] + " << offset;
+	  EXPECT_EQ(scanner.skipNameChars(p, end),
+		    scalar.skipNameChars(p, end))
+	      << impl << " [" << text << "] + " << offset;
+	  EXPECT_EQ(scanner.findEither(p, end, '$', '\\'),
+		    scalar.findEither(p, end, '$', '\\'))
+	      << impl << " [" << text << "] + " << offset;
+	}
+      }
+    }
+  }
+}
+
+TEST(CharacterScannerTests, Scan) {
+  const std::string TEXT= "  \t  some_name.with.dots = ${value} \\n";
+  const char* begin= TEXT.data();
+  const char* end= begin + TEXT.size();
+
+  for (auto impl : supportedImplementations()) {
+    const CharacterScanner scanner(impl);
+    const char* name= scanner.skipWhitespace(begin, end);
+    EXPECT_EQ(name - begin, 5) << impl;
+    EXPECT_EQ(scanner.skipNameChars(name, end) - begin, 24) << impl;
+    EXPECT_EQ(scanner.findEither(begin, end, '$', '\\') - begin, 27) << impl;
+    EXPECT_EQ(scanner.findEither(begin, end, '!', '?'), end) << impl;
+    EXPECT_EQ(scanner.skipWhitespace(end, end), end) << impl;
+  }
+}
@@ -92,76 +92,162 @@ This is line #2\\\n\
     return TRUTH;
   };
 
-}
+  ::testing::AssertionResult verifyTokens(ConfigFileLexer& lexer) {
+    const std::vector<Token> TRUTH = getTruth();
+    std::vector<Token>::const_iterator i = TRUTH.begin();
+    std::vector<Token> received;
+    int quoteState = 0;
+    Token t(TokenType::END_OF_FILE, "", 0, 0);
 
-TEST(ConfigFileLexerTests, Tokenize) {
-  const std::vector<Token> TRUTH = getTruth();
-  std::istringstream input(INPUT_TEXT);
-  ConfigFileLexer lexer(input, START_LINE, START_COLUMN);
-  std::vector<Token>::const_iterator i = TRUTH.begin();
-  std::vector<Token> received;
-  int quoteState = 0;
-  Token t(TokenType::END_OF_FILE, "", 0, 0);
+    do {
+      t = lexer.next();
+      received.push_back(t);
 
-  do {
-    t = lexer.next();
-    received.push_back(t);
+      if (quoteState) {
+	++quoteState;
+      }
+      if (t.type() != TokenType::PUNCTUATION) {
+	// Don't need to do anything special
+      } else if (t.value() == "=") {
+	lexer.parseNextAsValue();
+      } else if ((t.value() == "\"") && (!quoteState)) {
+	lexer.parseNextAsQuotedString();
+	quoteState = 1;
+      }
 
-    if (quoteState) {
-      ++quoteState;
-    }
-    if (t.type() != TokenType::PUNCTUATION) {
-      // Don't need to do anything special
-    } else if (t.value() == "=") {
-      lexer.parseNextAsValue();
-    } else if ((t.value() == "\"") && (!quoteState)) {
-      lexer.parseNextAsQuotedString();
-      quoteState = 1;
-    }
+      if (quoteState >= 3) {
+	quoteState= 0;
+      }
 
-    if (quoteState >= 3) {
-      quoteState= 0;
-    }
+      if (i == TRUTH.end()) {
+	std::ostringstream msg;
+	auto writeToken = [&msg](const Token& t) { msg << "\n  " << t; };
+	msg << "FAILED!  Extra token " << t
+	    << " past end-of-file.\nReceived tokens are:";
+	std::for_each(received.begin(), received.end(), writeToken);
+	msg << "\nToken stream should be:";
+	std::for_each(TRUTH.begin(), TRUTH.end(), writeToken);
+	msg << "\n";
+	return ::testing::AssertionFailure() << msg.str();
+      } else if (t != *i) {
+	std::ostringstream msg;
+	auto writeToken= [&msg](const Token& t) { msg << "\n  " << t; };
+	msg << "FAILED!  Tokens at position " << received.size()-1
+	    << " do not match.  Received tokens:";
+	std::for_each(received.begin(), received.end(), writeToken);
+	msg << "\nTokens should be:";
+	std::for_each(TRUTH.begin(), TRUTH.begin() + received.size(),
+		    writeToken);
+	msg << "\n";
+	return ::testing::AssertionFailure() << msg.str();
+      }
 
-    if (i == TRUTH.end()) {
-      std::ostringstream msg;
-      auto writeToken = [&msg](const Token& t) { msg << "\n  " << t; };
-      msg << "FAILED!  Extra token " << t
-	  << " past end-of-file.\nReceived tokens are:";
-      std::for_each(received.begin(), received.end(), writeToken);
-      msg << "\nToken stream should be:";
-      std::for_each(TRUTH.begin(), TRUTH.end(), writeToken);
-      msg << "\n";
-      FAIL() << msg.str();
-      return;
-    } else if (t != *i) {
+      ++i;
+    } while (t.type() != TokenType::END_OF_FILE);
+
+    if (i != TRUTH.end()) {
       std::ostringstream msg;
       auto writeToken= [&msg](const Token& t) { msg << "\n  " << t; };
-      msg << "FAILED!  Tokens at position " << received.size()-1
-	  << " do not match.  Received tokens:";
+
+      msg << "FAILED!  Premature end-of-file.  Tokens received:";
       std::for_each(received.begin(), received.end(), writeToken);
-      msg << "\nTokens should be:";
-      std::for_each(TRUTH.begin(), TRUTH.begin() + received.size(),
-		    writeToken);
+      msg << "Token stream should be:";
+      std::for_each(TRUTH.begin(), TRUTH.end(), writeToken);
       msg << "\n";
-      FAIL() << msg.str();
-      return;
+      return ::testing::AssertionFailure() << msg.str();
     }
 
-    ++i;
-  } while (t.type() != TokenType::END_OF_FILE);
+    return ::testing::AssertionSuccess();
+  }
+}
 
-  if (i != TRUTH.end()) {
-    std::ostringstream msg;
-    auto writeToken= [&msg](const Token& t) { msg << "\n  " << t; };
+TEST(ConfigFileLexerTests, Tokenize) {
+  std::istringstream input(INPUT_TEXT);
+  ConfigFileLexer lexer(input, START_LINE, START_COLUMN);
+  EXPECT_TRUE(verifyTokens(lexer));
+}
+
+TEST(ConfigFileLexerTests, TokenizeInChunks) {
+  // Small chunks split names, values and continuations between reads
+  for (size_t chunkSize : { 1, 2, 3, 7, 16, 61 }) {
+    std::istringstream input(INPUT_TEXT);
+    ConfigFileLexer lexer(input, START_LINE, START_COLUMN, chunkSize);
+    EXPECT_TRUE(verifyTokens(lexer)) << "chunkSize= " << chunkSize;
+  }
+}
 
-    msg << "FAILED!  Premature end-of-file.  Tokens received:";
-    std::for_each(received.begin(), received.end(), writeToken);
-    msg << "Token stream should be:";
-    std::for_each(TRUTH.begin(), TRUTH.end(), writeToken);
-    msg << "\n";
-    FAIL() << msg.str();
+TEST(ConfigFileLexerTests, StreamBufferIsBounded) {
+  std::ostringstream text;
+  for (int i= 0; i < 10000; ++i) {
+    text << "name" << i << "= value " << i << "\n";
   }
+  const std::string LONG_VALUE(1000, 'x');
+  text << "long= " << LONG_VALUE << "\n";
+
+  std::istringstream input(text.str());
+  ConfigFileLexer lexer(input, 1, 1, 64);
+  for (int i= 0; i < 10000; ++i) {
+    ASSERT_EQ(lexer.next().type(), TokenType::NAME);
+    ASSERT_EQ(lexer.next().value(), "=");
+    lexer.parseNextAsValue();
+    ASSERT_EQ(lexer.next().type(), TokenType::VALUE);
+  }
+  EXPECT_EQ(lexer.bufferSize(), 64);
+
+  // A line longer than the buffer is held whole
+  EXPECT_EQ(lexer.next(), Token(TokenType::NAME, "long", 10001, 1));
+  EXPECT_EQ(lexer.next().value(), "=");
+  lexer.parseNextAsValue();
+  EXPECT_EQ(lexer.next(), Token(TokenType::VALUE, LONG_VALUE, 10001, 7));
+  EXPECT_EQ(lexer.next().type(), TokenType::END_OF_FILE);
+  EXPECT_LE(lexer.bufferSize(), 4096);
+}
+
+TEST(ConfigFileLexerTests, TokenizeBuffer) {
+  ConfigFileLexer lexer(INPUT_TEXT.data(),
+			INPUT_TEXT.data() + INPUT_TEXT.size(),
+			START_LINE, START_COLUMN);
+  EXPECT_TRUE(verifyTokens(lexer));
+}
+
+TEST(ConfigFileLexerTests, BufferTokensReferToSource) {
+  const std::string TEXT= "# comment\nname = value\nmulti = a\\\nb\n";
+  const char* const begin= TEXT.data();
+  const char* const end= TEXT.data() + TEXT.size();
+  auto inSource= [begin, end](const Token& t) {
+    return !t.ownsValue() && (t.value().data() >= begin) &&
+           (t.value().data() + t.value().size() <= end);
+  };
+  ConfigFileLexer lexer(begin, end);
+
+  Token t= lexer.next();
+  EXPECT_EQ(t, Token(TokenType::COMMENT, "comment", 1, 3));
+  EXPECT_TRUE(inSource(t));
+
+  t= lexer.next();
+  EXPECT_EQ(t, Token(TokenType::NAME, "name", 2, 1));
+  EXPECT_TRUE(inSource(t));
+
+  t= lexer.next();
+  EXPECT_EQ(t, Token(TokenType::PUNCTUATION, "=", 2, 6));
+  EXPECT_TRUE(inSource(t));
+
+  lexer.parseNextAsValue();
+  t= lexer.next();
+  EXPECT_EQ(t, Token(TokenType::VALUE, "value", 2, 8));
+  EXPECT_TRUE(inSource(t));
+
+  lexer.next();
+  lexer.next();
+  lexer.parseNextAsValue();
+  t= lexer.next();
+
+  // Continued values are assembled from several lines, so they are copied
+  EXPECT_EQ(t, Token(TokenType::VALUE, "a\nb", 3, 9));
+  EXPECT_TRUE(t.ownsValue());
 
-  SUCCEED();
+  // Copies of a token that owns its value refer to their own copy
+  Token copy(t);
+  EXPECT_EQ(copy, t);
+  EXPECT_NE(copy.value().data(), t.value().data());
 }
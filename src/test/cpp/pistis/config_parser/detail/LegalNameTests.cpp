@@ -0,0 +1,54 @@
+/** @file LegalNameTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::detail::isLegalName
+ */
+
+#include <pistis/config_parser/detail/LegalName.hpp>
+#include <pistis/config_parser/ConfigurationProperty.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <regex>
+#include <string>
+
+using namespace pistis::config_parser;
+
+// Names can be checked at compile time
+static_assert(detail::isLegalName("listener.port"));
+static_assert(ConfigurationProperty::isLegalName("a.b_2.c"));
+static_assert(!ConfigurationProperty::isLegalName("a..b"));
+
+TEST(LegalNameTests, IsLegalName) {
+  EXPECT_TRUE(detail::isLegalName("a"));
+  EXPECT_TRUE(detail::isLegalName("Abc_123"));
+  EXPECT_TRUE(detail::isLegalName("a.b.c"));
+  EXPECT_TRUE(detail::isLegalName("a.1._"));
+  EXPECT_TRUE(detail::isLegalName("server.listener_2.port"));
+
+  EXPECT_FALSE(detail::isLegalName(""));
+  EXPECT_FALSE(detail::isLegalName("1a"));
+  EXPECT_FALSE(detail::isLegalName("_a"));
+  EXPECT_FALSE(detail::isLegalName(".a"));
+  EXPECT_FALSE(detail::isLegalName("a."));
+  EXPECT_FALSE(detail::isLegalName("a..b"));
+  EXPECT_FALSE(detail::isLegalName("a-b"));
+  EXPECT_FALSE(detail::isLegalName("a b"));
+  EXPECT_FALSE(detail::isLegalName("a\xc3\xa9"));
+  EXPECT_FALSE(detail::isLegalName(std::string_view("a\0b", 3)));
+}
+
+TEST(LegalNameTests, AgreesWithRegex) {
+  const std::regex LEGAL_NAME_REX("[A-Za-z][A-Za-z0-9_]*(?:\\.[A-Za-z0-9_]+)*");
+  const std::string ALPHABET= "aZ09_.-$ \x80";
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<size_t> pickLength(0, 8);
+  std::uniform_int_distribution<size_t> pickChar(0, ALPHABET.size() - 1);
+
+  for (int trial= 0; trial < 20000; ++trial) {
+    std::string name;
+    for (size_t n= pickLength(rng); n; --n) {
+      name.push_back(ALPHABET[pickChar(rng)]);
+    }
+    EXPECT_EQ(detail::isLegalName(name),
+	      std::regex_match(name, LEGAL_NAME_REX)) << "[" << name << "]";
+  }
+}
@@ -0,0 +1,125 @@
+/** @file SegmentTrieTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::detail::SegmentTrie
+ */
+
+#include <pistis/config_parser/detail/SegmentTrie.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace pistis::config_parser::detail;
+
+namespace {
+  SegmentTrie createTrie(const std::vector<std::string>& names) {
+    SegmentTrie trie;
+    for (size_t i= 0; i < names.size(); ++i) {
+      trie.insert(names[i], i);
+    }
+    return trie;
+  }
+}
+
+TEST(SegmentTrieTests, Construct) {
+  SegmentTrie trie;
+
+  EXPECT_TRUE(trie.empty());
+  EXPECT_EQ(trie.size(), 0);
+  EXPECT_EQ(trie.find("a"), SegmentTrie::NONE);
+  EXPECT_EQ(trie.rangeUnder("a"), std::make_pair((size_t)0, (size_t)0));
+  EXPECT_EQ(trie.shortestPrefixOf("a.b"), SegmentTrie::NONE);
+}
+
+TEST(SegmentTrieTests, InsertAndFind) {
+  SegmentTrie trie= createTrie({ "a", "a.b", "a.b.c", "a.bc", "b" });
+
+  EXPECT_FALSE(trie.empty());
+  EXPECT_EQ(trie.size(), 5);
+  EXPECT_EQ(trie.find("a"), 0);
+  EXPECT_EQ(trie.find("a.b"), 1);
+  EXPECT_EQ(trie.find("a.b.c"), 2);
+  EXPECT_EQ(trie.find("a.bc"), 3);
+  EXPECT_EQ(trie.find("b"), 4);
+  EXPECT_EQ(trie.find("a.c"), SegmentTrie::NONE);
+  EXPECT_EQ(trie.find("a.b.c.d"), SegmentTrie::NONE);
+  EXPECT_EQ(trie.find("c"), SegmentTrie::NONE);
+
+  // Replacing a value does not change the size
+  trie.insert("a.b", 10);
+  EXPECT_EQ(trie.size(), 5);
+  EXPECT_EQ(trie.find("a.b"), 10);
+
+  trie.clear();
+  EXPECT_TRUE(trie.empty());
+  EXPECT_EQ(trie.find("a"), SegmentTrie::NONE);
+}
+
+TEST(SegmentTrieTests, RangeUnder) {
+  const std::vector<std::string> NAMES{
+    "a", "a.b", "a.b.c", "a.b.d", "a.bc", "a.bc.x", "ab", "b.x", "b.y.z"
+  };
+  const SegmentTrie trie= createTrie(NAMES);
+  typedef std::pair<size_t, size_t> Range;
+
+  EXPECT_EQ(trie.rangeUnder("a"), Range(1, 6));
+  EXPECT_EQ(trie.rangeUnder("a.b"), Range(2, 4));
+  EXPECT_EQ(trie.rangeUnder("a.bc"), Range(5, 6));
+  EXPECT_EQ(trie.rangeUnder("b"), Range(7, 9));
+  EXPECT_EQ(trie.rangeUnder("b.y"), Range(8, 9));
+
+  // Blocks with no properties in them
+  EXPECT_EQ(trie.rangeUnder("ab"), Range(0, 0));
+  EXPECT_EQ(trie.rangeUnder("a.b.c"), Range(0, 0));
+  EXPECT_EQ(trie.rangeUnder("c"), Range(0, 0));
+  EXPECT_EQ(trie.rangeUnder("b.x.y"), Range(0, 0));
+}
+
+TEST(SegmentTrieTests, ShortestPrefixOf) {
+  const SegmentTrie trie= createTrie({ "abc", "abd.", "x.y", "x.y.", "q.r.s" });
+
+  // Prefixes that end inside a segment
+  EXPECT_EQ(trie.shortestPrefixOf("abc"), 3);
+  EXPECT_EQ(trie.shortestPrefixOf("abcdefg"), 3);
+  EXPECT_EQ(trie.shortestPrefixOf("abc.d"), 3);
+  EXPECT_EQ(trie.shortestPrefixOf("ab"), SegmentTrie::NONE);
+
+  // Prefixes that end with "."
+  EXPECT_EQ(trie.shortestPrefixOf("abd.e"), 4);
+  EXPECT_EQ(trie.shortestPrefixOf("abd"), SegmentTrie::NONE);
+  EXPECT_EQ(trie.shortestPrefixOf("abde"), SegmentTrie::NONE);
+
+  // The shortest of several prefixes wins
+  EXPECT_EQ(trie.shortestPrefixOf("x.yz"), 3);
+  EXPECT_EQ(trie.shortestPrefixOf("x.y.z"), 3);
+  EXPECT_EQ(trie.shortestPrefixOf("x"), SegmentTrie::NONE);
+  EXPECT_EQ(trie.shortestPrefixOf("x.z"), SegmentTrie::NONE);
+
+  EXPECT_EQ(trie.shortestPrefixOf("q.r.s.t"), 5);
+  EXPECT_EQ(trie.shortestPrefixOf("q.r.t"), SegmentTrie::NONE);
+  EXPECT_EQ(trie.shortestPrefixOf(""), SegmentTrie::NONE);
+}
+
+TEST(SegmentTrieTests, NodesAdded) {
+  EXPECT_EQ(SegmentTrie::nodesAdded("", "a.b.c"), 3);
+  EXPECT_EQ(SegmentTrie::nodesAdded("a.b.c", "a.b.d"), 1);
+  EXPECT_EQ(SegmentTrie::nodesAdded("a.b.c", "a.bc.d"), 2);
+  EXPECT_EQ(SegmentTrie::nodesAdded("a.b", "ab.c"), 2);
+  EXPECT_EQ(SegmentTrie::nodesAdded("a.b", "b"), 1);
+
+  // Counting the nodes for sorted names sizes the trie exactly
+  const std::vector<std::string> names{ "a.b.c", "a.b.d", "a.e", "f" };
+  size_t numNodes= 0;
+  for (size_t i= 0; i < names.size(); ++i) {
+    numNodes+= SegmentTrie::nodesAdded(i ? names[i - 1] : "", names[i]);
+  }
+  EXPECT_EQ(numNodes, 6);
+
+  SegmentTrie trie;
+  trie.reserve(numNodes);
+  for (size_t i= 0; i < names.size(); ++i) {
+    trie.insert(names[i], i);
+  }
+  EXPECT_EQ(trie.size(), 4);
+  EXPECT_EQ(trie.find("a.b.d"), 1);
+  EXPECT_EQ(trie.rangeUnder("a.b"), (std::pair<size_t, size_t>(0, 2)));
+}
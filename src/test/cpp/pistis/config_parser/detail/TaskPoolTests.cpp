@@ -0,0 +1,78 @@
+/** @file TaskPoolTests.cpp
+ *
+ *  Unit tests for pistis::config_parser::detail::TaskPool
+ */
+
+#include <pistis/config_parser/detail/TaskPool.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using namespace pistis::config_parser::detail;
+
+TEST(TaskPoolTests, RunTasks) {
+  TaskPool pool(4);
+  std::vector<int> results(100, 0);
+  std::vector< std::shared_ptr<TaskPool::Task> > tasks;
+
+  EXPECT_EQ(pool.numThreads(), 4);
+  for (int i= 0; i < (int)results.size(); ++i) {
+    tasks.push_back(pool.submit([&results, i]() { results[i]= i * i; }));
+  }
+  for (auto i= tasks.begin(); i != tasks.end(); ++i) {
+    pool.wait(**i);
+    EXPECT_TRUE((*i)->done());
+  }
+  for (int i= 0; i < (int)results.size(); ++i) {
+    EXPECT_EQ(results[i], i * i);
+  }
+}
+
+TEST(TaskPoolTests, WaitForNestedTasks) {
+  // Every task waits for tasks it submitted, which would deadlock a
+  // single thread if waiting did not run unstarted tasks
+  TaskPool pool(1);
+  std::atomic<int> count(0);
+  std::function<void (int)> spawn= [&pool, &count, &spawn](int depth) {
+    ++count;
+    if (depth) {
+      auto left= pool.submit([&spawn, depth]() { spawn(depth - 1); });
+      auto right= pool.submit([&spawn, depth]() { spawn(depth - 1); });
+      pool.wait(*right);
+      pool.wait(*left);
+    }
+  };
+
+  auto root= pool.submit([&spawn]() { spawn(6); });
+  pool.wait(*root);
+  EXPECT_EQ(count.load(), 127);
+}
+
+TEST(TaskPoolTests, Cancel) {
+  std::atomic<int> count(0);
+  {
+    TaskPool pool(1);
+    std::atomic<bool> release(false);
+    auto blocker= pool.submit([&release]() {
+      while (!release.load()) {
+	std::this_thread::yield();
+      }
+    });
+    auto cancelled= pool.submit([&count]() { ++count; });
+    auto kept= pool.submit([&count]() { count += 10; });
+
+    pool.cancel(*cancelled);
+    EXPECT_TRUE(cancelled->done());
+    pool.wait(*cancelled);
+    release= true;
+    pool.wait(*blocker);
+
+    // Cancelling a finished task does nothing
+    pool.cancel(*blocker);
+    EXPECT_TRUE(blocker->done());
+  }
+
+  // Destroying the pool runs the tasks left in its queue
+  EXPECT_EQ(count.load(), 10);
+}
@@ -3,9 +3,12 @@
  *  Unit tests for pistis::config_parser::detail::ValueProcessor
  */
 
+#include <pistis/config_parser/EnvironmentProvider.hpp>
 #include <pistis/config_parser/PropertyFormatError.hpp>
 #include <pistis/config_parser/detail/ValueProcessor.hpp>
 #include <gtest/gtest.h>
+#include <memory>
+#include <vector>
 #include <stdlib.h>
 
 using namespace pistis::config_parser;
@@ -65,6 +68,27 @@ TEST(ValueProcessorTests, DecodeEnclosedUnicodeChar) {
   EXPECT_THROW(processor.processValue(TOO_LONG), PropertyFormatError);
 }
 
+TEST(ValueProcessorTests, PlainAndMixedValues) {
+  const std::string LONG_RUN(100, 'x');
+  ConfigurationPropertyMap properties;
+  ValueProcessor processor(properties, false);
+
+  properties.add(ConfigurationProperty("v", "value", "someSource", 1));
+  EXPECT_EQ(processor.processValue(""), "");
+  EXPECT_EQ(processor.processValue("plain text"), "plain text");
+  EXPECT_EQ(processor.processValue(LONG_RUN), LONG_RUN);
+  EXPECT_EQ(processor.processValue(LONG_RUN + "\\t" + LONG_RUN + "${v}"),
+	    LONG_RUN + "\t" + LONG_RUN + "value");
+  EXPECT_EQ(processor.processValue("${v}" + LONG_RUN + "$" + LONG_RUN),
+	    "value" + LONG_RUN + "$" + LONG_RUN);
+  EXPECT_EQ(processor.processValue("$$${v}$"), "$$value$");
+  EXPECT_EQ(processor.processValue("ends in \\"), "ends in \\");
+
+  // A null character ends the value
+  EXPECT_EQ(processor.processValue(std::string("ab\0cd", 5)), "ab");
+  EXPECT_EQ(processor.processValue(std::string("\\n\0${v}", 7)), "\n");
+}
+
 TEST(ValueProcessorTests, VariableSubstitutionTest) {
   const std::string INPUT = "Variable substitution: ${fruit.name} is a fruit";
   const std::string TRUTH = "Variable substitution: apple is a fruit";
@@ -93,6 +117,59 @@ TEST(ValueProcessorTests, VariableSubstitutionTest) {
 	       PropertyFormatError);
 }
 
+TEST(ValueProcessorTests, CompileAndEvaluate) {
+  const std::string INPUT = "\\t${fruit.name}-${fruit.other}\\u41${x}";
+  ConfigurationPropertyMap properties;
+  ValueProcessor processor(properties, false);
+
+  properties.add(ConfigurationProperty("fruit.name", "apple", "someSource", 1));
+  properties.add(
+      ConfigurationProperty("fruit.other", "banana", "someSource", 2)
+  );
+  properties.add(ConfigurationProperty("x", "!", "someSource", 3));
+
+  // Compiling resolves nothing, so it succeeds with no properties
+  ConfigurationPropertyMap empty;
+  ValueProcessor compiler(empty, false);
+  const ValueTemplate compiled= compiler.compile(INPUT);
+  ASSERT_EQ(compiled.numReferences(), 3);
+  EXPECT_FALSE(compiled.isConstant());
+  EXPECT_EQ(compiled.literal(0), "\t");
+  EXPECT_EQ(compiled.name(0), "fruit.name");
+  EXPECT_EQ(compiled.literal(1), "-");
+  EXPECT_EQ(compiled.name(1), "fruit.other");
+  EXPECT_EQ(compiled.literal(2), "A");
+  EXPECT_EQ(compiled.name(2), "x");
+  EXPECT_EQ(compiled.literal(3), "");
+  EXPECT_EQ(compiled.literalSize(), 3);
+  EXPECT_EQ(compiled.sizeHint(), 3 + 13 + 14 + 4);
+
+  std::vector<VariableReference> references;
+  processor.setReferences(&references);
+  EXPECT_EQ(processor.evaluate(compiled), processor.processValue(INPUT));
+  processor.setReferences(nullptr);
+  EXPECT_EQ(processor.evaluate(compiled), "\tapple-bananaA!");
+  ASSERT_EQ(references.size(), 6);
+  EXPECT_EQ(references[0].name, "fruit.name");
+  EXPECT_EQ(references[0].value, "apple");
+  EXPECT_EQ(references[2].name, "x");
+
+  properties.add(ConfigurationProperty("fruit.name", "cherry", "other", 4));
+  EXPECT_EQ(processor.evaluate(compiled), "\tcherry-bananaA!");
+  EXPECT_THROW(compiler.evaluate(compiled), PropertyFormatError);
+
+  const ValueTemplate constant= compiler.compile("no \\$references");
+  EXPECT_TRUE(constant.isConstant());
+  EXPECT_EQ(compiler.evaluate(constant), "no $references");
+  EXPECT_EQ(compiler.compile(""), ValueTemplate());
+  EXPECT_NE(compiler.compile("a"), ValueTemplate());
+
+  EXPECT_THROW(compiler.compile("${"), PropertyFormatError);
+  EXPECT_THROW(compiler.compile("${}"), PropertyFormatError);
+  EXPECT_THROW(compiler.compile("\\u{1234567}"), PropertyFormatError);
+  EXPECT_THROW(compiler.compile("\\uZ"), PropertyFormatError);
+}
+
 TEST(ValueProcessorTests, VerifyEnvironmentSubstitution) {
   const std::string INPUT("Environment variable substitution: ${fruit.name}");
   const std::string TRUTH("Environment variable substitution: apple");
@@ -113,3 +190,37 @@ TEST(ValueProcessorTests, VerifyEnvironmentSubstitution) {
   );
   EXPECT_EQ(usesEnv.processValue(INPUT), TRUTH_2);
 }
+
+TEST(ValueProcessorTests, SubstituteFromEnvironmentSnapshot) {
+  const std::string INPUT("${fruit.color} ${fruit.name}");
+  ConfigurationPropertyMap properties;
+  LazyEnvironment environment(
+      std::make_shared<FixedEnvironmentProvider>(
+	  std::shared_ptr<const EnvironmentSnapshot>(
+	      new EnvironmentSnapshot{ { "fruit.name", "cherry" },
+				       { "fruit.color", "red" } }
+	  )
+      )
+  );
+  ValueProcessor processor(properties, true);
+  std::vector<VariableReference> references;
+
+  setenv("fruit.name", "apple", 1);
+  processor.setEnvironment(&environment);
+  processor.setReferences(&references);
+  EXPECT_EQ(processor.environment(), &environment);
+  EXPECT_EQ(processor.processValue(INPUT), "red cherry");
+  ASSERT_EQ(references.size(), 2);
+  EXPECT_EQ(references[1].name, "fruit.name");
+  EXPECT_EQ(references[1].value, "cherry");
+  EXPECT_TRUE(references[1].fromEnvironment);
+
+  // Properties still come before the environment
+  properties.add(ConfigurationProperty("fruit.color", "green", "test", 1));
+  EXPECT_EQ(processor.processValue(INPUT), "green cherry");
+  EXPECT_THROW(processor.processValue("${fruit.size}"), PropertyFormatError);
+
+  processor.setUseEnvironmentVars(false);
+  EXPECT_THROW(processor.processValue(INPUT), PropertyFormatError);
+  unsetenv("fruit.name");
+}
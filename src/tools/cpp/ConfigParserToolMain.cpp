@@ -0,0 +1,349 @@
+/** @file ConfigParserToolMain.cpp
+ *
+ *  Compiles configuration files into snapshots, prints the properties
+ *  they define, reports all of their errors and shows where the parser
+ *  spends its time on them.
+ *
+ *  Build with "make tools".
+ */
+
+#include <pistis/config_parser/ConfigFileParser.hpp>
+#include <pistis/config_parser/ConfigurationSnapshot.hpp>
+#include <pistis/config_parser/ApplicationConfigurationError.hpp>
+#include <pistis/config_parser/ParseStatistics.hpp>
+#include <pistis/config_parser/bench/AllocationCounter.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace pistis::config_parser;
+using namespace pistis::config_parser::bench;
+
+namespace {
+  struct Options {
+    std::string command;
+    std::string filename;
+    std::string snapshotDirectory;
+    bool isSnapshot;
+    bool useEnvironmentVars;
+    ConfigFileParser::DuplicatePropertyMode duplicatePropertyAction;
+    ConfigFileParser::DuplicatePropertyMode includedPropertyAction;
+    size_t threads;
+    size_t repeat;
+  };
+
+  void usage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " COMMAND [OPTIONS] FILE\n"
+	<< "Commands:\n"
+	<< "  check    Parse FILE and print every error in it, not just "
+	<< "the first\n"
+	<< "  compile  Parse FILE and write its snapshot into the "
+	<< "--snapshot-dir\n"
+	<< "           directory.  Programs find the snapshot when they "
+	<< "parse FILE,\n"
+	<< "           spelled the same way, with the same options.\n"
+	<< "  dump     Print the properties FILE defines, with the file "
+	<< "and line\n"
+	<< "           that defines each one\n"
+	<< "  stats    Parse FILE and print the time and allocations "
+	<< "spent in each\n"
+	<< "           phase of parsing\n"
+	<< "Options:\n"
+	<< "  --snapshot-dir=DIR  Directory of snapshots to write (compile) "
+	<< "or use\n"
+	<< "  --snapshot          FILE is a snapshot (dump only)\n"
+	<< "  --env               Substitute environment variables for "
+	<< "undefined\n"
+	<< "                      properties (default)\n"
+	<< "  --no-env            Do not substitute environment "
+	<< "variables\n"
+	<< "  --duplicates=MODE   What to do when a file defines a "
+	<< "property twice:\n"
+	<< "                      error (default), ignore or overwrite\n"
+	<< "  --included=MODE     What to do when an included file "
+	<< "defines a property\n"
+	<< "                      again: error, ignore (default) or "
+	<< "overwrite\n"
+	<< "  --threads=N         Parse included files on N threads\n"
+	<< "  --repeat=N          Parse FILE N times (stats only, "
+	<< "default 1)\n"
+	<< "  --help              Print this message" << std::endl;
+  }
+
+  bool parseMode(const char* text,
+		 ConfigFileParser::DuplicatePropertyMode& mode) {
+    if (!::strcmp(text, "error")) {
+      mode= ConfigFileParser::DUP_ERROR;
+    } else if (!::strcmp(text, "ignore")) {
+      mode= ConfigFileParser::DUP_IGNORE;
+    } else if (!::strcmp(text, "overwrite")) {
+      mode= ConfigFileParser::DUP_OVERWRITE;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  bool parseOptions(int argc, char** argv, Options& options) {
+    options.isSnapshot= false;
+    options.useEnvironmentVars= true;
+    options.duplicatePropertyAction= ConfigFileParser::DUP_ERROR;
+    options.includedPropertyAction= ConfigFileParser::DUP_IGNORE;
+    options.threads= 0;
+    options.repeat= 1;
+
+    for (int i= 1; i < argc; ++i) {
+      const char* arg= argv[i];
+      bool ok= true;
+      if (!::strcmp(arg, "--help")) {
+	usage(std::cout, argv[0]);
+	return false;
+      } else if (!::strncmp(arg, "--snapshot-dir=", 15)) {
+	options.snapshotDirectory= arg + 15;
+      } else if (!::strcmp(arg, "--snapshot")) {
+	options.isSnapshot= true;
+      } else if (!::strcmp(arg, "--env")) {
+	options.useEnvironmentVars= true;
+      } else if (!::strcmp(arg, "--no-env")) {
+	options.useEnvironmentVars= false;
+      } else if (!::strncmp(arg, "--duplicates=", 13)) {
+	ok= parseMode(arg + 13, options.duplicatePropertyAction);
+      } else if (!::strncmp(arg, "--included=", 11)) {
+	ok= parseMode(arg + 11, options.includedPropertyAction);
+      } else if (!::strncmp(arg, "--threads=", 10)) {
+	options.threads= ::atoi(arg + 10);
+      } else if (!::strncmp(arg, "--repeat=", 9)) {
+	options.repeat= ::atoi(arg + 9);
+	ok= options.repeat > 0;
+      } else if (arg[0] == '-') {
+	ok= false;
+      } else if (options.command.empty()) {
+	options.command= arg;
+      } else if (options.filename.empty()) {
+	options.filename= arg;
+      } else {
+	ok= false;
+      }
+
+      if (!ok) {
+	std::cerr << "Invalid argument \"" << arg << "\"" << std::endl;
+	usage(std::cerr, argv[0]);
+	return false;
+      }
+    }
+
+    if ((options.command != "check") && (options.command != "compile") &&
+	(options.command != "dump") && (options.command != "stats")) {
+      std::cerr << (options.command.empty() ? "Command missing"
+					    : "Unknown command")
+		<< std::endl;
+      usage(std::cerr, argv[0]);
+      return false;
+    } else if (options.filename.empty()) {
+      std::cerr << "File name missing" << std::endl;
+      usage(std::cerr, argv[0]);
+      return false;
+    } else if ((options.command == "compile") &&
+	       options.snapshotDirectory.empty()) {
+      std::cerr << "compile needs --snapshot-dir" << std::endl;
+      return false;
+    } else if (options.isSnapshot && (options.command != "dump")) {
+      std::cerr << "--snapshot only works with dump" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  std::unique_ptr<ConfigFileParser> createParser(const Options& options) {
+    std::unique_ptr<ConfigFileParser> parser(
+	new ConfigFileParser(options.useEnvironmentVars,
+			     options.duplicatePropertyAction,
+			     options.includedPropertyAction)
+    );
+    parser->setIncludeThreads(options.threads);
+    parser->setSnapshotDirectory(options.snapshotDirectory);
+    return parser;
+  }
+
+  /** @brief Write @c value with control characters and backslashes
+   *         escaped, so each property takes one line
+   */
+  void writeEscaped(std::ostream& out, std::string_view value) {
+    for (char c : value) {
+      if (c == '\\') {
+	out << "\\\\";
+      } else if (c == '\n') {
+	out << "\\n";
+      } else if (c == '\t') {
+	out << "\\t";
+      } else if ((unsigned char)c < 0x20) {
+	char hex[8];
+	::snprintf(hex, sizeof(hex), "\\x%02x", (unsigned char)c);
+	out << hex;
+      } else {
+	out << c;
+      }
+    }
+  }
+
+  void dumpProperty(std::ostream& out, std::string_view name,
+		    std::string_view value, std::string_view source,
+		    int line) {
+    out << source << ":" << line << ": " << name << " = ";
+    writeEscaped(out, value);
+    out << "\n";
+  }
+
+  int check(const Options& options) {
+    ApplicationConfigurationErrorList errors;
+    const ConfigurationPropertyMap properties=
+	createParser(options)->parse(options.filename, errors);
+    for (auto i= errors.begin(); i != errors.end(); ++i) {
+      std::cerr << (*i)->what() << "\n";
+    }
+    std::cout << options.filename << ": " << properties.size()
+	      << " properties, " << errors.size()
+	      << (errors.size() == 1 ? " error" : " errors") << std::endl;
+    return errors.empty() ? 0 : 1;
+  }
+
+  int compile(const Options& options) {
+    std::unique_ptr<ConfigFileParser> parser= createParser(options);
+    const std::string snapshotFile= parser->snapshotFile(options.filename);
+    if (snapshotFile.empty()) {
+      std::cerr << "Cannot find " << options.filename << std::endl;
+      return 1;
+    }
+
+    // Always parse the text, even if the snapshot is already fresh
+    ::unlink(snapshotFile.c_str());
+    const ConfigurationPropertyMap properties=
+	parser->parse(options.filename);
+
+    // The parser does not report failing to write a snapshot, so check
+    // that it is there
+    ConfigurationSnapshot snapshot(snapshotFile);
+    if ((snapshot.size() != properties.size()) || !snapshot.isFresh()) {
+      std::cerr << options.filename << " changed while it was compiled"
+		<< std::endl;
+      return 1;
+    }
+    std::cout << "Wrote " << snapshotFile << " (" << snapshot.size()
+	      << " properties from " << snapshot.numInputFiles()
+	      << " files)" << std::endl;
+    return 0;
+  }
+
+  int dump(const Options& options) {
+    if (options.isSnapshot) {
+      ConfigurationSnapshot snapshot(options.filename);
+      for (size_t i= 0; i < snapshot.size(); ++i) {
+	const ConfigurationSnapshot::Property p= snapshot.property(i);
+	dumpProperty(std::cout, p.name, p.value, p.source, p.line);
+      }
+      return 0;
+    }
+
+    const ConfigurationPropertyMap properties=
+	createParser(options)->parse(options.filename);
+    for (auto i= properties.begin(); i != properties.end(); ++i) {
+      dumpProperty(std::cout, i->name(), i->value(), i->source(), i->line());
+    }
+    return 0;
+  }
+
+  void printPhase(std::ostream& out, const char* name, uint64_t count,
+		  double ms, double totalMs, uint64_t allocations,
+		  size_t repeat) {
+    out << std::left << std::setw(18) << name << std::right
+	<< std::setw(12) << count / repeat
+	<< std::setw(12) << std::fixed << std::setprecision(3)
+	<< ms / repeat
+	<< std::setw(9) << std::setprecision(1)
+	<< (totalMs > 0.0 ? 100.0 * ms / totalMs : 0.0)
+	<< std::setw(14) << allocations / repeat << "\n";
+  }
+
+  int stats(const Options& options) {
+    std::shared_ptr<ParseStatistics> statistics=
+	std::make_shared<ParseStatistics>(&AllocationCounter::allocations);
+    std::unique_ptr<ConfigFileParser> parser= createParser(options);
+    parser->setStatistics(statistics);
+
+    size_t numProperties= 0;
+    const uint64_t allocationsBefore= AllocationCounter::allocations();
+    const auto start= std::chrono::steady_clock::now();
+    for (size_t i= 0; i < options.repeat; ++i) {
+      numProperties= parser->parse(options.filename).size();
+    }
+    const auto end= std::chrono::steady_clock::now();
+    const uint64_t allocations=
+	AllocationCounter::allocations() - allocationsBefore;
+    const double totalMs=
+	std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::cout << options.filename << ": " << numProperties
+	      << " properties, averaged over " << options.repeat
+	      << (options.repeat == 1 ? " parse" : " parses") << "\n\n"
+	      << "phase                    calls          ms   % time"
+	      << "        allocs\n";
+
+    double phaseMs= 0.0;
+    uint64_t phaseAllocations= 0;
+    for (int p= 0; p < ParseStatistics::NUM_PHASES; ++p) {
+      const ParseStatistics::Phase phase= (ParseStatistics::Phase)p;
+      const ParseStatistics::PhaseTotals totals= statistics->phase(phase);
+      const double ms= totals.nanoseconds / 1.0e6;
+      printPhase(std::cout, ParseStatistics::phaseName(phase), totals.count,
+		 ms, totalMs, totals.allocations, options.repeat);
+      phaseMs += ms;
+      phaseAllocations += totals.allocations;
+    }
+
+    // Phases on include threads overlap, so their sum can exceed the
+    // elapsed time
+    printPhase(std::cout, "other", options.repeat,
+	       std::max(totalMs - phaseMs, 0.0), totalMs,
+	       allocations > phaseAllocations ? allocations - phaseAllocations
+					      : 0,
+	       options.repeat);
+    printPhase(std::cout, "total", options.repeat, totalMs, totalMs,
+	       allocations, options.repeat);
+    if (options.threads) {
+      std::cout << "\nPhases on include threads overlap, so they may add "
+		<< "up to more than the total" << std::endl;
+    }
+    return 0;
+  }
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    return 2;
+  }
+
+  try {
+    if (options.command == "check") {
+      return check(options);
+    } else if (options.command == "compile") {
+      return compile(options);
+    } else if (options.command == "dump") {
+      return dump(options);
+    } else {
+      return stats(options);
+    }
+  } catch(const ApplicationConfigurationError& e) {
+    std::cerr << e.what() << std::endl;
+  } catch(const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+  }
+  return 1;
+}